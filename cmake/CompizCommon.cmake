@@ -66,6 +66,11 @@ if (NOT COMPIZ_DEPRECATED_WARNINGS)
     set (COMMON_FLAGS "${COMMON_FLAGS} -Wno-deprecated-declarations")
 endif ()
 
+option (COMPIZ_TRACING "Record the time spent in the paint and event paths, dumped as a Chrome trace on SIGUSR1" OFF)
+if (COMPIZ_TRACING)
+    set (COMMON_FLAGS "${COMMON_FLAGS} -DCOMPIZ_TRACING")
+endif ()
+
 option (COMPIZ_SIGN_WARNINGS "Should compiz use -Wsign-conversion during compilation." ON)
 if (NOT COMPIZ_SIGN_WARNINGS)
     set (COMMON_FLAGS "${COMMON_FLAGS} -Wno-sign-conversion")
@@ -15,7 +15,7 @@
 
 struct _CCSGSettingsBackendPrivate
 {
-    GList	               *settingsList;
+    GHashTable	               *settingsTable;
     CCSGSettingsWrapper        *compizconfigSettings;
     CCSGSettingsWrapper        *currentProfileSettings;
     CCSGSettingsWrapperFactory *wrapperFactory;
@@ -26,6 +26,15 @@ struct _CCSGSettingsBackendPrivate
     CCSIntegration *integration;
 
     CCSGNOMEValueChangeData *valueChangeData;
+
+    /* Wrappers which were put into delay-apply mode while
+     * a write was in progress */
+    GHashTable *delayedSettings;
+    gboolean   delayWrites;
+
+    /* Keys which changed since the last flush, by schema name */
+    GHashTable *changedKeys;
+    guint      changedKeysSource;
 };
 
 static void
@@ -34,6 +43,78 @@ ccsGSettingsWrapperDestroyNotify (gpointer o)
     ccsGSettingsWrapperUnref ((CCSGSettingsWrapper *) o);
 }
 
+static void
+ccsGSettingsKeySetDestroyNotify (gpointer o)
+{
+    g_hash_table_destroy ((GHashTable *) o);
+}
+
+static void
+ccsGSettingsBackendApplyDelayedWrapper (gpointer key,
+					gpointer value,
+					gpointer data)
+{
+    GSettings *settings = ccsGSettingsWrapperGetGSettings ((CCSGSettingsWrapper *) key);
+
+    if (settings)
+	g_settings_apply (settings);
+}
+
+static void
+ccsGSettingsBackendApplyDelayedWrappers (CCSGSettingsBackendPrivate *priv)
+{
+    g_hash_table_foreach (priv->delayedSettings,
+			  ccsGSettingsBackendApplyDelayedWrapper,
+			  NULL);
+}
+
+static void
+ccsGSettingsBackendDelayWrapper (CCSGSettingsBackendPrivate *priv,
+				 CCSGSettingsWrapper        *wrapper)
+{
+    GSettings *settings;
+
+    if (!priv->delayWrites ||
+	g_hash_table_lookup (priv->delayedSettings, wrapper))
+	return;
+
+    settings = ccsGSettingsWrapperGetGSettings (wrapper);
+
+    if (!settings)
+	return;
+
+    /* There is no way to take a GSettings object out of delay-apply
+     * mode again, so it stays in the set and any write made outside
+     * of a write pass has to be applied explicitly */
+    g_settings_delay (settings);
+    g_hash_table_insert (priv->delayedSettings, wrapper, wrapper);
+}
+
+static void
+ccsGSettingsBackendClearSettings (CCSGSettingsBackendPrivate *priv)
+{
+    ccsGSettingsBackendApplyDelayedWrappers (priv);
+    g_hash_table_remove_all (priv->delayedSettings);
+    g_hash_table_remove_all (priv->settingsTable);
+}
+
+void
+ccsGSettingsBackendDelayWrites (CCSBackend *backend)
+{
+    CCSGSettingsBackendPrivate *priv = (CCSGSettingsBackendPrivate *) ccsObjectGetPrivate (backend);
+
+    priv->delayWrites = TRUE;
+}
+
+void
+ccsGSettingsBackendApplyWrites (CCSBackend *backend)
+{
+    CCSGSettingsBackendPrivate *priv = (CCSGSettingsBackendPrivate *) ccsObjectGetPrivate (backend);
+
+    ccsGSettingsBackendApplyDelayedWrappers (priv);
+    priv->delayWrites = FALSE;
+}
+
 void
 ccsGSettingsSetIntegration (CCSBackend *backend, CCSIntegration *integration)
 {
@@ -74,6 +155,92 @@ ccsGSettingsGetExistingProfiles (CCSBackend *backend, CCSContext *context)
     return ret;
 }
 
+static GHashTable *
+ccsGSettingsBackendNewChangedKeys ()
+{
+    return g_hash_table_new_full (g_str_hash, g_str_equal,
+				  g_free, ccsGSettingsKeySetDestroyNotify);
+}
+
+void
+ccsGSettingsBackendFlushChangedKeys (CCSBackend *backend)
+{
+    CCSGSettingsBackendPrivate *priv = (CCSGSettingsBackendPrivate *) ccsObjectGetPrivate (backend);
+    CCSBackendInterface *backendInterface = (CCSBackendInterface *) GET_INTERFACE (CCSBackendInterface, backend);
+    GHashTable     *changedKeys = priv->changedKeys;
+    GHashTableIter schemaIter, keyIter;
+    gpointer       schemaName, keys, keyName;
+
+    if (priv->changedKeysSource)
+    {
+	g_source_remove (priv->changedKeysSource);
+	priv->changedKeysSource = 0;
+    }
+
+    /* Updating a setting may write to an integrated key
+     * and queue more changes, so start a fresh set first */
+    priv->changedKeys = ccsGSettingsBackendNewChangedKeys ();
+
+    g_hash_table_iter_init (&schemaIter, changedKeys);
+    while (g_hash_table_iter_next (&schemaIter, &schemaName, &keys))
+    {
+	CCSGSettingsWrapper *wrapper = g_hash_table_lookup (priv->settingsTable, schemaName);
+
+	/* The wrappers are dropped when the profile changes, in
+	 * which case everything is read again anyways */
+	if (!wrapper)
+	    continue;
+
+	ccsGSettingsWrapperRef (wrapper);
+
+	g_hash_table_iter_init (&keyIter, (GHashTable *) keys);
+	while (g_hash_table_iter_next (&keyIter, &keyName, NULL))
+	    updateSettingWithGSettingsKeyName (backend, wrapper, (const gchar *) keyName,
+					       backendInterface->updateSetting);
+
+	ccsGSettingsWrapperUnref (wrapper);
+    }
+
+    g_hash_table_destroy (changedKeys);
+}
+
+static gboolean
+ccsGSettingsBackendChangedKeysIdle (gpointer data)
+{
+    CCSBackend                 *backend = (CCSBackend *) data;
+    CCSGSettingsBackendPrivate *priv = (CCSGSettingsBackendPrivate *) ccsObjectGetPrivate (backend);
+
+    priv->changedKeysSource = 0;
+    ccsGSettingsBackendFlushChangedKeys (backend);
+
+    return FALSE;
+}
+
+void
+ccsGSettingsBackendQueueChangedKey (CCSBackend  *backend,
+				    const gchar *schemaName,
+				    const gchar *keyName)
+{
+    CCSGSettingsBackendPrivate *priv = (CCSGSettingsBackendPrivate *) ccsObjectGetPrivate (backend);
+    GHashTable                 *keys = g_hash_table_lookup (priv->changedKeys, schemaName);
+
+    if (!keys)
+    {
+	keys = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	g_hash_table_insert (priv->changedKeys, g_strdup (schemaName), keys);
+    }
+
+    /* Repeated changes to the same key only need to be read once */
+    if (!g_hash_table_lookup (keys, keyName))
+    {
+	gchar *key = g_strdup (keyName);
+	g_hash_table_insert (keys, key, key);
+    }
+
+    if (!priv->changedKeysSource)
+	priv->changedKeysSource = g_idle_add (ccsGSettingsBackendChangedKeysIdle, backend);
+}
+
 void
 ccsGSettingsValueChanged (GSettings   *settings,
 			  gchar	      *keyName,
@@ -81,19 +248,15 @@ ccsGSettingsValueChanged (GSettings   *settings,
 {
     CCSBackend   *backend = (CCSBackend *)user_data;
     GValue       schemaNameValue = G_VALUE_INIT;
-    CCSGSettingsBackendPrivate *priv = (CCSGSettingsBackendPrivate *) ccsObjectGetPrivate (backend);
-    CCSBackendInterface *backendInterface = (CCSBackendInterface *) GET_INTERFACE (CCSBackendInterface, backend);
-
 
     g_value_init (&schemaNameValue, G_TYPE_STRING);
     g_object_get_property (G_OBJECT (settings), "schema-id", &schemaNameValue);
 
-    const char *schemaName = g_value_get_string (&schemaNameValue);
-    CCSGSettingsWrapper *wrapper = findCCSGSettingsWrapperBySchemaName (schemaName, priv->settingsList);
+    /* Importing or switching a profile changes thousands of keys at
+     * once, so coalesce them into one update per main loop iteration */
+    ccsGSettingsBackendQueueChangedKey (backend, g_value_get_string (&schemaNameValue), keyName);
 
     g_value_unset (&schemaNameValue);
-
-    updateSettingWithGSettingsKeyName (backend, wrapper, keyName, backendInterface->updateSetting);
 }
 
 static CCSGSettingsWrapper *
@@ -110,10 +273,11 @@ ccsGSettingsBackendGetSettingsObjectForPluginWithPathDefault (CCSBackend *backen
 
     CCSGSettingsBackendPrivate *priv = (CCSGSettingsBackendPrivate *) ccsObjectGetPrivate (backend);
 
-    settingsObj = findCCSGSettingsWrapperBySchemaName (schemaName, priv->settingsList);
+    settingsObj = g_hash_table_lookup (priv->settingsTable, schemaName);
 
     if (settingsObj)
     {
+	ccsGSettingsBackendDelayWrapper (priv, settingsObj);
 	g_free (schemaName);
 	return settingsObj;
     }
@@ -124,10 +288,16 @@ ccsGSettingsBackendGetSettingsObjectForPluginWithPathDefault (CCSBackend *backen
 
     /* Couldn't allocate one */
     if (!settingsObj)
+    {
+	g_free (schemaName);
 	return NULL;
+    }
 
     ccsGSettingsBackendConnectToChangedSignal (backend, settingsObj);
-    priv->settingsList = g_list_append (priv->settingsList, (void *) settingsObj);
+    ccsGSettingsBackendDelayWrapper (priv, settingsObj);
+
+    /* The table takes ownership of schemaName */
+    g_hash_table_insert (priv->settingsTable, schemaName, settingsObj);
 
     /* Also write the plugin name to the list of modified plugins so
      * that when we delete the profile the keys for that profile are also
@@ -145,7 +315,6 @@ ccsGSettingsBackendGetSettingsObjectForPluginWithPathDefault (CCSBackend *backen
     }
 
     g_variant_unref (writtenPlugins);
-    g_free (schemaName);
     g_strfreev (newWrittenPlugins);
 
     return settingsObj;
@@ -199,8 +368,7 @@ ccsGSettingsBackendUpdateProfileDefault (CCSBackend *backend, CCSContext *contex
     if (g_strcmp0 (profile, currentProfile))
     {
 	ccsGSettingsBackendUpdateCurrentProfileName (backend, profile);
-	g_list_free_full (priv->settingsList, ccsGSettingsWrapperDestroyNotify);
-	priv->settingsList = NULL;
+	ccsGSettingsBackendClearSettings (priv);
     }
 
     free (profile);
@@ -398,8 +566,14 @@ ccsGSettingsBackendDetachFromBackend (CCSBackend *backend)
 	priv->currentProfile = NULL;
     }
 
-    g_list_free_full (priv->settingsList, ccsGSettingsWrapperDestroyNotify);
-    priv->settingsList = NULL;
+    if (priv->changedKeysSource)
+	g_source_remove (priv->changedKeysSource);
+
+    g_hash_table_destroy (priv->changedKeys);
+
+    ccsGSettingsBackendClearSettings (priv);
+    g_hash_table_destroy (priv->delayedSettings);
+    g_hash_table_destroy (priv->settingsTable);
 
     if (priv->currentProfileSettings)
     {
@@ -443,5 +617,10 @@ ccsGSettingsBackendAttachNewToBackend (CCSBackend                 *backend,
     priv->integration = integration;
     priv->wrapperFactory = wrapperFactory;
 
+    priv->settingsTable = g_hash_table_new_full (g_str_hash, g_str_equal,
+						 g_free, ccsGSettingsWrapperDestroyNotify);
+    priv->delayedSettings = g_hash_table_new (g_direct_hash, g_direct_equal);
+    priv->changedKeys = ccsGSettingsBackendNewChangedKeys ();
+
     return TRUE;
 }
@@ -42,6 +42,20 @@ gboolean ccsGSettingsBackendAddProfileDefault (CCSBackend *backend,
 void ccsGSettingsSetIntegration (CCSBackend *backend,
 				 CCSIntegration *integration);
 
+/* Put every settings object used until ccsGSettingsBackendApplyWrites
+ * into delay-apply mode, so that a full write pass reaches GSettings
+ * as one change set per schema rather than one per key */
+void ccsGSettingsBackendDelayWrites (CCSBackend *backend);
+
+void ccsGSettingsBackendApplyWrites (CCSBackend *backend);
+
+/* Changed keys are queued and read back once per main loop iteration */
+void ccsGSettingsBackendQueueChangedKey (CCSBackend  *backend,
+					 const gchar *schemaName,
+					 const gchar *keyName);
+
+void ccsGSettingsBackendFlushChangedKeys (CCSBackend *backend);
+
 COMPIZCONFIG_END_DECLS
 
 #endif
@@ -396,7 +396,12 @@ readSetting (CCSBackend *backend,
 Bool
 writeInit (CCSBackend *backend, CCSContext * context)
 {
-    return ccsGSettingsBackendUpdateProfile (backend, context);
+    if (!ccsGSettingsBackendUpdateProfile (backend, context))
+	return FALSE;
+
+    ccsGSettingsBackendDelayWrites (backend);
+
+    return TRUE;
 }
 
 void
@@ -420,6 +425,12 @@ writeSetting (CCSBackend *backend,
 
 }
 
+static void
+writeDone (CCSBackend *backend, CCSContext * context)
+{
+    ccsGSettingsBackendApplyWrites (backend);
+}
+
 static void
 updateSetting (CCSBackend *backend, CCSContext *context, CCSPlugin *plugin, CCSSetting *setting)
 {
@@ -442,6 +453,7 @@ updateSetting (CCSBackend *backend, CCSContext *context, CCSPlugin *plugin, CCSS
     {
 	ccsBackendWriteInit (backend, context);
 	ccsGSettingsBackendWriteIntegratedOption (backend, setting, integrated);
+	ccsBackendWriteDone (backend, context);
     }
 }
 
@@ -561,7 +573,13 @@ ccsGSettingsWrapDeleteProfile (CCSBackend *backend,
 			       CCSContext *context,
 			       char       *profile)
 {
-    return deleteProfile (backend, context, profile);
+    Bool ret = deleteProfile (backend, context, profile);
+
+    /* Resetting the keys goes through the same settings objects
+     * as writing them, which may be in delay-apply mode */
+    ccsGSettingsBackendApplyWrites (backend);
+
+    return ret;
 }
 
 static CCSBackendInterface gsettingsVTable = {
@@ -574,7 +592,7 @@ static CCSBackendInterface gsettingsVTable = {
     0,
     writeInit,
     writeSetting,
-    0,
+    writeDone,
     updateSetting,
     getSettingIsIntegrated,
     getSettingIsReadOnly,
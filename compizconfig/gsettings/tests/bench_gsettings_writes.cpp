@@ -0,0 +1,205 @@
+/*
+ * Compiz configuration system library
+ *
+ * Copyright © 2026 Compiz authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <gio/gio.h>
+
+#include <glib_gsettings_memory_backend_env.h>
+
+#include "gsettings-mock-schemas-config.h"
+
+/*
+ * Writes the keys of the mock schema over a number of rounds against
+ * the GSettings memory backend, once setting each key on its own and
+ * once the way the backend's write pass does it: with the settings
+ * object in delay-apply mode and one apply per round. Another settings
+ * object on the same path counts the change events that reach it,
+ * which is what every running compiz and settings manager has to
+ * process.
+ *
+ * COMPIZCONFIG_BENCH_ROUNDS - number of rounds (default: 1000)
+ */
+
+namespace
+{
+const std::string MOCK_SETTINGS_PATH ("/org/compiz/profiles/bench/plugins/mock/");
+const unsigned int DEFAULT_ROUNDS = 1000;
+
+const char *BENCH_KEYS[] =
+{
+    "integer-setting",
+    "boolean-setting",
+    "float-setting",
+    "string-setting",
+    "match-setting",
+    "bell-setting"
+};
+
+unsigned int
+RoundsFromEnv ()
+{
+    const char *value = getenv ("COMPIZCONFIG_BENCH_ROUNDS");
+    return value ? atoi (value) : DEFAULT_ROUNDS;
+}
+
+void
+CountChangeEvent (GSettings *settings,
+		  gpointer  keys,
+		  gint      nKeys,
+		  gpointer  data)
+{
+    ++(*(static_cast <unsigned int *> (data)));
+}
+
+void
+RunMainLoop ()
+{
+    while (g_main_context_iteration (NULL, FALSE));
+}
+}
+
+class CCSGSettingsWriteBenchmark :
+    public ::testing::Test
+{
+    public:
+
+	CCSGSettingsWriteBenchmark () :
+	    rounds (RoundsFromEnv ()),
+	    observer (NULL),
+	    changeEvents (0)
+	{
+	}
+
+	virtual void SetUp ()
+	{
+	    g_type_init ();
+	    env.SetUpEnv (MOCK_PATH);
+
+	    observer = g_settings_new_with_path (MOCK_SCHEMA.c_str (),
+						 MOCK_SETTINGS_PATH.c_str ());
+
+	    g_signal_connect (observer, "change-event",
+			      G_CALLBACK (CountChangeEvent), &changeEvents);
+	}
+
+	virtual void TearDown ()
+	{
+	    g_object_unref (observer);
+
+	    env.TearDownEnv ();
+	}
+
+	void WriteRound (GSettings    *settings,
+			 unsigned int round)
+	{
+	    std::stringstream ss;
+
+	    ss << "round " << round;
+
+	    g_settings_set_int (settings, "integer-setting", round);
+	    g_settings_set_boolean (settings, "boolean-setting", round % 2);
+	    g_settings_set_double (settings, "float-setting", round / 2.0);
+	    g_settings_set_string (settings, "string-setting", ss.str ().c_str ());
+	    g_settings_set_string (settings, "match-setting", ss.str ().c_str ());
+	    g_settings_set_boolean (settings, "bell-setting", !(round % 2));
+	}
+
+	void ResetKeys ()
+	{
+	    for (unsigned int i = 0; i < G_N_ELEMENTS (BENCH_KEYS); ++i)
+		g_settings_reset (observer, BENCH_KEYS[i]);
+
+	    RunMainLoop ();
+	}
+
+	/* Returns the milliseconds it took for all rounds to be written
+	 * and seen by the observer */
+	double Run (bool delayApply)
+	{
+	    GSettings *writer = g_settings_new_with_path (MOCK_SCHEMA.c_str (),
+							  MOCK_SETTINGS_PATH.c_str ());
+
+	    if (delayApply)
+		g_settings_delay (writer);
+
+	    changeEvents = 0;
+
+	    gint64 start = g_get_monotonic_time ();
+
+	    for (unsigned int i = 1; i <= rounds; ++i)
+	    {
+		WriteRound (writer, i);
+
+		if (delayApply)
+		    g_settings_apply (writer);
+
+		RunMainLoop ();
+	    }
+
+	    gint64 end = g_get_monotonic_time ();
+
+	    g_object_unref (writer);
+
+	    return (end - start) / 1000.0;
+	}
+
+	unsigned int rounds;
+	GSettings    *observer;
+	unsigned int changeEvents;
+
+    private:
+
+	CompizGLibGSettingsMemoryBackendTestingEnv env;
+};
+
+TEST_F (CCSGSettingsWriteBenchmark, PerKeyAgainstDelayAppliedWrites)
+{
+    ASSERT_GT (rounds, 0u);
+
+    double       perKeyMs = Run (false);
+    unsigned int perKeyEvents = changeEvents;
+
+    EXPECT_EQ (static_cast <gint> (rounds),
+	       g_settings_get_int (observer, "integer-setting"));
+
+    /* Start over from the defaults, so both write the same changes */
+    ResetKeys ();
+
+    double       delayedMs = Run (true);
+    unsigned int delayedEvents = changeEvents;
+
+    /* Both end up with the same values */
+    EXPECT_EQ (static_cast <gint> (rounds),
+	       g_settings_get_int (observer, "integer-setting"));
+
+    /* One change set per round */
+    EXPECT_EQ (rounds, delayedEvents);
+    EXPECT_LT (delayedEvents, perKeyEvents);
+
+    std::cout << "[BENCH] " << rounds << " rounds, per key: "
+	      << perKeyMs << " ms, " << perKeyEvents << " change events; "
+	      << "delay-applied: " << delayedMs << " ms, "
+	      << delayedEvents << " change events" << std::endl;
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <vector>
 #include <tr1/tuple>
 
 #include <boost/function.hpp>
@@ -2067,6 +2069,18 @@ namespace
 	return TRUE;
     }
 
+    /* Settings the backend was asked to update, in order */
+    std::vector <CCSSetting *> stubBackendUpdatedSettings;
+
+    void
+    stubBackendUpdateSetting (CCSBackend *backend,
+			      CCSContext *context,
+			      CCSPlugin  *plugin,
+			      CCSSetting *setting)
+    {
+	stubBackendUpdatedSettings.push_back (setting);
+    }
+
     CCSBackendInterface stubBackendInterface =
     {
 	stubBackendGetInfo,
@@ -2079,7 +2093,7 @@ namespace
 	NULL,
 	NULL,
 	NULL,
-	NULL,
+	stubBackendUpdateSetting,
 	NULL,
 	NULL,
 	NULL,
@@ -2256,7 +2270,9 @@ TEST_F (CCSGSettingsTestCCSGSettingsBackend, TestReturnExistingWrapper)
 										   MOCK_GSCHEMA_PATH.c_str (),
 										   mockContext.get ());
 
-    EXPECT_CALL (*gmockWrapper, getSchemaName ()).WillOnce (Return (MOCK_SCHEMA_NAME.c_str ()));
+    /* Wrappers are looked up by the schema name they were created
+     * with, so there is no need to ask each one for it */
+    EXPECT_CALL (*gmockWrapper, getSchemaName ()).Times (0);
 
     /* Shouldn't be called again */
     EXPECT_CALL (*gmockWrapperFactory, newGSettingsWrapperWithPath (_, _, _)).Times (0);
@@ -2269,3 +2285,167 @@ TEST_F (CCSGSettingsTestCCSGSettingsBackend, TestReturnExistingWrapper)
     /* It should return the cached one */
     EXPECT_EQ (mockMockPluginWrapper, wrapper);
 }
+
+class CCSGSettingsTestCCSGSettingsBackendWithMemoryBackend :
+    public CCSGSettingsTestCCSGSettingsBackend
+{
+    public:
+
+	CCSGSettingsTestCCSGSettingsBackendWithMemoryBackend () :
+	    mockPath (MOCK_GSCHEMA_PATH + "/"),
+	    settings (NULL),
+	    observer (NULL)
+	{
+	}
+
+	virtual void SetUp ()
+	{
+	    CCSGSettingsTestCCSGSettingsBackend::SetUp ();
+	    env.SetUpEnv (MOCK_PATH);
+
+	    stubBackendUpdatedSettings.clear ();
+
+	    settings = g_settings_new_with_path (MOCK_SCHEMA_NAME.c_str (),
+						 mockPath.c_str ());
+	    observer = g_settings_new_with_path (MOCK_SCHEMA_NAME.c_str (),
+						 mockPath.c_str ());
+
+	    ON_CALL (*gmockWrapper, getGSettings ()).WillByDefault (Return (settings));
+	    ON_CALL (*gmockWrapper, getPath ()).WillByDefault (Return (MOCK_GSCHEMA_PATH.c_str ()));
+	}
+
+	virtual void TearDown ()
+	{
+	    /* Detaching applies what is still delayed */
+	    CCSGSettingsTestCCSGSettingsBackend::TearDown ();
+
+	    g_object_unref (observer);
+	    g_object_unref (settings);
+
+	    env.TearDownEnv ();
+	}
+
+	/* Makes the backend create and keep the wrapper for the mock plugin */
+	void GetMockPluginWrapper ()
+	{
+	    boost::shared_ptr <GVariant> pluginsWithSetKeysVariantEmpty (GetEmptyPluginsWithSetKeys ());
+
+	    EXPECT_CALL (*gmockWrapperFactory, newGSettingsWrapperWithPath (Eq (MOCK_SCHEMA_NAME),
+									    Eq (MOCK_GSCHEMA_PATH),
+									    _)).WillOnce (Return (mockMockPluginWrapper));
+	    EXPECT_CALL (*gmockWrapper, connectToChangedSignal (_, stubBackend.get ()));
+	    EXPECT_CALL (*gmockCurrentProfileSettings, getValue (Eq (PLUGINS_WITH_SET_KEYS)))
+		    .WillOnce (Return (g_variant_ref (pluginsWithSetKeysVariantEmpty.get ())));
+	    EXPECT_CALL (*gmockCurrentProfileSettings, setValue (Eq (PLUGINS_WITH_SET_KEYS), _))
+		    .WillOnce (WithArgs <1> (Invoke (g_variant_unref)));
+
+	    EXPECT_EQ (mockMockPluginWrapper,
+		       ccsGSettingsGetSettingsObjectForPluginWithPath (stubBackend.get (),
+								       MOCK_PLUGIN_NAME.c_str (),
+								       MOCK_GSCHEMA_PATH.c_str (),
+								       mockContext.get ()));
+	}
+
+	void RunMainLoop ()
+	{
+	    while (g_main_context_iteration (NULL, FALSE));
+	}
+
+    protected:
+
+	std::string mockPath;
+	GSettings   *settings;
+	GSettings   *observer;
+
+    private:
+
+	CompizGLibGSettingsMemoryBackendTestingEnv env;
+};
+
+TEST_F (CCSGSettingsTestCCSGSettingsBackendWithMemoryBackend, TestRepeatedChangesToOneKeyUpdateOnce)
+{
+    boost::shared_ptr <CCSPlugin> plugin (ccsMockPluginNew (),
+					  boost::bind (ccsPluginUnref, _1));
+    CCSPluginGMock *gmockPlugin = reinterpret_cast <CCSPluginGMock *> (ccsObjectGetPrivate (plugin.get ()));
+    boost::shared_ptr <CCSSetting> integerSetting (ccsMockSettingNew (),
+						   boost::bind (ccsSettingUnref, _1));
+    boost::shared_ptr <CCSSetting> booleanSetting (ccsMockSettingNew (),
+						   boost::bind (ccsSettingUnref, _1));
+    CCSContextGMock *gmockContext = reinterpret_cast <CCSContextGMock *> (ccsObjectGetPrivate (mockContext.get ()));
+
+    GetMockPluginWrapper ();
+
+    EXPECT_CALL (*gmockContext, findPlugin (Eq (MOCK_PLUGIN_NAME))).WillRepeatedly (Return (plugin.get ()));
+    EXPECT_CALL (*gmockPlugin, findSetting (Eq (std::string ("integer_setting"))))
+	    .WillOnce (Return (integerSetting.get ()));
+    EXPECT_CALL (*gmockPlugin, findSetting (Eq (std::string ("boolean_setting"))))
+	    .WillOnce (Return (booleanSetting.get ()));
+
+    for (unsigned int i = 0; i < 5; ++i)
+	ccsGSettingsBackendQueueChangedKey (stubBackend.get (),
+					    MOCK_SCHEMA_NAME.c_str (),
+					    "integer-setting");
+
+    ccsGSettingsBackendQueueChangedKey (stubBackend.get (),
+					MOCK_SCHEMA_NAME.c_str (),
+					"boolean-setting");
+
+    /* Nothing is read back until the main loop runs */
+    EXPECT_TRUE (stubBackendUpdatedSettings.empty ());
+
+    RunMainLoop ();
+
+    ASSERT_EQ (2, stubBackendUpdatedSettings.size ());
+    EXPECT_EQ (1, std::count (stubBackendUpdatedSettings.begin (),
+			      stubBackendUpdatedSettings.end (),
+			      integerSetting.get ()));
+    EXPECT_EQ (1, std::count (stubBackendUpdatedSettings.begin (),
+			      stubBackendUpdatedSettings.end (),
+			      booleanSetting.get ()));
+
+    /* The queue is empty again */
+    RunMainLoop ();
+    EXPECT_EQ (2, stubBackendUpdatedSettings.size ());
+}
+
+TEST_F (CCSGSettingsTestCCSGSettingsBackendWithMemoryBackend, TestChangedKeysOfUnknownSchemaAreDropped)
+{
+    ccsGSettingsBackendQueueChangedKey (stubBackend.get (),
+					"org.compiz.unknown",
+					"integer-setting");
+
+    RunMainLoop ();
+
+    EXPECT_TRUE (stubBackendUpdatedSettings.empty ());
+}
+
+TEST_F (CCSGSettingsTestCCSGSettingsBackendWithMemoryBackend, TestWritesBetweenWriteInitAndWriteDoneApplyTogether)
+{
+    ccsGSettingsBackendDelayWrites (stubBackend.get ());
+
+    GetMockPluginWrapper ();
+
+    g_settings_set_int (settings, "integer-setting", 2);
+    g_settings_set_boolean (settings, "boolean-setting", TRUE);
+
+    /* Nothing reaches the settings backend yet */
+    EXPECT_TRUE (g_settings_get_has_unapplied (settings));
+    EXPECT_EQ (0, g_settings_get_int (observer, "integer-setting"));
+    EXPECT_FALSE (g_settings_get_boolean (observer, "boolean-setting"));
+
+    ccsGSettingsBackendApplyWrites (stubBackend.get ());
+
+    EXPECT_FALSE (g_settings_get_has_unapplied (settings));
+    EXPECT_EQ (2, g_settings_get_int (observer, "integer-setting"));
+    EXPECT_TRUE (g_settings_get_boolean (observer, "boolean-setting"));
+}
+
+TEST_F (CCSGSettingsTestCCSGSettingsBackendWithMemoryBackend, TestWritesOutsideWritePassAreNotDelayed)
+{
+    GetMockPluginWrapper ();
+
+    g_settings_set_int (settings, "integer-setting", 3);
+
+    EXPECT_FALSE (g_settings_get_has_unapplied (settings));
+    EXPECT_EQ (3, g_settings_get_int (observer, "integer-setting"));
+}
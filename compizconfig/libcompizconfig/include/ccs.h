@@ -154,6 +154,11 @@ typedef Bool (*CCSContextCheckForSettingsUpgrade) (CCSContext *context);
 typedef void (*CCSContextLoadPlugins) (CCSContext *context);
 typedef void (*CCSContextDestructor) (CCSContext *context);
 
+/* Called whenever a setting is added to an empty list of changed
+ * settings, so that the changes can be picked up without polling */
+typedef void (*CCSContextChangedSettingsNotify) (CCSContext *context, void *data);
+typedef void (*CCSContextSetChangedSettingsNotifyProc) (CCSContext *context, CCSContextChangedSettingsNotify notify, void *data);
+
 struct _CCSContextInterface
 {
     CCSContextGetPluginsProc contextGetPlugins;
@@ -191,6 +196,7 @@ struct _CCSContextInterface
     CCSContextCheckForSettingsUpgrade contextCheckForSettingsUpgrade;
     CCSContextLoadPlugins contextLoadPlugins;
     CCSContextDestructor contextDestructor;
+    CCSContextSetChangedSettingsNotifyProc contextSetChangedSettingsNotify;
 };
 
 unsigned int ccsCCSContextInterfaceGetType ();
@@ -206,6 +212,10 @@ CCSSettingList ccsContextStealChangedSettings (CCSContext *context);
 void * ccsContextGetPrivatePtr (CCSContext *context);
 void ccsContextSetPrivatePtr (CCSContext *context, void *ptr);
 
+void ccsContextSetChangedSettingsNotify (CCSContext                      *context,
+					 CCSContextChangedSettingsNotify notify,
+					 void                            *data);
+
 /* only for bindings */
 void * ccsContextGetPluginsBindable (CCSContext *context);
 void * ccsContextStealChangedSettingsBindable (CCSContext *context);
@@ -968,6 +978,11 @@ void ccsRemoveFileWatch (unsigned int watchId);
 void ccsDisableFileWatch (unsigned int watchId);
 void ccsEnableFileWatch (unsigned int watchId);
 
+/* Returns the file descriptor which becomes readable when a watched
+ * file changes, or -1 if there is none. It may change when the last
+ * watch is removed, ccsProcessEvents handles the events on it */
+int ccsGetFileWatchFd (void);
+
 /* INI file stuff
  * FIXME: This should not be part of the
  * public API */
@@ -54,6 +54,9 @@ typedef struct _CCSContextPrivate
     CCSSettingList    changedSettings; /* list of settings changed since last
                                           settings write */
 
+    CCSContextChangedSettingsNotify changedSettingsNotify;
+    void                            *changedSettingsNotifyData;
+
     unsigned int screenNum; /* screen number this context is assigned to */
     const CCSInterfaceTable *object_interfaces;
 
@@ -95,6 +95,16 @@ void ccsCheckFileWatches (void)
 #endif
 }
 
+int ccsGetFileWatchFd (void)
+{
+#if HAVE_SYS_INOTIFY_H
+    if (inotifyFd)
+	return inotifyFd;
+#endif
+
+    return -1;
+}
+
 unsigned int ccsAddFileWatch (const char            *fileName,
 			      Bool                  enable,
 			      FileWatchCallbackProc callback,
@@ -418,12 +418,27 @@ static Bool
 ccsContextAddChangedSettingDefault (CCSContext *context, CCSSetting *setting)
 {
     CCSContextPrivate *cPrivate = GET_PRIVATE (CCSContextPrivate, context);
+    Bool              wasEmpty = !cPrivate->changedSettings;
 
     cPrivate->changedSettings = ccsSettingListAppend (cPrivate->changedSettings, setting);
 
+    if (wasEmpty && cPrivate->changedSettingsNotify)
+	(*cPrivate->changedSettingsNotify) (context, cPrivate->changedSettingsNotifyData);
+
     return TRUE;
 }
 
+static void
+ccsContextSetChangedSettingsNotifyDefault (CCSContext                      *context,
+					   CCSContextChangedSettingsNotify notify,
+					   void                            *data)
+{
+    CCSContextPrivate *cPrivate = GET_PRIVATE (CCSContextPrivate, context);
+
+    cPrivate->changedSettingsNotify     = notify;
+    cPrivate->changedSettingsNotifyData = data;
+}
+
 static Bool
 ccsContextClearChangedSettingsDefault (CCSContext *context)
 {
@@ -499,6 +514,14 @@ ccsContextSetPrivatePtr (CCSContext *context, void *ptr)
     (*(GET_INTERFACE (CCSContextInterface, context))->contextSetPrivatePtr) (context, ptr);
 }
 
+void
+ccsContextSetChangedSettingsNotify (CCSContext                      *context,
+				    CCSContextChangedSettingsNotify notify,
+				    void                            *data)
+{
+    (*(GET_INTERFACE (CCSContextInterface, context))->contextSetChangedSettingsNotify) (context, notify, data);
+}
+
 void *
 ccsContextGetPluginsBindable (CCSContext *context)
 {
@@ -6055,7 +6078,8 @@ const CCSContextInterface ccsDefaultContextInterface =
     ccsDeleteProfileDefault,
     ccsCheckForSettingsUpgradeDefault,
     ccsLoadPluginsDefault,
-    ccsFreeContextDefault
+    ccsFreeContextDefault,
+    ccsContextSetChangedSettingsNotifyDefault
 };
 
 static const CCSSettingInterface ccsDefaultSettingInterface =
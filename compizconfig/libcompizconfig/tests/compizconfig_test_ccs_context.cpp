@@ -1,3 +1,8 @@
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <poll.h>
+
 #include <boost/shared_ptr.hpp>
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -19,6 +24,7 @@
 #include "compizconfig_ccs_backend_loader_mock.h"
 #include "compizconfig_ccs_backend_mock.h"
 #include "compizconfig_ccs_context_mock.h"
+#include "compizconfig_ccs_setting_mock.h"
 
 using ::testing::_;
 using ::testing::AtLeast;
@@ -69,6 +75,7 @@ TEST_F(CCSContextTest, TestMock)
     EXPECT_CALL (*mock, canDisablePlugin (_));
     EXPECT_CALL (*mock, getExistingProfiles ());
     EXPECT_CALL (*mock, deleteProfile (_));
+    EXPECT_CALL (*mock, setChangedSettingsNotify (_, _));
 
     char *foo = strdup ("foo");
     char *bar = strdup ("bar");
@@ -105,6 +112,7 @@ TEST_F(CCSContextTest, TestMock)
     ccsCanDisablePlugin (context, NULL);
     ccsGetExistingProfiles (context);
     ccsDeleteProfile (context, foo);
+    ccsContextSetChangedSettingsNotify (context, NULL, NULL);
 
     free (foo);
     free (bar);
@@ -361,3 +369,97 @@ TEST_F (CCSContextTestWithMockedBackendProfile, NoImportProfileIfNotInDir)
 
     ccsSetProfile (context.get (), unavailableProfileStr.c_str ());
 }
+
+namespace
+{
+    struct ChangedSettingsWatch
+    {
+	CCSContext   *context;
+	CCSSetting   *setting;
+	unsigned int notified;
+    };
+
+    void
+    countChangedSettingsNotify (CCSContext *context,
+				void       *data)
+    {
+	++(static_cast <ChangedSettingsWatch *> (data))->notified;
+    }
+
+    /* What a backend does when the file it reads from changed */
+    void
+    markSettingChanged (unsigned int watchId,
+			void         *closure)
+    {
+	ChangedSettingsWatch *watch = static_cast <ChangedSettingsWatch *> (closure);
+
+	ccsContextAddChangedSetting (watch->context, watch->setting);
+    }
+
+    void
+    touch (const char *fileName)
+    {
+	FILE *file = fopen (fileName, "a");
+
+	ASSERT_TRUE (file);
+	fputs ("changed\n", file);
+	fclose (file);
+    }
+}
+
+TEST_F (CCSContextTestWithMockedBackendProfile, ChangedSettingsNotifyFiresOnFileWatchChange)
+{
+    boost::shared_ptr <CCSSetting> setting (ccsMockSettingNew (),
+					    ccsSettingUnref);
+    char                 fileName[] = "/tmp/compizconfig-filewatch-XXXXXX";
+    int                  fd = mkstemp (fileName);
+    ChangedSettingsWatch watch = { context.get (), setting.get (), 0 };
+
+    ASSERT_NE (-1, fd);
+    close (fd);
+
+    EXPECT_CALL (*mockBackend, executeEvents (_)).Times (AtLeast (0));
+
+    ccsContextSetChangedSettingsNotify (context.get (),
+					countChangedSettingsNotify,
+					&watch);
+
+    unsigned int watchId = ccsAddFileWatch (fileName, TRUE,
+					    markSettingChanged, &watch);
+    int          watchFd = ccsGetFileWatchFd ();
+
+    if (watchFd < 0)
+    {
+	/* Built without inotify, nothing to watch */
+	ccsRemoveFileWatch (watchId);
+	unlink (fileName);
+	return;
+    }
+
+    touch (fileName);
+
+    struct pollfd pfd = { watchFd, POLLIN, 0 };
+
+    ASSERT_EQ (1, poll (&pfd, 1, 1000));
+
+    ccsProcessEvents (context.get (), ProcessEventsNoGlibMainLoopMask);
+    EXPECT_EQ (1, watch.notified);
+
+    /* Only the first change to an empty list is reported */
+    touch (fileName);
+    ASSERT_EQ (1, poll (&pfd, 1, 1000));
+    ccsProcessEvents (context.get (), ProcessEventsNoGlibMainLoopMask);
+    EXPECT_EQ (1, watch.notified);
+
+    ccsSettingListFree (ccsContextStealChangedSettings (context.get ()), FALSE);
+
+    touch (fileName);
+    ASSERT_EQ (1, poll (&pfd, 1, 1000));
+    ccsProcessEvents (context.get (), ProcessEventsNoGlibMainLoopMask);
+    EXPECT_EQ (2, watch.notified);
+
+    ccsContextSetChangedSettingsNotify (context.get (), NULL, NULL);
+    ccsContextClearChangedSettings (context.get ());
+    ccsRemoveFileWatch (watchId);
+    unlink (fileName);
+}
@@ -41,7 +41,8 @@ CCSContextInterface CCSContextGMockInterface =
     CCSContextGMock::ccsDeleteProfile,
     CCSContextGMock::ccsCheckForSettingsUpgrade,
     CCSContextGMock::ccsLoadPlugins,
-    CCSContextGMock::ccsFreeContext
+    CCSContextGMock::ccsFreeContext,
+    CCSContextGMock::ccsContextSetChangedSettingsNotify
 };
 
 CCSContext *
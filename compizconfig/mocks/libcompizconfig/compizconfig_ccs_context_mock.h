@@ -49,6 +49,7 @@ class CCSContextGMockInterface
 	virtual CCSStringList getExistingProfiles () = 0;
 	virtual Bool checkForSettingsUpgrade () = 0;
 	virtual void loadPlugins () = 0;
+	virtual void setChangedSettingsNotify (CCSContextChangedSettingsNotify notify, void *data) = 0;
 };
 
 class CCSContextGMock :
@@ -97,6 +98,7 @@ class CCSContextGMock :
 	MOCK_METHOD0 (getExistingProfiles, CCSStringList ());
 	MOCK_METHOD0 (checkForSettingsUpgrade, Bool ());
 	MOCK_METHOD0 (loadPlugins, void ());
+	MOCK_METHOD2 (setChangedSettingsNotify, void (CCSContextChangedSettingsNotify, void *));
 
     private:
 
@@ -348,6 +350,14 @@ class CCSContextGMock :
 	    return ((CCSContextGMock *) ccsObjectGetPrivate (context))->loadPlugins ();
 	}
 
+	static void
+	ccsContextSetChangedSettingsNotify (CCSContext                      *context,
+					    CCSContextChangedSettingsNotify notify,
+					    void                            *data)
+	{
+	    ((CCSContextGMock *) ccsObjectGetPrivate (context))->setChangedSettingsNotify (notify, data);
+	}
+
 	static void
 	ccsFreeContext (CCSContext *context)
 	{
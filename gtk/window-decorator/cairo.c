@@ -131,6 +131,124 @@ fill_rounded_rectangle (cairo_t       *cr,
     cairo_pattern_destroy (pattern);
 }
 
+/*
+ * The shadow around a decoration only depends on the shadow, the
+ * context and the layout, but filling it in takes a stretched
+ * composite for every side. The most recently used ones are rendered
+ * once and copied box by box into decorations that share them.
+ */
+#define SHADOW_BACKGROUND_CACHE_SIZE 8
+
+typedef struct _shadow_background {
+    decor_shadow_t  *shadow;
+    decor_context_t context;
+    decor_layout_t  layout;
+    Pixmap	    pixmap;
+    Picture	    picture;
+    unsigned int    age;
+} shadow_background_t;
+
+static shadow_background_t shadow_backgrounds[SHADOW_BACKGROUND_CACHE_SIZE];
+static unsigned int	   shadow_background_age = 0;
+
+static void
+shadow_background_free (Display		    *xdisplay,
+			shadow_background_t *background)
+{
+    XRenderFreePicture (xdisplay, background->picture);
+    XFreePixmap (xdisplay, background->pixmap);
+    decor_shadow_destroy (xdisplay, background->shadow);
+
+    background->shadow = NULL;
+}
+
+static Picture
+get_shadow_background (Display	       *xdisplay,
+		       decor_shadow_t  *s,
+		       decor_context_t *c,
+		       decor_layout_t  *layout)
+{
+    static XRenderColor clear = { 0x0000, 0x0000, 0x0000, 0x0000 };
+    shadow_background_t *background = &shadow_backgrounds[0];
+    XRenderPictFormat	*format;
+    int			i;
+
+    for (i = 0; i < SHADOW_BACKGROUND_CACHE_SIZE; ++i)
+    {
+	shadow_background_t *entry = &shadow_backgrounds[i];
+
+	if (entry->shadow == s					  &&
+	    memcmp (&entry->context, c, sizeof (*c)) == 0	  &&
+	    memcmp (&entry->layout, layout, sizeof (*layout)) == 0)
+	{
+	    entry->age = ++shadow_background_age;
+	    return entry->picture;
+	}
+
+	/* replace the least recently used entry */
+	if (background->shadow &&
+	    (!entry->shadow || entry->age < background->age))
+	    background = entry;
+    }
+
+    if (layout->width <= 0 || layout->height <= 0)
+	return None;
+
+    if (background->shadow)
+	shadow_background_free (xdisplay, background);
+
+    format = XRenderFindStandardFormat (xdisplay, PictStandardARGB32);
+
+    background->pixmap = XCreatePixmap (xdisplay,
+					gdk_x11_get_default_root_xwindow (),
+					layout->width, layout->height, 32);
+    background->picture = XRenderCreatePicture (xdisplay, background->pixmap,
+						format, 0, NULL);
+
+    /* whatever the shadow doesn't cover stays transparent */
+    XRenderFillRectangle (xdisplay, PictOpSrc, background->picture, &clear,
+			  0, 0, layout->width, layout->height);
+
+    decor_fill_picture_extents_with_shadow (xdisplay, s, c,
+					    background->picture, layout);
+
+    decor_shadow_reference (s);
+
+    background->shadow  = s;
+    background->context = *c;
+    background->layout  = *layout;
+    background->age     = ++shadow_background_age;
+
+    return background->picture;
+}
+
+static void
+copy_shadow_background_box (Display	*xdisplay,
+			    Picture	src,
+			    Picture	dst,
+			    decor_box_t *box)
+{
+    if (box->x2 <= box->x1 || box->y2 <= box->y1)
+	return;
+
+    XRenderComposite (xdisplay, PictOpSrc, src, None, dst,
+		      box->x1, box->y1,
+		      0, 0,
+		      box->x1, box->y1,
+		      box->x2 - box->x1, box->y2 - box->y1);
+}
+
+void
+flush_shadow_background_cache (void)
+{
+    Display *xdisplay = GDK_DISPLAY_XDISPLAY (gdk_display_get_default ());
+    int	    i;
+
+    for (i = 0; i < SHADOW_BACKGROUND_CACHE_SIZE; ++i)
+	if (shadow_backgrounds[i].shadow)
+	    shadow_background_free (xdisplay, &shadow_backgrounds[i]);
+}
+
 void
 draw_shadow_background (decor_t		*d,
 			cairo_t		*cr,
@@ -138,6 +256,7 @@ draw_shadow_background (decor_t		*d,
 			decor_context_t *c)
 {
     Display *xdisplay = GDK_DISPLAY_XDISPLAY (gdk_display_get_default ());
+    Picture background;
 
     if (!s || !s->picture ||!d->picture)
     {
@@ -146,10 +265,28 @@ draw_shadow_background (decor_t		*d,
     }
     else
     {
-	decor_fill_picture_extents_with_shadow (xdisplay,
-						s, c,
-						d->picture,
-						&d->border_layout);
+	background = get_shadow_background (xdisplay, s, c,
+					    &d->border_layout);
+
+	if (background)
+	{
+	    /* the shadow fills these boxes entirely */
+	    copy_shadow_background_box (xdisplay, background, d->picture,
+					&d->border_layout.top);
+	    copy_shadow_background_box (xdisplay, background, d->picture,
+					&d->border_layout.left);
+	    copy_shadow_background_box (xdisplay, background, d->picture,
+					&d->border_layout.right);
+	    copy_shadow_background_box (xdisplay, background, d->picture,
+					&d->border_layout.bottom);
+	}
+	else
+	{
+	    decor_fill_picture_extents_with_shadow (xdisplay,
+						    s, c,
+						    d->picture,
+						    &d->border_layout);
+	}
     }
 }
 
@@ -290,18 +427,233 @@ button_state_paint (cairo_t	  *cr,
     }
 }
 
-void
-draw_window_decoration (decor_t *d)
+/*
+ * Buttons only depend on their kind, state and colors, so each look is
+ * rendered once into a small surface on the server and composited onto
+ * every decoration showing it. Button positions are whole pixels plus
+ * the offset of the pressed state.
+ */
+#define BUTTON_SPRITE_PAD	 3
+#define BUTTON_SPRITE_SIZE	 (12 + 2 * BUTTON_SPRITE_PAD)
+#define BUTTON_SPRITE_CACHE_SIZE 32
+
+typedef struct _button_sprite {
+    int		    button;
+    gboolean	    maximized;
+    gboolean	    active;
+    guint	    state;
+    double	    x;
+    double	    y;
+    GdkColor	    fg;
+    decor_color_t   color;
+    double	    alpha;
+    cairo_surface_t *surface;
+    unsigned int    age;
+} button_sprite_t;
+
+static button_sprite_t button_sprites[BUTTON_SPRITE_CACHE_SIZE];
+static unsigned int    button_sprite_age = 0;
+
+static gboolean
+button_sprite_matches (button_sprite_t *sprite,
+		       button_sprite_t *key)
+{
+    return sprite->surface				&&
+	sprite->button	    == key->button		&&
+	sprite->maximized   == key->maximized		&&
+	sprite->active	    == key->active		&&
+	sprite->state	    == key->state		&&
+	sprite->x	    == key->x			&&
+	sprite->y	    == key->y			&&
+	sprite->fg.red	    == key->fg.red		&&
+	sprite->fg.green    == key->fg.green		&&
+	sprite->fg.blue	    == key->fg.blue		&&
+	sprite->color.r	    == key->color.r		&&
+	sprite->color.g	    == key->color.g		&&
+	sprite->color.b	    == key->color.b		&&
+	sprite->alpha	    == key->alpha;
+}
+
+static void
+render_button_sprite (button_sprite_t *sprite,
+		      cairo_t	      *target,
+		      GtkStyle	      *style)
+{
+    cairo_t *cr;
+
+    /* similar surfaces start out transparent */
+    sprite->surface =
+	cairo_surface_create_similar (cairo_get_target (target),
+				      CAIRO_CONTENT_COLOR_ALPHA,
+				      BUTTON_SPRITE_SIZE,
+				      BUTTON_SPRITE_SIZE);
+
+    cr = cairo_create (sprite->surface);
+
+    cairo_set_line_width (cr, 2.0);
+
+    if (sprite->button == BUTTON_MAX)
+	cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+
+    cairo_move_to (cr, sprite->x, sprite->y);
+
+    switch (sprite->button) {
+    case BUTTON_CLOSE:
+	draw_close_button (NULL, cr, 3.0);
+	break;
+    case BUTTON_MAX:
+	if (sprite->maximized)
+	    draw_unmax_button (NULL, cr, 4.0);
+	else
+	    draw_max_button (NULL, cr, 4.0);
+	break;
+    case BUTTON_MIN:
+    default:
+	draw_min_button (NULL, cr, 4.0);
+	break;
+    }
+
+    if (sprite->active)
+    {
+	button_state_paint (cr, style, &sprite->color, sprite->state);
+    }
+    else
+    {
+	gdk_cairo_set_source_color_alpha (cr,
+					  &style->fg[GTK_STATE_NORMAL],
+					  sprite->alpha * 0.75);
+	cairo_fill (cr);
+    }
+
+    cairo_destroy (cr);
+}
+
+static cairo_surface_t *
+get_button_sprite (cairo_t	   *target,
+		   GtkStyle	   *style,
+		   button_sprite_t *key)
+{
+    button_sprite_t *sprite = &button_sprites[0];
+    int		    i;
+
+    for (i = 0; i < BUTTON_SPRITE_CACHE_SIZE; ++i)
+    {
+	button_sprite_t *entry = &button_sprites[i];
+
+	if (button_sprite_matches (entry, key))
+	{
+	    entry->age = ++button_sprite_age;
+	    return entry->surface;
+	}
+
+	/* replace the least recently used entry */
+	if (sprite->surface &&
+	    (!entry->surface || entry->age < sprite->age))
+	    sprite = entry;
+    }
+
+    if (sprite->surface)
+	cairo_surface_destroy (sprite->surface);
+
+    *sprite = *key;
+    sprite->age = ++button_sprite_age;
+
+    render_button_sprite (sprite, target, style);
+
+    return sprite->surface;
+}
+
+static void
+draw_button (decor_t	   *d,
+	     cairo_t	   *cr,
+	     GtkStyle	   *style,
+	     decor_color_t *color,
+	     double	   alpha,
+	     int	   button,
+	     gboolean	   maximized,
+	     double	   x,
+	     double	   y)
+{
+    button_sprite_t key;
+    double	    sx, sy;
+
+    memset (&key, 0, sizeof (key));
+
+    key.button	  = button;
+    key.maximized = maximized ? TRUE : FALSE;
+    key.active	  = d->active;
+    key.state	  = d->button_states[button];
+    key.fg	  = style->fg[GTK_STATE_NORMAL];
+    key.color	  = *color;
+
+    /* only inactive buttons are drawn with the decoration alpha */
+    key.alpha = d->active ? 1.0 : alpha;
+
+    button_state_offsets (x, y, key.state, &x, &y);
+
+    sx = floor (x);
+    sy = floor (y);
+
+    key.x = BUTTON_SPRITE_PAD + x - sx;
+    key.y = BUTTON_SPRITE_PAD + y - sy;
+
+    cairo_set_source_surface (cr, get_button_sprite (cr, style, &key),
+			      sx - BUTTON_SPRITE_PAD,
+			      sy - BUTTON_SPRITE_PAD);
+    cairo_paint (cr);
+}
+
+/* Buttons are laid out leftwards from the right edge of the title bar */
+static void
+draw_buttons (decor_t	    *d,
+	      cairo_t	    *cr,
+	      GtkStyle	    *style,
+	      decor_color_t *color,
+	      double	    alpha,
+	      double	    button_y)
+{
+    int button_x = d->width - d->context->right_space - 13;
+
+    if (d->actions & WNCK_WINDOW_ACTION_CLOSE)
+    {
+	draw_button (d, cr, style, color, alpha, BUTTON_CLOSE, FALSE,
+		     button_x, button_y);
+
+	button_x -= 17;
+    }
+
+    if (d->actions & WNCK_WINDOW_ACTION_MAXIMIZE)
+    {
+	draw_button (d, cr, style, color, alpha, BUTTON_MAX,
+		     d->state & (WNCK_WINDOW_STATE_MAXIMIZED_HORIZONTALLY |
+				 WNCK_WINDOW_STATE_MAXIMIZED_VERTICALLY),
+		     button_x, button_y);
+
+	button_x -= 17;
+    }
+
+    if (d->actions & WNCK_WINDOW_ACTION_MINIMIZE)
+	draw_button (d, cr, style, color, alpha, BUTTON_MIN, FALSE,
+		     button_x, button_y);
+}
+
+/*
+ * Draws the decoration, or with area only what falls inside it. Area
+ * must not overlap the shadow, the buttons or the icon, which are
+ * skipped, and is copied to the front buffer on its own.
+ */
+static void
+draw_window_decoration_area (decor_t	  *d,
+			     GdkRectangle *area)
 {
     cairo_t       *cr;
     GtkStyle	  *style;
     GdkDrawable   *drawable;
     decor_color_t color;
     double        alpha;
-    double        x1, y1, x2, y2, x, y, h;
+    double        x1, y1, x2, y2, h;
     int		  corners = SHADE_LEFT | SHADE_RIGHT | SHADE_TOP | SHADE_BOTTOM;
     int		  top;
-    int		  button_x;
 
     if (!d->pixmap)
 	return;
@@ -326,6 +678,12 @@ draw_window_decoration (decor_t *d)
     if (!cr)
 	return;
 
+    if (area)
+    {
+	gdk_cairo_rectangle (cr, area);
+	cairo_clip (cr);
+    }
+
     cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
 
     top = d->frame->win_extents.top + d->frame->titlebar_height;
@@ -339,7 +697,7 @@ draw_window_decoration (decor_t *d)
 
     cairo_set_line_width (cr, 1.0);
 
-    if (!d->frame_window)
+    if (!d->frame_window && !area)
 	draw_shadow_background (d, cr, d->shadow, d->context);
 
     if (d->active)
@@ -518,6 +876,12 @@ draw_window_decoration (decor_t *d)
 
     cairo_reset_clip (cr);
 
+    if (area)
+    {
+	gdk_cairo_rectangle (cr, area);
+	cairo_clip (cr);
+    }
+
     rounded_rectangle (cr,
 		       x1 + 0.5, y1 + 0.5,
 		       x2 - x1 - 1.0, y2 - y1 - 1.0,
@@ -533,111 +897,9 @@ draw_window_decoration (decor_t *d)
 
     cairo_set_line_width (cr, 2.0);
 
-    button_x = d->width - d->context->right_space - 13;
-
-    if (d->actions & WNCK_WINDOW_ACTION_CLOSE)
-    {
-	button_state_offsets (button_x,
-			      y1 - 3.0 + d->frame->titlebar_height / 2,
-			      d->button_states[BUTTON_CLOSE], &x, &y);
-
-	button_x -= 17;
-
-	if (d->active)
-	{
-	    cairo_move_to (cr, x, y);
-	    draw_close_button (d, cr, 3.0);
-	    button_state_paint (cr, style, &color,
-				d->button_states[BUTTON_CLOSE]);
-	}
-	else
-	{
-	    gdk_cairo_set_source_color_alpha (cr,
-					      &style->fg[GTK_STATE_NORMAL],
-					      alpha * 0.75);
-
-	    cairo_move_to (cr, x, y);
-	    draw_close_button (d, cr, 3.0);
-	    cairo_fill (cr);
-	}
-    }
-
-    if (d->actions & WNCK_WINDOW_ACTION_MAXIMIZE)
-    {
-	button_state_offsets (button_x,
-			      y1 - 3.0 + d->frame->titlebar_height / 2,
-			      d->button_states[BUTTON_MAX], &x, &y);
-
-	button_x -= 17;
-
-	cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
-
-	if (d->active)
-	{
-	    gdk_cairo_set_source_color_alpha (cr,
-					      &style->fg[GTK_STATE_NORMAL],
-					      STROKE_ALPHA);
-
-	    cairo_move_to (cr, x, y);
-
-	    if (d->state & (WNCK_WINDOW_STATE_MAXIMIZED_HORIZONTALLY |
-			    WNCK_WINDOW_STATE_MAXIMIZED_VERTICALLY))
-		draw_unmax_button (d, cr, 4.0);
-	    else
-		draw_max_button (d, cr, 4.0);
-
-	    button_state_paint (cr, style, &color,
-				d->button_states[BUTTON_MAX]);
-	}
-	else
-	{
-	    gdk_cairo_set_source_color_alpha (cr,
-					      &style->fg[GTK_STATE_NORMAL],
-					      alpha * 0.75);
-
-	    cairo_move_to (cr, x, y);
-
-	    if (d->state & (WNCK_WINDOW_STATE_MAXIMIZED_HORIZONTALLY |
-			    WNCK_WINDOW_STATE_MAXIMIZED_VERTICALLY))
-		draw_unmax_button (d, cr, 4.0);
-	    else
-		draw_max_button (d, cr, 4.0);
-
-	    cairo_fill (cr);
-	}
-    }
-
-    if (d->actions & WNCK_WINDOW_ACTION_MINIMIZE)
-    {
-	button_state_offsets (button_x,
-			      y1 - 3.0 + d->frame->titlebar_height / 2,
-			      d->button_states[BUTTON_MIN], &x, &y);
-
-	button_x -= 17;
-
-	if (d->active)
-	{
-	    gdk_cairo_set_source_color_alpha (cr,
-					      &style->fg[GTK_STATE_NORMAL],
-					      STROKE_ALPHA);
-
-
-	    cairo_move_to (cr, x, y);
-	    draw_min_button (d, cr, 4.0);
-	    button_state_paint (cr, style, &color,
-				d->button_states[BUTTON_MIN]);
-	}
-	else
-	{
-	    gdk_cairo_set_source_color_alpha (cr,
-					      &style->fg[GTK_STATE_NORMAL],
-					      alpha * 0.75);
-
-	    cairo_move_to (cr, x, y);
-	    draw_min_button (d, cr, 4.0);
-	    cairo_fill (cr);
-	}
-    }
+    if (!area)
+	draw_buttons (d, cr, style, &color, alpha,
+		      y1 - 3.0 + d->frame->titlebar_height / 2);
 
     if (d->layout)
     {
@@ -670,7 +932,7 @@ draw_window_decoration (decor_t *d)
 	pango_cairo_show_layout (cr, d->layout);
     }
 
-    if (d->icon)
+    if (d->icon && !area)
     {
 	cairo_translate (cr, d->context->left_space + 1,
 			 y1 - 5.0 + d->frame->titlebar_height / 2);
@@ -686,6 +948,12 @@ draw_window_decoration (decor_t *d)
 
     cairo_destroy (cr);
 
+    if (area)
+    {
+	copy_area_to_front_buffer (d, area);
+	return;
+    }
+
     copy_to_front_buffer (d);
 
     if (d->frame_window)
@@ -705,6 +973,57 @@ draw_window_decoration (decor_t *d)
     }
 }
 
+void
+draw_window_decoration (decor_t *d)
+{
+    draw_window_decoration_area (d, NULL);
+}
+
+/*
+ * The title text sits on the title bar fill between the icon and the
+ * buttons, that region can be redrawn without touching anything else.
+ * The fill is antialiased along the top edge of the frame, so the
+ * first row is left alone too.
+ */
+static gboolean
+get_title_area (decor_t	     *d,
+		GdkRectangle *area)
+{
+    int y1 = d->context->top_space - d->frame->win_extents.top -
+	     d->frame->titlebar_height;
+    int x2 = d->width - d->context->right_space;
+
+    if (d->actions & WNCK_WINDOW_ACTION_CLOSE)
+	x2 -= 17;
+    if (d->actions & WNCK_WINDOW_ACTION_MAXIMIZE)
+	x2 -= 17;
+    if (d->actions & WNCK_WINDOW_ACTION_MINIMIZE)
+	x2 -= 17;
+
+    area->x	 = d->context->left_space + 18;
+    area->y	 = y1 + 1;
+    area->width	 = x2 - area->x;
+    area->height = d->frame->win_extents.top + d->frame->titlebar_height - 1;
+
+    return area->width > 0 && area->height > 0;
+}
+
+void
+draw_window_decoration_title (decor_t *d)
+{
+    GdkRectangle area;
+
+    /* the decoration property and the reparented frame image are only
+     * updated by full redraws */
+    if (d->frame_window || d->prop_xid || !get_title_area (d, &area))
+    {
+	draw_window_decoration (d);
+	return;
+    }
+
+    draw_window_decoration_area (d, &area);
+}
+
 static void
 calc_button_size (decor_t *d)
 {
@@ -24,6 +24,7 @@
  */
 
 #include "gtk-window-decorator.h"
+#include "gwd-border-shape-util.h"
 
 decor_frame_t *
 create_normal_frame (const gchar *type)
@@ -802,6 +803,48 @@ draw_border_shape (Display	   *xdisplay,
     g_object_unref (G_OBJECT (d.pixmap));
 }
 
+/* corner radius of the rounded corners drawn by the themes */
+#define BORDER_SHAPE_CORNER_RADIUS 5
+
+/*
+ * draw_border_shape_mask
+ * Returns: void
+ * Description: Renders the coverage of draw_border_shape on the
+ * client, so that libdecoration can blur the shadow without reading
+ * the decoration back from the server
+ */
+static void
+draw_border_shape_mask (float		*mask,
+			int		width,
+			int		height,
+			decor_context_t *c,
+			void		*closure)
+{
+    decor_shadow_info_t *info = (decor_shadow_info_t *) closure;
+    int			radius = BORDER_SHAPE_CORNER_RADIUS;
+
+    /* maximized decorations have square corners */
+    if (info && (info->state & (WNCK_WINDOW_STATE_MAXIMIZED_HORIZONTALLY |
+				WNCK_WINDOW_STATE_MAXIMIZED_VERTICALLY)))
+	radius = 0;
+
+    gwd_border_shape_mask (mask, width, height, c, radius);
+}
+
+/*
+ * border_shape_key
+ * Returns: unsigned int
+ * Description: What draw_border_shape draws only depends on the frame
+ * type and the window state in info, as long as the theme and settings
+ * don't change, and update_shadow flushes the cache when they do
+ */
+static unsigned int
+border_shape_key (decor_frame_t       *frame,
+		  decor_shadow_info_t *info)
+{
+    return gwd_border_shape_key (frame->type, info->state, info->active);
+}
+
 
 /*
  * update_shadow
@@ -914,25 +957,27 @@ decor_frame_update_shadow (Display		  *xdisplay,
      *          (third last parameter). So even if you don't want a shadow
      *          then you still need to call decor_shadow_create :(
      */
-    *shadow_normal = decor_shadow_create (xdisplay,
-						 screen,
-						 1, 1,
-						 frame->win_extents.left,
-						 frame->win_extents.right,
-						 frame->win_extents.top + frame->titlebar_height,
-						 frame->win_extents.bottom,
-						 frame->win_extents.left -
-						 TRANSLUCENT_CORNER_SIZE,
-						 frame->win_extents.right -
-						 TRANSLUCENT_CORNER_SIZE,
-						 frame->win_extents.top + frame->titlebar_height -
-						 TRANSLUCENT_CORNER_SIZE,
-						 frame->win_extents.bottom -
-						 TRANSLUCENT_CORNER_SIZE,
-						 opt_shadow,
-						 context_normal,
-						 draw_border_shape,
-						 (void *) info);
+    *shadow_normal = decor_shadow_create_with_mask (xdisplay,
+						    screen,
+						    1, 1,
+						    frame->win_extents.left,
+						    frame->win_extents.right,
+						    frame->win_extents.top + frame->titlebar_height,
+						    frame->win_extents.bottom,
+						    frame->win_extents.left -
+						    TRANSLUCENT_CORNER_SIZE,
+						    frame->win_extents.right -
+						    TRANSLUCENT_CORNER_SIZE,
+						    frame->win_extents.top + frame->titlebar_height -
+						    TRANSLUCENT_CORNER_SIZE,
+						    frame->win_extents.bottom -
+						    TRANSLUCENT_CORNER_SIZE,
+						    opt_shadow,
+						    context_normal,
+						    draw_border_shape,
+						    draw_border_shape_mask,
+						    border_shape_key (frame, info),
+						    (void *) info);
 
     /* Maximized border shadow pixmap mode */
     if (*shadow_max)
@@ -945,22 +990,24 @@ decor_frame_update_shadow (Display		  *xdisplay,
 		   WNCK_WINDOW_STATE_MAXIMIZED_VERTICALLY);
 
     *shadow_max =
-	decor_shadow_create (xdisplay,
-			     screen,
-			     1, 1,
-			     frame->max_win_extents.left,
-			     frame->max_win_extents.right,
-			     frame->max_win_extents.top + frame->max_titlebar_height,
-			     frame->max_win_extents.bottom,
-			     frame->max_win_extents.left - TRANSLUCENT_CORNER_SIZE,
-			     frame->max_win_extents.right - TRANSLUCENT_CORNER_SIZE,
-			     frame->max_win_extents.top + frame->max_titlebar_height -
-			     TRANSLUCENT_CORNER_SIZE,
-			     frame->max_win_extents.bottom - TRANSLUCENT_CORNER_SIZE,
-			     opt_no_shadow,  /* No shadow when maximized */
-			     context_max,
-			     draw_border_shape,
-			     (void *) info);
+	decor_shadow_create_with_mask (xdisplay,
+				       screen,
+				       1, 1,
+				       frame->max_win_extents.left,
+				       frame->max_win_extents.right,
+				       frame->max_win_extents.top + frame->max_titlebar_height,
+				       frame->max_win_extents.bottom,
+				       frame->max_win_extents.left - TRANSLUCENT_CORNER_SIZE,
+				       frame->max_win_extents.right - TRANSLUCENT_CORNER_SIZE,
+				       frame->max_win_extents.top + frame->max_titlebar_height -
+				       TRANSLUCENT_CORNER_SIZE,
+				       frame->max_win_extents.bottom - TRANSLUCENT_CORNER_SIZE,
+				       opt_no_shadow,  /* No shadow when maximized */
+				       context_max,
+				       draw_border_shape,
+				       draw_border_shape_mask,
+				       border_shape_key (frame, info),
+				       (void *) info);
 
     /* Reset info->state */
     info->state = 0;
@@ -1081,6 +1128,10 @@ meta_get_shadow (decor_frame_t *frame, decor_shadow_options_t *opts, gboolean ac
 int
 update_shadow (void)
 {
+    /* Shadows cached for the old settings won't be asked for again */
+    decor_shadow_cache_flush (gdk_x11_get_default_xdisplay ());
+    flush_shadow_background_cache ();
+
     gwd_frames_foreach (update_frames_shadows, NULL);
 
     return 1;
@@ -1282,19 +1333,31 @@ update_window_decoration_actions (WnckWindow *win)
 static gboolean
 draw_decor_list (void *data)
 {
-    GSList  *list;
+    GSList  *list, *queued;
     decor_t *d;
 
     draw_idle_id = 0;
 
-    for (list = draw_list; list; list = list->next)
+    /* The list is built with prepend, so reverse it to draw in the
+     * order requests were queued. Detach it first so that anything
+     * queued from a draw callback gets its own idle pass */
+    queued    = g_slist_reverse (draw_list);
+    draw_list = NULL;
+
+    for (list = queued; list; list = list->next)
     {
 	d = (decor_t *) list->data;
-	(*d->draw) (d);
+	d->draw_queued = FALSE;
+
+	if (d->draw_title_only && d->draw == draw_window_decoration)
+	    draw_window_decoration_title (d);
+	else
+	    (*d->draw) (d);
+
+	d->draw_title_only = FALSE;
     }
 
-    g_slist_free (draw_list);
-    draw_list = NULL;
+    g_slist_free (queued);
 
     return FALSE;
 }
@@ -1305,20 +1368,42 @@ draw_decor_list (void *data)
  * Description :queue a redraw request for this decoration. Since this function
  * only gets called on idle, don't redraw window decorations multiple
  * times if they are already waiting to be drawn (since the drawn copy
- * will always be the most updated one)
+ * will always be the most updated one). Membership is tracked with
+ * a flag on the decoration so that queueing stays O(1) per window
  */
 void
 queue_decor_draw (decor_t *d)
 {
-    if (g_slist_find (draw_list, d))
+    d->draw_title_only = FALSE;
+
+    if (d->draw_queued)
 	return;
 
-    draw_list = g_slist_append (draw_list, d);
+    d->draw_queued = TRUE;
+    draw_list = g_slist_prepend (draw_list, d);
 
     if (!draw_idle_id)
 	draw_idle_id = g_idle_add (draw_decor_list, NULL);
 }
 
+/*
+ * queue_decor_draw_title
+ *
+ * Description: queue a redraw of only the title of this decoration,
+ * for when nothing but the window name changed. Themes which can't
+ * redraw the title on its own get a full redraw, and so does a
+ * decoration which already has one queued
+ */
+void
+queue_decor_draw_title (decor_t *d)
+{
+    if (d->draw_queued)
+	return;
+
+    queue_decor_draw (d);
+    d->draw_title_only = TRUE;
+}
+
 /*
  * update_default_decorations
  *
@@ -1503,3 +1588,21 @@ copy_to_front_buffer (decor_t *d)
     gdk_cairo_set_source_pixmap (d->cr, d->buffer_pixmap, 0, 0);
     cairo_paint (d->cr);
 }
+
+/*
+ * copy_area_to_front_buffer
+ *
+ * Description: Like copy_to_front_buffer, but only uploads area
+ */
+void
+copy_area_to_front_buffer (decor_t	*d,
+			   GdkRectangle *area)
+{
+    if (!d->buffer_pixmap)
+	return;
+
+    cairo_set_operator (d->cr, CAIRO_OPERATOR_SOURCE);
+    gdk_cairo_set_source_pixmap (d->cr, d->buffer_pixmap, 0, 0);
+    gdk_cairo_rectangle (d->cr, area);
+    cairo_fill (d->cr);
+}
@@ -429,6 +429,8 @@ main (int argc, char *argv[])
     gwd_decor_frame_unref (bare_p);
     gwd_decor_frame_unref (switcher_p);
 
+    decor_shadow_cache_flush (xdisplay);
+
     fini_settings ();
 
     return 0;
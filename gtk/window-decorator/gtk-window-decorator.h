@@ -421,6 +421,8 @@ typedef struct _decor {
     XID		      prop_xid;
     GtkWidget	      *force_quit_dialog;
     Bool	      created;
+    gboolean	      draw_queued;
+    gboolean	      draw_title_only;
     void	      (*draw) (struct _decor *d);
 } decor_t;
 
@@ -635,9 +637,16 @@ update_window_decoration (WnckWindow *win);
 void
 queue_decor_draw (decor_t *d);
 
+void
+queue_decor_draw_title (decor_t *d);
+
 void
 copy_to_front_buffer (decor_t *d);
 
+void
+copy_area_to_front_buffer (decor_t	*d,
+			   GdkRectangle *area);
+
 /* wnck.c*/
 
 const gchar *
@@ -717,6 +726,12 @@ draw_shadow_background (decor_t		*d,
 void
 draw_window_decoration (decor_t *d);
 
+void
+draw_window_decoration_title (decor_t *d);
+
+void
+flush_shadow_background_cache (void);
+
 void
 fill_rounded_rectangle (cairo_t       *cr,
 			double        x,
@@ -0,0 +1,94 @@
+/*
+ * Copyright © 2026 Compiz authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+#include <math.h>
+#include <decoration.h>
+#include "gwd-border-shape-util.h"
+
+static float
+corner_coverage (float x,
+		 float y,
+		 float cx,
+		 float cy,
+		 int   radius)
+{
+    float dx = x - cx;
+    float dy = y - cy;
+    float coverage = radius - sqrtf (dx * dx + dy * dy) + 0.5f;
+
+    return MIN (1.0f, MAX (0.0f, coverage));
+}
+
+void
+gwd_border_shape_mask (float	       *mask,
+		       int	       width,
+		       int	       height,
+		       decor_context_t *c,
+		       int	       radius)
+{
+    int x, y;
+    int x1 = c->left_space - c->extents.left;
+    int y1 = c->top_space - c->extents.top;
+    int x2 = width - c->right_space + c->extents.right;
+    int y2 = height - c->bottom_space + c->extents.bottom;
+
+    radius = MAX (0, MIN (radius, MIN (x2 - x1, y2 - y1) / 2));
+
+    for (y = 0; y < height; ++y)
+    {
+	for (x = 0; x < width; ++x)
+	{
+	    /* sample at the pixel center */
+	    float px = x + 0.5f;
+	    float py = y + 0.5f;
+	    float v  = 0.0f;
+
+	    if (x >= x1 && x < x2 && y >= y1 && y < y2)
+	    {
+		v = 1.0f;
+
+		if (x < x1 + radius && y < y1 + radius)
+		    v = corner_coverage (px, py, x1 + radius, y1 + radius,
+					 radius);
+		else if (x >= x2 - radius && y < y1 + radius)
+		    v = corner_coverage (px, py, x2 - radius, y1 + radius,
+					 radius);
+		else if (x < x1 + radius && y >= y2 - radius)
+		    v = corner_coverage (px, py, x1 + radius, y2 - radius,
+					 radius);
+		else if (x >= x2 - radius && y >= y2 - radius)
+		    v = corner_coverage (px, py, x2 - radius, y2 - radius,
+					 radius);
+	    }
+
+	    mask[y * width + x] = v;
+	}
+    }
+}
+
+unsigned int
+gwd_border_shape_key (const gchar  *frame_type,
+		      unsigned int state,
+		      gboolean     active)
+{
+    unsigned int key = frame_type ? g_str_hash (frame_type) : 0;
+
+    key = key * 31 + state;
+    key = key * 31 + (active ? 1 : 0);
+
+    return key;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright © 2026 Compiz authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+#ifndef _GWD_BORDER_SHAPE_UTIL_H
+#define _GWD_BORDER_SHAPE_UTIL_H
+
+#include <glib.h>
+#include <decoration.h>
+
+G_BEGIN_DECLS
+
+/* Coverage of a frame drawn over the extents of c with corners
+ * rounded by radius, as passed to decor_shadow_create_with_mask */
+void
+gwd_border_shape_mask (float	       *mask,
+		       int	       width,
+		       int	       height,
+		       decor_context_t *c,
+		       int	       radius);
+
+/* Shadow cache key for the border shape of a frame type in the
+ * given window state */
+unsigned int
+gwd_border_shape_key (const gchar  *frame_type,
+		      unsigned int state,
+		      gboolean     active);
+
+G_END_DECLS
+
+#endif
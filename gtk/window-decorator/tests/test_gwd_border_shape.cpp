@@ -0,0 +1,157 @@
+/*
+ * Copyright © 2026 Compiz authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <vector>
+#include <gtest/gtest.h>
+#include <decoration.h>
+
+#include "gwd-border-shape-util.h"
+
+namespace
+{
+    /* 4px of shadow space around 6px extents,
+     * 1px of window in between */
+    const int SPACE = 10;
+    const int EXTENT = 6;
+    const int WIDTH = SPACE * 2 + 1;
+    const int HEIGHT = SPACE * 2 + 1;
+
+    decor_context_t
+    makeContext ()
+    {
+	decor_context_t c;
+
+	memset (&c, 0, sizeof (c));
+
+	c.extents.left   = EXTENT;
+	c.extents.right  = EXTENT;
+	c.extents.top    = EXTENT;
+	c.extents.bottom = EXTENT;
+
+	c.left_space   = SPACE;
+	c.right_space  = SPACE;
+	c.top_space    = SPACE;
+	c.bottom_space = SPACE;
+
+	return c;
+    }
+}
+
+class GWDBorderShapeTest :
+    public ::testing::Test
+{
+    public:
+
+	GWDBorderShapeTest () :
+	    context (makeContext ()),
+	    mask (WIDTH * HEIGHT, -1.0f)
+	{
+	}
+
+	float at (int x, int y) const
+	{
+	    return mask[y * WIDTH + x];
+	}
+
+	decor_context_t      context;
+	std::vector <float> mask;
+};
+
+TEST_F (GWDBorderShapeTest, SquareShapeCoversExtents)
+{
+    gwd_border_shape_mask (&mask[0], WIDTH, HEIGHT, &context, 0);
+
+    const int x1 = SPACE - EXTENT;
+    const int x2 = WIDTH - SPACE + EXTENT;
+
+    for (int y = 0; y < HEIGHT; ++y)
+	for (int x = 0; x < WIDTH; ++x)
+	{
+	    bool inside = x >= x1 && x < x2 && y >= x1 && y < x2;
+
+	    EXPECT_FLOAT_EQ (inside ? 1.0f : 0.0f, at (x, y));
+	}
+}
+
+TEST_F (GWDBorderShapeTest, RoundedCornersArePartiallyCovered)
+{
+    gwd_border_shape_mask (&mask[0], WIDTH, HEIGHT, &context, 5);
+
+    const int x1 = SPACE - EXTENT;
+    const int x2 = WIDTH - SPACE + EXTENT - 1;
+
+    /* the corner pixels fall outside the arc */
+    EXPECT_FLOAT_EQ (0.0f, at (x1, x1));
+    EXPECT_FLOAT_EQ (0.0f, at (x2, x1));
+    EXPECT_FLOAT_EQ (0.0f, at (x1, x2));
+    EXPECT_FLOAT_EQ (0.0f, at (x2, x2));
+
+    /* edges next to the corner are antialiased */
+    EXPECT_GT (at (x1, x1 + 2), 0.0f);
+    EXPECT_LT (at (x1, x1 + 2), 1.0f);
+
+    /* while the middle of the edges is solid */
+    EXPECT_FLOAT_EQ (1.0f, at (x1, SPACE));
+    EXPECT_FLOAT_EQ (1.0f, at (SPACE, x1));
+    EXPECT_FLOAT_EQ (1.0f, at (SPACE, SPACE));
+
+    /* and the shadow space stays empty */
+    EXPECT_FLOAT_EQ (0.0f, at (x1 - 1, SPACE));
+    EXPECT_FLOAT_EQ (0.0f, at (SPACE, x2 + 1));
+}
+
+TEST_F (GWDBorderShapeTest, RoundedCornersAreSymmetric)
+{
+    gwd_border_shape_mask (&mask[0], WIDTH, HEIGHT, &context, 5);
+
+    for (int y = 0; y < HEIGHT; ++y)
+	for (int x = 0; x < WIDTH; ++x)
+	{
+	    EXPECT_FLOAT_EQ (at (x, y), at (WIDTH - 1 - x, y));
+	    EXPECT_FLOAT_EQ (at (x, y), at (x, HEIGHT - 1 - y));
+	}
+}
+
+TEST_F (GWDBorderShapeTest, RadiusIsClampedToTheShape)
+{
+    gwd_border_shape_mask (&mask[0], WIDTH, HEIGHT, &context, 100);
+
+    for (int y = 0; y < HEIGHT; ++y)
+	for (int x = 0; x < WIDTH; ++x)
+	{
+	    EXPECT_GE (at (x, y), 0.0f);
+	    EXPECT_LE (at (x, y), 1.0f);
+	}
+
+    EXPECT_FLOAT_EQ (1.0f, at (SPACE, SPACE));
+}
+
+TEST (GWDBorderShapeKeyTest, SameFrameAndStateShareAKey)
+{
+    EXPECT_EQ (gwd_border_shape_key ("normal", 0, TRUE),
+	       gwd_border_shape_key ("normal", 0, TRUE));
+}
+
+TEST (GWDBorderShapeKeyTest, KeyDependsOnFrameStateAndActivity)
+{
+    unsigned int normal = gwd_border_shape_key ("normal", 0, TRUE);
+
+    EXPECT_NE (normal, gwd_border_shape_key ("dialog", 0, TRUE));
+    EXPECT_NE (normal, gwd_border_shape_key ("normal", 1, TRUE));
+    EXPECT_NE (normal, gwd_border_shape_key ("normal", 0, FALSE));
+}
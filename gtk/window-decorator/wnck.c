@@ -93,7 +93,7 @@ window_name_changed (WnckWindow *win)
     if (d->decorated)
     {
 	if (!request_update_window_decoration_size (win))
-	    queue_decor_draw (d);
+	    queue_decor_draw_title (d);
     }
 }
 
@@ -591,7 +591,13 @@ remove_frame_window (WnckWindow *win)
     d->context = NULL;
     d->shadow  = NULL;
 
-    draw_list = g_slist_remove (draw_list, d);
+    if (d->draw_queued)
+    {
+	draw_list = g_slist_remove (draw_list, d);
+	d->draw_queued = FALSE;
+    }
+
+    d->draw_title_only = FALSE;
 }
 
 void
@@ -5,6 +5,6 @@
 #  error Conflicting definitions of CORE_ABIVERSION
 #endif
 
-#define CORE_ABIVERSION 20140123
+#define CORE_ABIVERSION 20261021
 
 #endif // COMPIZ_ABIVERSION_H
@@ -51,6 +51,19 @@ class CompMatch {
 		virtual bool evaluate (const CompWindow *window) const = 0;
 	};
 
+	/**
+	 * Counters describing how much work match evaluation did.
+	 * Expression results are cached per window until
+	 * CompScreen::matchPropertyChanged is called for it, so
+	 * expressionEvaluations is usually far lower than evaluations.
+	 */
+	struct Statistics {
+	    unsigned long events;
+	    unsigned long evaluations;
+	    unsigned long expressionEvaluations;
+	    unsigned long cacheHits;
+	};
+
     public:
 	CompMatch ();
 	CompMatch (const CompString);
@@ -88,6 +101,13 @@ class CompMatch {
 	bool operator== (const CompMatch &) const;
 	bool operator!= (const CompMatch &) const;
 
+	/**
+	 * Returns the match evaluation counters accumulated since
+	 * startup or the last resetStatistics ()
+	 */
+	static const Statistics & statistics ();
+	static void resetStatistics ();
+
     private:
 	PrivateMatch *priv;
 };
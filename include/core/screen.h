@@ -47,6 +47,15 @@ class CoreWindow;
 class CoreOptions;
 class ServerGrabInterface;
 
+namespace compiz
+{
+namespace core
+{
+class ThreadPool;
+class TaskHandle;
+}
+}
+
 typedef std::list<CompWindow *> CompWindowList;
 typedef std::vector<CompWindow *> CompWindowVector;
 
@@ -82,6 +91,7 @@ extern unsigned int pointerMods;
 
 typedef boost::function<void (short int)> FdWatchCallBack;
 typedef boost::function<void (const char *)> FileWatchCallBack;
+typedef boost::function<void ()> MainLoopCallBack;
 
 typedef int CompFileWatchHandle;
 typedef int CompWatchFdHandle;
@@ -333,10 +343,26 @@ public:
     virtual bool hasValue (CompString key) = 0;
     virtual CompPrivate getValue (CompString key) = 0;
     virtual void eraseValue (CompString key) = 0;
+
+    /* Watches with POLLNVAL in events are told when fd was closed
+     * behind their back, they are removed after that callback */
     virtual CompWatchFdHandle addWatchFd (int             fd,
 				      short int       events,
 				      FdWatchCallBack callBack) = 0;
     virtual void removeWatchFd (CompWatchFdHandle handle) = 0;
+
+    /* Runs callBack on the main loop thread soon after. Unlike
+     * everything else here, this may be called from any thread */
+    virtual void postToMainLoop (const MainLoopCallBack &callBack) = 0;
+
+    /* Runs work on a worker thread, then continuation on the main
+     * loop unless the task was cancelled meanwhile. Tasks owned by
+     * a window are cancelled when it is destroyed. The returned
+     * handle and the pool are declared in core/threadpool.h */
+    virtual compiz::core::TaskHandle runTask (const MainLoopCallBack &work,
+					      const MainLoopCallBack &continuation,
+					      CompWindow             *owner) = 0;
+    virtual compiz::core::ThreadPool & threadPool () = 0;
     virtual void eventLoop () = 0;
 
     virtual CompFileWatchHandle addFileWatch (const char        *path,
@@ -405,6 +431,11 @@ public:
     virtual void updatePassiveKeyGrabs () const = 0;
     virtual void applyStartupProperties (CompWindow *window) = 0;
     virtual void updateClientList() = 0;
+
+    /* Negative if a is stacked below b, positive if it is above and
+     * zero if they are the same window or either is not in the stack.
+     * Does not walk the window list */
+    virtual int compareStacking (const CompWindow *a, const CompWindow *b) const = 0;
     virtual CompWindow * getTopWindow() const = 0;
     virtual CompWindow * getTopServerWindow() const = 0;
     virtual CoreOptions& getCoreOptions() = 0;
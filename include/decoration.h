@@ -205,6 +205,14 @@ typedef void (*decor_draw_func_t) (Display	   *xdisplay,
 				   decor_context_t *context,
 				   void		   *closure);
 
+/* Renders the coverage of what the matching decor_draw_func_t draws
+   into mask, width * height values between 0.0 and 1.0 */
+typedef void (*decor_draw_mask_func_t) (float		*mask,
+					int		width,
+					int		height,
+					decor_context_t *context,
+					void		*closure);
+
 #define PROP_HEADER_SIZE 3
 #define WINDOW_PROP_SIZE 12
 #define BASE_PROP_SIZE 22
@@ -402,6 +410,26 @@ decor_shadow_create (Display		    *xdisplay,
 		     decor_draw_func_t      draw,
 		     void		    *closure);
 
+decor_shadow_t *
+decor_shadow_create_with_mask (Display		      *xdisplay,
+			       Screen		      *screen,
+			       int		      width,
+			       int		      height,
+			       int		      left,
+			       int		      right,
+			       int		      top,
+			       int		      bottom,
+			       int		      solid_left,
+			       int		      solid_right,
+			       int		      solid_top,
+			       int		      solid_bottom,
+			       decor_shadow_options_t *opt,
+			       decor_context_t	      *context,
+			       decor_draw_func_t      draw,
+			       decor_draw_mask_func_t draw_mask,
+			       unsigned int	      key,
+			       void		      *closure);
+
 void
 decor_shadow_destroy (Display	     *xdisplay,
 		      decor_shadow_t *shadow);
@@ -409,6 +437,9 @@ decor_shadow_destroy (Display	     *xdisplay,
 void
 decor_shadow_reference (decor_shadow_t *shadow);
 
+void
+decor_shadow_cache_flush (Display *xdisplay);
+
 void
 decor_shadow (Display	     *xdisplay,
 		      decor_shadow_t *shadow);
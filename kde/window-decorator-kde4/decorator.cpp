@@ -200,6 +200,8 @@ KWD::Decorator::~Decorator (void)
 
     XDestroyWindow (QX11Info::display (), mCompositeWindow);
 
+    decor_shadow_cache_flush (QX11Info::display ());
+
     delete mOptions;
     delete mPlugins;
     delete mConfig;
@@ -321,6 +323,9 @@ KWD::Decorator::updateShadow (void)
     if (mNoBorderShadow)
 	decor_shadow_destroy (xdisplay, mNoBorderShadow);
 
+    /* Shadows cached for the old options won't be asked for again */
+    decor_shadow_cache_flush (xdisplay);
+
     mNoBorderShadow = decor_shadow_create (xdisplay,
 					   xscreen,
 					   1, 1,
@@ -1433,118 +1433,401 @@ create_gaussian_kernel (double radius,
 #define SIGMA(r) ((r) / 2.0)
 #define ALPHA(r) (r)
 
-decor_shadow_t *
-decor_shadow_create (Display		    *xdisplay,
-		     Screen		    *screen,
-		     int		    width,
-		     int		    height,
-		     int		    left,
-		     int		    right,
-		     int		    top,
-		     int		    bottom,
-		     int		    solid_left,
-		     int		    solid_right,
-		     int		    solid_top,
-		     int		    solid_bottom,
-		     decor_shadow_options_t *opt,
-		     decor_context_t	    *c,
-		     decor_draw_func_t	    draw,
-		     void		    *closure)
+/*
+  Blurs the alpha channel of src with kernel, horizontally and then
+  vertically, shifting it by (dx, dy). Pixels outside the image count
+  as transparent. Both passes walk whole rows so the inner loops are
+  contiguous and can be vectorized by the compiler.
+ */
+static void
+blur_alpha (const float *src,
+	    float	*tmp,
+	    float	*dst,
+	    int		width,
+	    int		height,
+	    const float *kernel,
+	    int		n_kernel,
+	    int		dx,
+	    int		dy)
 {
-    static XRenderColor white = { 0xffff, 0xffff, 0xffff, 0xffff };
-    XRenderPictFormat   *format;
-    Pixmap		pixmap;
-    Picture		src, dst, tmp;
-    XFixed		opacity, *params;
-    XFilters		*filters;
-    char		*filter = NULL;
-    int			size, n_params = 0;
-    XRenderColor	color;
-    int			shadow_offset_x;
-    int			shadow_offset_y;
-    Pixmap		d_pixmap;
-    int			d_width;
-    int			d_height;
-    Window		xroot = screen->root;
-    decor_shadow_t	*shadow;
-    int			clipX1, clipY1, clipX2, clipY2;
+    int half = n_kernel / 2;
+    int x, y, k;
 
-    shadow = malloc (sizeof (decor_shadow_t));
-    if (!shadow)
-	return NULL;
+    memset (tmp, 0, sizeof (float) * width * height);
+    memset (dst, 0, sizeof (float) * width * height);
 
-    shadow->ref_count = 1;
+    for (y = 0; y < height; ++y)
+    {
+	const float *in  = src + y * width;
+	float	    *out = tmp + y * width;
 
-    shadow->pixmap  = 0;
-    shadow->picture = 0;
-    shadow->width   = 0;
-    shadow->height  = 0;
+	for (k = 0; k < n_kernel; ++k)
+	{
+	    int	  shift = k - half - dx;
+	    int	  x1 = MAX (0, -shift);
+	    int	  x2 = MIN (width, width - shift);
+	    float w = kernel[k];
 
-    shadow_offset_x = opt->shadow_offset_x;
-    shadow_offset_y = opt->shadow_offset_y;
+	    for (x = x1; x < x2; ++x)
+		out[x] += w * in[x + shift];
+	}
+    }
 
-    /* compute a gaussian convolution kernel */
-    params = create_gaussian_kernel (opt->shadow_radius,
-				     SIGMA (opt->shadow_radius),
-				     ALPHA (opt->shadow_radius),
-				     &size);
-    if (!params)
-	shadow_offset_x = shadow_offset_y = size = 0;
+    for (y = 0; y < height; ++y)
+    {
+	float *out = dst + y * width;
 
-    if (opt->shadow_radius <= 0.0 &&
-	shadow_offset_x == 0	  &&
-	shadow_offset_y == 0)
-	size = 0;
+	for (k = 0; k < n_kernel; ++k)
+	{
+	    int		sy = y + k - half - dy;
+	    const float *in;
+	    float	w = kernel[k];
 
-    n_params = size + 2;
-    size     = size / 2;
+	    if (sy < 0 || sy >= height)
+		continue;
 
-    c->extents.left   = left;
-    c->extents.right  = right;
-    c->extents.top    = top;
-    c->extents.bottom = bottom;
+	    in = tmp + sy * width;
 
-    c->left_space   = left   + size - shadow_offset_x;
-    c->right_space  = right  + size + shadow_offset_x;
-    c->top_space    = top    + size - shadow_offset_y;
-    c->bottom_space = bottom + size + shadow_offset_y;
+	    for (x = 0; x < width; ++x)
+		out[x] += w * in[x];
+	}
+    }
+}
 
-    c->left_space   = MAX (left,   c->left_space);
-    c->right_space  = MAX (right,  c->right_space);
-    c->top_space    = MAX (top,    c->top_space);
-    c->bottom_space = MAX (bottom, c->bottom_space);
+/*
+  Coverage of decor_draw_simple, the decoration extents as a plain
+  rectangle.
+ */
+static void
+draw_simple_mask (float		  *mask,
+		  int		  width,
+		  int		  height,
+		  decor_context_t *c,
+		  void		  *closure)
+{
+    int x, y;
+    int x1 = c->left_space - c->extents.left;
+    int y1 = c->top_space - c->extents.top;
+    int x2 = width - c->right_space + c->extents.right;
+    int y2 = height - c->bottom_space + c->extents.bottom;
+
+    for (y = 0; y < height; ++y)
+	for (x = 0; x < width; ++x)
+	    mask[y * width + x] =
+		(x >= x1 && x < x2 && y >= y1 && y < y2) ? 1.0f : 0.0f;
+}
 
-    c->left_corner_space   = MAX (1, size - solid_left   + shadow_offset_x);
-    c->right_corner_space  = MAX (1, size - solid_right  - shadow_offset_x);
-    c->top_corner_space    = MAX (1, size - solid_top    + shadow_offset_y);
-    c->bottom_corner_space = MAX (1, size - solid_bottom - shadow_offset_y);
+/*
+  Blurs the coverage rendered by draw_mask on the client and uploads
+  the result with a single XPutImage, so nothing is read back from the
+  server. The decoration inside the shadow spaces is then drawn on the
+  server by draw, unless it is decor_draw_simple whose white rectangle
+  the coverage already describes.
+  Returns 0 if the shadow could not be created this way.
+ */
+static int
+create_shadow_client_side (Display		  *xdisplay,
+			   Window		  xroot,
+			   XRenderPictFormat	  *format,
+			   decor_shadow_t	  *shadow,
+			   XFixed		  *params,
+			   int			  n_params,
+			   int			  shadow_offset_x,
+			   int			  shadow_offset_y,
+			   int			  d_width,
+			   int			  d_height,
+			   decor_shadow_options_t *opt,
+			   decor_context_t	  *c,
+			   decor_draw_func_t	  draw,
+			   decor_draw_mask_func_t draw_mask,
+			   void			  *closure)
+{
+    XImage	  *image;
+    Pixmap	  pixmap;
+    GC		  gc;
+    float	  *kernel, *mask, *tmp, *blur;
+    unsigned int  *data;
+    double	  opacity, red, green, blue;
+    int		  n_pixels = d_width * d_height;
+    int		  n_kernel = n_params - 2;
+    int		  x, y, i;
+    int		  x1, y1, x2, y2;
+
+    kernel = malloc (sizeof (float) * n_kernel);
+    mask   = malloc (sizeof (float) * n_pixels * 3);
+    data   = malloc (sizeof (unsigned int) * n_pixels);
+    if (!kernel || !mask || !data)
+    {
+	free (kernel);
+	free (mask);
+	free (data);
 
-    width  = MAX (width, c->left_corner_space + c->right_corner_space);
-    height = MAX (height, c->top_corner_space + c->bottom_corner_space);
+	return 0;
+    }
 
-    width  = MAX (1, width);
-    height = MAX (1, height);
+    tmp  = mask + n_pixels;
+    blur = tmp + n_pixels;
 
-    d_width  = c->left_space + width + c->right_space;
-    d_height = c->top_space + height + c->bottom_space;
+    for (i = 0; i < n_kernel; ++i)
+	kernel[i] = XFixedToDouble (params[i + 2]);
 
-    /* all pixmaps are ARGB32 */
-    format = XRenderFindStandardFormat (xdisplay, PictStandardARGB32);
+    (*draw_mask) (mask, d_width, d_height, c, closure);
 
-    /* no shadow */
-    if (size <= 0)
+    blur_alpha (mask, tmp, blur, d_width, d_height, kernel, n_kernel,
+		shadow_offset_x, shadow_offset_y);
+
+    /* opacities above 1.0 make the shadow denser, just like the
+       opacity pass of the server side path */
+    opacity = opt->shadow_opacity;
+    red	    = opt->shadow_color[0] / 65535.0;
+    green   = opt->shadow_color[1] / 65535.0;
+    blue    = opt->shadow_color[2] / 65535.0;
+
+    /* the decoration itself is kept as drawn inside the shadow spaces */
+    x1 = c->left_space;
+    y1 = c->top_space;
+    x2 = d_width - c->right_space;
+    y2 = d_height - c->bottom_space;
+
+    for (y = 0; y < d_height; ++y)
     {
-	if (params)
-	    free (params);
+	for (x = 0; x < d_width; ++x)
+	{
+	    unsigned int pixel;
 
-	return shadow;
+	    i = y * d_width + x;
+
+	    if (x >= x1 && x < x2 && y >= y1 && y < y2)
+	    {
+		unsigned int v = MIN (1.0f, MAX (0.0f, mask[i])) * 255.0f + 0.5f;
+
+		pixel = (v << 24) | (v << 16) | (v << 8) | v;
+	    }
+	    else
+	    {
+		double a = MIN (1.0, blur[i] * opacity);
+
+		pixel = ((unsigned int) (a * 255.0 + 0.5) << 24)	   |
+			((unsigned int) (red * a * 255.0 + 0.5) << 16)   |
+			((unsigned int) (green * a * 255.0 + 0.5) << 8)  |
+			((unsigned int) (blue * a * 255.0 + 0.5));
+	    }
+
+	    data[i] = pixel;
+	}
     }
 
+    free (kernel);
+    free (mask);
+
+    image = XCreateImage (xdisplay, NULL, 32, ZPixmap, 0, (char *) data,
+			  d_width, d_height, 32, 0);
+    if (!image)
+    {
+	free (data);
+	return 0;
+    }
+
+    /* pixels are stored in host byte order, Xlib swaps them if needed */
+    x = 1;
+    image->byte_order = *((char *) &x) ? LSBFirst : MSBFirst;
+
     pixmap = XCreatePixmap (xdisplay, xroot, d_width, d_height, 32);
     if (!pixmap)
     {
-	free (params);
-	return shadow;
+	XDestroyImage (image);
+	return 0;
+    }
+
+    gc = XCreateGC (xdisplay, pixmap, 0, NULL);
+    XPutImage (xdisplay, pixmap, gc, image, 0, 0, 0, 0, d_width, d_height);
+    XFreeGC (xdisplay, gc);
+
+    /* also frees data */
+    XDestroyImage (image);
+
+    shadow->pixmap  = pixmap;
+    shadow->picture = XRenderCreatePicture (xdisplay, pixmap, format, 0, NULL);
+    shadow->width   = d_width;
+    shadow->height  = d_height;
+
+    if (draw != decor_draw_simple && x1 < x2 && y1 < y2)
+    {
+	Pixmap	d_pixmap;
+	Picture d_picture;
+
+	d_pixmap = XCreatePixmap (xdisplay, xroot, d_width, d_height, 32);
+	if (d_pixmap)
+	{
+	    d_picture = XRenderCreatePicture (xdisplay, d_pixmap, format,
+					      0, NULL);
+
+	    (*draw) (xdisplay, d_pixmap, d_picture, d_width, d_height,
+		     c, closure);
+
+	    XRenderComposite (xdisplay,
+			      PictOpSrc,
+			      d_picture,
+			      None,
+			      shadow->picture,
+			      x1, y1,
+			      0, 0,
+			      x1, y1,
+			      x2 - x1, y2 - y1);
+
+	    XRenderFreePicture (xdisplay, d_picture);
+	    XFreePixmap (xdisplay, d_pixmap);
+	}
+    }
+
+    return 1;
+}
+
+/*
+  Shadows with a mask function only depend on their arguments and the
+  key the caller gives for the closure, so the most recently used ones
+  are kept around and shared between callers asking for the same shadow
+  again.
+ */
+#define SHADOW_CACHE_SIZE 8
+
+typedef struct _decor_shadow_cache_entry {
+    Display		   *xdisplay;
+    Window		   xroot;
+    decor_draw_func_t	   draw;
+    unsigned int	   key;
+    int			   size[10];
+    decor_shadow_options_t opt;
+    decor_shadow_t	   *shadow;
+    unsigned int	   age;
+} decor_shadow_cache_entry_t;
+
+static decor_shadow_cache_entry_t shadow_cache[SHADOW_CACHE_SIZE];
+static unsigned int		  shadow_cache_age = 0;
+
+static decor_shadow_t *
+shadow_cache_lookup (Display		    *xdisplay,
+		     Window		    xroot,
+		     decor_draw_func_t	    draw,
+		     unsigned int	    key,
+		     const int		    *size,
+		     decor_shadow_options_t *opt)
+{
+    int i;
+
+    for (i = 0; i < SHADOW_CACHE_SIZE; ++i)
+    {
+	decor_shadow_cache_entry_t *entry = &shadow_cache[i];
+
+	if (entry->shadow				       &&
+	    entry->xdisplay == xdisplay			       &&
+	    entry->xroot == xroot				       &&
+	    entry->draw == draw					       &&
+	    entry->key == key					       &&
+	    memcmp (entry->size, size, sizeof (entry->size)) == 0 &&
+	    decor_shadow_options_cmp (&entry->opt, opt))
+	{
+	    entry->age = ++shadow_cache_age;
+	    decor_shadow_reference (entry->shadow);
+
+	    return entry->shadow;
+	}
+    }
+
+    return NULL;
+}
+
+static void
+shadow_cache_insert (Display		    *xdisplay,
+		     Window		    xroot,
+		     decor_draw_func_t	    draw,
+		     unsigned int	    key,
+		     const int		    *size,
+		     decor_shadow_options_t *opt,
+		     decor_shadow_t	    *shadow)
+{
+    decor_shadow_cache_entry_t *entry = &shadow_cache[0];
+    int			       i;
+
+    /* replace the least recently used entry */
+    for (i = 1; i < SHADOW_CACHE_SIZE; ++i)
+    {
+	if (!entry->shadow)
+	    break;
+
+	if (!shadow_cache[i].shadow || shadow_cache[i].age < entry->age)
+	    entry = &shadow_cache[i];
+    }
+
+    if (entry->shadow)
+	decor_shadow_destroy (entry->xdisplay, entry->shadow);
+
+    entry->xdisplay = xdisplay;
+    entry->xroot    = xroot;
+    entry->draw	    = draw;
+    entry->key	    = key;
+    entry->opt	    = *opt;
+    entry->shadow   = shadow;
+    entry->age	    = ++shadow_cache_age;
+
+    memcpy (entry->size, size, sizeof (entry->size));
+
+    decor_shadow_reference (shadow);
+}
+
+void
+decor_shadow_cache_flush (Display *xdisplay)
+{
+    int i;
+
+    for (i = 0; i < SHADOW_CACHE_SIZE; ++i)
+    {
+	decor_shadow_cache_entry_t *entry = &shadow_cache[i];
+
+	if (entry->shadow && entry->xdisplay == xdisplay)
+	{
+	    decor_shadow_destroy (xdisplay, entry->shadow);
+	    entry->shadow = NULL;
+	}
+    }
+}
+
+/*
+  Blurs the decoration mask on the server with two convolution filter
+  passes. Used for draw functions without a mask function, and when the
+  client side path fails.
+ */
+static void
+create_shadow_server_side (Display		  *xdisplay,
+			   Window		  xroot,
+			   XRenderPictFormat	  *format,
+			   decor_shadow_t	  *shadow,
+			   XFixed		  *params,
+			   int			  n_params,
+			   int			  size,
+			   int			  shadow_offset_x,
+			   int			  shadow_offset_y,
+			   int			  d_width,
+			   int			  d_height,
+			   decor_shadow_options_t *opt,
+			   decor_context_t	  *c,
+			   decor_draw_func_t	  draw,
+			   void			  *closure)
+{
+    static XRenderColor white = { 0xffff, 0xffff, 0xffff, 0xffff };
+    Pixmap		pixmap;
+    Picture		src, dst, tmp;
+    XFixed		opacity;
+    XFilters		*filters;
+    char		*filter = NULL;
+    XRenderColor	color;
+    Pixmap		d_pixmap;
+    int			clipX1, clipY1, clipX2, clipY2;
+
+    pixmap = XCreatePixmap (xdisplay, xroot, d_width, d_height, 32);
+    if (!pixmap)
+    {
+	return;
     }
 
     /* query server for convolution filter */
@@ -1568,9 +1851,7 @@ decor_shadow_create (Display		    *xdisplay,
     if (!filter)
     {
 	XFreePixmap (xdisplay, pixmap);
-	free (params);
-
-	return shadow;
+	return;
     }
 
     /* create pixmap for temporary decorations */
@@ -1578,9 +1859,7 @@ decor_shadow_create (Display		    *xdisplay,
     if (!d_pixmap)
     {
 	XFreePixmap (xdisplay, pixmap);
-	free (params);
-
-	return shadow;
+	return;
     }
 
     src = XRenderCreateSolidFill (xdisplay, &white);
@@ -1712,12 +1991,182 @@ decor_shadow_create (Display		    *xdisplay,
 
     shadow->width  = d_width;
     shadow->height = d_height;
+}
+
+/*
+  Like decor_shadow_create, but draw_mask renders the coverage of draw on
+  the client so the shadow can be blurred there. key identifies what
+  draw and draw_mask render for closure, shadows with the same draw
+  function, key, geometry and options are shared.
+ */
+decor_shadow_t *
+decor_shadow_create_with_mask (Display		      *xdisplay,
+			       Screen		      *screen,
+			       int		      width,
+			       int		      height,
+			       int		      left,
+			       int		      right,
+			       int		      top,
+			       int		      bottom,
+			       int		      solid_left,
+			       int		      solid_right,
+			       int		      solid_top,
+			       int		      solid_bottom,
+			       decor_shadow_options_t *opt,
+			       decor_context_t	      *c,
+			       decor_draw_func_t      draw,
+			       decor_draw_mask_func_t draw_mask,
+			       unsigned int	      key,
+			       void		      *closure)
+{
+    XRenderPictFormat   *format;
+    XFixed		*params;
+    int			size, n_params = 0;
+    int			shadow_offset_x;
+    int			shadow_offset_y;
+    int			d_width;
+    int			d_height;
+    Window		xroot = screen->root;
+    decor_shadow_t	*shadow, *cached;
+    int			size_key[10] = {
+	width, height, left, right, top, bottom,
+	solid_left, solid_right, solid_top, solid_bottom
+    };
+
+    shadow = malloc (sizeof (decor_shadow_t));
+    if (!shadow)
+	return NULL;
+
+    shadow->ref_count = 1;
+
+    shadow->pixmap  = 0;
+    shadow->picture = 0;
+    shadow->width   = 0;
+    shadow->height  = 0;
+
+    shadow_offset_x = opt->shadow_offset_x;
+    shadow_offset_y = opt->shadow_offset_y;
+
+    /* compute a gaussian convolution kernel */
+    params = create_gaussian_kernel (opt->shadow_radius,
+				     SIGMA (opt->shadow_radius),
+				     ALPHA (opt->shadow_radius),
+				     &size);
+    if (!params)
+	shadow_offset_x = shadow_offset_y = size = 0;
+
+    if (opt->shadow_radius <= 0.0 &&
+	shadow_offset_x == 0	  &&
+	shadow_offset_y == 0)
+	size = 0;
+
+    n_params = size + 2;
+    size     = size / 2;
+
+    c->extents.left   = left;
+    c->extents.right  = right;
+    c->extents.top    = top;
+    c->extents.bottom = bottom;
+
+    c->left_space   = left   + size - shadow_offset_x;
+    c->right_space  = right  + size + shadow_offset_x;
+    c->top_space    = top    + size - shadow_offset_y;
+    c->bottom_space = bottom + size + shadow_offset_y;
+
+    c->left_space   = MAX (left,   c->left_space);
+    c->right_space  = MAX (right,  c->right_space);
+    c->top_space    = MAX (top,    c->top_space);
+    c->bottom_space = MAX (bottom, c->bottom_space);
+
+    c->left_corner_space   = MAX (1, size - solid_left   + shadow_offset_x);
+    c->right_corner_space  = MAX (1, size - solid_right  - shadow_offset_x);
+    c->top_corner_space    = MAX (1, size - solid_top    + shadow_offset_y);
+    c->bottom_corner_space = MAX (1, size - solid_bottom - shadow_offset_y);
+
+    width  = MAX (width, c->left_corner_space + c->right_corner_space);
+    height = MAX (height, c->top_corner_space + c->bottom_corner_space);
+
+    width  = MAX (1, width);
+    height = MAX (1, height);
+
+    d_width  = c->left_space + width + c->right_space;
+    d_height = c->top_space + height + c->bottom_space;
+
+    /* all pixmaps are ARGB32 */
+    format = XRenderFindStandardFormat (xdisplay, PictStandardARGB32);
+
+    /* no shadow */
+    if (size <= 0)
+    {
+	if (params)
+	    free (params);
+
+	return shadow;
+    }
+
+    if (draw_mask)
+    {
+	cached = shadow_cache_lookup (xdisplay, xroot, draw, key, size_key,
+				      opt);
+	if (cached)
+	{
+	    free (shadow);
+	    free (params);
+
+	    return cached;
+	}
+    }
+
+    if (!draw_mask ||
+	!create_shadow_client_side (xdisplay, xroot, format, shadow,
+				    params, n_params,
+				    shadow_offset_x, shadow_offset_y,
+				    d_width, d_height, opt, c,
+				    draw, draw_mask, closure))
+	create_shadow_server_side (xdisplay, xroot, format, shadow,
+				   params, n_params, size,
+				   shadow_offset_x, shadow_offset_y,
+				   d_width, d_height, opt, c, draw, closure);
+
+    if (draw_mask && shadow->pixmap)
+	shadow_cache_insert (xdisplay, xroot, draw, key, size_key, opt,
+			     shadow);
 
     free (params);
 
     return shadow;
 }
 
+decor_shadow_t *
+decor_shadow_create (Display		    *xdisplay,
+		     Screen		    *screen,
+		     int		    width,
+		     int		    height,
+		     int		    left,
+		     int		    right,
+		     int		    top,
+		     int		    bottom,
+		     int		    solid_left,
+		     int		    solid_right,
+		     int		    solid_top,
+		     int		    solid_bottom,
+		     decor_shadow_options_t *opt,
+		     decor_context_t	    *c,
+		     decor_draw_func_t	    draw,
+		     void		    *closure)
+{
+    /* other draw functions depend on state the library can't see */
+    return decor_shadow_create_with_mask (xdisplay, screen,
+					  width, height,
+					  left, right, top, bottom,
+					  solid_left, solid_right,
+					  solid_top, solid_bottom,
+					  opt, c, draw,
+					  draw == decor_draw_simple ?
+					  draw_simple_mask : NULL,
+					  0, closure);
+}
+
 void
 decor_shadow_destroy (Display	     *xdisplay,
 		      decor_shadow_t *shadow)
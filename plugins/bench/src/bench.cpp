@@ -23,6 +23,10 @@
  *
  **/
 
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
 #include "bench.h"
 
 using namespace compiz::core;
@@ -32,9 +36,26 @@ COMPIZ_PLUGIN_20090315 (bench, BenchPluginVTable)
 static const unsigned int TEX_WIDTH = 512;
 static const unsigned short TEX_HEIGHT = 256;
 
+namespace
+{
+    long long
+    timespecDiffU (const struct timespec &a, const struct timespec &b)
+    {
+	return (a.tv_sec - b.tv_sec) * 1000000LL +
+	       (a.tv_nsec - b.tv_nsec) / 1000;
+    }
+}
+
 void
 BenchScreen::preparePaint (int msSinceLastPaint)
 {
+    if (mRecording)
+    {
+	clock_gettime (CLOCK_MONOTONIC, &mFrameStart);
+	clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &mFrameCpuStart);
+	mFrameRequestStart = XNextRequest (screen->dpy ());
+    }
+
     struct timeval now;
     gettimeofday (&now, 0);
 
@@ -88,7 +109,7 @@ BenchScreen::preparePaint (int msSinceLastPaint)
     {
 	if (mAlpha <= 0.0)
 	{
-	    cScreen->preparePaintSetEnabled (this, false);
+	    cScreen->preparePaintSetEnabled (this, mRecording);
 	    gScreen->glPaintOutputSetEnabled (this, false);
 	    mTimer.stop ();
 	}
@@ -102,6 +123,101 @@ BenchScreen::preparePaint (int msSinceLastPaint)
     cScreen->preparePaint (msSinceLastPaint);
 }
 
+void
+BenchScreen::donePaint ()
+{
+    cScreen->donePaint ();
+
+    if (!mRecording)
+	return;
+
+    struct timespec end, cpuEnd;
+
+    clock_gettime (CLOCK_MONOTONIC, &end);
+    clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &cpuEnd);
+
+    mRecorder.record (compiz::bench::FrameSample (
+			  timespecDiffU (end, mFrameStart),
+			  timespecDiffU (cpuEnd, mFrameCpuStart),
+			  XNextRequest (screen->dpy ()) - mFrameRequestStart));
+
+    if (mRecorder.full ())
+    {
+	writeRecording ();
+	stopRecording ();
+    }
+}
+
+void
+BenchScreen::startRecording ()
+{
+    const char *file = getenv ("COMPIZ_BENCH_RECORD_FILE");
+    const char *frames = getenv ("COMPIZ_BENCH_RECORD_FRAMES");
+
+    mRecordFile = file ? file : optionGetRecordFile ();
+    mRecording = !mRecordFile.empty ();
+    mRecorder = compiz::bench::FrameRecorder (frames ?
+					      atoi (frames) :
+					      optionGetRecordFrames ());
+
+    /*
+     * preparePaint may not have run since the last time the overlay was
+     * shown, so a stale redraw time would turn the first recorded frame
+     * into one huge fade step. Start the fade clock from now and drop a
+     * leftover fade-out so the overlay isn't painted into the recording.
+     */
+    gettimeofday (&mLastRedraw, 0);
+    mLastPrint = mLastRedraw;
+
+    if (mRecording && !mActive)
+    {
+	mAlpha = 0.0f;
+	mTimer.stop ();
+	gScreen->glPaintOutputSetEnabled (this, false);
+    }
+
+    cScreen->preparePaintSetEnabled (this, mRecording || mActive);
+    cScreen->donePaintSetEnabled (this, mRecording);
+}
+
+void
+BenchScreen::stopRecording ()
+{
+    mRecording = false;
+    mRecorder.clear ();
+
+    cScreen->donePaintSetEnabled (this, false);
+
+    if (!mActive && mAlpha <= 0.0)
+	cScreen->preparePaintSetEnabled (this, false);
+}
+
+void
+BenchScreen::writeRecording ()
+{
+    /* Write to a temporary file first, so that anyone waiting for the
+     * file never reads a partial one */
+    std::string tmpFile (mRecordFile + ".tmp");
+    std::ofstream out (tmpFile.c_str ());
+
+    mRecorder.write (out);
+    out.close ();
+
+    if (out.fail () || rename (tmpFile.c_str (), mRecordFile.c_str ()))
+	compLogMessage ("bench", CompLogLevelWarn,
+			"Couldn't write frame timings to %s",
+			mRecordFile.c_str ());
+}
+
+void
+BenchScreen::recordingOptionChanged ()
+{
+    if (mRecording && mRecorder.frames ())
+	writeRecording ();
+
+    startRecording ();
+}
+
 float
 BenchScreen::averageFramerate () const
 /*
@@ -295,17 +411,25 @@ BenchScreen::BenchScreen (CompScreen *screen) :
     mLastPrintFrames (0),
     mActive (false),
     mOldLimiterMode ((CompositeFPSLimiterMode)
-    		     BenchOptions::FpsLimiterModeDefaultLimiter)
+    		     BenchOptions::FpsLimiterModeDefaultLimiter),
+    mRecording (false),
+    mFrameRequestStart (0)
 {
     optionSetInitiateKeyInitiate (boost::bind (&BenchScreen::initiate, this,
 					       _3));
 
     optionSetFpsLimiterModeNotify
 	(boost::bind (&BenchScreen::limiterModeChanged, this, _1));
+    optionSetRecordFileNotify
+	(boost::bind (&BenchScreen::recordingOptionChanged, this));
+    optionSetRecordFramesNotify
+	(boost::bind (&BenchScreen::recordingOptionChanged, this));
 
     CompositeScreenInterface::setHandler (cScreen, false);
     GLScreenInterface::setHandler (gScreen, false);
 
+    startRecording ();
+
     mRect.setGeometry (optionGetPositionX (), optionGetPositionY (),
                        TEX_WIDTH, TEX_HEIGHT);
     mTimer.setCallback (boost::bind (&BenchScreen::timedOut, this));
@@ -396,6 +520,9 @@ BenchScreen::BenchScreen (CompScreen *screen) :
 
 BenchScreen::~BenchScreen ()
 {
+    if (mRecording && mRecorder.frames ())
+	writeRecording ();
+
     if (mActive)
     {
     	// Restore FPS limiter mode
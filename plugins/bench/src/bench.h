@@ -31,9 +31,11 @@
 #include <opengl/opengl.h>
 
 #include <sys/time.h>
+#include <time.h>
 
 #include "bench_tex.h"
 #include "bench_options.h"
+#include "frame-recorder.h"
 
 #define TIMEVALDIFFU(tv1, tv2)                                              \
     (((tv1)->tv_sec == (tv2)->tv_sec || (tv1)->tv_usec >= (tv2)->tv_usec) ? \
@@ -93,6 +95,13 @@ class BenchScreen :
 
 	CompositeFPSLimiterMode mOldLimiterMode;
 
+	std::string                   mRecordFile;
+	bool                          mRecording;
+	compiz::bench::FrameRecorder  mRecorder;
+	struct timespec               mFrameStart;
+	struct timespec               mFrameCpuStart;
+	unsigned long                 mFrameRequestStart;
+
 	void damageSelf ();
 	bool timedOut ();
 	float averageFramerate () const;
@@ -108,7 +117,13 @@ class BenchScreen :
 
 	void limiterModeChanged (CompOption *opt);
 
+	void startRecording ();
+	void stopRecording ();
+	void writeRecording ();
+	void recordingOptionChanged ();
+
 	void preparePaint (int msSinceLastPaint);
+	void donePaint ();
 
 	bool glPaintOutput (const GLScreenPaintAttrib &,
 			    const GLMatrix &, const CompRegion &,
@@ -0,0 +1,82 @@
+/*
+ *
+ * Compiz benchmark plugin
+ *
+ * frame-recorder.h
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _COMPIZ_BENCH_FRAME_RECORDER_H
+#define _COMPIZ_BENCH_FRAME_RECORDER_H
+
+#include <ostream>
+#include <vector>
+
+namespace compiz
+{
+namespace bench
+{
+
+/*
+ * The cost of painting a single frame, from preparePaint to donePaint.
+ * Times are in microseconds, requests is the number of X requests the
+ * compositor issued while painting.
+ */
+struct FrameSample
+{
+    FrameSample (long long     wallTime = 0,
+		 long long     cpuTime = 0,
+		 unsigned long requests = 0) :
+	wallTime (wallTime),
+	cpuTime (cpuTime),
+	requests (requests)
+    {
+    }
+
+    long long     wallTime;
+    long long     cpuTime;
+    unsigned long requests;
+};
+
+/*
+ * Collects frame samples and summarizes them as JSON, so that runs
+ * of the headless benchmark can be compared by scripts.
+ */
+class FrameRecorder
+{
+    public:
+
+	/* A limit of zero records frames until cleared */
+	FrameRecorder (unsigned int limit = 0);
+
+	void record (const FrameSample &sample);
+	void clear ();
+
+	bool full () const;
+	unsigned int frames () const;
+
+	/* Nearest rank percentile of the frame times, p in [0, 100] */
+	long long percentile (double p) const;
+
+	void write (std::ostream &os) const;
+
+    private:
+
+	unsigned int               mLimit;
+	std::vector <FrameSample> mSamples;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,141 @@
+/*
+ *
+ * Compiz benchmark plugin
+ *
+ * frame-recorder.cpp
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <locale>
+#include <sstream>
+
+#include "frame-recorder.h"
+
+namespace cb = compiz::bench;
+
+cb::FrameRecorder::FrameRecorder (unsigned int limit) :
+    mLimit (limit)
+{
+    if (mLimit)
+	mSamples.reserve (mLimit);
+}
+
+void
+cb::FrameRecorder::record (const FrameSample &sample)
+{
+    if (full ())
+	return;
+
+    mSamples.push_back (sample);
+}
+
+void
+cb::FrameRecorder::clear ()
+{
+    mSamples.clear ();
+}
+
+bool
+cb::FrameRecorder::full () const
+{
+    return mLimit && mSamples.size () >= mLimit;
+}
+
+unsigned int
+cb::FrameRecorder::frames () const
+{
+    return mSamples.size ();
+}
+
+long long
+cb::FrameRecorder::percentile (double p) const
+{
+    if (mSamples.empty ())
+	return 0;
+
+    std::vector <long long> times;
+    times.reserve (mSamples.size ());
+
+    for (std::vector <FrameSample>::const_iterator it = mSamples.begin ();
+	 it != mSamples.end (); ++it)
+	times.push_back (it->wallTime);
+
+    p = std::min (100.0, std::max (0.0, p));
+
+    size_t rank = static_cast <size_t> (std::ceil (p / 100.0 * times.size ()));
+    size_t index = rank ? rank - 1 : 0;
+
+    std::nth_element (times.begin (), times.begin () + index, times.end ());
+
+    return times[index];
+}
+
+void
+cb::FrameRecorder::write (std::ostream &os) const
+{
+    long long     wallTotal = 0, wallMax = 0, cpuTotal = 0;
+    unsigned long requestTotal = 0;
+    size_t        n = mSamples.size ();
+
+    for (std::vector <FrameSample>::const_iterator it = mSamples.begin ();
+	 it != mSamples.end (); ++it)
+    {
+	wallTotal += it->wallTime;
+	wallMax = std::max (wallMax, it->wallTime);
+	cpuTotal += it->cpuTime;
+	requestTotal += it->requests;
+    }
+
+    /* JSON needs a '.' as decimal separator, whatever the user's locale */
+    std::ostringstream json;
+    json.imbue (std::locale::classic ());
+    json.setf (std::ios::fixed);
+    json.precision (1);
+
+    double count = n ? n : 1;
+
+    json << "{\n"
+	 << "  \"frames\": " << n << ",\n"
+	 << "  \"frame_time_us\": {\n"
+	 << "    \"p50\": " << percentile (50) << ",\n"
+	 << "    \"p99\": " << percentile (99) << ",\n"
+	 << "    \"mean\": " << wallTotal / count << ",\n"
+	 << "    \"max\": " << wallMax << "\n"
+	 << "  },\n"
+	 << "  \"cpu_time_us\": {\n"
+	 << "    \"total\": " << cpuTotal << ",\n"
+	 << "    \"mean\": " << cpuTotal / count << "\n"
+	 << "  },\n"
+	 << "  \"x_requests\": {\n"
+	 << "    \"total\": " << requestTotal << ",\n"
+	 << "    \"mean\": " << requestTotal / count << "\n"
+	 << "  },\n"
+	 << "  \"sample_fields\": "
+	 << "[\"frame_time_us\", \"cpu_time_us\", \"x_requests\"],\n"
+	 << "  \"samples\": [";
+
+    for (size_t i = 0; i < n; ++i)
+    {
+	const FrameSample &s = mSamples[i];
+
+	json << (i ? ",\n    " : "\n    ")
+	     << "[" << s.wallTime << ", " << s.cpuTime << ", "
+	     << s.requests << "]";
+    }
+
+    json << (n ? "\n  ]\n" : "]\n") << "}\n";
+
+    os << json.str ();
+}
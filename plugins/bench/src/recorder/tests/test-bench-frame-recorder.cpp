@@ -0,0 +1,111 @@
+/*
+ * Compiz benchmark plugin
+ *
+ * test-bench-frame-recorder.cpp
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <sstream>
+#include <gtest/gtest.h>
+
+#include "frame-recorder.h"
+
+namespace cb = compiz::bench;
+
+TEST (BenchFrameRecorder, EmptyRecorderHasNoPercentiles)
+{
+    cb::FrameRecorder recorder;
+
+    EXPECT_EQ (0u, recorder.frames ());
+    EXPECT_EQ (0, recorder.percentile (50));
+    EXPECT_EQ (0, recorder.percentile (99));
+}
+
+TEST (BenchFrameRecorder, NearestRankPercentiles)
+{
+    cb::FrameRecorder recorder;
+
+    /* Recorded out of order on purpose */
+    for (int i = 100; i >= 1; --i)
+	recorder.record (cb::FrameSample (i * 10));
+
+    EXPECT_EQ (100u, recorder.frames ());
+    EXPECT_EQ (500, recorder.percentile (50));
+    EXPECT_EQ (990, recorder.percentile (99));
+    EXPECT_EQ (1000, recorder.percentile (100));
+    EXPECT_EQ (10, recorder.percentile (0));
+}
+
+TEST (BenchFrameRecorder, StopsAtLimit)
+{
+    cb::FrameRecorder recorder (3);
+
+    for (int i = 0; i < 5; ++i)
+    {
+	EXPECT_EQ (i >= 3, recorder.full ());
+	recorder.record (cb::FrameSample (i));
+    }
+
+    EXPECT_EQ (3u, recorder.frames ());
+    EXPECT_EQ (2, recorder.percentile (100));
+
+    recorder.clear ();
+    EXPECT_FALSE (recorder.full ());
+    EXPECT_EQ (0u, recorder.frames ());
+}
+
+TEST (BenchFrameRecorder, UnlimitedNeverFull)
+{
+    cb::FrameRecorder recorder;
+
+    for (int i = 0; i < 1000; ++i)
+	recorder.record (cb::FrameSample (i));
+
+    EXPECT_FALSE (recorder.full ());
+    EXPECT_EQ (1000u, recorder.frames ());
+}
+
+TEST (BenchFrameRecorder, WritesSummaryAndSamples)
+{
+    cb::FrameRecorder recorder;
+
+    recorder.record (cb::FrameSample (1000, 800, 12));
+    recorder.record (cb::FrameSample (3000, 1200, 20));
+
+    std::ostringstream os;
+    recorder.write (os);
+
+    const std::string json (os.str ());
+
+    EXPECT_NE (std::string::npos, json.find ("\"frames\": 2,"));
+    EXPECT_NE (std::string::npos, json.find ("\"p50\": 1000,"));
+    EXPECT_NE (std::string::npos, json.find ("\"p99\": 3000,"));
+    EXPECT_NE (std::string::npos, json.find ("\"mean\": 2000.0,"));
+    EXPECT_NE (std::string::npos, json.find ("\"max\": 3000\n"));
+    EXPECT_NE (std::string::npos, json.find ("\"total\": 2000,"));
+    EXPECT_NE (std::string::npos, json.find ("\"total\": 32,"));
+    EXPECT_NE (std::string::npos, json.find ("[1000, 800, 12],"));
+    EXPECT_NE (std::string::npos, json.find ("[3000, 1200, 20]\n"));
+}
+
+TEST (BenchFrameRecorder, WritesValidJSONWithoutFrames)
+{
+    cb::FrameRecorder recorder;
+
+    std::ostringstream os;
+    recorder.write (os);
+
+    const std::string json (os.str ());
+
+    EXPECT_NE (std::string::npos, json.find ("\"frames\": 0,"));
+    EXPECT_NE (std::string::npos, json.find ("\"samples\": []"));
+}
@@ -18,6 +18,8 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <poll.h>
+
 #include "ccp.h"
 
 COMPIZ_PLUGIN_20090315 (ccp, CcpPluginVTable)
@@ -27,6 +29,18 @@ static const unsigned short CCP_UPDATE_MAX_TIMEOUT = 4000;
 
 #define CORE_VTABLE_NAME  "core"
 
+static void
+ccpChangedSettingsNotify (CCSContext *context,
+			  void       *data)
+{
+    CcpScreen *cs = (CcpScreen *) data;
+
+    /* This is called from inside the backend while it is still
+     * updating settings, so apply them once it is done */
+    if (!cs->mApplyTimer.active ())
+	cs->mApplyTimer.start (boost::bind (&CcpScreen::applyChangedSettings, cs), 0);
+}
+
 static void
 ccpSetValueToValue (CCSSettingValue   *sv,
 		    CompOption::Value *v,
@@ -407,14 +421,53 @@ CcpScreen::setOptionFromContext (CompOption *o,
 
     CCSSetting *setting = ccsFindSetting (bsp, o->name ().c_str ());
 
-    if (!setting ||
-	!ccpTypeCheck (setting, o))
+    if (setting)
+	setOptionFromSetting (o, setting, plugin);
+}
+
+void
+CcpScreen::setOptionsFromContext (CompPlugin *p)
+{
+    const char *plugin = p->vTable->name ().c_str ();
+    CCSPlugin  *bsp = ccsFindPlugin (mContext, plugin);
+
+    if (!bsp)
+	return;
+
+    /* Index the settings of the plugin once, rather than searching
+     * through all of them again for every single option */
+    std::map <CompString, CCSSetting *> settings;
+
+    for (CCSSettingList l = ccsGetPluginSettings (bsp); l; l = l->next)
+	settings[ccsSettingGetName (l->data)] = l->data;
+
+    foreach (CompOption &o, p->vTable->getOptions ())
+    {
+	std::map <CompString, CCSSetting *>::iterator it =
+	    settings.find (o.name ());
+
+	if (it != settings.end ())
+	    setOptionFromSetting (&o, it->second, plugin);
+    }
+}
+
+void
+CcpScreen::setOptionFromSetting (CompOption *o,
+				 CCSSetting *setting,
+				 const char *plugin)
+{
+    if (!ccpTypeCheck (setting, o))
 	return;
 
     CompOption::Value value;
 
     ccpSettingToValue (setting, &value);
 
+    /* Most settings are still at the value the plugin was
+     * initialised with, don't make it process them again */
+    if (value == o->value ())
+	return;
+
     mApplyingSettings = true;
     screen->setOptionForPlugin (plugin, o->name ().c_str (), value);
     mApplyingSettings = false;
@@ -442,17 +495,14 @@ bool
 CcpScreen::reload ()
 {
     foreach (CompPlugin *p, CompPlugin::getPlugins ())
-	foreach (CompOption &o, p->vTable->getOptions ())
-	    setOptionFromContext (&o, p->vTable->name ().c_str ());
+	setOptionsFromContext (p);
 
     return false;
 }
 
 bool
-CcpScreen::timeout ()
+CcpScreen::applyChangedSettings ()
 {
-    ccsProcessEvents (mContext, ProcessEventsNoGlibMainLoopMask);
-
     CCSSettingList list = ccsContextStealChangedSettings (mContext);
 
     if (ccsSettingListLength (list))
@@ -484,7 +534,66 @@ CcpScreen::timeout ()
 	ccsContextClearChangedSettings (mContext);
     }
 
-    return true;
+    return false;
+}
+
+void
+CcpScreen::processEvents ()
+{
+    ccsProcessEvents (mContext, ProcessEventsNoGlibMainLoopMask);
+
+    applyChangedSettings ();
+
+    /* Reading the settings may have added or removed file watches */
+    updateFileWatch ();
+}
+
+bool
+CcpScreen::timeout ()
+{
+    processEvents ();
+
+    /* Only poll while there is nothing to watch */
+    return mFileWatchFd < 0;
+}
+
+void
+CcpScreen::fileWatchEvent (short int events)
+{
+    /* libcompizconfig closed the descriptor or it broke, drop the
+     * watch before the fd number is reused by something else */
+    if (events & (POLLERR | POLLNVAL))
+    {
+	screen->removeWatchFd (mFileWatchHandle);
+	mFileWatchFd = -1;
+	mFileWatchHandle = 0;
+    }
+    else
+	processEvents ();
+
+    if (mFileWatchFd < 0 && !mTimeoutTimer.active ())
+	mTimeoutTimer.start (boost::bind (&CcpScreen::timeout, this),
+			     CCP_UPDATE_MIN_TIMEOUT, CCP_UPDATE_MAX_TIMEOUT);
+}
+
+void
+CcpScreen::updateFileWatch ()
+{
+    int fd = ccsGetFileWatchFd ();
+
+    if (fd == mFileWatchFd)
+	return;
+
+    if (mFileWatchFd >= 0)
+	screen->removeWatchFd (mFileWatchHandle);
+
+    mFileWatchFd = fd;
+
+    if (mFileWatchFd >= 0)
+	mFileWatchHandle = screen->addWatchFd (mFileWatchFd,
+					       POLLIN | POLLERR | POLLNVAL,
+					       boost::bind (&CcpScreen::fileWatchEvent,
+							    this, _1));
 }
 
 bool
@@ -524,17 +633,16 @@ CcpScreen::initPluginForScreen (CompPlugin *p)
     bool status = screen->initPluginForScreen (p);
 
     if (status)
-    {
-	foreach (CompOption &opt, p->vTable->getOptions ())
-	    setOptionFromContext (&opt, p->vTable->name ().c_str ());
-    }
+	setOptionsFromContext (p);
 
     return status;
 }
 
 CcpScreen::CcpScreen (CompScreen *screen) :
     PluginClassHandler<CcpScreen,CompScreen> (screen),
-    mApplyingSettings (false)
+    mApplyingSettings (false),
+    mFileWatchFd (-1),
+    mFileWatchHandle (0)
 {
     ccsSetBasicMetadata (TRUE);
 
@@ -543,15 +651,27 @@ CcpScreen::CcpScreen (CompScreen *screen) :
 
     ccsContextClearChangedSettings (mContext);
 
+    /* Changes from GLib based backends arrive through the main loop
+     * and changes to watched files through the file watch fd, so
+     * there is only a need to poll if neither is available */
+    ccsContextSetChangedSettingsNotify (mContext, ccpChangedSettingsNotify, this);
+    updateFileWatch ();
+
     mReloadTimer.start (boost::bind (&CcpScreen::reload, this), 0);
-    mTimeoutTimer.start (boost::bind (&CcpScreen::timeout, this),
-			 CCP_UPDATE_MIN_TIMEOUT, CCP_UPDATE_MAX_TIMEOUT);
+
+    if (mFileWatchFd < 0)
+	mTimeoutTimer.start (boost::bind (&CcpScreen::timeout, this),
+			     CCP_UPDATE_MIN_TIMEOUT, CCP_UPDATE_MAX_TIMEOUT);
 
     ScreenInterface::setHandler (screen);
 }
 
 CcpScreen::~CcpScreen ()
 {
+    if (mFileWatchFd >= 0)
+	screen->removeWatchFd (mFileWatchHandle);
+
+    ccsContextSetChangedSettingsNotify (mContext, NULL, NULL);
     ccsContextDestroy (mContext);
 }
 
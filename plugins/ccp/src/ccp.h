@@ -28,6 +28,8 @@ extern "C"
 #include <ccs.h>
 }
 
+#include <map>
+
 #include <core/core.h>
 #include <core/pluginclasshandler.h>
 #include <core/timer.h>
@@ -50,9 +52,20 @@ class CcpScreen :
 	bool timeout ();
 	bool reload ();
 
+	void processEvents ();
+	void fileWatchEvent (short int events);
+	void updateFileWatch ();
+	bool applyChangedSettings ();
+
 	void setOptionFromContext (CompOption *o,
 				   const char *plugin);
 
+	void setOptionsFromContext (CompPlugin *p);
+
+	void setOptionFromSetting (CompOption *o,
+				   CCSSetting *setting,
+				   const char *plugin);
+
 	void setContextFromOption (CompOption *o,
 				   const char *plugin);
 
@@ -64,6 +77,10 @@ class CcpScreen :
 
 	CompTimer   mTimeoutTimer;
 	CompTimer   mReloadTimer;
+	CompTimer   mApplyTimer;
+
+	int               mFileWatchFd;
+	CompWatchFdHandle mFileWatchHandle;
 };
 
 class CcpPluginVTable :
@@ -486,6 +486,9 @@ BaseSwitchWindow::paintThumb (const GLWindowPaintAttrib &attrib,
 	   very ugly but necessary until the vertex stage has been made
 	   fully pluggable. */
 	gWindow->glAddGeometrySetCurrentIndex (MAXSHORT);
+	gWindow->setDownscaleHint (
+	    CompSize (window->inputRect ().width ()  * sAttrib.xScale,
+		      window->inputRect ().height () * sAttrib.yScale));
 	gWindow->glDraw (wTransform, sAttrib, infiniteRegion, mask);
 	gWindow->glAddGeometrySetCurrentIndex (addWindowGeometryIndex);
 
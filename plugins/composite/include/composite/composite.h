@@ -30,7 +30,7 @@
 
 #include <X11/extensions/Xcomposite.h>
 
-#define COMPIZ_COMPOSITE_ABI 6
+#define COMPIZ_COMPOSITE_ABI 7
 
 #include "core/pluginclasshandler.h"
 #include "core/timer.h"
@@ -183,12 +183,24 @@ class CompositeScreenInterface :
 	 * events will be for the next frame
 	 */
 	virtual void damageCutoff ();
+
+	/**
+	 * Like preparePaint, but with sub-millisecond precision. Hook
+	 * this instead of preparePaint to step animations smoothly on
+	 * displays whose frame period isn't a whole number of
+	 * milliseconds. Unhooked, it calls preparePaint with whole
+	 * milliseconds, carrying the rounding over to the next frame.
+	 *
+	 * @param msSinceLastPaint Describes how many milliseconds have passed
+	 * since the last screen repaint
+	 */
+	virtual void preparePaintPrecise (float msSinceLastPaint);
 };
 
 extern template class PluginClassHandler<CompositeScreen, CompScreen, COMPIZ_COMPOSITE_ABI>;
 
 class CompositeScreen :
-    public WrapableHandler<CompositeScreenInterface, 8>,
+    public WrapableHandler<CompositeScreenInterface, 9>,
     public PluginClassHandler<CompositeScreen, CompScreen, COMPIZ_COMPOSITE_ABI>,
     public CompOption::Class
 {
@@ -287,8 +299,11 @@ class CompositeScreen :
 	 */
 	WRAPABLE_HND (6, CompositeScreenInterface, void, damageRegion, const CompRegion &);
 	WRAPABLE_HND (7, CompositeScreenInterface, void, damageCutoff);
+	WRAPABLE_HND (8, CompositeScreenInterface, void, preparePaintPrecise,
+		      float);
 
 	friend class PrivateCompositeDisplay;
+	friend class PrivateCompositeWindow;
 
     private:
 	PrivateCompositeScreen *priv;
@@ -81,8 +81,7 @@ PrivateCompositeScreen::setOption (const CompString  &name,
 	    if (optionGetDetectRefreshRate ())
 		return false;
 
-	    redrawTime = 1000 / optionGetRefreshRate ();
-	    optimalRedrawTime = redrawTime;
+	    setRefreshRate (optionGetRefreshRate ());
 	    break;
 
 	default:
@@ -0,0 +1,118 @@
+/*
+ * Compiz, composite plugin, adaptive damage reporting
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef _COMPIZ_COMPOSITE_DAMAGEREPORTING_H
+#define _COMPIZ_COMPOSITE_DAMAGEREPORTING_H
+
+#include <vector>
+
+#include <core/rect.h>
+
+namespace compiz
+{
+namespace composite
+{
+namespace damagereporting
+{
+/*
+ * Merges damage rectangles as they arrive, keeping at most maxRects
+ * of them. Two rectangles are merged into their bounding box when the
+ * area the bounding box adds over the two of them is at most
+ * wastePercent of it. Once the limit is hit, the pair wasting the
+ * least area is merged regardless.
+ */
+class RectangleCoalescer
+{
+    public:
+
+	RectangleCoalescer (unsigned int maxRects,
+			    unsigned int wastePercent);
+
+	void add (const CompRect &rect);
+	void clear ();
+
+	bool empty () const;
+	const std::vector <CompRect> & rects () const;
+
+    private:
+
+	unsigned int           mMaxRects;
+	unsigned int           mWastePercent;
+	std::vector <CompRect> mRects;
+};
+
+typedef enum
+{
+    ReportBoundingBox,
+    ReportDeltaRectangles
+} ReportLevel;
+
+/*
+ * Decides whether a window's damage should be reported as bounding
+ * boxes or as individual rectangles.
+ *
+ * Rectangles let sparse updates, such as a terminal updating two
+ * distant lines, repaint only what changed. They cost one event each
+ * though, so a window producing many rectangles per frame which
+ * mostly cover their bounding box is switched to bounding boxes.
+ * As a bounding box hides how sparse the damage is, such windows are
+ * periodically switched back to rectangles to sample it again.
+ */
+class ReportLevelPolicy
+{
+    public:
+
+	ReportLevelPolicy (unsigned int maxRectsPerFrame,
+			   unsigned int wastePercent,
+			   unsigned int sampleInterval);
+
+	ReportLevel level () const;
+
+	/* Records a rectangle of damage reported for the current frame */
+	void damage (const CompRect &rect);
+
+	/* Ends the current frame, returns true if the level changed */
+	bool frame ();
+
+    private:
+
+	/* Consecutive frames needed before switching to bounding boxes */
+	static const unsigned int DENSE_FRAMES = 3;
+
+	unsigned int mMaxRectsPerFrame;
+	unsigned int mWastePercent;
+	unsigned int mSampleInterval;
+
+	ReportLevel  mLevel;
+
+	unsigned int       mFrameRects;
+	unsigned long long mFrameArea;
+	CompRect           mFrameBounds;
+
+	unsigned int mDenseFrames;
+	unsigned int mBoundingBoxFrames;
+};
+}
+}
+}
+
+#endif
@@ -0,0 +1,203 @@
+/*
+ * Compiz, composite plugin, adaptive damage reporting
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <algorithm>
+
+#include "damagereporting.h"
+
+namespace cd = compiz::composite::damagereporting;
+
+namespace
+{
+CompRect
+boundingBox (const CompRect &a, const CompRect &b)
+{
+    int x1 = std::min (a.x1 (), b.x1 ());
+    int y1 = std::min (a.y1 (), b.y1 ());
+    int x2 = std::max (a.x2 (), b.x2 ());
+    int y2 = std::max (a.y2 (), b.y2 ());
+
+    return CompRect (x1, y1, x2 - x1, y2 - y1);
+}
+
+/* The area the bounding box of a and b covers that neither of them does */
+long long
+waste (const CompRect &a, const CompRect &b, long long &boundsArea)
+{
+    boundsArea = boundingBox (a, b).area ();
+
+    return boundsArea -
+	   (static_cast <long long> (a.area ()) + b.area () - (a & b).area ());
+}
+}
+
+cd::RectangleCoalescer::RectangleCoalescer (unsigned int maxRects,
+					    unsigned int wastePercent) :
+    mMaxRects (std::max (1u, maxRects)),
+    mWastePercent (wastePercent)
+{
+    mRects.reserve (mMaxRects + 1);
+}
+
+void
+cd::RectangleCoalescer::add (const CompRect &rect)
+{
+    if (rect.isEmpty ())
+	return;
+
+    CompRect merged (rect);
+
+    /* Merging can make the result cheap to merge with rectangles that
+     * were checked before, so start over after each merge */
+    for (unsigned int i = 0; i < mRects.size ();)
+    {
+	long long boundsArea;
+	long long wasted = waste (merged, mRects[i], boundsArea);
+
+	if (wasted * 100 <= boundsArea * mWastePercent)
+	{
+	    merged = boundingBox (merged, mRects[i]);
+	    mRects.erase (mRects.begin () + i);
+	    i = 0;
+	}
+	else
+	    ++i;
+    }
+
+    mRects.push_back (merged);
+
+    if (mRects.size () <= mMaxRects)
+	return;
+
+    unsigned int bestI = 0, bestJ = 1;
+    long long    bestWaste = -1;
+
+    for (unsigned int i = 0; i < mRects.size (); ++i)
+    {
+	for (unsigned int j = i + 1; j < mRects.size (); ++j)
+	{
+	    long long boundsArea;
+	    long long wasted = waste (mRects[i], mRects[j], boundsArea);
+
+	    if (bestWaste < 0 || wasted < bestWaste)
+	    {
+		bestWaste = wasted;
+		bestI = i;
+		bestJ = j;
+	    }
+	}
+    }
+
+    mRects[bestI] = boundingBox (mRects[bestI], mRects[bestJ]);
+    mRects.erase (mRects.begin () + bestJ);
+}
+
+void
+cd::RectangleCoalescer::clear ()
+{
+    mRects.clear ();
+}
+
+bool
+cd::RectangleCoalescer::empty () const
+{
+    return mRects.empty ();
+}
+
+const std::vector <CompRect> &
+cd::RectangleCoalescer::rects () const
+{
+    return mRects;
+}
+
+cd::ReportLevelPolicy::ReportLevelPolicy (unsigned int maxRectsPerFrame,
+					  unsigned int wastePercent,
+					  unsigned int sampleInterval) :
+    mMaxRectsPerFrame (maxRectsPerFrame),
+    mWastePercent (wastePercent),
+    mSampleInterval (sampleInterval),
+    mLevel (ReportDeltaRectangles),
+    mFrameRects (0),
+    mFrameArea (0),
+    mDenseFrames (0),
+    mBoundingBoxFrames (0)
+{
+}
+
+cd::ReportLevel
+cd::ReportLevelPolicy::level () const
+{
+    return mLevel;
+}
+
+void
+cd::ReportLevelPolicy::damage (const CompRect &rect)
+{
+    if (rect.isEmpty ())
+	return;
+
+    mFrameBounds = mFrameRects ? boundingBox (mFrameBounds, rect) : rect;
+    mFrameArea += rect.area ();
+    ++mFrameRects;
+}
+
+bool
+cd::ReportLevelPolicy::frame ()
+{
+    unsigned int       rects = mFrameRects;
+    unsigned long long area = mFrameArea;
+    unsigned long long boundsArea = mFrameBounds.area ();
+
+    mFrameRects = 0;
+    mFrameArea = 0;
+
+    /* Nothing happened, nothing to learn */
+    if (!rects)
+	return false;
+
+    if (mLevel == ReportBoundingBox)
+    {
+	if (++mBoundingBoxFrames < mSampleInterval)
+	    return false;
+
+	mBoundingBoxFrames = 0;
+	mLevel = ReportDeltaRectangles;
+
+	return true;
+    }
+
+    /* Delta rectangles only cover damage that wasn't reported yet, so
+     * they hardly overlap and their summed area is what changed */
+    bool dense = rects > mMaxRectsPerFrame &&
+		 (boundsArea - std::min (area, boundsArea)) * 100 <=
+		 boundsArea * mWastePercent;
+
+    mDenseFrames = dense ? mDenseFrames + 1 : 0;
+
+    if (mDenseFrames < DENSE_FRAMES)
+	return false;
+
+    mDenseFrames = 0;
+    mLevel = ReportBoundingBox;
+
+    return true;
+}
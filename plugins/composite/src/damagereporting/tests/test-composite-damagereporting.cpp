@@ -0,0 +1,357 @@
+/*
+ * Compiz, composite plugin, adaptive damage reporting tests
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "damagereporting.h"
+
+namespace cd = compiz::composite::damagereporting;
+
+namespace
+{
+const unsigned int MAX_RECTS = 16;
+const unsigned int WASTE_PERCENT = 25;
+const unsigned int MAX_RECTS_PER_FRAME = 32;
+const unsigned int SAMPLE_INTERVAL = 60;
+
+/* Counts the pixels covered by a set of rectangles on a small canvas */
+class Coverage
+{
+    public:
+
+	Coverage (int width, int height) :
+	    mWidth (width),
+	    mPixels (width * height, false)
+	{
+	}
+
+	void add (const CompRect &r)
+	{
+	    for (int y = r.y1 (); y < r.y2 (); ++y)
+		for (int x = r.x1 (); x < r.x2 (); ++x)
+		    mPixels[y * mWidth + x] = true;
+	}
+
+	void add (const std::vector <CompRect> &rects)
+	{
+	    for (unsigned int i = 0; i < rects.size (); ++i)
+		add (rects[i]);
+	}
+
+	bool covered (int x, int y) const
+	{
+	    return mPixels[y * mWidth + x];
+	}
+
+	long long pixels () const
+	{
+	    long long n = 0;
+
+	    for (unsigned int i = 0; i < mPixels.size (); ++i)
+		n += mPixels[i];
+
+	    return n;
+	}
+
+    private:
+
+	int                mWidth;
+	std::vector <bool> mPixels;
+};
+
+CompRect
+bounds (const std::vector <CompRect> &rects)
+{
+    CompRect b (rects[0]);
+
+    for (unsigned int i = 1; i < rects.size (); ++i)
+    {
+	int x1 = std::min (b.x1 (), rects[i].x1 ());
+	int y1 = std::min (b.y1 (), rects[i].y1 ());
+	int x2 = std::max (b.x2 (), rects[i].x2 ());
+	int y2 = std::max (b.y2 (), rects[i].y2 ());
+
+	b = CompRect (x1, y1, x2 - x1, y2 - y1);
+    }
+
+    return b;
+}
+}
+
+TEST (CompositeDamageReporting, CoalescerIgnoresEmptyRects)
+{
+    cd::RectangleCoalescer coalescer (MAX_RECTS, WASTE_PERCENT);
+
+    coalescer.add (CompRect (10, 10, 0, 5));
+
+    EXPECT_TRUE (coalescer.empty ());
+}
+
+TEST (CompositeDamageReporting, CoalescerMergesAdjacentRects)
+{
+    cd::RectangleCoalescer coalescer (MAX_RECTS, WASTE_PERCENT);
+
+    /* Three consecutive lines of text */
+    coalescer.add (CompRect (0, 0, 400, 16));
+    coalescer.add (CompRect (0, 16, 400, 16));
+    coalescer.add (CompRect (0, 32, 400, 16));
+
+    ASSERT_EQ (1u, coalescer.rects ().size ());
+    EXPECT_EQ (CompRect (0, 0, 400, 48), coalescer.rects ()[0]);
+}
+
+TEST (CompositeDamageReporting, CoalescerKeepsDistantRectsApart)
+{
+    cd::RectangleCoalescer coalescer (MAX_RECTS, WASTE_PERCENT);
+
+    /* The first and the last line of a terminal */
+    coalescer.add (CompRect (0, 0, 400, 16));
+    coalescer.add (CompRect (0, 584, 400, 16));
+
+    EXPECT_EQ (2u, coalescer.rects ().size ());
+}
+
+TEST (CompositeDamageReporting, CoalescerMergesCascades)
+{
+    cd::RectangleCoalescer coalescer (MAX_RECTS, WASTE_PERCENT);
+
+    coalescer.add (CompRect (0, 0, 100, 100));
+    coalescer.add (CompRect (200, 0, 100, 100));
+
+    ASSERT_EQ (2u, coalescer.rects ().size ());
+
+    /* Bridges the gap, so all three end up in one rectangle */
+    coalescer.add (CompRect (100, 0, 100, 100));
+
+    ASSERT_EQ (1u, coalescer.rects ().size ());
+    EXPECT_EQ (CompRect (0, 0, 300, 100), coalescer.rects ()[0]);
+}
+
+TEST (CompositeDamageReporting, CoalescerBoundsRectCount)
+{
+    cd::RectangleCoalescer coalescer (4, WASTE_PERCENT);
+    Coverage               reported (1000, 1000);
+
+    for (int i = 0; i < 10; ++i)
+    {
+	CompRect r (i * 100, i * 100, 10, 10);
+
+	coalescer.add (r);
+	reported.add (r);
+
+	EXPECT_LE (coalescer.rects ().size (), 4u);
+    }
+
+    /* Nothing reported gets lost while merging */
+    Coverage coalesced (1000, 1000);
+    coalesced.add (coalescer.rects ());
+
+    for (int i = 0; i < 10; ++i)
+	EXPECT_TRUE (coalesced.covered (i * 100 + 5, i * 100 + 5));
+
+    coalescer.clear ();
+    EXPECT_TRUE (coalescer.empty ());
+}
+
+TEST (CompositeDamageReporting, PolicyStartsWithDeltaRectangles)
+{
+    cd::ReportLevelPolicy policy (MAX_RECTS_PER_FRAME, WASTE_PERCENT,
+				  SAMPLE_INTERVAL);
+
+    EXPECT_EQ (cd::ReportDeltaRectangles, policy.level ());
+}
+
+TEST (CompositeDamageReporting, PolicyKeepsRectanglesForSparseDamage)
+{
+    cd::ReportLevelPolicy policy (MAX_RECTS_PER_FRAME, WASTE_PERCENT,
+				  SAMPLE_INTERVAL);
+
+    for (int frame = 0; frame < 100; ++frame)
+    {
+	/* Many small rectangles scattered over a large area */
+	for (int i = 0; i < 64; ++i)
+	    policy.damage (CompRect (i * 20, i * 20, 4, 4));
+
+	EXPECT_FALSE (policy.frame ());
+    }
+
+    EXPECT_EQ (cd::ReportDeltaRectangles, policy.level ());
+}
+
+TEST (CompositeDamageReporting, PolicySwitchesToBoundingBoxForDenseDamage)
+{
+    cd::ReportLevelPolicy policy (MAX_RECTS_PER_FRAME, WASTE_PERCENT,
+				  SAMPLE_INTERVAL);
+
+    bool switched = false;
+
+    for (int frame = 0; frame < 10 && !switched; ++frame)
+    {
+	/* A tiled redraw covering the whole window */
+	for (int y = 0; y < 8; ++y)
+	    for (int x = 0; x < 8; ++x)
+		policy.damage (CompRect (x * 50, y * 50, 50, 50));
+
+	switched = policy.frame ();
+    }
+
+    EXPECT_TRUE (switched);
+    EXPECT_EQ (cd::ReportBoundingBox, policy.level ());
+}
+
+TEST (CompositeDamageReporting, PolicyNeedsConsecutiveDenseFrames)
+{
+    cd::ReportLevelPolicy policy (MAX_RECTS_PER_FRAME, WASTE_PERCENT,
+				  SAMPLE_INTERVAL);
+
+    for (int frame = 0; frame < 20; ++frame)
+    {
+	if (frame % 2)
+	    policy.damage (CompRect (0, 0, 10, 10));
+	else
+	    for (int i = 0; i < 64; ++i)
+		policy.damage (CompRect (i * 10, 0, 10, 10));
+
+	EXPECT_FALSE (policy.frame ());
+    }
+}
+
+TEST (CompositeDamageReporting, PolicySamplesRectanglesAgain)
+{
+    cd::ReportLevelPolicy policy (MAX_RECTS_PER_FRAME, WASTE_PERCENT,
+				  SAMPLE_INTERVAL);
+
+    while (policy.level () != cd::ReportBoundingBox)
+    {
+	for (int i = 0; i < 64; ++i)
+	    policy.damage (CompRect (i * 10, 0, 10, 10));
+
+	policy.frame ();
+    }
+
+    /* Frames without damage don't count */
+    for (unsigned int frame = 0; frame < SAMPLE_INTERVAL * 2; ++frame)
+	EXPECT_FALSE (policy.frame ());
+
+    unsigned int frames = 0;
+
+    do
+    {
+	policy.damage (CompRect (0, 0, 640, 10));
+	++frames;
+    } while (!policy.frame ());
+
+    EXPECT_EQ (SAMPLE_INTERVAL, frames);
+    EXPECT_EQ (cd::ReportDeltaRectangles, policy.level ());
+}
+
+/*
+ * Compares the pixels repainted with bounding box reporting and with
+ * coalesced rectangles against the pixels that actually changed, for
+ * a terminal updating a few lines at a time and for scattered updates.
+ */
+TEST (CompositeDamageReporting, BenchmarkRepaintedVersusChangedPixels)
+{
+    const int WIDTH = 800;
+    const int HEIGHT = 600;
+    const int LINE_HEIGHT = 16;
+    const int FRAMES = 200;
+
+    srand (42);
+
+    const char *workloads[] = { "terminal", "scattered" };
+
+    for (unsigned int w = 0; w < 2; ++w)
+    {
+	long long changed = 0, boundingBox = 0, coalesced = 0;
+
+	for (int frame = 0; frame < FRAMES; ++frame)
+	{
+	    std::vector <CompRect> damage;
+
+	    if (w == 0)
+	    {
+		/* A cursor line and a status line, sometimes more */
+		int lines = 2 + rand () % 3;
+
+		for (int i = 0; i < lines; ++i)
+		{
+		    int line = rand () % (HEIGHT / LINE_HEIGHT);
+		    int x = rand () % (WIDTH / 2);
+
+		    damage.push_back (CompRect (x, line * LINE_HEIGHT,
+						1 + rand () % (WIDTH - x),
+						LINE_HEIGHT));
+		}
+	    }
+	    else
+	    {
+		int n = 1 + rand () % 40;
+
+		for (int i = 0; i < n; ++i)
+		    damage.push_back (CompRect (rand () % (WIDTH - 32),
+						rand () % (HEIGHT - 32),
+						1 + rand () % 32,
+						1 + rand () % 32));
+	    }
+
+	    cd::RectangleCoalescer coalescer (MAX_RECTS, WASTE_PERCENT);
+
+	    for (unsigned int i = 0; i < damage.size (); ++i)
+		coalescer.add (damage[i]);
+
+	    Coverage exact (WIDTH, HEIGHT), merged (WIDTH, HEIGHT);
+
+	    exact.add (damage);
+	    merged.add (coalescer.rects ());
+
+	    long long exactPixels = exact.pixels ();
+	    long long mergedPixels = merged.pixels ();
+
+	    EXPECT_GE (mergedPixels, exactPixels);
+	    EXPECT_LE (coalescer.rects ().size (), MAX_RECTS);
+
+	    changed += exactPixels;
+	    coalesced += mergedPixels;
+	    boundingBox += bounds (damage).area ();
+	}
+
+	EXPECT_LE (coalesced, boundingBox);
+
+	std::stringstream ss;
+	ss << "changed " << changed
+	   << ", bounding box " << boundingBox
+	   << " (" << boundingBox * 100 / changed << "%)"
+	   << ", coalesced " << coalesced
+	   << " (" << coalesced * 100 / changed << "%)";
+
+	RecordProperty (workloads[w], ss.str ().c_str ());
+	std::cout << "[ BENCH    ] " << workloads[w] << ": "
+		  << ss.str () << std::endl;
+    }
+}
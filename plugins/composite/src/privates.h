@@ -37,6 +37,8 @@
 
 #include "pixmapbinding.h"
 #include "backbuffertracking.h"
+#include "damagereporting.h"
+#include "scheduler.h"
 #include "composite_options.h"
 
 extern CompPlugin::VTable *compositeVTable;
@@ -71,6 +73,7 @@ class PrivateCompositeScreen :
 	void handleExposeEvent (XExposeEvent *event);
 
 	void detectRefreshRate ();
+	void setRefreshRate (int rate);
 
 	void scheduleRepaint ();
 
@@ -107,9 +110,11 @@ class PrivateCompositeScreen :
 	int overlayWindowCount;
 	bool outputShapeChanged;
 
-	struct timeval lastRedraw;
-	int            redrawTime;
-	int            optimalRedrawTime;
+	compiz::composite::scheduler::MonotonicClock clock;
+	compiz::composite::scheduler::FrameScheduler frameScheduler;
+	int                                           redrawTime;
+	int                                           optimalRedrawTime;
+	float                                         preparePaintRemainder;
 	bool           scheduled, painting, reschedule;
 	bool           damageRequiresRepaintReschedule;
 
@@ -126,9 +131,12 @@ class PrivateCompositeScreen :
 	Atom cmSnAtom;
 	Window newCmSnOwner;
 
-	/* Map Damage handle to its bounding box */
+	/* Map Damage handle to the bounding box of its damage */
 	std::map<Damage, XRectangle> damages;
 
+	/* Incremented whenever the damage of a frame has been collected */
+	unsigned int damageFrameSequence;
+
 	compiz::composite::buffertracking::AgeingDamageBuffers ageingBuffers;
 	compiz::composite::buffertracking::FrameRoster         roster;
 };
@@ -162,6 +170,12 @@ class PrivateCompositeWindow :
 				      int             width,
 				      int             height);
 
+	void processDamage (XDamageNotifyEvent *de);
+	void createDamage ();
+	void destroyDamage ();
+	void updateDamageReportLevel ();
+	void flushDamageRects ();
+
     public:
 	CompWindow      *window;
 	CompositeWindow *cWindow;
@@ -179,9 +193,13 @@ class PrivateCompositeWindow :
 	unsigned short brightness;
 	unsigned short saturation;
 
-	XRectangle *damageRects;
-	int        sizeDamage;
-	int        nDamage;
+	/* Damage held back while waiting for the client to sync */
+	std::vector <XRectangle> damageRects;
+
+	compiz::composite::damagereporting::ReportLevel        damageLevel;
+	compiz::composite::damagereporting::ReportLevelPolicy  damagePolicy;
+	compiz::composite::damagereporting::RectangleCoalescer damageCoalescer;
+	unsigned int                                           damageFrame;
 
     private:
 
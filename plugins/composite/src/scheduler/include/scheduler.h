@@ -0,0 +1,98 @@
+/*
+ * Compiz, composite plugin, frame scheduling
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef _COMPIZ_COMPOSITE_SCHEDULER_H
+#define _COMPIZ_COMPOSITE_SCHEDULER_H
+
+namespace compiz
+{
+namespace composite
+{
+namespace scheduler
+{
+class Clock
+{
+    public:
+
+	virtual ~Clock () {}
+
+	/* Nanoseconds on a clock that never goes backwards */
+	virtual long long now () = 0;
+};
+
+class MonotonicClock :
+    public Clock
+{
+    public:
+
+	long long now ();
+};
+
+/*
+ * Decides when to start painting the next frame. It measures how long
+ * painting takes and starts each frame just early enough to have it
+ * finished one frame period after the previous one, so that frames
+ * are evenly paced and contain the most recent damage possible.
+ *
+ * All times are in nanoseconds.
+ */
+class FrameScheduler
+{
+    public:
+
+	FrameScheduler (Clock &clock, long long framePeriod);
+
+	void setFramePeriod (long long framePeriod);
+	long long framePeriod () const;
+
+	/* How long to wait from now before starting the next frame */
+	long long delay ();
+
+	/* Marks the start of a frame and returns the time since the
+	 * previous one started. After being idle for a while the frame
+	 * period is returned instead, as animations expect small steps */
+	long long beginFrame ();
+
+	/* Marks the end of a frame, painted is false if nothing was */
+	void endFrame (bool painted);
+
+	/* Expected time painting a frame takes, with some margin */
+	long long paintTimeEstimate () const;
+
+    private:
+
+	Clock     &mClock;
+	long long mFramePeriod;
+
+	bool      mStarted;
+	long long mFrameStart;
+	long long mLastPaintEnd;
+
+	bool      mHavePaintTime;
+	long long mPaintTime;
+	long long mPaintTimeDeviation;
+};
+}
+}
+}
+
+#endif
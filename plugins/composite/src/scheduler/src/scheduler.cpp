@@ -0,0 +1,134 @@
+/*
+ * Compiz, composite plugin, frame scheduling
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <cstdlib>
+#include <time.h>
+
+#include "scheduler.h"
+
+namespace cs = compiz::composite::scheduler;
+
+namespace
+{
+/* Intervals longer than this mean the screen was idle */
+const long long MAX_FRAME_INTERVAL = 100 * 1000000LL;
+}
+
+long long
+cs::MonotonicClock::now ()
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+cs::FrameScheduler::FrameScheduler (Clock     &clock,
+				    long long framePeriod) :
+    mClock (clock),
+    mFramePeriod (framePeriod),
+    mStarted (false),
+    mFrameStart (0),
+    mLastPaintEnd (0),
+    mHavePaintTime (false),
+    mPaintTime (0),
+    mPaintTimeDeviation (0)
+{
+}
+
+void
+cs::FrameScheduler::setFramePeriod (long long framePeriod)
+{
+    mFramePeriod = framePeriod;
+}
+
+long long
+cs::FrameScheduler::framePeriod () const
+{
+    return mFramePeriod;
+}
+
+long long
+cs::FrameScheduler::paintTimeEstimate () const
+{
+    /* Like round trip time estimation in TCP: the average plus four
+     * times the mean deviation covers nearly all frames */
+    return mPaintTime + 4 * mPaintTimeDeviation;
+}
+
+long long
+cs::FrameScheduler::delay ()
+{
+    if (!mHavePaintTime)
+	return 0;
+
+    long long deadline = mLastPaintEnd + mFramePeriod;
+    long long start = deadline - paintTimeEstimate ();
+    long long now = mClock.now ();
+
+    return start > now ? start - now : 0;
+}
+
+long long
+cs::FrameScheduler::beginFrame ()
+{
+    long long now = mClock.now ();
+    long long interval = mStarted ? now - mFrameStart : mFramePeriod;
+
+    mStarted = true;
+    mFrameStart = now;
+
+    if (interval < 0)
+	return 0;
+
+    if (interval > MAX_FRAME_INTERVAL)
+	return mFramePeriod;
+
+    return interval;
+}
+
+void
+cs::FrameScheduler::endFrame (bool painted)
+{
+    if (!painted)
+	return;
+
+    long long now = mClock.now ();
+    long long paintTime = now - mFrameStart;
+
+    mLastPaintEnd = now;
+
+    if (!mHavePaintTime)
+    {
+	mHavePaintTime = true;
+	mPaintTime = paintTime;
+	mPaintTimeDeviation = paintTime / 2;
+	return;
+    }
+
+    long long error = paintTime - mPaintTime;
+
+    /* Exponentially weighted, 1/8 for the average, 1/4 for deviation */
+    mPaintTime += error / 8;
+    mPaintTimeDeviation += (llabs (error) - mPaintTimeDeviation) / 4;
+}
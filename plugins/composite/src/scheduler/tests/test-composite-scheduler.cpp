@@ -0,0 +1,202 @@
+/*
+ * Compiz, composite plugin, frame scheduling tests
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include "scheduler.h"
+
+namespace cs = compiz::composite::scheduler;
+
+namespace
+{
+const long long MS = 1000000LL;
+
+/* 144Hz, which can't be expressed in whole milliseconds */
+const long long PERIOD_144HZ = 1000000000LL / 144;
+
+class FakeClock :
+    public cs::Clock
+{
+    public:
+
+	FakeClock () : time (1000 * MS) {}
+
+	long long now () { return time; }
+
+	void advance (long long ns) { time += ns; }
+
+	long long time;
+};
+
+/* Paints a frame taking paintTime, waiting for the scheduler first */
+long long
+runFrame (FakeClock &clock, cs::FrameScheduler &scheduler, long long paintTime)
+{
+    clock.advance (scheduler.delay ());
+
+    long long interval = scheduler.beginFrame ();
+
+    clock.advance (paintTime);
+    scheduler.endFrame (true);
+
+    return interval;
+}
+}
+
+TEST (CompositeFrameScheduler, NoDelayBeforeFirstFrame)
+{
+    FakeClock          clock;
+    cs::FrameScheduler scheduler (clock, PERIOD_144HZ);
+
+    EXPECT_EQ (0, scheduler.delay ());
+}
+
+TEST (CompositeFrameScheduler, FirstIntervalIsFramePeriod)
+{
+    FakeClock          clock;
+    cs::FrameScheduler scheduler (clock, PERIOD_144HZ);
+
+    EXPECT_EQ (PERIOD_144HZ, scheduler.beginFrame ());
+}
+
+TEST (CompositeFrameScheduler, IntervalsHaveNanosecondPrecision)
+{
+    FakeClock          clock;
+    cs::FrameScheduler scheduler (clock, PERIOD_144HZ);
+
+    scheduler.beginFrame ();
+    clock.advance (6944444);
+
+    EXPECT_EQ (6944444, scheduler.beginFrame ());
+}
+
+TEST (CompositeFrameScheduler, LongIntervalsAreClampedToFramePeriod)
+{
+    FakeClock          clock;
+    cs::FrameScheduler scheduler (clock, PERIOD_144HZ);
+
+    scheduler.beginFrame ();
+    clock.advance (5000 * MS);
+
+    EXPECT_EQ (PERIOD_144HZ, scheduler.beginFrame ());
+}
+
+TEST (CompositeFrameScheduler, EstimateConvergesOnPaintTime)
+{
+    FakeClock          clock;
+    cs::FrameScheduler scheduler (clock, PERIOD_144HZ);
+
+    for (int i = 0; i < 100; ++i)
+	runFrame (clock, scheduler, 2 * MS);
+
+    EXPECT_NEAR (2 * MS, scheduler.paintTimeEstimate (), MS / 100);
+}
+
+TEST (CompositeFrameScheduler, EstimateCoversJitter)
+{
+    FakeClock          clock;
+    cs::FrameScheduler scheduler (clock, PERIOD_144HZ);
+
+    for (int i = 0; i < 100; ++i)
+	runFrame (clock, scheduler, (i % 2) ? 3 * MS : 1 * MS);
+
+    EXPECT_GE (scheduler.paintTimeEstimate (), 3 * MS);
+}
+
+TEST (CompositeFrameScheduler, FramesFinishOnePeriodApart)
+{
+    FakeClock          clock;
+    cs::FrameScheduler scheduler (clock, PERIOD_144HZ);
+
+    /* Let the estimate settle */
+    for (int i = 0; i < 50; ++i)
+	runFrame (clock, scheduler, 2 * MS);
+
+    long long lastEnd = clock.now ();
+
+    for (int i = 0; i < 50; ++i)
+    {
+	runFrame (clock, scheduler, 2 * MS);
+
+	/* Evenly paced, without millisecond rounding */
+	EXPECT_NEAR (PERIOD_144HZ, clock.now () - lastEnd, 1000);
+	lastEnd = clock.now ();
+    }
+}
+
+TEST (CompositeFrameScheduler, SlowerPaintStartsEarlier)
+{
+    FakeClock          clock;
+    cs::FrameScheduler fast (clock, PERIOD_144HZ);
+    FakeClock          slowClock;
+    cs::FrameScheduler slow (slowClock, PERIOD_144HZ);
+
+    for (int i = 0; i < 50; ++i)
+    {
+	runFrame (clock, fast, 1 * MS);
+	runFrame (slowClock, slow, 4 * MS);
+    }
+
+    EXPECT_GT (fast.delay (), slow.delay ());
+}
+
+TEST (CompositeFrameScheduler, NoDelayWhenLate)
+{
+    FakeClock          clock;
+    cs::FrameScheduler scheduler (clock, PERIOD_144HZ);
+
+    runFrame (clock, scheduler, 2 * MS);
+    clock.advance (PERIOD_144HZ);
+
+    EXPECT_EQ (0, scheduler.delay ());
+}
+
+TEST (CompositeFrameScheduler, UnpaintedFramesDontCount)
+{
+    FakeClock          clock;
+    cs::FrameScheduler scheduler (clock, PERIOD_144HZ);
+
+    runFrame (clock, scheduler, 2 * MS);
+
+    long long estimate = scheduler.paintTimeEstimate ();
+    long long delay = scheduler.delay ();
+
+    ASSERT_GT (delay, 0);
+
+    scheduler.beginFrame ();
+    clock.advance (delay / 2);
+    scheduler.endFrame (false);
+
+    EXPECT_EQ (estimate, scheduler.paintTimeEstimate ());
+    EXPECT_EQ (delay - delay / 2, scheduler.delay ());
+}
+
+TEST (CompositeFrameScheduler, FramePeriodCanChange)
+{
+    FakeClock          clock;
+    cs::FrameScheduler scheduler (clock, PERIOD_144HZ);
+
+    scheduler.setFramePeriod (1000000000LL / 60);
+
+    EXPECT_EQ (1000000000LL / 60, scheduler.framePeriod ());
+    EXPECT_EQ (1000000000LL / 60, scheduler.beginFrame ());
+}
@@ -31,6 +31,7 @@
 
 #include <boost/make_shared.hpp>
 
+#include <algorithm>
 #include <sys/time.h>
 
 #include <X11/Xlib.h>
@@ -46,6 +47,7 @@
 #include <X11/extensions/Xrandr.h>
 
 #include <core/timer.h>
+#include <core/trace.h>
 
 template class WrapableInterface<CompositeScreen, CompositeScreenInterface>;
 
@@ -107,7 +109,27 @@ PrivateCompositeScreen::handleEvent (XEvent *event)
 	    else if (event->type == damageEvent + XDamageNotify)
 	    {
 		XDamageNotifyEvent *de = (XDamageNotifyEvent*)event;
-		damages[de->damage] = de->area;
+		std::map<Damage, XRectangle>::iterator d = damages.find (de->damage);
+
+		/* Windows reporting delta rectangles send several events
+		 * per frame, subtract the bounding box of all of them */
+		if (d == damages.end ())
+		    damages[de->damage] = de->area;
+		else
+		{
+		    XRectangle &r = d->second;
+		    int        x1 = std::min (r.x, de->area.x);
+		    int        y1 = std::min (r.y, de->area.y);
+		    int        x2 = std::max (r.x + r.width,
+					      de->area.x + de->area.width);
+		    int        y2 = std::max (r.y + r.height,
+					      de->area.y + de->area.height);
+
+		    r.x      = x1;
+		    r.y      = y1;
+		    r.width  = x2 - x1;
+		    r.height = y2 - y1;
+		}
 	    }
 	    break;
     }
@@ -302,8 +324,10 @@ PrivateCompositeScreen::PrivateCompositeScreen (CompositeScreen *cs) :
     windowPaintOffset (0, 0),
     overlayWindowCount (0),
     outputShapeChanged (false),
+    frameScheduler (clock, 1000000000LL / FALLBACK_REFRESH_RATE),
     redrawTime (1000 / FALLBACK_REFRESH_RATE),
     optimalRedrawTime (1000 / FALLBACK_REFRESH_RATE),
+    preparePaintRemainder (0.0f),
     scheduled (false),
     painting (false),
     reschedule (false),
@@ -314,11 +338,11 @@ PrivateCompositeScreen::PrivateCompositeScreen (CompositeScreen *cs) :
     withDestroyedWindows (),
     cmSnAtom (0),
     newCmSnOwner (None),
+    damageFrameSequence (0),
     roster (*screen,
 	    ageingBuffers,
 	    boost::bind (alwaysMarkDirty))
 {
-    gettimeofday (&lastRedraw, 0);
     // wrap outputChangeNotify
     ScreenInterface::setHandler (screen);
 
@@ -796,7 +820,7 @@ PrivateCompositeScreen::detectRefreshRate ()
 	mOptions[CompositeOptions::DetectRefreshRate].value ().set (false);
 	screen->setOptionForPlugin ("composite", "refresh_rate", value);
 	mOptions[CompositeOptions::DetectRefreshRate].value ().set (true);
-	optimalRedrawTime = redrawTime = 1000 / value.i ();
+	setRefreshRate (value.i ());
     }
     else
     {
@@ -809,11 +833,18 @@ PrivateCompositeScreen::detectRefreshRate ()
 	    screen->setOptionForPlugin ("composite", "refresh_rate", value);
 	}
 
-	redrawTime = 1000 / optionGetRefreshRate ();
-	optimalRedrawTime = redrawTime;
+	setRefreshRate (optionGetRefreshRate ());
     }
 }
 
+void
+PrivateCompositeScreen::setRefreshRate (int rate)
+{
+    redrawTime = 1000 / rate;
+    optimalRedrawTime = redrawTime;
+    frameScheduler.setFramePeriod (1000000000LL / rate);
+}
+
 CompositeFPSLimiterMode
 CompositeScreen::FPSLimiterMode ()
 {
@@ -846,16 +877,8 @@ PrivateCompositeScreen::scheduleRepaint ()
 	(pHnd && pHnd->hasVSync ()))
 	delay = 1;
     else
-    {
-	struct timeval now;
-	gettimeofday (&now, 0);
-	int elapsed = compiz::core::timer::timeval_diff (&now, &lastRedraw);
-
-	if (elapsed < 0)
-	    elapsed = 0;
-
- 	delay = elapsed < optimalRedrawTime ? optimalRedrawTime - elapsed : 1;
-    }
+	/* Timers only have millisecond resolution, rather start early */
+	delay = frameScheduler.delay () / 1000000;
 
     paintTimer.start
 	(boost::bind (&CompositeScreen::handlePaintTimeout, cScreen),
@@ -877,11 +900,13 @@ CompositeScreen::optimalRedrawTime ()
 bool
 CompositeScreen::handlePaintTimeout ()
 {
-    struct      timeval tv;
+    COMPIZ_TRACE_SCOPE ("paint", "handlePaintTimeout");
+
+    long long interval = priv->frameScheduler.beginFrame ();
+    bool      painted = priv->damageMask;
 
     priv->painting = true;
     priv->reschedule = false;
-    gettimeofday (&tv, 0);
 
     if (priv->damageMask)
     {
@@ -892,23 +917,16 @@ CompositeScreen::handlePaintTimeout ()
 	if (priv->pHnd)
 	    priv->pHnd->prepareDrawing ();
 
-	int timeDiff = compiz::core::timer::timeval_diff (&tv, &priv->lastRedraw);
-
-	/* handle clock rollback */
-	if (timeDiff < 0)
-	    timeDiff = 0;
 	/*
-	 * Now that we use a "tickless" timing algorithm, timeDiff could be
-	 * very large if the screen is truely idle.
-	 * However plugins expect the old behaviour where timeDiff is rarely
-	 * larger than the frame rate (optimalRedrawTime).
-	 * So enforce this to keep animations timed correctly and smooth...
+	 * Now that we use a "tickless" timing algorithm, the interval could
+	 * be very large if the screen is truely idle. However plugins expect
+	 * the old behaviour where it is rarely larger than the frame period,
+	 * so the scheduler returns the frame period after being idle.
 	 */
-	if (timeDiff > 100)
-	    timeDiff = priv->optimalRedrawTime;
+	float msSinceLastPaint = interval / 1000000.0f;
 
-	priv->redrawTime = timeDiff;
-	preparePaint (priv->slowAnimations ? 1 : timeDiff);
+	priv->redrawTime = interval / 1000000;
+	preparePaintPrecise (priv->slowAnimations ? 1.0f : msSinceLastPaint);
 
 	/* substract top most overlay window region */
 	if (priv->overlayWindowCount)
@@ -962,6 +980,7 @@ CompositeScreen::handlePaintTimeout ()
 
 	XSync (dpy, False);
 	priv->damages.clear ();
+	++priv->damageFrameSequence;
 
 	/* Any more damage requires a repaint reschedule */
 	priv->damageRequiresRepaintReschedule = true;
@@ -1004,7 +1023,7 @@ CompositeScreen::handlePaintTimeout ()
 	}
     }
 
-    priv->lastRedraw = tv;
+    priv->frameScheduler.endFrame (painted);
     priv->painting = false;
     priv->scheduled = false;
     if (priv->reschedule)
@@ -1015,17 +1034,33 @@ CompositeScreen::handlePaintTimeout ()
 
 void
 CompositeScreen::preparePaint (int msSinceLastPaint)
-    WRAPABLE_HND_FUNCTN (preparePaint, msSinceLastPaint)
+    WRAPABLE_HND_FUNCTN_TRACED (preparePaint, msSinceLastPaint)
+
+void
+CompositeScreen::preparePaintPrecise (float msSinceLastPaint)
+{
+    WRAPABLE_HND_FUNCTN (preparePaintPrecise, msSinceLastPaint)
+
+    /* Carry what rounding drops over to the next frame, so that
+     * animations stepped in whole milliseconds don't drift */
+    priv->preparePaintRemainder += msSinceLastPaint;
+
+    int ms = priv->preparePaintRemainder;
+
+    priv->preparePaintRemainder -= ms;
+
+    preparePaint (ms);
+}
 
 void
 CompositeScreen::donePaint ()
-    WRAPABLE_HND_FUNCTN (donePaint)
+    WRAPABLE_HND_FUNCTN_TRACED (donePaint)
 
 void
 CompositeScreen::paint (CompOutput::ptrList &outputs,
 		        unsigned int        mask)
 {
-    WRAPABLE_HND_FUNCTN (paint, outputs, mask)
+    WRAPABLE_HND_FUNCTN_TRACED (paint, outputs, mask)
 
     if (priv->pHnd)
 	priv->pHnd->paintOutputs (outputs, mask, priv->tmpRegion);
@@ -1150,6 +1185,10 @@ void
 CompositeScreenInterface::damageCutoff ()
     WRAPABLE_DEF (damageCutoff);
 
+void
+CompositeScreenInterface::preparePaintPrecise (float msSinceLastPaint)
+    WRAPABLE_DEF (preparePaintPrecise, msSinceLastPaint);
+
 const CompRegion &
 CompositeScreen::currentDamage () const
 {
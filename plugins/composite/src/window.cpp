@@ -30,6 +30,23 @@
 template class WrapableInterface<CompositeWindow, CompositeWindowInterface>;
 template class PluginClassHandler<CompositeWindow, CompWindow, COMPIZ_COMPOSITE_ABI>;
 
+namespace cd = compiz::composite::damagereporting;
+
+namespace
+{
+    /* Damage rectangles kept per window before merging them */
+    const unsigned int MAX_DAMAGE_RECTS = 16;
+
+    /* Merge rectangles if at most this much of the result is undamaged */
+    const unsigned int DAMAGE_WASTE_PERCENT = 25;
+
+    /* Windows reporting more rectangles per frame get bounding boxes */
+    const unsigned int MAX_DAMAGE_RECTS_PER_FRAME = 32;
+
+    /* Damaged frames after which bounding box windows are sampled again */
+    const unsigned int DAMAGE_SAMPLE_INTERVAL = 120;
+}
+
 CompositeWindow::CompositeWindow (CompWindow *w) :
     PluginClassHandler<CompositeWindow, CompWindow, COMPIZ_COMPOSITE_ABI> (w),
     priv (new PrivateCompositeWindow (w, this))
@@ -37,10 +54,7 @@ CompositeWindow::CompositeWindow (CompWindow *w) :
     CompScreen *s = screen;
 
     if (w->windowClass () != InputOnly)
-	priv->damage = XDamageCreate (s->dpy (), w->id (),
-				      XDamageReportBoundingBox);
-    else
-	priv->damage = None;
+	priv->createDamage ();
 
     priv->opacity = OPAQUE;
 
@@ -60,8 +74,7 @@ CompositeWindow::CompositeWindow (CompWindow *w) :
 
 CompositeWindow::~CompositeWindow ()
 {
-    if (priv->damage)
-	XDamageDestroy (screen->dpy (), priv->damage);
+    priv->destroyDamage ();
 
      if (!priv->redirected)
     {
@@ -116,17 +129,86 @@ PrivateCompositeWindow::PrivateCompositeWindow (CompWindow      *w,
     opacity (OPAQUE),
     brightness (BRIGHT),
     saturation (COLOR),
-    damageRects (0),
-    sizeDamage (0),
-    nDamage (0)
+    damageLevel (cd::ReportBoundingBox),
+    damagePolicy (MAX_DAMAGE_RECTS_PER_FRAME,
+		  DAMAGE_WASTE_PERCENT,
+		  DAMAGE_SAMPLE_INTERVAL),
+    damageCoalescer (MAX_DAMAGE_RECTS, DAMAGE_WASTE_PERCENT),
+    damageFrame (cScreen->priv->damageFrameSequence)
 {
+    damageRects.reserve (MAX_DAMAGE_RECTS);
+
     WindowInterface::setHandler (w);
 }
 
 PrivateCompositeWindow::~PrivateCompositeWindow ()
 {
-    if (sizeDamage)
-	free (damageRects);
+}
+
+void
+PrivateCompositeWindow::createDamage ()
+{
+    if (cScreen->priv->optionGetAdaptiveDamageReporting ())
+	damageLevel = damagePolicy.level ();
+    else
+	damageLevel = cd::ReportBoundingBox;
+
+    damage = XDamageCreate (screen->dpy (), window->id (),
+			    damageLevel == cd::ReportDeltaRectangles ?
+			    XDamageReportDeltaRectangles :
+			    XDamageReportBoundingBox);
+}
+
+void
+PrivateCompositeWindow::destroyDamage ()
+{
+    if (!damage)
+	return;
+
+    XDamageDestroy (screen->dpy (), damage);
+
+    /* Nothing left to subtract from */
+    cScreen->priv->damages.erase (damage);
+    damage = None;
+}
+
+void
+PrivateCompositeWindow::updateDamageReportLevel ()
+{
+    if (damageFrame == cScreen->priv->damageFrameSequence)
+	return;
+
+    /* The first damage of a new frame, learn from the previous one */
+    damageFrame = cScreen->priv->damageFrameSequence;
+    damagePolicy.frame ();
+
+    cd::ReportLevel level = cd::ReportBoundingBox;
+
+    if (cScreen->priv->optionGetAdaptiveDamageReporting ())
+	level = damagePolicy.level ();
+
+    if (level == damageLevel || !damage)
+	return;
+
+    flushDamageRects ();
+
+    /* Create the new damage before destroying the old one, so that
+     * nothing drawn in between goes unreported */
+    Damage old = damage;
+
+    createDamage ();
+
+    XDamageDestroy (screen->dpy (), old);
+    cScreen->priv->damages.erase (old);
+}
+
+void
+PrivateCompositeWindow::flushDamageRects ()
+{
+    foreach (const CompRect &r, damageCoalescer.rects ())
+	handleDamageRect (cWindow, r.x (), r.y (), r.width (), r.height ());
+
+    damageCoalescer.clear ();
 }
 
 bool
@@ -404,25 +486,33 @@ CompositeWindow::damaged ()
 void
 CompositeWindow::processDamage (XDamageNotifyEvent *de)
 {
-    if (priv->window->syncWait ())
-    {
-	if (priv->nDamage == priv->sizeDamage)
-	{
-	    priv->damageRects = (XRectangle *) realloc (priv->damageRects,
-				 (priv->sizeDamage + 1) *
-				 sizeof (XRectangle));
-	    priv->sizeDamage += 1;
-	}
+    priv->processDamage (de);
+}
+
+void
+PrivateCompositeWindow::processDamage (XDamageNotifyEvent *de)
+{
+    /* Still queued from a damage replaced by updateDamageReportLevel */
+    if (de->damage != damage)
+	cScreen->priv->damages.erase (de->damage);
+
+    updateDamageReportLevel ();
+
+    CompRect rect (de->area);
 
-	priv->damageRects[priv->nDamage].x      = de->area.x;
-	priv->damageRects[priv->nDamage].y      = de->area.y;
-	priv->damageRects[priv->nDamage].width  = de->area.width;
-	priv->damageRects[priv->nDamage].height = de->area.height;
-	priv->nDamage++;
+    damagePolicy.damage (rect);
+
+    if (window->syncWait ())
+    {
+	damageRects.push_back (de->area);
+	return;
     }
-    else
-	priv->handleDamageRect (this, de->area.x, de->area.y,
-				de->area.width, de->area.height);
+
+    damageCoalescer.add (rect);
+
+    /* Rectangles reported together are painted together */
+    if (!de->more)
+	flushDamageRects ();
 }
 
 void
@@ -565,17 +655,11 @@ PrivateCompositeWindow::windowNotify (CompWindowNotify n)
 
 	case CompWindowNotifySyncAlarm:
 	{
-	    XRectangle *rects;
-
-	    rects   = damageRects;
-	    while (nDamage--)
-	    {
-		PrivateCompositeWindow::handleDamageRect (cWindow,
-							  rects[nDamage].x,
-							  rects[nDamage].y,
-							  rects[nDamage].width,
-							  rects[nDamage].height);
-	    }
+	    foreach (const XRectangle &r, damageRects)
+		damageCoalescer.add (CompRect (r));
+
+	    damageRects.clear ();
+	    flushDamageRects ();
 	    break;
 	}
 
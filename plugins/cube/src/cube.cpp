@@ -138,6 +138,7 @@ void
 CubeScreen::rotationState (CubeScreen::RotationState state)
 {
     priv->mRotationState = state;
+    priv->toggleFunctions (true);
 }
 
 int 
@@ -651,6 +652,9 @@ PrivateCubeScreen::setOption (const CompString  &name,
     if (!rv || !CompOption::findOption (getOptions (), name, &index))
 	return false;
 
+    /* the opacities and cap colors are picked up in preparePaint */
+    toggleFunctions (true);
+
     switch (index)
     {
 	case CubeOptions::In:
@@ -745,9 +749,6 @@ PrivateCubeScreen::preparePaint (int msSinceLastPaint)
 	}
     }
 
-    memset (mCleared, 0, sizeof (Bool) * screen->outputDevs ().size ());
-    memset (mCapsPainted, 0, sizeof (Bool) * screen->outputDevs ().size ());
-
     /* Transparency handling */
     if (mRotationState == CubeScreen::RotationManual ||
 	(mRotationState == CubeScreen::RotationChange &&
@@ -816,6 +817,13 @@ PrivateCubeScreen::glPaintOutput (const GLScreenPaintAttrib &sAttrib,
 
     mSrcOutput = ((unsigned int) output->id () != (unsigned int) ~0) ?
 		     output->id () : 0;
+
+    /* Other plugins can paint the cube transformed while it is idle and
+     * preparePaint is off, so start every output with a fresh clear and
+     * fresh caps here */
+    mCleared[mSrcOutput]     = false;
+    mCapsPainted[mSrcOutput] = false;
+
     /* Always use BTF painting on non-transformed screen */
     mPaintOrder = BTF;
 
@@ -825,12 +833,28 @@ PrivateCubeScreen::glPaintOutput (const GLScreenPaintAttrib &sAttrib,
 void
 PrivateCubeScreen::donePaint ()
 {
+    float x, progress;
+
     if (mGrabIndex || mDesktopOpacity != mToOpacity)
 	cScreen->damageScreen ();
 
+    cubeScreen->cubeGetRotation (x, x, progress);
+
+    /* folded, not rotating and the opacity has settled */
+    if (!mGrabIndex && mRotationState == CubeScreen::RotationNone &&
+	mDesktopOpacity == mToOpacity && progress == 0.0f)
+	toggleFunctions (false);
+
     cScreen->donePaint ();
 }
 
+void
+PrivateCubeScreen::toggleFunctions (bool enabled)
+{
+    cScreen->preparePaintSetEnabled (this, enabled);
+    cScreen->donePaintSetEnabled (this, enabled);
+}
+
 bool
 CubeScreen::cubeCheckOrientation (const GLScreenPaintAttrib &sAttrib,
 				  const GLMatrix            &transform,
@@ -1579,6 +1603,7 @@ PrivateCubeScreen::unfold (CompAction         *action,
 	if (cs->priv->mGrabIndex)
 	{
 	    cs->priv->mUnfolded = true;
+	    cs->priv->toggleFunctions (true);
 	    cs->priv->cScreen->damageScreen ();
 	}
 
@@ -46,6 +46,8 @@ class PrivateCubeScreen :
 
 	void preparePaint (int);
 	void donePaint ();
+
+	void toggleFunctions (bool enabled);
 	
 	void paint (CompOutput::ptrList &outputs, unsigned int);
 
@@ -0,0 +1,92 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _COMPIZ_DBUS_OPTION_BATCH_H
+#define _COMPIZ_DBUS_OPTION_BATCH_H
+
+#include <map>
+#include <vector>
+
+#include <core/option.h>
+
+#include "option-codec.h"
+
+namespace compiz
+{
+namespace dbus
+{
+
+/* New option values by plugin name */
+typedef std::map <CompString, OptionChanges> PluginOptionChanges;
+
+/* What a batch of option changes is applied to */
+class OptionChangeTarget
+{
+    public:
+
+	virtual ~OptionChangeTarget () {}
+
+	/* Change a single option. Expected to come back to
+	 * OptionChangeBatch::changed if the option did change */
+	virtual bool setOption (const CompString  &plugin,
+				const CompString  &name,
+				CompOption::Value &value) = 0;
+
+	/* Report the options named in names as changed */
+	virtual void optionsChanged (const CompString               &plugin,
+				     const std::vector <CompString> &names) = 0;
+
+	/* The set of active plugins changed */
+	virtual void pluginsChanged () = 0;
+};
+
+/* Applies the changes of a 'SetMany' request. Options are still set
+ * one at a time, plugins only have per option change notification.
+ * What gets batched are the change notifications: one optionsChanged
+ * per plugin and at most one pluginsChanged, after everything has
+ * been set. Changing the active plugins may unload some of the
+ * plugins there are changes for, so that is applied last */
+class OptionChangeBatch
+{
+    public:
+
+	OptionChangeBatch ();
+
+	void apply (PluginOptionChanges &changes,
+		    OptionChangeTarget  &target);
+
+	/* Record that an option has changed. Returns false if no
+	 * batch is being applied, in which case the caller has to
+	 * report the change itself */
+	bool changed (const CompString &plugin,
+		      const CompString &name);
+
+    private:
+
+	bool                                             mApplying;
+	bool                                             mPluginsChanged;
+	std::map <CompString, std::vector <CompString> > mChanged;
+};
+
+}
+}
+
+#endif
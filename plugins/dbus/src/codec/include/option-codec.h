@@ -0,0 +1,88 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _COMPIZ_DBUS_OPTION_CODEC_H
+#define _COMPIZ_DBUS_OPTION_CODEC_H
+
+#include <vector>
+
+#include <dbus/dbus.h>
+
+#include <core/option.h>
+#include <core/action.h>
+#include <core/match.h>
+
+namespace compiz
+{
+namespace dbus
+{
+
+/* A validated new value for the option called name */
+struct OptionChange
+{
+    CompString        name;
+    CompOption::Value value;
+};
+
+typedef std::vector <OptionChange> OptionChanges;
+
+/* D-Bus signature of the value of an option, e.g. "i" or "as".
+ * Empty for options which have no value to transfer, like
+ * plain actions */
+CompString optionSignature (const CompOption &option);
+
+/* Append the value of an option as an argument of its own
+ * signature (not wrapped in a variant) */
+bool appendOptionValue (DBusMessageIter         *iter,
+			CompOption::Type        type,
+			const CompOption::Value &value);
+
+/* Append the name and value of every option with a signature
+ * as an a{sv} dictionary */
+bool appendOptionDict (DBusMessageIter          *iter,
+		       const CompOption::Vector &options);
+
+/* Like the above, but only for the options named in names */
+bool appendOptionDict (DBusMessageIter                 *iter,
+		       const CompOption::Vector        &options,
+		       const std::vector <CompString>  &names);
+
+/* Read a value for option from iter. The argument must have the
+ * signature of the option, variants have to be recursed into by
+ * the caller */
+bool readOptionValue (DBusMessageIter   *iter,
+		      const CompOption  &option,
+		      CompOption::Value &value);
+
+/* Read an a{sv} dictionary of new values for options. Every entry
+ * is validated before anything is returned, so a request either
+ * applies completely or not at all. Entries which would not change
+ * the option are left out of changes. On failure error describes
+ * the first offending entry */
+bool readOptionDict (DBusMessageIter    *iter,
+		     CompOption::Vector &options,
+		     OptionChanges      &changes,
+		     CompString         &error);
+
+}
+}
+
+#endif
@@ -0,0 +1,110 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include <boost/foreach.hpp>
+
+#include "option-batch.h"
+
+#ifndef foreach
+#define foreach BOOST_FOREACH
+#endif
+
+namespace cd = compiz::dbus;
+
+namespace
+{
+
+bool
+isActivePlugins (const CompString &plugin,
+		 const CompString &name)
+{
+    return plugin == "core" && name == "active_plugins";
+}
+
+}
+
+cd::OptionChangeBatch::OptionChangeBatch () :
+    mApplying (false),
+    mPluginsChanged (false)
+{
+}
+
+void
+cd::OptionChangeBatch::apply (PluginOptionChanges &changes,
+			      OptionChangeTarget  &target)
+{
+    OptionChange *activePlugins = NULL;
+
+    mApplying = true;
+
+    for (PluginOptionChanges::iterator it = changes.begin ();
+	 it != changes.end (); ++it)
+    {
+	foreach (OptionChange &change, it->second)
+	{
+	    if (isActivePlugins (it->first, change.name))
+		activePlugins = &change;
+	    else
+		target.setOption (it->first, change.name, change.value);
+	}
+    }
+
+    if (activePlugins)
+	target.setOption ("core", "active_plugins", activePlugins->value);
+
+    mApplying = false;
+
+    std::map <CompString, std::vector <CompString> > changed;
+    bool                                             pluginsChanged;
+
+    /* Reporting may well change options again */
+    changed.swap (mChanged);
+    pluginsChanged = mPluginsChanged;
+    mPluginsChanged = false;
+
+    std::map <CompString, std::vector <CompString> >::iterator it;
+
+    for (it = changed.begin (); it != changed.end (); ++it)
+	target.optionsChanged (it->first, it->second);
+
+    if (pluginsChanged)
+	target.pluginsChanged ();
+}
+
+bool
+cd::OptionChangeBatch::changed (const CompString &plugin,
+				const CompString &name)
+{
+    if (!mApplying)
+	return false;
+
+    std::vector <CompString> &names = mChanged[plugin];
+
+    if (std::find (names.begin (), names.end (), name) == names.end ())
+	names.push_back (name);
+
+    if (isActivePlugins (plugin, name))
+	mPluginsChanged = true;
+
+    return true;
+}
@@ -0,0 +1,430 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <boost/foreach.hpp>
+
+#include "option-codec.h"
+
+#ifndef foreach
+#define foreach BOOST_FOREACH
+#endif
+
+namespace
+{
+
+/* Type code of a single value of type on the bus, or
+ * DBUS_TYPE_INVALID if it is not transferred at all */
+int
+valueTypeCode (CompOption::Type type)
+{
+    switch (type) {
+    case CompOption::TypeBool:
+    case CompOption::TypeBell:
+	return DBUS_TYPE_BOOLEAN;
+    case CompOption::TypeInt:
+	return DBUS_TYPE_INT32;
+    case CompOption::TypeFloat:
+	return DBUS_TYPE_DOUBLE;
+    case CompOption::TypeString:
+    case CompOption::TypeColor:
+    case CompOption::TypeKey:
+    case CompOption::TypeButton:
+    case CompOption::TypeEdge:
+    case CompOption::TypeMatch:
+	return DBUS_TYPE_STRING;
+    default:
+	return DBUS_TYPE_INVALID;
+    }
+}
+
+bool
+appendString (DBusMessageIter  *iter,
+	      const CompString &string)
+{
+    const char *s = string.c_str ();
+
+    return dbus_message_iter_append_basic (iter, DBUS_TYPE_STRING, &s);
+}
+
+bool
+appendSimpleValue (DBusMessageIter         *iter,
+		   CompOption::Type        type,
+		   const CompOption::Value &value)
+{
+    switch (type) {
+    case CompOption::TypeBool:
+	{
+	    dbus_bool_t b = value.b () ? TRUE : FALSE;
+	    return dbus_message_iter_append_basic (iter, DBUS_TYPE_BOOLEAN, &b);
+	}
+    case CompOption::TypeInt:
+	{
+	    dbus_int32_t i = value.i ();
+	    return dbus_message_iter_append_basic (iter, DBUS_TYPE_INT32, &i);
+	}
+    case CompOption::TypeFloat:
+	{
+	    double d = value.f ();
+	    return dbus_message_iter_append_basic (iter, DBUS_TYPE_DOUBLE, &d);
+	}
+    case CompOption::TypeString:
+	return appendString (iter, value.s ());
+    case CompOption::TypeColor:
+	return appendString (iter, CompOption::colorToString (value.c ()));
+    case CompOption::TypeKey:
+	return appendString (iter, value.action ().keyToString ());
+    case CompOption::TypeButton:
+	return appendString (iter, value.action ().buttonToString ());
+    case CompOption::TypeEdge:
+	return appendString (iter, value.action ().edgeMaskToString ());
+    case CompOption::TypeBell:
+	{
+	    dbus_bool_t bell = value.action ().bell () ? TRUE : FALSE;
+	    return dbus_message_iter_append_basic (iter, DBUS_TYPE_BOOLEAN,
+						   &bell);
+	}
+    case CompOption::TypeMatch:
+	return appendString (iter, value.match ().toString ());
+    default:
+	return false;
+    }
+}
+
+bool
+readSimpleValue (DBusMessageIter   *iter,
+		 CompOption::Type  type,
+		 CompOption::Value &value)
+{
+    int code = valueTypeCode (type);
+
+    if (code == DBUS_TYPE_INVALID ||
+	dbus_message_iter_get_arg_type (iter) != code)
+	return false;
+
+    switch (code) {
+    case DBUS_TYPE_BOOLEAN:
+	{
+	    dbus_bool_t b;
+	    dbus_message_iter_get_basic (iter, &b);
+
+	    if (type == CompOption::TypeBell)
+	    {
+		CompAction action;
+
+		action.setBell (b ? true : false);
+		value.set (action);
+	    }
+	    else
+		value.set (b ? true : false);
+
+	    return true;
+	}
+    case DBUS_TYPE_INT32:
+	{
+	    dbus_int32_t i;
+	    dbus_message_iter_get_basic (iter, &i);
+	    value.set ((int) i);
+	    return true;
+	}
+    case DBUS_TYPE_DOUBLE:
+	{
+	    double d;
+	    dbus_message_iter_get_basic (iter, &d);
+	    value.set ((float) d);
+	    return true;
+	}
+    default:
+	break;
+    }
+
+    const char *s;
+    dbus_message_iter_get_basic (iter, &s);
+
+    CompString     string (s);
+    CompAction     action;
+    unsigned short c[4];
+
+    switch (type) {
+    case CompOption::TypeString:
+	value.set (string);
+	return true;
+    case CompOption::TypeColor:
+	if (!CompOption::stringToColor (string, c))
+	    return false;
+	value.set (c);
+	return true;
+    case CompOption::TypeKey:
+	if (!action.keyFromString (string))
+	    return false;
+	value.set (action);
+	return true;
+    case CompOption::TypeButton:
+	if (!action.buttonFromString (string))
+	    return false;
+	value.set (action);
+	return true;
+    case CompOption::TypeEdge:
+	if (!action.edgeMaskFromString (string))
+	    return false;
+	value.set (action);
+	return true;
+    case CompOption::TypeMatch:
+	value.set (CompMatch (string));
+	return true;
+    default:
+	return false;
+    }
+}
+
+bool
+appendDictEntry (DBusMessageIter  *dict,
+		 const CompOption &option)
+{
+    CompString      signature = compiz::dbus::optionSignature (option);
+    DBusMessageIter entry, variant;
+
+    if (signature.empty ())
+	return true;
+
+    if (!dbus_message_iter_open_container (dict, DBUS_TYPE_DICT_ENTRY,
+					   NULL, &entry))
+	return false;
+
+    bool status = appendString (&entry, option.name ()) &&
+		  dbus_message_iter_open_container (&entry, DBUS_TYPE_VARIANT,
+						    signature.c_str (),
+						    &variant);
+
+    if (status)
+    {
+	status = compiz::dbus::appendOptionValue (&variant, option.type (),
+						  option.value ());
+	status &= dbus_message_iter_close_container (&entry, &variant);
+    }
+
+    status &= dbus_message_iter_close_container (dict, &entry);
+
+    return status;
+}
+
+}
+
+CompString
+compiz::dbus::optionSignature (const CompOption &option)
+{
+    bool             isList = option.type () == CompOption::TypeList;
+    CompOption::Type type = isList ? option.value ().listType () :
+				     option.type ();
+    int              code = valueTypeCode (type);
+
+    if (code == DBUS_TYPE_INVALID)
+	return CompString ();
+
+    CompString signature (1, (char) code);
+
+    if (isList)
+	signature.insert (0, 1, (char) DBUS_TYPE_ARRAY);
+
+    return signature;
+}
+
+bool
+compiz::dbus::appendOptionValue (DBusMessageIter         *iter,
+				 CompOption::Type        type,
+				 const CompOption::Value &value)
+{
+    if (type != CompOption::TypeList)
+	return appendSimpleValue (iter, type, value);
+
+    int code = valueTypeCode (value.listType ());
+
+    if (code == DBUS_TYPE_INVALID)
+	return false;
+
+    char            sig[2] = { (char) code, '\0' };
+    DBusMessageIter listIter;
+
+    if (!dbus_message_iter_open_container (iter, DBUS_TYPE_ARRAY,
+					   sig, &listIter))
+	return false;
+
+    bool status = true;
+
+    foreach (const CompOption::Value &v, value.list ())
+	status &= appendSimpleValue (&listIter, value.listType (), v);
+
+    status &= dbus_message_iter_close_container (iter, &listIter);
+
+    return status;
+}
+
+bool
+compiz::dbus::appendOptionDict (DBusMessageIter          *iter,
+				const CompOption::Vector &options)
+{
+    DBusMessageIter dict;
+    bool            status = true;
+
+    if (!dbus_message_iter_open_container (iter, DBUS_TYPE_ARRAY,
+					   "{sv}", &dict))
+	return false;
+
+    foreach (const CompOption &option, options)
+	status &= appendDictEntry (&dict, option);
+
+    status &= dbus_message_iter_close_container (iter, &dict);
+
+    return status;
+}
+
+bool
+compiz::dbus::appendOptionDict (DBusMessageIter                *iter,
+				const CompOption::Vector       &options,
+				const std::vector <CompString> &names)
+{
+    DBusMessageIter dict;
+    bool            status = true;
+
+    if (!dbus_message_iter_open_container (iter, DBUS_TYPE_ARRAY,
+					   "{sv}", &dict))
+	return false;
+
+    foreach (const CompString &name, names)
+    {
+	foreach (const CompOption &option, options)
+	{
+	    if (option.name () == name)
+	    {
+		status &= appendDictEntry (&dict, option);
+		break;
+	    }
+	}
+    }
+
+    status &= dbus_message_iter_close_container (iter, &dict);
+
+    return status;
+}
+
+bool
+compiz::dbus::readOptionValue (DBusMessageIter   *iter,
+			       const CompOption  &option,
+			       CompOption::Value &value)
+{
+    if (option.type () != CompOption::TypeList)
+	return readSimpleValue (iter, option.type (), value);
+
+    CompOption::Type          listType = option.value ().listType ();
+    CompOption::Value::Vector list;
+    DBusMessageIter           listIter;
+
+    if (dbus_message_iter_get_arg_type (iter) != DBUS_TYPE_ARRAY)
+	return false;
+
+    dbus_message_iter_recurse (iter, &listIter);
+
+    while (dbus_message_iter_get_arg_type (&listIter) != DBUS_TYPE_INVALID)
+    {
+	CompOption::Value v;
+
+	if (!readSimpleValue (&listIter, listType, v))
+	    return false;
+
+	list.push_back (v);
+	dbus_message_iter_next (&listIter);
+    }
+
+    value.set (listType, list);
+
+    return true;
+}
+
+bool
+compiz::dbus::readOptionDict (DBusMessageIter    *iter,
+			      CompOption::Vector &options,
+			      OptionChanges      &changes,
+			      CompString         &error)
+{
+    DBusMessageIter dict;
+
+    if (dbus_message_iter_get_arg_type (iter) != DBUS_TYPE_ARRAY ||
+	dbus_message_iter_get_element_type (iter) != DBUS_TYPE_DICT_ENTRY)
+    {
+	error = "Expected a dictionary of option values";
+	return false;
+    }
+
+    dbus_message_iter_recurse (iter, &dict);
+
+    OptionChanges pending;
+
+    while (dbus_message_iter_get_arg_type (&dict) == DBUS_TYPE_DICT_ENTRY)
+    {
+	DBusMessageIter entry, variant;
+	const char      *name;
+
+	dbus_message_iter_recurse (&dict, &entry);
+
+	if (dbus_message_iter_get_arg_type (&entry) != DBUS_TYPE_STRING)
+	{
+	    error = "Option names must be strings";
+	    return false;
+	}
+
+	dbus_message_iter_get_basic (&entry, &name);
+
+	CompOption *option = CompOption::findOption (options, name);
+
+	if (!option || optionSignature (*option).empty ())
+	{
+	    error = CompString ("No such option: ") + name;
+	    return false;
+	}
+
+	if (!dbus_message_iter_next (&entry) ||
+	    dbus_message_iter_get_arg_type (&entry) != DBUS_TYPE_VARIANT)
+	{
+	    error = CompString ("Expected a variant for option ") + name;
+	    return false;
+	}
+
+	dbus_message_iter_recurse (&entry, &variant);
+
+	OptionChange change;
+
+	change.name = name;
+
+	if (!readOptionValue (&variant, *option, change.value))
+	{
+	    error = CompString ("Invalid value for option ") + name;
+	    return false;
+	}
+
+	if (change.value != option->value ())
+	    pending.push_back (change);
+
+	dbus_message_iter_next (&dict);
+    }
+
+    changes.insert (changes.end (), pending.begin (), pending.end ());
+
+    return true;
+}
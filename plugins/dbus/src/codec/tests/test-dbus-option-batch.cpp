@@ -0,0 +1,241 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "option-batch.h"
+
+namespace cd = compiz::dbus;
+
+namespace
+{
+
+typedef std::vector <CompString> Names;
+
+/* Stands in for DbusScreen: options are only reported through
+ * the batch if one is being applied, like its setOptionForPlugin
+ * wrap does */
+class RecordingTarget :
+    public cd::OptionChangeTarget
+{
+    public:
+
+	RecordingTarget (cd::OptionChangeBatch &batch) :
+	    batch (batch),
+	    pluginsChangedCount (0)
+	{
+	    plugins.push_back ("core");
+	    plugins.push_back ("expo");
+	    plugins.push_back ("wall");
+	}
+
+	bool setOption (const CompString  &plugin,
+			const CompString  &name,
+			CompOption::Value &value)
+	{
+	    if (std::find (plugins.begin (), plugins.end (), plugin) ==
+		plugins.end ())
+		return false;
+
+	    set.push_back (plugin + "/" + name);
+
+	    /* Loading the new set of plugins unloads expo */
+	    if (plugin == "core" && name == "active_plugins")
+		plugins.erase (std::find (plugins.begin (), plugins.end (),
+					  "expo"));
+
+	    if (!batch.changed (plugin, name))
+		immediate.push_back (plugin + "/" + name);
+
+	    /* wall keeps its vsize in step with its hsize */
+	    if (plugin == "wall" && name == "hsize")
+	    {
+		CompOption::Value vsize (value.i ());
+
+		setOption ("wall", "vsize", vsize);
+	    }
+
+	    return true;
+	}
+
+	void optionsChanged (const CompString &plugin,
+			     const Names      &names)
+	{
+	    signals.push_back (std::make_pair (plugin, names));
+	}
+
+	void pluginsChanged ()
+	{
+	    ++pluginsChangedCount;
+	}
+
+	cd::OptionChangeBatch                          &batch;
+	Names                                          plugins;
+	Names                                          set;
+	Names                                          immediate;
+	std::vector <std::pair <CompString, Names> >   signals;
+	unsigned int                                   pluginsChangedCount;
+};
+
+cd::OptionChange
+change (const CompString &name,
+	int              value)
+{
+    cd::OptionChange c;
+
+    c.name = name;
+    c.value.set (value);
+
+    return c;
+}
+
+cd::OptionChange
+activePlugins ()
+{
+    cd::OptionChange          c;
+    CompOption::Value::Vector plugins;
+
+    plugins.push_back (CompOption::Value (CompString ("core")));
+    plugins.push_back (CompOption::Value (CompString ("wall")));
+
+    c.name = "active_plugins";
+    c.value.set (CompOption::TypeString, plugins);
+
+    return c;
+}
+
+}
+
+class DBusOptionBatch :
+    public ::testing::Test
+{
+    public:
+
+	DBusOptionBatch () :
+	    target (batch)
+	{
+	}
+
+	cd::OptionChangeBatch   batch;
+	RecordingTarget         target;
+	cd::PluginOptionChanges changes;
+};
+
+TEST_F (DBusOptionBatch, OneSignalPerPlugin)
+{
+    changes["core"].push_back (change ("hsize", 4));
+    changes["core"].push_back (change ("vsize", 2));
+    changes["expo"].push_back (change ("zoom_time", 1));
+
+    batch.apply (changes, target);
+
+    EXPECT_TRUE (target.immediate.empty ());
+    ASSERT_EQ (2u, target.signals.size ());
+
+    EXPECT_EQ ("core", target.signals[0].first);
+    ASSERT_EQ (2u, target.signals[0].second.size ());
+    EXPECT_EQ ("hsize", target.signals[0].second[0]);
+    EXPECT_EQ ("vsize", target.signals[0].second[1]);
+
+    EXPECT_EQ ("expo", target.signals[1].first);
+    ASSERT_EQ (1u, target.signals[1].second.size ());
+    EXPECT_EQ ("zoom_time", target.signals[1].second[0]);
+
+    EXPECT_EQ (0u, target.pluginsChangedCount);
+}
+
+TEST_F (DBusOptionBatch, OptionsChangedByThePluginAreInTheSameSignal)
+{
+    changes["wall"].push_back (change ("hsize", 3));
+    changes["wall"].push_back (change ("vsize", 3));
+
+    batch.apply (changes, target);
+
+    EXPECT_TRUE (target.immediate.empty ());
+    ASSERT_EQ (1u, target.signals.size ());
+    EXPECT_EQ ("wall", target.signals[0].first);
+
+    /* vsize changed twice but is only reported once */
+    ASSERT_EQ (2u, target.signals[0].second.size ());
+    EXPECT_EQ ("hsize", target.signals[0].second[0]);
+    EXPECT_EQ ("vsize", target.signals[0].second[1]);
+}
+
+TEST_F (DBusOptionBatch, ActivePluginsIsAppliedLast)
+{
+    /* "core" sorts before "expo", so without reordering
+     * expo would be unloaded before its change is applied */
+    changes["core"].push_back (activePlugins ());
+    changes["core"].push_back (change ("hsize", 4));
+    changes["expo"].push_back (change ("zoom_time", 1));
+
+    batch.apply (changes, target);
+
+    ASSERT_EQ (3u, target.set.size ());
+    EXPECT_EQ ("core/hsize", target.set[0]);
+    EXPECT_EQ ("expo/zoom_time", target.set[1]);
+    EXPECT_EQ ("core/active_plugins", target.set[2]);
+}
+
+TEST_F (DBusOptionBatch, ChangingActivePluginsReportsPluginsChangedOnce)
+{
+    changes["core"].push_back (activePlugins ());
+    changes["core"].push_back (change ("hsize", 4));
+
+    batch.apply (changes, target);
+
+    EXPECT_EQ (1u, target.pluginsChangedCount);
+    ASSERT_EQ (1u, target.signals.size ());
+    EXPECT_EQ ("core", target.signals[0].first);
+    EXPECT_EQ (2u, target.signals[0].second.size ());
+}
+
+TEST_F (DBusOptionBatch, ChangesOutsideABatchAreNotRecorded)
+{
+    CompOption::Value value (4);
+
+    target.setOption ("core", "hsize", value);
+
+    ASSERT_EQ (1u, target.immediate.size ());
+    EXPECT_EQ ("core/hsize", target.immediate[0]);
+
+    batch.apply (changes, target);
+
+    EXPECT_TRUE (target.signals.empty ());
+}
+
+TEST_F (DBusOptionBatch, BatchesDoNotCarryOver)
+{
+    changes["core"].push_back (activePlugins ());
+
+    batch.apply (changes, target);
+
+    changes.clear ();
+    changes["wall"].push_back (change ("hsize", 2));
+
+    batch.apply (changes, target);
+
+    EXPECT_EQ (1u, target.pluginsChangedCount);
+    ASSERT_EQ (2u, target.signals.size ());
+    EXPECT_EQ ("wall", target.signals[1].first);
+}
@@ -0,0 +1,434 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <csignal>
+#include <cstring>
+#include <cstdlib>
+
+#include "option-codec.h"
+
+namespace cd = compiz::dbus;
+
+namespace
+{
+
+const char *TEST_PATH = "/org/freedesktop/compiz/test/screen0";
+const char *TEST_INTERFACE = "org.freedesktop.compiz";
+
+/* Serves getAll and setMany for a vector of options on
+ * its own connection, the way the plugin does for every
+ * plugin's screen object */
+class OptionService
+{
+    public:
+
+	OptionService () :
+	    applied (0)
+	{
+	}
+
+	DBusHandlerResult
+	handle (DBusConnection *connection,
+		DBusMessage    *message)
+	{
+	    DBusMessage     *reply = NULL;
+	    DBusMessageIter iter;
+
+	    if (dbus_message_is_method_call (message, TEST_INTERFACE, "getAll"))
+	    {
+		reply = dbus_message_new_method_return (message);
+		dbus_message_iter_init_append (reply, &iter);
+		cd::appendOptionDict (&iter, options);
+	    }
+	    else if (dbus_message_is_method_call (message, TEST_INTERFACE,
+						  "setMany"))
+	    {
+		cd::OptionChanges changes;
+		CompString        error ("Expected a dictionary of option values");
+
+		if (dbus_message_iter_init (message, &iter) &&
+		    cd::readOptionDict (&iter, options, changes, error))
+		{
+		    for (cd::OptionChanges::iterator it = changes.begin ();
+			 it != changes.end (); ++it)
+		    {
+			CompOption::findOption (options, it->name)->set (it->value);
+			++applied;
+		    }
+
+		    reply = dbus_message_new_method_return (message);
+		}
+		else
+		{
+		    reply = dbus_message_new_error (message, DBUS_ERROR_FAILED,
+						    error.c_str ());
+		}
+	    }
+	    else
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+	    dbus_connection_send (connection, reply, NULL);
+	    dbus_message_unref (reply);
+
+	    return DBUS_HANDLER_RESULT_HANDLED;
+	}
+
+	static DBusHandlerResult
+	handleMessage (DBusConnection *connection,
+		       DBusMessage    *message,
+		       void           *data)
+	{
+	    return static_cast <OptionService *> (data)->handle (connection,
+								 message);
+	}
+
+	CompOption::Vector options;
+	unsigned int       applied;
+};
+
+DBusObjectPathVTable serviceVTable = {
+    NULL, OptionService::handleMessage,
+    NULL, NULL, NULL, NULL
+};
+
+class DBusOptionCodec :
+    public ::testing::Test
+{
+    public:
+
+	DBusOptionCodec () :
+	    daemonPid (0),
+	    serviceConnection (NULL),
+	    clientConnection (NULL)
+	{
+	}
+
+	virtual void SetUp ()
+	{
+	    startDaemon ();
+
+	    serviceConnection = connect ();
+	    clientConnection = connect ();
+
+	    ASSERT_TRUE (serviceConnection);
+	    ASSERT_TRUE (clientConnection);
+
+	    dbus_connection_register_object_path (serviceConnection, TEST_PATH,
+						  &serviceVTable, &service);
+
+	    CompOption::Value::Vector values;
+
+	    values.push_back (CompOption::Value (1));
+	    values.push_back (CompOption::Value (2));
+
+	    addOption ("enabled", CompOption::TypeBool).value ().set (true);
+	    addOption ("size", CompOption::TypeInt).value ().set (5);
+	    addOption ("opacity", CompOption::TypeFloat).value ().set (0.5f);
+	    addOption ("title", CompOption::TypeString).value ().set (CompString ("compiz"));
+	    addOption ("values", CompOption::TypeList).value ().set (CompOption::TypeInt,
+								     values);
+	    addOption ("action", CompOption::TypeAction);
+	}
+
+	virtual void TearDown ()
+	{
+	    disconnect (clientConnection);
+	    disconnect (serviceConnection);
+
+	    if (daemonPid > 0)
+		kill (daemonPid, SIGTERM);
+	}
+
+	CompOption &
+	addOption (const char *name, CompOption::Type type)
+	{
+	    service.options.push_back (CompOption (name, type));
+	    return service.options.back ();
+	}
+
+	/* Calls method on the service and returns the reply, which
+	 * may be an error. Both connections get dispatched in turn
+	 * until it arrives */
+	DBusMessage *
+	call (DBusMessage *message)
+	{
+	    DBusPendingCall *pending = NULL;
+	    DBusMessage     *reply = NULL;
+
+	    dbus_connection_send_with_reply (clientConnection, message,
+					     &pending, 5000);
+	    dbus_message_unref (message);
+
+	    if (!pending)
+		return NULL;
+
+	    for (int i = 0; i < 500 && !dbus_pending_call_get_completed (pending); ++i)
+	    {
+		dbus_connection_read_write_dispatch (serviceConnection, 10);
+		dbus_connection_read_write_dispatch (clientConnection, 10);
+	    }
+
+	    reply = dbus_pending_call_steal_reply (pending);
+	    dbus_pending_call_unref (pending);
+
+	    return reply;
+	}
+
+	DBusMessage *
+	methodCall (const char *method)
+	{
+	    return dbus_message_new_method_call (dbus_bus_get_unique_name (serviceConnection),
+						 TEST_PATH, TEST_INTERFACE,
+						 method);
+	}
+
+	/* Sends the options as setMany and returns the reply */
+	DBusMessage *
+	setMany (const CompOption::Vector &options)
+	{
+	    DBusMessage     *message = methodCall ("setMany");
+	    DBusMessageIter iter;
+
+	    dbus_message_iter_init_append (message, &iter);
+	    cd::appendOptionDict (&iter, options);
+
+	    return call (message);
+	}
+
+	/* Fetches all options through getAll into a copy of
+	 * the service's options with everything reset */
+	bool
+	getAll (CompOption::Vector &mirror)
+	{
+	    DBusMessage     *reply = call (methodCall ("getAll"));
+	    DBusMessageIter iter;
+	    bool            status = false;
+
+	    mirror.clear ();
+
+	    for (CompOption::Vector::iterator it = service.options.begin ();
+		 it != service.options.end (); ++it)
+	    {
+		mirror.push_back (CompOption (it->name (), it->type ()));
+
+		if (it->type () == CompOption::TypeList)
+		    mirror.back ().value ().set (it->value ().listType (),
+						 CompOption::Value::Vector ());
+	    }
+
+	    if (reply &&
+		dbus_message_get_type (reply) == DBUS_MESSAGE_TYPE_METHOD_RETURN &&
+		dbus_message_iter_init (reply, &iter))
+	    {
+		cd::OptionChanges changes;
+		CompString        error;
+
+		status = cd::readOptionDict (&iter, mirror, changes, error);
+
+		for (cd::OptionChanges::iterator it = changes.begin ();
+		     it != changes.end (); ++it)
+		    CompOption::findOption (mirror, it->name)->set (it->value);
+	    }
+
+	    if (reply)
+		dbus_message_unref (reply);
+
+	    return status;
+	}
+
+	static bool
+	isError (DBusMessage *reply)
+	{
+	    bool error = !reply ||
+			 dbus_message_get_type (reply) == DBUS_MESSAGE_TYPE_ERROR;
+
+	    if (reply)
+		dbus_message_unref (reply);
+
+	    return error;
+	}
+
+	OptionService service;
+
+    private:
+
+	void startDaemon ()
+	{
+	    FILE *daemon = popen (DBUS_DAEMON_EXECUTABLE
+				  " --session --fork --print-address=1"
+				  " --print-pid=1", "r");
+	    char line[1024];
+
+	    ASSERT_TRUE (daemon);
+
+	    if (fgets (line, sizeof (line), daemon))
+		address = CompString (line, strcspn (line, "\n"));
+
+	    if (fgets (line, sizeof (line), daemon))
+		daemonPid = atoi (line);
+
+	    pclose (daemon);
+
+	    ASSERT_FALSE (address.empty ());
+	    ASSERT_GT (daemonPid, 0);
+	}
+
+	DBusConnection *
+	connect ()
+	{
+	    DBusConnection *connection =
+		dbus_connection_open_private (address.c_str (), NULL);
+
+	    if (connection && !dbus_bus_register (connection, NULL))
+	    {
+		disconnect (connection);
+		return NULL;
+	    }
+
+	    return connection;
+	}
+
+	static void
+	disconnect (DBusConnection *connection)
+	{
+	    if (!connection)
+		return;
+
+	    dbus_connection_close (connection);
+	    dbus_connection_unref (connection);
+	}
+
+	CompString     address;
+	pid_t          daemonPid;
+	DBusConnection *serviceConnection;
+	DBusConnection *clientConnection;
+};
+
+}
+
+TEST (DBusOptionSignature, SignatureOfEachType)
+{
+    CompOption                b ("b", CompOption::TypeBool);
+    CompOption                f ("f", CompOption::TypeFloat);
+    CompOption                color ("color", CompOption::TypeColor);
+    CompOption                list ("list", CompOption::TypeList);
+    CompOption                action ("action", CompOption::TypeAction);
+
+    list.value ().set (CompOption::TypeInt, CompOption::Value::Vector ());
+
+    EXPECT_EQ ("b", cd::optionSignature (b));
+    EXPECT_EQ ("d", cd::optionSignature (f));
+    EXPECT_EQ ("s", cd::optionSignature (color));
+    EXPECT_EQ ("ai", cd::optionSignature (list));
+    EXPECT_EQ ("", cd::optionSignature (action));
+}
+
+TEST_F (DBusOptionCodec, GetAllReturnsEveryOptionWithAValue)
+{
+    CompOption::Vector mirror;
+
+    ASSERT_TRUE (getAll (mirror));
+
+    EXPECT_TRUE (CompOption::findOption (mirror, "enabled")->value ().b ());
+    EXPECT_EQ (5, CompOption::findOption (mirror, "size")->value ().i ());
+    EXPECT_FLOAT_EQ (0.5f, CompOption::findOption (mirror, "opacity")->value ().f ());
+    EXPECT_EQ ("compiz", CompOption::findOption (mirror, "title")->value ().s ());
+
+    const CompOption::Value::Vector &values =
+	CompOption::findOption (mirror, "values")->value ().list ();
+
+    ASSERT_EQ (2u, values.size ());
+    EXPECT_EQ (1, values[0].i ());
+    EXPECT_EQ (2, values[1].i ());
+}
+
+TEST_F (DBusOptionCodec, SetManyAppliesEveryValue)
+{
+    CompOption::Vector        update;
+    CompOption::Value::Vector values;
+
+    values.push_back (CompOption::Value (3));
+
+    update.push_back (CompOption ("size", CompOption::TypeInt));
+    update.back ().value ().set (10);
+    update.push_back (CompOption ("title", CompOption::TypeString));
+    update.back ().value ().set (CompString ("dbus"));
+    update.push_back (CompOption ("values", CompOption::TypeList));
+    update.back ().value ().set (CompOption::TypeInt, values);
+
+    ASSERT_FALSE (isError (setMany (update)));
+
+    CompOption::Vector &options = service.options;
+
+    EXPECT_EQ (10, CompOption::findOption (options, "size")->value ().i ());
+    EXPECT_EQ ("dbus", CompOption::findOption (options, "title")->value ().s ());
+    ASSERT_EQ (1u, CompOption::findOption (options, "values")->value ().list ().size ());
+    EXPECT_EQ (3, CompOption::findOption (options, "values")->value ().list ()[0].i ());
+    EXPECT_EQ (3u, service.applied);
+}
+
+TEST_F (DBusOptionCodec, SetManyLeavesOutUnchangedValues)
+{
+    CompOption::Vector update;
+
+    update.push_back (CompOption ("size", CompOption::TypeInt));
+    update.back ().value ().set (5);
+    update.push_back (CompOption ("enabled", CompOption::TypeBool));
+    update.back ().value ().set (false);
+
+    ASSERT_FALSE (isError (setMany (update)));
+
+    EXPECT_FALSE (CompOption::findOption (service.options, "enabled")->value ().b ());
+    EXPECT_EQ (1u, service.applied);
+}
+
+TEST_F (DBusOptionCodec, SetManyWithAnUnknownOptionChangesNothing)
+{
+    CompOption::Vector update;
+
+    update.push_back (CompOption ("size", CompOption::TypeInt));
+    update.back ().value ().set (10);
+    update.push_back (CompOption ("nonexistent", CompOption::TypeInt));
+    update.back ().value ().set (1);
+
+    EXPECT_TRUE (isError (setMany (update)));
+
+    EXPECT_EQ (5, CompOption::findOption (service.options, "size")->value ().i ());
+    EXPECT_EQ (0u, service.applied);
+}
+
+TEST_F (DBusOptionCodec, SetManyWithAMismatchedTypeChangesNothing)
+{
+    CompOption::Vector update;
+
+    update.push_back (CompOption ("size", CompOption::TypeInt));
+    update.back ().value ().set (10);
+    update.push_back (CompOption ("title", CompOption::TypeInt));
+    update.back ().value ().set (1);
+
+    EXPECT_TRUE (isError (setMany (update)));
+
+    EXPECT_EQ (5, CompOption::findOption (service.options, "size")->value ().i ());
+    EXPECT_EQ (0u, service.applied);
+}
@@ -231,6 +231,10 @@ DbusScreen::handleRootIntrospectMessage (DBusConnection *connection,
 			"b", "out", "as", "out", "as", "out");
 #endif
 
+    response.addMethod (COMPIZ_DBUS_GET_ALL_MEMBER_NAME, 1,
+			"a{sa{sv}}", "out");
+    response.addMethod (COMPIZ_DBUS_SET_MANY_MEMBER_NAME, 1,
+			"a{sa{sv}}", "in");
     response.addSignal (COMPIZ_DBUS_PLUGINS_CHANGED_SIGNAL_NAME, 0);
     response.endInterface ();
 
@@ -273,6 +277,9 @@ DbusScreen::handleScreenIntrospectMessage (DBusConnection           *connection,
 
     response.startInterface ();
     response.addMethod (COMPIZ_DBUS_LIST_MEMBER_NAME, 1, "as", "out");
+    response.addMethod (COMPIZ_DBUS_GET_ALL_MEMBER_NAME, 1, "a{sv}", "out");
+    response.addMethod (COMPIZ_DBUS_SET_MANY_MEMBER_NAME, 1, "a{sv}", "in");
+    response.addSignal (COMPIZ_DBUS_OPTIONS_CHANGED_SIGNAL_NAME, 1, "a{sv}");
     response.endInterface ();
 
     CompOption::Vector &options = getOptionsFromPath (path);
@@ -592,123 +599,6 @@ DbusScreen::tryGetValueWithType (DBusMessageIter *iter,
     return false;
 }
 
-bool
-DbusScreen::getOptionValue (DBusMessageIter   *iter,
-			    CompOption::Type  type,
-			    CompOption::Value &value)
-{
-    bool   success;
-
-    switch (type) {
-    case CompOption::TypeBool:
-	{
-	    bool b;
-	    success = tryGetValueWithType (iter, DBUS_TYPE_BOOLEAN, &b);
-	    if (success)
-		value.set (b ? true : false);
-	}
-	break;
-    case CompOption::TypeInt:
-	{
-	    int i;
-	    success = tryGetValueWithType (iter, DBUS_TYPE_INT32, &i);
-	    if (success)
-		value.set (i);
-	}
-	break;
-    case CompOption::TypeFloat:
-	{
-	    double d;
-	    success = tryGetValueWithType (iter, DBUS_TYPE_DOUBLE, &d);
-	    if (success)
-		value.set ((float) d);
-	}
-	break;
-    case CompOption::TypeString:
-	{
-	    char *s;
-	    success = tryGetValueWithType (iter, DBUS_TYPE_STRING, &s);
-	    if (success)
-	        value.set (CompString (s));
-	}
-	break;
-    case CompOption::TypeColor:
-	{
-	    char           *s;
-	    unsigned short c[4];
-
-	    success = tryGetValueWithType (iter, DBUS_TYPE_STRING, &s);
-	    if (success)
-		success &= CompOption::stringToColor (CompString (s), c);
-	    if (success)
-		value.set (c);
-	}
-	break;
-    case CompOption::TypeKey:
-	{
-	    char       *s;
-	    CompAction action;
-
-	    success = tryGetValueWithType (iter, DBUS_TYPE_STRING, &s);
-	    if (success)
-		success = action.keyFromString (CompString (s));
-	    if (success)
-		value.set (action);
-	}
-	break;
-    case CompOption::TypeButton:
-	{
-	    char       *s;
-	    CompAction action;
-
-	    success = tryGetValueWithType (iter, DBUS_TYPE_STRING, &s);
-	    if (success)
-		success = action.buttonFromString (CompString (s));
-	    if (success)
-		value.set (action);
-	}
-	break;
-    case CompOption::TypeEdge:
-	{
-	    char       *s;
-	    CompAction action;
-
-	    success = tryGetValueWithType (iter, DBUS_TYPE_STRING, &s);
-	    if (success)
-		success = action.edgeMaskFromString (CompString (s));
-	    if (success)
-		value.set (action);
-	}
-	break;
-    case CompOption::TypeBell:
-	{
-	    bool       bell;
-	    CompAction action;
-
-	    success = tryGetValueWithType (iter, DBUS_TYPE_BOOLEAN, &bell);
-	    if (success)
-	    {
-		action.setBell (bell ? true : false);
-		value.set (action);
-	    }
-	}
-	break;
-    case CompOption::TypeMatch:
-	{
-	    char *s;
-	    success = tryGetValueWithType (iter, DBUS_TYPE_STRING, &s);
-	    if (success)
-		value.set (CompMatch (s));
-	}
-	break;
-    default:
-	success = false;
-	break;
-    }
-
-    return success;
-}
-
 /*
  * 'Set' can be used to change any existing option. Argument
  * should be the new value for the option.
@@ -755,34 +645,12 @@ DbusScreen::handleSetOptionMessage (DBusConnection                 *connection,
     {
 	if (option.name () == path[2])
 	{
-	    DBusMessageIter   iter, aiter;
-	    CompOption::Value value, tmpValue;
+	    DBusMessageIter   iter;
+	    CompOption::Value value;
 	    bool              status = false;
 
-	    if (option.type () == CompOption::TypeList)
-	    {
-		if (dbus_message_iter_init (message, &iter) &&
-		    dbus_message_iter_get_arg_type (&iter) == DBUS_TYPE_ARRAY)
-		{
-		    dbus_message_iter_recurse (&iter, &aiter);
-
-		    do
-		    {
-			if (getOptionValue (&aiter,
-					    option.value ().listType (),
-					    tmpValue))
-			{
-			    option.value ().list ().push_back (tmpValue);
-			}
-		    } while (dbus_message_iter_next (&aiter));
-
-		    status = true;
-		}
-	    }
-	    else if (dbus_message_iter_init (message, &iter))
-	    {
-		status = getOptionValue (&iter, option.type (), value);
-	    }
+	    if (dbus_message_iter_init (message, &iter))
+		status = compiz::dbus::readOptionValue (&iter, option, value);
 
 	    if (status)
 	    {
@@ -810,220 +678,15 @@ DbusScreen::handleSetOptionMessage (DBusConnection                 *connection,
     return false;
 }
 
-void
-DbusScreen::appendSimpleOptionValue (DBusMessage       *message,
-				     CompOption::Type  type,
-				     CompOption::Value &value)
-{
-    switch (type) {
-    case CompOption::TypeBool:
-	{
-	    bool b = value.b () ? true : false;
-	    dbus_message_append_args (message,
-				      DBUS_TYPE_BOOLEAN, &b,
-				      DBUS_TYPE_INVALID);
-	}
-	break;
-    case CompOption::TypeInt:
-	{
-	    int i = value.i ();
-	    dbus_message_append_args (message,
-				      DBUS_TYPE_INT32, &i,
-				      DBUS_TYPE_INVALID);
-	}
-	break;
-    case CompOption::TypeFloat:
-	{
-	    double d = value.f ();
-	    dbus_message_append_args (message,
-				      DBUS_TYPE_DOUBLE, &d,
-				      DBUS_TYPE_INVALID);
-	}
-	break;
-    case CompOption::TypeString:
-	{
-	    CompString string = value.s ();
-	    const char *s = string.c_str ();
-	    dbus_message_append_args (message,
-				      DBUS_TYPE_STRING, &s,
-				      DBUS_TYPE_INVALID);
-	}
-	break;
-    case CompOption::TypeColor:
-	{
-	    CompString color = CompOption::colorToString (value.c ());
-	    const char *s = color.c_str ();
-	    dbus_message_append_args (message,
-				      DBUS_TYPE_STRING, &s,
-				      DBUS_TYPE_INVALID);
-	}
-	break;
-    case CompOption::TypeKey:
-	{
-	    CompString key = value.action ().keyToString ();
-	    const char *s = key.c_str ();
-	    dbus_message_append_args (message,
-				      DBUS_TYPE_STRING, &s,
-				      DBUS_TYPE_INVALID);
-	}
-	break;
-    case CompOption::TypeButton:
-	{
-	    CompString button = value.action ().buttonToString ();
-	    const char *s = button.c_str ();
-	    dbus_message_append_args (message,
-				      DBUS_TYPE_STRING, &s,
-				      DBUS_TYPE_INVALID);
-	}
-	break;
-    case CompOption::TypeEdge:
-	{
-	    CompString edge = value.action ().edgeMaskToString ();
-	    const char *s = edge.c_str ();
-	    dbus_message_append_args (message,
-				      DBUS_TYPE_STRING, &s,
-				      DBUS_TYPE_INVALID);
-	}
-	break;
-    case CompOption::TypeBell:
-	{
-	    bool bell = value.action ().bell () ? true : false;
-	    dbus_message_append_args (message,
-				      DBUS_TYPE_BOOLEAN, &bell,
-				      DBUS_TYPE_INVALID);
-	}
-	break;
-    case CompOption::TypeMatch:
-	{
-	    CompString match = value.match ().toString ();
-	    const char *s = match.c_str ();
-	    dbus_message_append_args (message,
-				      DBUS_TYPE_STRING, &s,
-				      DBUS_TYPE_INVALID);
-	}
-    default:
-	break;
-    }
-}
-
-void
-DbusScreen::appendListOptionValue (DBusMessage       *message,
-				   CompOption::Type  type,
-				   CompOption::Value &value)
-{
-    DBusMessageIter iter;
-    DBusMessageIter listIter;
-    char	    sig[2];
-
-    switch (value.listType ()) {
-    case CompOption::TypeInt:
-	sig[0] = DBUS_TYPE_INT32;
-	break;
-    case CompOption::TypeFloat:
-	sig[0] = DBUS_TYPE_DOUBLE;
-	break;
-    case CompOption::TypeBool:
-    case CompOption::TypeBell:
-	sig[0] = DBUS_TYPE_BOOLEAN;
-	break;
-    default:
-	sig[0] = DBUS_TYPE_STRING;
-	break;
-    }
-    sig[1] = '\0';
-
-    dbus_message_iter_init_append (message, &iter);
-
-    if (!dbus_message_iter_open_container (&iter, DBUS_TYPE_ARRAY,
-					   sig, &listIter))
-	return;
-
-    foreach (CompOption::Value& val, value.list ())
-    {
-	switch (value.listType ()) {
-	case CompOption::TypeInt:
-	    {
-		int i = val.i ();
-		dbus_message_iter_append_basic (&listIter, sig[0], &i);
-	    }
-	    break;
-	case CompOption::TypeFloat:
-	    {
-		float f = val.f ();
-		dbus_message_iter_append_basic (&listIter, sig[0], &f);
-	    }
-	    break;
-	case CompOption::TypeBool:
-	    {
-		bool b = val.b () ? true : false;
-		dbus_message_iter_append_basic (&listIter, sig[0], &b);
-	    }
-	    break;
-	case CompOption::TypeString:
-	    {
-		CompString string = val.s ();
-		const char *s = string.c_str ();
-		dbus_message_iter_append_basic (&listIter, sig[0], &s);
-	    }
-	    break;
-	case CompOption::TypeKey:
-	    {
-		CompString key = val.action ().keyToString ();
-		const char *s = key.c_str ();
-		dbus_message_iter_append_basic (&listIter, sig[0], &s);
-	    }
-	    break;
-	case CompOption::TypeButton:
-	    {
-		CompString button = val.action ().buttonToString ();
-		const char *s = button.c_str ();
-		dbus_message_iter_append_basic (&listIter, sig[0], &s);
-	    }
-	    break;
-	case CompOption::TypeEdge:
-	    {
-		CompString edge = val.action ().edgeMaskToString ();
-		const char *s = edge.c_str ();
-		dbus_message_iter_append_basic (&listIter, sig[0], &s);
-	    }
-	    break;
-	case CompOption::TypeBell:
-	    {
-		bool bell = val.action ().bell () ? true : false;
-		dbus_message_iter_append_basic (&listIter, sig[0], &bell);
-	    }
-	    break;
-	case CompOption::TypeMatch:
-	    {
-		CompString match = val.match ().toString ();
-		const char *s = match.c_str ();
-		dbus_message_iter_append_basic (&listIter, sig[0], &s);
-	    }
-	    break;
-	case CompOption::TypeColor:
-	    {
-		CompString color = CompOption::colorToString (val.c ());
-		const char *s = color.c_str ();
-		dbus_message_iter_append_basic (&listIter, sig[0], &s);
-	    }
-	    break;
-	default:
-	    break;
-	}
-    }
-
-    dbus_message_iter_close_container (&iter, &listIter);
-}
-
 void
 DbusScreen::appendOptionValue (DBusMessage       *message,
 			       CompOption::Type  type,
 			       CompOption::Value &value)
 {
-    if (type == CompOption::TypeList)
-	appendListOptionValue (message, type, value);
-    else
-	appendSimpleOptionValue (message, type, value);
+    DBusMessageIter iter;
+
+    dbus_message_iter_init_append (message, &iter);
+    compiz::dbus::appendOptionValue (&iter, type, value);
 }
 
 /*
@@ -1105,6 +768,240 @@ DbusScreen::handleListMessage (DBusConnection                 *connection,
     return true;
 }
 
+/*
+ * 'GetAll' can be used to retrieve the values of all options of a
+ * plugin at once, as a dictionary of option names and values.
+ *
+ * Example:
+ *
+ * dbus-send --print-reply --type=method_call \
+ * --dest=org.freedesktop.compiz	      \
+ * /org/freedesktop/compiz/core/screen0	      \
+ * org.freedesktop.compiz.getAll
+ */
+bool
+DbusScreen::handleGetAllMessage (DBusConnection                 *connection,
+				 DBusMessage                    *message,
+				 const std::vector<CompString>& path)
+{
+    CompOption::Vector &options = getOptionsFromPath (path);
+    DBusMessage        *reply;
+    DBusMessageIter    iter;
+
+    reply = dbus_message_new_method_return (message);
+
+    dbus_message_iter_init_append (reply, &iter);
+    compiz::dbus::appendOptionDict (&iter, options);
+
+    dbus_connection_send (connection, reply, NULL);
+    dbus_connection_flush (connection);
+
+    dbus_message_unref (reply);
+
+    return true;
+}
+
+/*
+ * 'SetMany' can be used to change any number of options of a plugin
+ * at once. The argument is a dictionary of option names and new
+ * values. Nothing is changed unless all of them are valid, and the
+ * options which did change are reported in a single 'optionsChanged'
+ * signal rather than one 'changed' signal each.
+ *
+ * Example (will set the hsize and vsize options):
+ *
+ * gdbus call --session --dest org.freedesktop.compiz \
+ * --object-path /org/freedesktop/compiz/core/screen0 \
+ * --method org.freedesktop.compiz.setMany	      \
+ * "{'hsize': <4>, 'vsize': <2>}"
+ */
+bool
+DbusScreen::handleSetManyMessage (DBusConnection                 *connection,
+				  DBusMessage                    *message,
+				  const std::vector<CompString>& path)
+{
+    compiz::dbus::PluginOptionChanges changes;
+    CompString                        error;
+    DBusMessageIter                   iter;
+    CompPlugin                        *p = CompPlugin::find (path[0].c_str ());
+
+    if (!p || !p->vTable)
+	error = "No such plugin";
+    else if (!dbus_message_iter_init (message, &iter))
+	error = "Expected a dictionary of option values";
+    else if (compiz::dbus::readOptionDict (&iter, p->vTable->getOptions (),
+					   changes[path[0]], error))
+	optionBatch.apply (changes, *this);
+
+    sendReply (connection, message, error);
+
+    return true;
+}
+
+/*
+ * 'GetAll' on the root object retrieves the options of all active
+ * plugins, as a dictionary of plugin names and option dictionaries.
+ *
+ * Example:
+ *
+ * dbus-send --print-reply --type=method_call \
+ * --dest=org.freedesktop.compiz	      \
+ * /org/freedesktop/compiz		      \
+ * org.freedesktop.compiz.getAll
+ */
+bool
+DbusScreen::handleRootGetAllMessage (DBusConnection *connection,
+				     DBusMessage    *message)
+{
+    DBusMessage     *reply;
+    DBusMessageIter iter, dict;
+
+    reply = dbus_message_new_method_return (message);
+
+    dbus_message_iter_init_append (reply, &iter);
+    dbus_message_iter_open_container (&iter, DBUS_TYPE_ARRAY, "{sa{sv}}",
+				      &dict);
+
+    foreach (CompPlugin *p, CompPlugin::getPlugins ())
+    {
+	DBusMessageIter entry;
+	const char      *name;
+
+	if (!p->vTable)
+	    continue;
+
+	name = p->vTable->name ().c_str ();
+
+	dbus_message_iter_open_container (&dict, DBUS_TYPE_DICT_ENTRY, NULL,
+					  &entry);
+	dbus_message_iter_append_basic (&entry, DBUS_TYPE_STRING, &name);
+	compiz::dbus::appendOptionDict (&entry, p->vTable->getOptions ());
+	dbus_message_iter_close_container (&dict, &entry);
+    }
+
+    dbus_message_iter_close_container (&iter, &dict);
+
+    dbus_connection_send (connection, reply, NULL);
+    dbus_connection_flush (connection);
+
+    dbus_message_unref (reply);
+
+    return true;
+}
+
+/*
+ * 'SetMany' on the root object changes options of several plugins
+ * at once. The argument is a dictionary of plugin names and option
+ * dictionaries as taken by the plugins' 'SetMany'. If any plugin,
+ * option or value is invalid nothing is changed at all.
+ *
+ * Example:
+ *
+ * gdbus call --session --dest org.freedesktop.compiz	     \
+ * --object-path /org/freedesktop/compiz		     \
+ * --method org.freedesktop.compiz.setMany		     \
+ * "{'core': {'hsize': <4>}, 'expo': {'zoom_time': <0.3>}}"
+ */
+bool
+DbusScreen::handleRootSetManyMessage (DBusConnection *connection,
+				      DBusMessage    *message)
+{
+    compiz::dbus::PluginOptionChanges changes;
+    CompString                        error;
+    DBusMessageIter                   iter, dict;
+
+    if (!dbus_message_iter_init (message, &iter) ||
+	dbus_message_iter_get_arg_type (&iter) != DBUS_TYPE_ARRAY ||
+	dbus_message_iter_get_element_type (&iter) != DBUS_TYPE_DICT_ENTRY)
+    {
+	error = "Expected a dictionary of plugin names and option values";
+    }
+    else
+    {
+	dbus_message_iter_recurse (&iter, &dict);
+
+	while (error.empty () &&
+	       dbus_message_iter_get_arg_type (&dict) == DBUS_TYPE_DICT_ENTRY)
+	{
+	    DBusMessageIter entry;
+	    const char      *name = "";
+	    CompPlugin      *p = NULL;
+
+	    dbus_message_iter_recurse (&dict, &entry);
+
+	    if (dbus_message_iter_get_arg_type (&entry) == DBUS_TYPE_STRING)
+	    {
+		dbus_message_iter_get_basic (&entry, &name);
+		p = CompPlugin::find (name);
+	    }
+
+	    if (!p || !p->vTable)
+	    {
+		error = CompString ("No such plugin: ") + name;
+		break;
+	    }
+
+	    dbus_message_iter_next (&entry);
+	    compiz::dbus::readOptionDict (&entry, p->vTable->getOptions (),
+					  changes[name], error);
+
+	    dbus_message_iter_next (&dict);
+	}
+    }
+
+    if (error.empty ())
+	optionBatch.apply (changes, *this);
+
+    sendReply (connection, message, error);
+
+    return true;
+}
+
+void
+DbusScreen::sendReply (DBusConnection   *connection,
+		       DBusMessage      *message,
+		       const CompString &error)
+{
+    DBusMessage *reply;
+
+    if (dbus_message_get_no_reply (message))
+	return;
+
+    if (error.empty ())
+	reply = dbus_message_new_method_return (message);
+    else
+	reply = dbus_message_new_error (message,
+					DBUS_ERROR_FAILED,
+					error.c_str ());
+
+    dbus_connection_send (connection, reply, NULL);
+    dbus_connection_flush (connection);
+
+    dbus_message_unref (reply);
+}
+
+bool
+DbusScreen::setOption (const CompString  &plugin,
+		       const CompString  &name,
+		       CompOption::Value &value)
+{
+    return screen->setOptionForPlugin (plugin.c_str (), name.c_str (), value);
+}
+
+void
+DbusScreen::optionsChanged (const CompString               &plugin,
+			    const std::vector <CompString> &names)
+{
+    sendOptionsChangedSignal (plugin, names);
+}
+
+void
+DbusScreen::pluginsChanged ()
+{
+    unregisterPluginsForScreen (connection);
+    registerPluginsForScreen (connection);
+}
+
 /*
  * 'GetMetadata' can be used to retrieve metadata for an option.
  *
@@ -1383,6 +1280,18 @@ DbusScreen::handleMessage (DBusConnection *connection,
 	    if (handleRootIntrospectMessage (connection, message))
 		return DBUS_HANDLER_RESULT_HANDLED;
 	}
+	else if (dbus_message_is_method_call (message, COMPIZ_DBUS_INTERFACE,
+					      COMPIZ_DBUS_GET_ALL_MEMBER_NAME))
+	{
+	    if (handleRootGetAllMessage (connection, message))
+		return DBUS_HANDLER_RESULT_HANDLED;
+	}
+	else if (dbus_message_is_method_call (message, COMPIZ_DBUS_INTERFACE,
+					      COMPIZ_DBUS_SET_MANY_MEMBER_NAME))
+	{
+	    if (handleRootSetManyMessage (connection, message))
+		return DBUS_HANDLER_RESULT_HANDLED;
+	}
 #if GET_PLUGIN_METADATA_ENABLED
 	else if (dbus_message_is_method_call (message, COMPIZ_DBUS_INTERFACE,
 				 COMPIZ_DBUS_GET_PLUGIN_METADATA_MEMBER_NAME))
@@ -1425,6 +1334,20 @@ DbusScreen::handleMessage (DBusConnection *connection,
 		return DBUS_HANDLER_RESULT_HANDLED;
 	}
 
+	if (dbus_message_is_method_call (message, COMPIZ_DBUS_INTERFACE,
+					 COMPIZ_DBUS_GET_ALL_MEMBER_NAME))
+	{
+	    if (handleGetAllMessage (connection, message, path))
+		return DBUS_HANDLER_RESULT_HANDLED;
+	}
+
+	if (dbus_message_is_method_call (message, COMPIZ_DBUS_INTERFACE,
+					 COMPIZ_DBUS_SET_MANY_MEMBER_NAME))
+	{
+	    if (handleSetManyMessage (connection, message, path))
+		return DBUS_HANDLER_RESULT_HANDLED;
+	}
+
 	return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
     }
     /* option message */
@@ -1682,12 +1605,18 @@ DbusScreen::setOptionForPlugin (const char        *plugin,
 	p = CompPlugin::find (plugin);
 	if (p && p->vTable)
 	{
+	    bool activePlugins = p->vTable->name () == "core" &&
+				 strcmp (name, "active_plugins") == 0;
+
+	    /* Reported once the whole batch has been applied */
+	    if (optionBatch.changed (p->vTable->name (), name))
+		return status;
+
 	    CompOption::Vector &options = p->vTable->getOptions ();
 	    sendChangeSignalForOption (CompOption::findOption (options, name),
 				       p->vTable->name ());
 
-	    if (p->vTable->name () == "core" &&
-		strcmp (name, "active_plugins") == 0)
+	    if (activePlugins)
 	    {
 		unregisterPluginsForScreen (connection);
 		registerPluginsForScreen (connection);
@@ -1698,6 +1627,35 @@ DbusScreen::setOptionForPlugin (const char        *plugin,
     return status;
 }
 
+void
+DbusScreen::sendOptionsChangedSignal (const CompString               &plugin,
+				      const std::vector <CompString> &names)
+{
+    CompPlugin      *p = CompPlugin::find (plugin.c_str ());
+    DBusMessage     *signal;
+    DBusMessageIter iter;
+    char            path[256];
+
+    /* The plugin might have been unloaded by the same batch */
+    if (!p || !p->vTable)
+	return;
+
+    snprintf (path, 256, "%s/%s/screen%d", COMPIZ_DBUS_ROOT_PATH,
+	      plugin.c_str (), screen->screenNum ());
+
+    signal = dbus_message_new_signal (path,
+				      COMPIZ_DBUS_SERVICE_NAME,
+				      COMPIZ_DBUS_OPTIONS_CHANGED_SIGNAL_NAME);
+
+    dbus_message_iter_init_append (signal, &iter);
+    compiz::dbus::appendOptionDict (&iter, p->vTable->getOptions (), names);
+
+    dbus_connection_send (connection, signal, NULL);
+    dbus_connection_flush (connection);
+
+    dbus_message_unref (signal);
+}
+
 void
 DbusScreen::sendPluginsChangedSignal (const char *name)
 {
@@ -37,6 +37,9 @@
 #include <dbus/dbus.h>
 #include <libxml/xmlwriter.h>
 
+#include "option-codec.h"
+#include "option-batch.h"
+
 #define COMPIZ_DBUS_SERVICE_NAME	            "org.freedesktop.compiz"
 #define COMPIZ_DBUS_INTERFACE			    "org.freedesktop.compiz"
 #define COMPIZ_DBUS_ROOT_PATH			    "/org/freedesktop/compiz"
@@ -48,9 +51,12 @@
 #define COMPIZ_DBUS_GET_METADATA_MEMBER_NAME	    "getMetadata"
 #define COMPIZ_DBUS_LIST_MEMBER_NAME		    "list"
 #define COMPIZ_DBUS_GET_PLUGIN_METADATA_MEMBER_NAME "getPluginMetadata"
+#define COMPIZ_DBUS_GET_ALL_MEMBER_NAME		    "getAll"
+#define COMPIZ_DBUS_SET_MANY_MEMBER_NAME	    "setMany"
 
 #define COMPIZ_DBUS_CHANGED_SIGNAL_NAME		    "changed"
 #define COMPIZ_DBUS_PLUGINS_CHANGED_SIGNAL_NAME	    "pluginsChanged"
+#define COMPIZ_DBUS_OPTIONS_CHANGED_SIGNAL_NAME	    "optionsChanged"
 
 #define DBUS_FILE_WATCH_CURRENT	0
 #define DBUS_FILE_WATCH_PLUGIN	1
@@ -91,7 +97,8 @@ class IntrospectionResponse
 
 class DbusScreen :
     public PluginClassHandler <DbusScreen, CompScreen>,
-    public ScreenInterface
+    public ScreenInterface,
+    public compiz::dbus::OptionChangeTarget
 {
     public:
 
@@ -103,6 +110,8 @@ class DbusScreen :
 	DBusConnection    *connection;
 	CompWatchFdHandle watchFdHandle;
 
+	compiz::dbus::OptionChangeBatch optionBatch;
+
 	bool
 	setOptionForPlugin (const char *plugin,
 			    const char *name,
@@ -148,26 +157,11 @@ class DbusScreen :
 			     int	     type,
 			     void 	     *value);
 
-	bool
-	getOptionValue (DBusMessageIter   *iter,
-			CompOption::Type  type,
-			CompOption::Value &value);
-
 	bool
 	handleSetOptionMessage (DBusConnection                 *connection,
 				DBusMessage                    *message,
 				const std::vector<CompString>& path);
 
-	void
-	appendSimpleOptionValue (DBusMessage       *message,
-				 CompOption::Type  type,
-				 CompOption::Value &value);
-
-	void
-	appendListOptionValue (DBusMessage       *message,
-			       CompOption::Type  type,
-			       CompOption::Value &value);
-
 	void
 	appendOptionValue (DBusMessage       *message,
 			   CompOption::Type  type,
@@ -183,6 +177,41 @@ class DbusScreen :
 			   DBusMessage                    *message,
 			   const std::vector<CompString>& path);
 
+	bool
+	handleGetAllMessage (DBusConnection                 *connection,
+			     DBusMessage                    *message,
+			     const std::vector<CompString>& path);
+
+	bool
+	handleSetManyMessage (DBusConnection                 *connection,
+			      DBusMessage                    *message,
+			      const std::vector<CompString>& path);
+
+	bool
+	handleRootGetAllMessage (DBusConnection *connection,
+				 DBusMessage    *message);
+
+	bool
+	handleRootSetManyMessage (DBusConnection *connection,
+				  DBusMessage    *message);
+
+	static void
+	sendReply (DBusConnection   *connection,
+		   DBusMessage      *message,
+		   const CompString &error);
+
+	bool
+	setOption (const CompString  &plugin,
+		   const CompString  &name,
+		   CompOption::Value &value);
+
+	void
+	optionsChanged (const CompString               &plugin,
+			const std::vector <CompString> &names);
+
+	void
+	pluginsChanged ();
+
 	DBusHandlerResult
 	handleMessage (DBusConnection *connection,
 		       DBusMessage    *message,
@@ -195,6 +224,10 @@ class DbusScreen :
 	sendChangeSignalForOption (CompOption       *o,
 			           const CompString &plugin);
 
+	void
+	sendOptionsChangedSignal (const CompString               &plugin,
+				  const std::vector <CompString> &names);
+
 	bool
 	getPathDecomposed (const char              *data,
 			   std::vector<CompString> &path);
@@ -1024,18 +1024,20 @@ EZoomScreen::restrainCursor (int out)
     int   east   = distanceToEdge (out, EAST);
     int   west   = distanceToEdge (out, WEST);
 
+    const GLCursorImage &cursor = gScreen->cursor ();
+
     if (zooms.at (out).currentZoom == 1.0f)
     {
 	lastChange = time(NULL);
 	mouse = MousePoller::getCurrentPosition ();
     }
 
-    convertToZoomedTarget (out, mouse.x () - cursor.hotX,
-			   mouse.y () - cursor.hotY, &x1, &y1);
+    convertToZoomedTarget (out, mouse.x () - cursor.hotspot.x (),
+			   mouse.y () - cursor.hotspot.y (), &x1, &y1);
     convertToZoomedTarget
 	(out,
-	 mouse.x () - cursor.hotX + cursor.width,
-	 mouse.y () - cursor.hotY + cursor.height,
+	 mouse.x () - cursor.hotspot.x () + cursor.size.width (),
+	 mouse.y () - cursor.hotspot.y () + cursor.size.height (),
 	 &x2, &y2);
 
     if ((x2 - x1 > o->x2 () - o->x1 ()) ||
@@ -1076,14 +1078,18 @@ EZoomScreen::cursorMoved ()
 	    restrainCursor (out);
 
 	if (optionGetZoomMode () == EzoomOptions::ZoomModePanArea)
-	    ensureVisibilityArea (mouse.x () - cursor.hotX,
-				  mouse.y () - cursor.hotY,
-				  mouse.x () + cursor.width -
-				  cursor.hotX,
-				  mouse.y () + cursor.height -
-				  cursor.hotY,
+	{
+	    const GLCursorImage &cursor = gScreen->cursor ();
+
+	    ensureVisibilityArea (mouse.x () - cursor.hotspot.x (),
+				  mouse.y () - cursor.hotspot.y (),
+				  mouse.x () + cursor.size.width () -
+				  cursor.hotspot.x (),
+				  mouse.y () + cursor.size.height () -
+				  cursor.hotspot.y (),
 				  optionGetRestrainMargin (),
 				  NORTHWEST);
+	}
 	cursorZoomActive (out);
     }
     else
@@ -1127,26 +1133,15 @@ EZoomScreen::updateMouseInterval (const CompPoint &p)
     }
 }
 
-/* Free a cursor */
-void
-EZoomScreen::freeCursor (CursorTexture *cursor)
-{
-    if (!cursor->isSet)
-	return;
-
-    cursor->isSet = false;
-    glDeleteTextures (1, &cursor->texture);
-    cursor->texture = 0;
-}
-
 /* Translate into place and draw the scaled cursor.  */
 void
 EZoomScreen::drawCursor (CompOutput    *output,
 			const GLMatrix &transform)
 {
-    int out = output->id ();
+    int                 out = output->id ();
+    const GLCursorImage &cursor = gScreen->cursor ();
 
-    if (cursor.isSet)
+    if (cursorTracked)
     {
 	/*
 	 * XXX: expo knows how to handle mouse when zoomed, so we back off
@@ -1158,6 +1153,9 @@ EZoomScreen::drawCursor (CompOutput    *output,
 	    return;
 	}
 
+	if (cursor.textures.empty ())
+	    return;
+
 	GLMatrix       sTransform = transform;
 	float          scaleFactor;
 	int            ax, ay;
@@ -1175,15 +1173,18 @@ EZoomScreen::drawCursor (CompOutput    *output,
 	    scaleFactor = 1.0f / optionGetScaleMouseStatic ();
 
 	sTransform.scale (scaleFactor, scaleFactor, 1.0f);
-	int x = -cursor.hotX;
-	int y = -cursor.hotY;
+	int x = -cursor.hotspot.x ();
+	int y = -cursor.hotspot.y ();
+
+	GLTexture               *tex = cursor.textures[0];
+	const GLTexture::Matrix &m = tex->matrix ();
 
 	GLboolean glBlendEnabled = glIsEnabled (GL_BLEND);
 
 	if (!glBlendEnabled)
 	    glEnable (GL_BLEND);
 
-	glBindTexture (GL_TEXTURE_2D, cursor.texture);
+	tex->enable (GLTexture::Good);
 
 	streamingBuffer->begin (GL_TRIANGLE_STRIP);
 
@@ -1191,123 +1192,36 @@ EZoomScreen::drawCursor (CompOutput    *output,
 	vertexData[1]  = y;
 	vertexData[2]  = 0.0f;
 	vertexData[3]  = x;
-	vertexData[4]  = y + cursor.height;
+	vertexData[4]  = y + cursor.size.height ();
 	vertexData[5]  = 0.0f;
-	vertexData[6]  = x + cursor.width;
+	vertexData[6]  = x + cursor.size.width ();
 	vertexData[7]  = y;
 	vertexData[8]  = 0.0f;
-	vertexData[9]  = x + cursor.width;
-	vertexData[10] = y + cursor.height;
+	vertexData[9]  = x + cursor.size.width ();
+	vertexData[10] = y + cursor.size.height ();
 	vertexData[11] = 0.0f;
 
 	streamingBuffer->addVertices (4, vertexData);
 
-	textureData[0] = 0;
-	textureData[1] = 0;
-	textureData[2] = 0;
-	textureData[3] = 1;
-	textureData[4] = 1;
-	textureData[5] = 0;
-	textureData[6] = 1;
-	textureData[7] = 1;
+	textureData[0] = COMP_TEX_COORD_X (m, 0);
+	textureData[1] = COMP_TEX_COORD_Y (m, 0);
+	textureData[2] = COMP_TEX_COORD_X (m, 0);
+	textureData[3] = COMP_TEX_COORD_Y (m, cursor.size.height ());
+	textureData[4] = COMP_TEX_COORD_X (m, cursor.size.width ());
+	textureData[5] = COMP_TEX_COORD_Y (m, 0);
+	textureData[6] = COMP_TEX_COORD_X (m, cursor.size.width ());
+	textureData[7] = COMP_TEX_COORD_Y (m, cursor.size.height ());
 
 	streamingBuffer->addTexCoords (0, 4, textureData);
 
 	streamingBuffer->end ();
 	streamingBuffer->render (sTransform);
 
-	glBindTexture (GL_TEXTURE_2D, 0);
+	tex->disable ();
 	glDisable (GL_BLEND);
     }
 }
 
-/* Create (if necessary) a texture to store the cursor,
- * fetch the cursor with XFixes. Store it. */
-void
-EZoomScreen::updateCursor (CursorTexture * cursor)
-{
-    int     i;
-    Display *dpy = screen->dpy ();
-
-    if (!cursor->isSet)
-    {
-	cursor->isSet = true;
-	cursor->screen = screen;
-
-	glGenTextures (1, &cursor->texture);
-	glBindTexture (GL_TEXTURE_2D, cursor->texture);
-
-	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
-			 gScreen->textureFilter ());
-	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-			 gScreen->textureFilter ());
-    }
-
-    XFixesCursorImage *ci = XFixesGetCursorImage (dpy);
-    unsigned char     *pixels;
-    unsigned long     pix;
-
-    if (ci)
-    {
-	cursor->width  = ci->width;
-	cursor->height = ci->height;
-	cursor->hotX = ci->xhot;
-	cursor->hotY = ci->yhot;
-	pixels = (unsigned char *) malloc (ci->width * ci->height * 4);
-
-	if (!pixels)
-	{
-	    XFree (ci);
-	    return;
-	}
-
-	for (i = 0; i < ci->width * ci->height; ++i)
-	{
-	    pix                 = ci->pixels[i];
-	    pixels[i * 4]       = pix & 0xff;
-	    pixels[(i * 4) + 1] = (pix >> 8) & 0xff;
-	    pixels[(i * 4) + 2] = (pix >> 16) & 0xff;
-	    pixels[(i * 4) + 3] = (pix >> 24) & 0xff;
-	}
-
-	XFree (ci);
-    }
-    else
-    {
-	/* Fallback R: 255 G: 255 B: 255 A: 255
-	 * FIXME: Draw a cairo mouse cursor */
-
-	cursor->width  = 1;
-	cursor->height = 1;
-	cursor->hotX   = 0;
-	cursor->hotY   = 0;
-	pixels = (unsigned char *) malloc (cursor->width * cursor->height * 4);
-
-	if (!pixels)
-	    return;
-
-	for (i = 0; i < cursor->width * cursor->height; ++i)
-	{
-	    pix                 = 0x00ffffff;
-	    pixels[i * 4]       = pix & 0xff;
-	    pixels[(i * 4) + 1] = (pix >> 8) & 0xff;
-	    pixels[(i * 4) + 2] = (pix >> 16) & 0xff;
-	    pixels[(i * 4) + 3] = (pix >> 24) & 0xff;
-	}
-
-	compLogMessage ("ezoom", CompLogLevelWarn, "unable to get system cursor image!");
-    }
-
-    glBindTexture (GL_TEXTURE_2D, cursor->texture);
-    glTexImage2D (GL_TEXTURE_2D, 0, GL_RGBA, cursor->width,
-		  cursor->height, 0, GL_BGRA, GL_UNSIGNED_BYTE, pixels);
-    glBindTexture (GL_TEXTURE_2D, 0);
-
-    free (pixels);
-}
-
 /* We are no longer zooming the cursor, so display it.  */
 void
 EZoomScreen::cursorZoomInactive ()
@@ -1315,15 +1229,12 @@ EZoomScreen::cursorZoomInactive ()
     if (!fixesSupported)
 	return;
 
-    if (cursorInfoSelected)
+    if (cursorTracked)
     {
-	cursorInfoSelected = false;
-	XFixesSelectCursorInput (screen->dpy (), screen->root (), 0);
+	cursorTracked = false;
+	gScreen->trackCursor (false);
     }
 
-    if (cursor.isSet)
-	freeCursor (&cursor);
-
     if (cursorHidden)
     {
 	cursorHidden = false;
@@ -1351,12 +1262,10 @@ EZoomScreen::cursorZoomActive (int out)
 	!zooms.at (out).locked)
 	return;
 
-    if (!cursorInfoSelected)
+    if (!cursorTracked)
     {
-	cursorInfoSelected = true;
-	XFixesSelectCursorInput (screen->dpy (), screen->root (),
-				 XFixesDisplayCursorNotifyMask);
-	updateCursor (&cursor);
+	cursorTracked = true;
+	gScreen->trackCursor (true);
     }
 
     if (canHideCursor &&
@@ -1886,32 +1795,12 @@ EZoomScreen::handleEvent (XEvent *event)
 	    break;
 
 	default:
-	    if (event->type == fixesEventBase + XFixesCursorNotify)
-	    {
-		//XFixesCursorNotifyEvent *cev = (XFixesCursorNotifyEvent *)
-		//event;
-		if (cursor.isSet)
-		    updateCursor (&cursor);
-	    }
-
 	    break;
     }
 
     screen->handleEvent (event);
 }
 
-/* TODO: Use this ctor carefully */
-
-EZoomScreen::CursorTexture::CursorTexture () :
-    isSet (false),
-    screen (0),
-    width (0),
-    height (0),
-    hotX (0),
-    hotY (0)
-{
-}
-
 EZoomScreen::EZoomScreen (CompScreen *screen) :
     PluginClassHandler <EZoomScreen, CompScreen> (screen),
     cScreen (CompositeScreen::get (screen)),
@@ -1919,7 +1808,7 @@ EZoomScreen::EZoomScreen (CompScreen *screen) :
     grabbed (0),
     grabIndex (0),
     lastChange (0),
-    cursorInfoSelected (false),
+    cursorTracked (false),
     cursorHidden (false)
 {
     ScreenInterface::setHandler (screen, false);
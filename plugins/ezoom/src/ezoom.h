@@ -92,23 +92,6 @@ class EZoomScreen :
 	    WEST
 	} ZoomEdge;
 
-	class CursorTexture
-	{
-	    public:
-
-		bool       isSet;
-		GLuint     texture;
-		CompScreen *screen;
-		int        width;
-		int        height;
-		int        hotX;
-		int        hotY;
-
-	    public:
-
-		CursorTexture ();
-	};
-
 	/* Stores an actual zoom-setup. This can later be used to store/restore
 	 * zoom areas on the fly.
 	 *
@@ -157,10 +140,8 @@ class EZoomScreen :
 	unsigned long int      grabbed;
 	CompScreen::GrabHandle grabIndex; // for zoomBox
 	time_t                 lastChange;
-	CursorTexture          cursor;	// the texture for the faux-cursor
-					// we paint to do fake input
-					// handling
-	bool                   cursorInfoSelected;
+	bool                   cursorTracked; // whether we draw the faux-cursor
+					      // for fake input handling
 	bool                   cursorHidden;
 	CompRect               box;
 	CompPoint              clickPos;
@@ -282,17 +263,10 @@ class EZoomScreen :
 	void
 	updateMouseInterval (const CompPoint &p);
 
-	/* Make dtor */
-	void
-	freeCursor (CursorTexture * cursor);
-
 	void
 	drawCursor (CompOutput     *output,
 		    const GLMatrix &transform);
 
-	void
-	updateCursor (CursorTexture * cursor);
-
 	void
 	cursorZoomInactive ();
 
@@ -23,6 +23,8 @@
  * Author: David Reveman <davidr@novell.com>
  */
 
+#include <algorithm>
+
 #include "fade.h"
 #include <core/atoms.h>
 
@@ -83,8 +85,8 @@ FadeScreen::preparePaint (int msSinceLastPaint)
     int          steps = MAX (12, (msSinceLastPaint * OPAQUE) / fadeTime);
     unsigned int mode = optionGetFadeMode ();
 
-    foreach (CompWindow *w, screen->windows ())
-	FadeWindow::get (w)->paintStep (mode, msSinceLastPaint, steps);
+    foreach (FadeWindow *fw, fadingWindows)
+	fw->paintStep (mode, msSinceLastPaint, steps);
 
     cScreen->preparePaint (msSinceLastPaint);
 }
@@ -155,6 +157,24 @@ FadeWindow::paintStep (unsigned int mode,
     }
 }
 
+void
+FadeWindow::setFading (bool fade)
+{
+    if (fading == fade)
+	return;
+
+    fading = fade;
+
+    std::vector <FadeWindow *> &windows = fScreen->fadingWindows;
+
+    if (fading)
+	windows.push_back (this);
+    else
+	windows.erase (std::find (windows.begin (), windows.end (), this));
+
+    fScreen->cScreen->preparePaintSetEnabled (fScreen, !windows.empty ());
+}
+
 void
 FadeWindow::windowNotify (CompWindowNotify n)
 {
@@ -178,7 +198,10 @@ FadeWindow::glPaint (const GLWindowPaintAttrib &attrib,
 	brightness == attrib.brightness &&
 	saturation == attrib.saturation &&
 	!fScreen->displayModals)
+    {
+	setFading (false);
 	return gWindow->glPaint (attrib, transform, region, mask);
+    }
 
     GLWindowPaintAttrib fAttrib (attrib);
 
@@ -220,6 +243,20 @@ FadeWindow::glPaint (const GLWindowPaintAttrib &attrib,
 	targetSaturation = fAttrib.saturation;
     }
 
+    if (!fading &&
+	(opacity    != fAttrib.opacity    ||
+	 brightness != fAttrib.brightness ||
+	 saturation != fAttrib.saturation))
+    {
+	/* Only just started fading, so this window missed
+	 * out on the step handed out in preparePaint */
+	if (mode == FadeOptions::FadeModeConstantSpeed)
+	    steps = MAX (12, (fScreen->cScreen->redrawTime () * OPAQUE) /
+			     fScreen->fadeTime);
+
+	setFading (true);
+    }
+
     if (steps)
     {
 	GLint newOpacity    = OPAQUE;
@@ -281,6 +318,11 @@ FadeWindow::glPaint (const GLWindowPaintAttrib &attrib,
 	    opacity = 0;
     }
 
+    if (opacity    == fAttrib.opacity    &&
+	brightness == fAttrib.brightness &&
+	saturation == fAttrib.saturation)
+	setFading (false);
+
     fAttrib.opacity    = opacity;
     fAttrib.brightness = brightness;
     fAttrib.saturation = saturation;
@@ -299,6 +341,8 @@ FadeScreen::FadeScreen (CompScreen *s) :
 
     ScreenInterface::setHandler (screen);
     CompositeScreenInterface::setHandler (cScreen);
+
+    cScreen->preparePaintSetEnabled (this, false);
 }
 
 bool
@@ -348,6 +392,7 @@ FadeWindow::FadeWindow (CompWindow *w) :
     targetBrightness (brightness),
     targetSaturation (saturation),
     dModal           (false),
+    fading           (false),
     steps            (0),
     fadeTime         (0),
     opacityDiff      (0),
@@ -366,6 +411,7 @@ FadeWindow::FadeWindow (CompWindow *w) :
 
 FadeWindow::~FadeWindow ()
 {
+    setFading (false);
     removeDisplayModal ();
 }
 
@@ -23,6 +23,8 @@
  * Author: David Reveman <davidr@novell.com>
  */
 
+#include <vector>
+
 #include <core/window.h>
 #include <core/pluginclasshandler.h>
 #include <composite/composite.h>
@@ -31,6 +33,8 @@
 
 #include <opengl/opengl.h>
 
+class FadeWindow;
+
 class FadeScreen :
     public ScreenInterface,
     public CompositeScreenInterface,
@@ -55,6 +59,10 @@ class FadeScreen :
 	int             displayModals;
 	int             fadeTime;
 
+	/* Only these get stepped, so that nothing is done
+	 * per frame while no window is fading */
+	std::vector <FadeWindow *> fadingWindows;
+
 	CompositeScreen *cScreen;
 };
 
@@ -85,6 +93,8 @@ class FadeWindow :
 
 	void dim (bool);
 
+	void setFading (bool);
+
     private:
 
 	FadeScreen      *fScreen;
@@ -101,6 +111,7 @@ class FadeWindow :
 	GLushort        targetSaturation;
 
 	bool            dModal;
+	bool            fading;
 
 	int             steps;
 	int             fadeTime;
@@ -25,23 +25,20 @@
 
 COMPIZ_PLUGIN_20090315 (imgjpeg, JpegPluginVTable)
 
-static bool
-rgbToBGRA (const JSAMPLE *source,
-	   void          *&data,
-	   CompSize      &size,
-	   int           alpha)
-{
-    int  height = size.height ();
-    int  width  = size.width ();
-    char *dest  = (char *) malloc ((unsigned)(height * width * 4));
-
-    if (!dest)
-	return false;
+/* Pixels converted per task when spreading the work over the pool */
+static const unsigned int PIXELS_PER_TASK = 64 * 1024;
 
-    data = dest;
+static void
+rgbRowsToBGRA (const JSAMPLE *source,
+	       char          *dest,
+	       int           width,
+	       int           alpha,
+	       unsigned int  begin,
+	       unsigned int  end)
+{
     int pos;
 
-    for (int h = 0; h < height; ++h)
+    for (int h = begin; h < (int) end; ++h)
     {
 	for (int w = 0; w < width; ++w)
 	{
@@ -59,31 +56,42 @@ rgbToBGRA (const JSAMPLE *source,
 #endif
 	}
     }
-
-    return true;
 }
 
 static bool
-rgbaToRGB (unsigned char *source,
-	   JSAMPLE       **dest,
+rgbToBGRA (const JSAMPLE *source,
+	   void          *&data,
 	   CompSize      &size,
-	   int           stride)
+	   int           alpha)
 {
-    int     height = size.height ();
-    int     width  = size.width ();
-    JSAMPLE *d;
+    int  height = size.height ();
+    int  width  = size.width ();
+    char *dest  = (char *) malloc ((unsigned)(height * width * 4));
 
-    d = (JSAMPLE *) malloc ((unsigned)height * (unsigned)width * 3 *
-			    sizeof (JSAMPLE));
-    if (!d)
+    if (!dest)
 	return false;
 
-    *dest = d;
+    data = dest;
 
-    int ps = stride / width;	/* pixel size */
+    screen->threadPool ().forEachChunk (height, PIXELS_PER_TASK / width + 1,
+					boost::bind (rgbRowsToBGRA, source,
+						     dest, width, alpha,
+						     _1, _2));
+
+    return true;
+}
+
+static void
+rgbaRowsToRGB (const unsigned char *source,
+	       JSAMPLE             *d,
+	       int                 width,
+	       int                 ps,
+	       unsigned int        begin,
+	       unsigned int        end)
+{
     int pos;
 
-    for (int h = 0; h < height; ++h)
+    for (int h = begin; h < (int) end; ++h)
     {
 	for (int w = 0; w < width; ++w)
 	{
@@ -99,6 +107,30 @@ rgbaToRGB (unsigned char *source,
 #endif
 	}
     }
+}
+
+static bool
+rgbaToRGB (unsigned char *source,
+	   JSAMPLE       **dest,
+	   CompSize      &size,
+	   int           stride)
+{
+    int     height = size.height ();
+    int     width  = size.width ();
+    JSAMPLE *d;
+
+    d = (JSAMPLE *) malloc ((unsigned)height * (unsigned)width * 3 *
+			    sizeof (JSAMPLE));
+    if (!d)
+	return false;
+
+    *dest = d;
+
+    int ps = stride / width;	/* pixel size */
+
+    screen->threadPool ().forEachChunk (height, PIXELS_PER_TASK / width + 1,
+					boost::bind (rgbaRowsToRGB, source,
+						     d, width, ps, _1, _2));
 
     return true;
 }
@@ -31,6 +31,9 @@
 
 #include <core/core.h>
 #include <core/pluginclasshandler.h>
+#include <core/threadpool.h>
+
+#include <boost/bind.hpp>
 
 #include <X11/Xarch.h>
 #include <jpeglib.h>
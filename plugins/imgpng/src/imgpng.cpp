@@ -27,6 +27,10 @@
 
 #include "core/abiversion.h"
 
+#include <core/threadpool.h>
+
+#include <boost/bind.hpp>
+
 #include <fstream>
 #include <stdio.h>
 #include <stdlib.h>
@@ -38,6 +42,9 @@ COMPIZ_PLUGIN_20090315 (imgpng, PngPluginVTable)
 
 const unsigned short PNG_SIG_SIZE = 8;
 
+/* Pixels premultiplied per task when spreading the work over the pool */
+static const unsigned int PIXELS_PER_TASK = 64 * 1024;
+
 PngScreen::PngScreen (CompScreen *screen) :
     PluginClassHandler<PngScreen, CompScreen> (screen)
 {
@@ -52,11 +59,12 @@ PngScreen::~PngScreen ()
 }
 
 static void
-premultiplyData (png_structp   png,
-		 png_row_infop row_info,
-		 png_bytep     data)
+premultiplyRows (png_bytep    data,
+		 unsigned int width,
+		 unsigned int begin,
+		 unsigned int end)
 {
-    for (unsigned int i = 0; i < row_info->rowbytes; i += 4)
+    for (unsigned int i = begin * width * 4; i < end * width * 4; i += 4)
     {
 	unsigned char *base = &data[i];
 	unsigned char blue  = base[0];
@@ -124,8 +132,6 @@ PngScreen::readPngData (png_struct *png,
     png_set_bgr (png);
     png_set_filler (png, 0xff, PNG_FILLER_AFTER);
 
-    png_set_read_user_transform_fn (png, premultiplyData);
-
     png_read_update_info (png, info);
 
     pixelSize = 4;
@@ -152,6 +158,14 @@ PngScreen::readPngData (png_struct *png,
 
     delete [] rowPointers;
 
+    /* Premultiply once the whole image is decoded rather than as a
+     * libpng row transform, so that the rows can be shared out */
+    screen->threadPool ().forEachChunk (pngHeight,
+					PIXELS_PER_TASK / pngWidth + 1,
+					boost::bind (premultiplyRows,
+						     (png_bytep) d, pngWidth,
+						     _1, _2));
+
     return true;
 }
 
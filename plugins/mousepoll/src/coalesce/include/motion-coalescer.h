@@ -0,0 +1,84 @@
+/*
+ *
+ * Compiz mouse position polling plugin
+ *
+ * motion-coalescer.h
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef _COMPIZ_MOUSEPOLL_MOTION_COALESCER_H
+#define _COMPIZ_MOUSEPOLL_MOTION_COALESCER_H
+
+#include <boost/function.hpp>
+
+namespace compiz
+{
+namespace mousepoll
+{
+
+/*
+ * A one-shot timer. MotionCoalescer only ever arms it in response
+ * to pointer motion, so nothing fires while the pointer is idle.
+ */
+class DispatchTimer
+{
+    public:
+
+	virtual ~DispatchTimer () {}
+
+	virtual void start () = 0;
+	virtual void stop () = 0;
+	virtual bool active () = 0;
+};
+
+/*
+ * Collapses a burst of pointer motion events into a single
+ * position update per timer period.
+ */
+class MotionCoalescer
+{
+    public:
+
+	typedef boost::function <void ()> Flush;
+
+	MotionCoalescer (DispatchTimer &timer,
+			 const Flush   &flush);
+
+	/* Note that the pointer has moved, arming the dispatch
+	 * timer if no update is pending yet */
+	void motion ();
+
+	/* Dispatch timer callback. Delivers the pending update,
+	 * always returns false so the timer does not repeat */
+	bool dispatch ();
+
+	/* Drop any pending update and disarm the timer */
+	void cancel ();
+
+	bool pending () const;
+
+	/* Number of times dispatch () actually delivered an update */
+	unsigned int wakeups () const;
+
+    private:
+
+	DispatchTimer &mTimer;
+	Flush         mFlush;
+	bool          mPending;
+	unsigned int  mWakeups;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,73 @@
+/*
+ *
+ * Compiz mouse position polling plugin
+ *
+ * motion-coalescer.cpp
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#include "motion-coalescer.h"
+
+namespace cmp = compiz::mousepoll;
+
+cmp::MotionCoalescer::MotionCoalescer (DispatchTimer &timer,
+				       const Flush   &flush) :
+    mTimer (timer),
+    mFlush (flush),
+    mPending (false),
+    mWakeups (0)
+{
+}
+
+void
+cmp::MotionCoalescer::motion ()
+{
+    mPending = true;
+
+    if (!mTimer.active ())
+	mTimer.start ();
+}
+
+bool
+cmp::MotionCoalescer::dispatch ()
+{
+    if (!mPending)
+	return false;
+
+    mPending = false;
+    ++mWakeups;
+
+    if (!mFlush.empty ())
+	mFlush ();
+
+    return false;
+}
+
+void
+cmp::MotionCoalescer::cancel ()
+{
+    mPending = false;
+    mTimer.stop ();
+}
+
+bool
+cmp::MotionCoalescer::pending () const
+{
+    return mPending;
+}
+
+unsigned int
+cmp::MotionCoalescer::wakeups () const
+{
+    return mWakeups;
+}
@@ -0,0 +1,146 @@
+/*
+ * Compiz mouse position polling plugin
+ *
+ * test-mousepoll-motion-coalescer.cpp
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <gtest/gtest.h>
+#include <boost/bind.hpp>
+
+#include "motion-coalescer.h"
+
+namespace cmp = compiz::mousepoll;
+
+namespace
+{
+
+class FakeDispatchTimer :
+    public cmp::DispatchTimer
+{
+    public:
+
+	FakeDispatchTimer () :
+	    armed (false),
+	    starts (0)
+	{
+	}
+
+	void start () { armed = true; ++starts; }
+	void stop () { armed = false; }
+	bool active () { return armed; }
+
+	bool         armed;
+	unsigned int starts;
+};
+
+class MousepollMotionCoalescer :
+    public ::testing::Test
+{
+    public:
+
+	MousepollMotionCoalescer () :
+	    flushes (0),
+	    coalescer (timer,
+		       boost::bind (&MousepollMotionCoalescer::flush, this))
+	{
+	}
+
+	void flush () { ++flushes; }
+
+	/* One main loop iteration: fire the timer if it is armed */
+	void iterate ()
+	{
+	    if (timer.armed)
+	    {
+		timer.armed = false;
+
+		if (coalescer.dispatch ())
+		    timer.armed = true;
+	    }
+	}
+
+	FakeDispatchTimer    timer;
+	unsigned int         flushes;
+	cmp::MotionCoalescer coalescer;
+};
+
+}
+
+TEST_F (MousepollMotionCoalescer, NotArmedInitially)
+{
+    EXPECT_FALSE (timer.armed);
+    EXPECT_FALSE (coalescer.pending ());
+}
+
+TEST_F (MousepollMotionCoalescer, MotionArmsTimer)
+{
+    coalescer.motion ();
+
+    EXPECT_TRUE (timer.armed);
+    EXPECT_TRUE (coalescer.pending ());
+}
+
+TEST_F (MousepollMotionCoalescer, BurstIsDeliveredOnce)
+{
+    for (unsigned int i = 0; i < 100; ++i)
+	coalescer.motion ();
+
+    iterate ();
+
+    EXPECT_EQ (1, timer.starts);
+    EXPECT_EQ (1, flushes);
+    EXPECT_EQ (1, coalescer.wakeups ());
+}
+
+TEST_F (MousepollMotionCoalescer, MotionAfterDispatchRearms)
+{
+    coalescer.motion ();
+    iterate ();
+    coalescer.motion ();
+    iterate ();
+
+    EXPECT_EQ (2, timer.starts);
+    EXPECT_EQ (2, flushes);
+}
+
+TEST_F (MousepollMotionCoalescer, NoWakeupsWhenIdle)
+{
+    coalescer.motion ();
+    iterate ();
+
+    unsigned int before = coalescer.wakeups ();
+
+    for (unsigned int i = 0; i < 1000; ++i)
+	iterate ();
+
+    EXPECT_FALSE (timer.armed);
+    EXPECT_EQ (before, coalescer.wakeups ());
+    EXPECT_EQ (1, timer.starts);
+}
+
+TEST_F (MousepollMotionCoalescer, CancelDropsPendingUpdate)
+{
+    coalescer.motion ();
+    coalescer.cancel ();
+    iterate ();
+
+    EXPECT_FALSE (timer.armed);
+    EXPECT_EQ (0, flushes);
+}
+
+TEST_F (MousepollMotionCoalescer, SpuriousDispatchDoesNotFlush)
+{
+    EXPECT_FALSE (coalescer.dispatch ());
+    EXPECT_EQ (0, flushes);
+    EXPECT_EQ (0, coalescer.wakeups ());
+}
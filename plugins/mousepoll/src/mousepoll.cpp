@@ -82,10 +82,7 @@ MousepollScreen::addTimer (MousePoller *poller)
     pollers.insert (it, poller);
 
     if (start)
-    {
-	getMousePosition ();
-	timer.start ();
-    }
+	startTracking ();
 
     return true;
 }
@@ -102,7 +99,102 @@ MousepollScreen::removeTimer (MousePoller *poller)
     pollers.erase (it);
 
     if (pollers.empty ())
-	timer.stop ();
+	stopTracking ();
+}
+
+bool
+MousepollScreen::eventDriven ()
+{
+    return xi2Supported && optionGetEventDriven ();
+}
+
+/* Pointer updates are coalesced to one per frame, so take the
+ * refresh rate from composite if it is around */
+unsigned int
+MousepollScreen::refreshInterval ()
+{
+    CompPlugin *p = CompPlugin::find ("composite");
+
+    if (p)
+    {
+	CompOption *o = CompOption::findOption (p->vTable->getOptions (),
+						"refresh_rate");
+
+	if (o && o->value ().i () > 0)
+	    return 1000 / o->value ().i ();
+    }
+
+    return optionGetMousePollInterval ();
+}
+
+void
+MousepollScreen::selectRawMotion (bool select)
+{
+    unsigned char mask[XIMaskLen (XI_LASTEVENT)] = { 0 };
+    XIEventMask   eventMask;
+
+    if (select)
+	XISetMask (mask, XI_RawMotion);
+
+    eventMask.deviceid = XIAllMasterDevices;
+    eventMask.mask_len = sizeof (mask);
+    eventMask.mask     = mask;
+
+    XISelectEvents (screen->dpy (), screen->root (), &eventMask, 1);
+
+    rawMotionSelected = select;
+}
+
+void
+MousepollScreen::startTracking ()
+{
+    getMousePosition ();
+
+    if (eventDriven ())
+    {
+	unsigned int interval = refreshInterval ();
+
+	dispatchTimer.setTimes (interval, interval);
+	selectRawMotion (true);
+	screen->handleEventSetEnabled (this, true);
+    }
+    else
+	timer.start ();
+}
+
+void
+MousepollScreen::stopTracking ()
+{
+    timer.stop ();
+    coalescer.cancel ();
+
+    if (rawMotionSelected)
+	selectRawMotion (false);
+
+    screen->handleEventSetEnabled (this, false);
+}
+
+void
+MousepollScreen::updateTrackingMode ()
+{
+    if (pollers.empty ())
+	return;
+
+    stopTracking ();
+    startTracking ();
+}
+
+void
+MousepollScreen::handleEvent (XEvent *event)
+{
+    /* Raw events carry no position, they only tell us that the
+     * pointer moved. The position is queried once per dispatch */
+    if (event->type == GenericEvent &&
+	event->xcookie.extension == xi2Opcode &&
+	event->xcookie.evtype == XI_RawMotion)
+	coalescer.motion ();
+
+    screen->handleEvent (event);
 }
 
 void
@@ -222,12 +314,43 @@ MousepollScreen::updateTimer ()
 template class PluginClassHandler <MousepollScreen, CompScreen, COMPIZ_MOUSEPOLL_ABI>;
 
 MousepollScreen::MousepollScreen (CompScreen *screen) :
-    PluginClassHandler <MousepollScreen, CompScreen, COMPIZ_MOUSEPOLL_ABI> (screen)
+    PluginClassHandler <MousepollScreen, CompScreen, COMPIZ_MOUSEPOLL_ABI> (screen),
+    xi2Supported (false),
+    xi2Opcode (0),
+    rawMotionSelected (false),
+    dispatchTimerAdapter (dispatchTimer),
+    coalescer (dispatchTimerAdapter,
+	       boost::bind (&MousepollScreen::updatePosition, this))
 {
+    int event, error;
+
+    /* Raw events are only delivered to the root window
+     * regardless of grabs since XI 2.1 */
+    if (XQueryExtension (screen->dpy (), "XInputExtension",
+			 &xi2Opcode, &event, &error))
+    {
+	int major = 2, minor = 1;
+
+	if (XIQueryVersion (screen->dpy (), &major, &minor) == Success &&
+	    (major > 2 || (major == 2 && minor >= 1)))
+	    xi2Supported = true;
+    }
+
+    ScreenInterface::setHandler (screen, false);
+
     updateTimer ();
     timer.setCallback (boost::bind (&MousepollScreen::updatePosition, this));
+    dispatchTimer.setCallback (boost::bind (&compiz::mousepoll::MotionCoalescer::dispatch,
+					    &coalescer));
 
     optionSetMousePollIntervalNotify (boost::bind (&MousepollScreen::updateTimer, this));
+    optionSetEventDrivenNotify (boost::bind (&MousepollScreen::updateTrackingMode, this));
+}
+
+MousepollScreen::~MousepollScreen ()
+{
+    if (rawMotionSelected)
+	selectRawMotion (false);
 }
 
 bool
@@ -24,9 +24,12 @@
 #include <core/pluginclasshandler.h>
 #include <core/timer.h>
 
+#include <X11/extensions/XInput2.h>
+
 #include <mousepoll/mousepoll.h>
 
 #include "mousepoll_options.h"
+#include "motion-coalescer.h"
 
 typedef enum _MousepollOptions
 {
@@ -34,20 +37,52 @@ typedef enum _MousepollOptions
     MP_DISPLAY_OPTION_NUM
 } MousepollDisplayOptions;
 
+class CompTimerDispatch :
+    public compiz::mousepoll::DispatchTimer
+{
+    public:
+
+	CompTimerDispatch (CompTimer &timer) :
+	    mTimer (timer)
+	{
+	}
+
+	void start () { mTimer.start (); }
+	void stop () { mTimer.stop (); }
+	bool active () { return mTimer.active (); }
+
+    private:
+
+	CompTimer &mTimer;
+};
+
 class MousepollScreen;
 extern template class PluginClassHandler <MousepollScreen, CompScreen, COMPIZ_MOUSEPOLL_ABI>;
 
 class MousepollScreen :
     public PluginClassHandler <MousepollScreen, CompScreen, COMPIZ_MOUSEPOLL_ABI>,
+    public ScreenInterface,
     public MousepollOptions
 {
     public:
 
 	MousepollScreen (CompScreen *screen);
+	~MousepollScreen ();
+
+	void handleEvent (XEvent *);
 
 	std::list<MousePoller *> pollers;
 	CompTimer                timer;
 
+	/* Event driven tracking, used instead of timer if the
+	 * server can deliver XI 2.1 raw motion events */
+	bool                     xi2Supported;
+	int                      xi2Opcode;
+	bool                     rawMotionSelected;
+	CompTimer                dispatchTimer;
+	CompTimerDispatch        dispatchTimerAdapter;
+	compiz::mousepoll::MotionCoalescer coalescer;
+
 	CompPoint                pos;
 
 	bool
@@ -63,6 +98,24 @@ class MousepollScreen :
 	removeTimer (MousePoller *poller);
 
 	void updateTimer ();
+
+	bool
+	eventDriven ();
+
+	unsigned int
+	refreshInterval ();
+
+	void
+	selectRawMotion (bool select);
+
+	void
+	startTracking ();
+
+	void
+	stopTracking ();
+
+	void
+	updateTrackingMode ();
 };
 
 #define MOUSEPOLL_SCREEN(s)						\
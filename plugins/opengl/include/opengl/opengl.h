@@ -57,7 +57,7 @@
 #include <opengl/programcache.h>
 #include <opengl/shadercache.h>
 
-#define COMPIZ_OPENGL_ABI 7
+#define COMPIZ_OPENGL_ABI 9
 
 /*
  * Some plugins check for #ifdef USE_MODERN_COMPIZ_GL. Support it for now, but
@@ -320,6 +320,19 @@ namespace GL {
 					   GLsizei width,
 					   GLsizei height);
 
+    /* GL_ARB_get_program_binary / GL_OES_get_program_binary */
+    typedef void (*GLGetProgramBinaryProc) (GLuint  program,
+					    GLsizei bufSize,
+					    GLsizei *length,
+					    GLenum  *binaryFormat,
+					    void    *binary);
+    typedef void (*GLProgramBinaryProc) (GLuint     program,
+					 GLenum     binaryFormat,
+					 const void *binary,
+					 GLsizei    length);
+    typedef void (*GLProgramParameteriProc) (GLuint program,
+					     GLenum pname,
+					     GLint  value);
 
     /* GL_ARB_shader_objects */
     #ifndef USE_GLES
@@ -426,6 +439,10 @@ namespace GL {
     extern GLFramebufferRenderbufferProc framebufferRenderbuffer;
     extern GLRenderbufferStorageProc renderbufferStorage;
 
+    extern GLGetProgramBinaryProc  getProgramBinary;
+    extern GLProgramBinaryProc     programBinary;
+    extern GLProgramParameteriProc programParameteri;
+
     #ifndef USE_GLES
     extern GLCreateShaderObjectARBProc createShaderObjectARB;
     extern GLCreateProgramObjectARBProc createProgramObjectARB;
@@ -481,6 +498,10 @@ namespace GL {
     static const GLenum 		    FRAGMENT_SHADER = GL_FRAGMENT_SHADER;
     static const GLenum 		    VERTEX_SHADER = GL_VERTEX_SHADER;
 
+    static const GLenum 		    PROGRAM_BINARY_LENGTH = GL_PROGRAM_BINARY_LENGTH_OES;
+    static const GLenum 		    NUM_PROGRAM_BINARY_FORMATS = GL_NUM_PROGRAM_BINARY_FORMATS_OES;
+    static const GLenum 		    PROGRAM_BINARY_RETRIEVABLE_HINT = 0;
+
 #else
 
     static const GLenum 		  FRAMEBUFFER_BINDING = GL_FRAMEBUFFER_BINDING_EXT;
@@ -517,6 +538,10 @@ namespace GL {
     static const GLenum 		  FRAGMENT_SHADER = GL_FRAGMENT_SHADER_ARB;
     static const GLenum 		  VERTEX_SHADER = GL_VERTEX_SHADER_ARB;
 
+    static const GLenum 		  PROGRAM_BINARY_LENGTH = GL_PROGRAM_BINARY_LENGTH;
+    static const GLenum 		  NUM_PROGRAM_BINARY_FORMATS = GL_NUM_PROGRAM_BINARY_FORMATS;
+    static const GLenum 		  PROGRAM_BINARY_RETRIEVABLE_HINT = GL_PROGRAM_BINARY_RETRIEVABLE_HINT;
+
 #endif
 
     extern bool  textureFromPixmap;
@@ -537,6 +562,7 @@ namespace GL {
     extern bool  stencilBuffer;
     extern GLint maxTextureUnits;
     extern bool  bufferAge;
+    extern bool  programBinarySupported;
 
     extern bool canDoSaturated;
     extern bool canDoSlightlySaturated;
@@ -690,6 +716,22 @@ class GLScreenInterface :
 
 extern template class PluginClassHandler<GLScreen, CompScreen, COMPIZ_OPENGL_ABI>;
 
+/**
+ * The image of the current cursor, as returned by GLScreen::cursor
+ */
+struct GLCursorImage
+{
+    GLCursorImage () :
+	serial (0)
+    {
+    }
+
+    GLTexture::List textures;
+    CompSize        size;
+    CompPoint       hotspot;
+    unsigned long   serial; // XFixes cursor serial, 0 if there is none
+};
+
 class GLScreen :
     public WrapableHandler<GLScreenInterface, 9>,
     public PluginClassHandler<GLScreen, CompScreen, COMPIZ_OPENGL_ABI>,
@@ -783,6 +825,21 @@ class GLScreen :
 	 */
 	GLTexture *defaultIcon ();
 
+	/**
+	 * Plugins which draw the cursor themselves call this with true
+	 * when they start and with false when they stop. While anyone
+	 * tracks the cursor, cursor () follows cursor changes. Calls
+	 * are counted, so several plugins can track it at once.
+	 */
+	void trackCursor (bool track);
+
+	/**
+	 * Returns the image of the current cursor while the cursor is
+	 * tracked. Each cursor shape is uploaded once and shared by
+	 * all plugins. textures is empty if there is no image.
+	 */
+	const GLCursorImage & cursor ();
+
 	void resetRasterPos ();
 
 	bool glInitContext (XVisualInfo *);
@@ -964,6 +1021,24 @@ class GLWindow :
 
 	GLTexture *getIcon (int width, int height);
 
+	/**
+	 * Returns a texture holding a copy of the window contents that
+	 * fits in maxSize, or NULL if the window is not much larger than
+	 * maxSize or the copy could not be made. The copy is redrawn when
+	 * the window is damaged, at most every 100ms. matrix is set to map
+	 * screen coordinates onto the texture, like matrices () does.
+	 */
+	GLTexture *downscaledTexture (const CompSize    &maxSize,
+				      GLTexture::Matrix &matrix);
+
+	/**
+	 * Draw the window from its downscaled copy in the next transformed
+	 * glDraw, as it will appear no larger than maxSize on screen.
+	 * Plugins showing many small windows, like switchers, should call
+	 * this before drawing each one.
+	 */
+	void setDownscaleHint (const CompSize &maxSize);
+
 	WRAPABLE_HND (0, GLWindowInterface, bool, glPaint,
 		      const GLWindowPaintAttrib &, const GLMatrix &,
 		      const CompRegion &, unsigned int);
@@ -0,0 +1,114 @@
+/*
+ * Compiz opengl plugin, AtlasAllocator class
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include "atlas.h"
+
+using namespace compiz::opengl;
+
+AtlasAllocator::AtlasAllocator (const CompSize &pageSize,
+				const CompSize &cellSize) :
+    mPageSize (pageSize),
+    mCellSize (cellSize),
+    mColumns (std::max (1, pageSize.width () / cellSize.width ())),
+    mCellsPerPage (mColumns *
+		   std::max (1, pageSize.height () / cellSize.height ())),
+    mNext (0)
+{
+}
+
+const CompSize &
+AtlasAllocator::pageSize () const
+{
+    return mPageSize;
+}
+
+const CompSize &
+AtlasAllocator::cellSize () const
+{
+    return mCellSize;
+}
+
+bool
+AtlasAllocator::fits (const CompSize &size) const
+{
+    return size.width ()  <= mCellSize.width () &&
+	   size.height () <= mCellSize.height ();
+}
+
+AtlasAllocator::Slot
+AtlasAllocator::allocate ()
+{
+    Slot slot;
+
+    if (!mFree.empty ())
+    {
+	slot = mFree.back ();
+	mFree.pop_back ();
+
+	return slot;
+    }
+
+    unsigned int cell = mNext % mCellsPerPage;
+
+    slot.page = mNext / mCellsPerPage;
+    slot.x    = (cell % mColumns) * mCellSize.width ();
+    slot.y    = (cell / mColumns) * mCellSize.height ();
+
+    mNext++;
+
+    return slot;
+}
+
+void
+AtlasAllocator::release (const Slot &slot)
+{
+    mFree.push_back (slot);
+}
+
+unsigned int
+AtlasAllocator::pages () const
+{
+    return (mNext + mCellsPerPage - 1) / mCellsPerPage;
+}
+
+unsigned int
+AtlasAllocator::used () const
+{
+    return mNext - mFree.size ();
+}
+
+unsigned long long
+compiz::opengl::hashImage (const void *data, size_t bytes)
+{
+    const unsigned char *p = static_cast <const unsigned char *> (data);
+    unsigned long long  hash = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < bytes; i++)
+    {
+	hash ^= p[i];
+	hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
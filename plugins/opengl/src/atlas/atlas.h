@@ -0,0 +1,78 @@
+/*
+ * Compiz opengl plugin, AtlasAllocator class
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef __COMPIZ_OPENGL_ATLAS_H
+#define __COMPIZ_OPENGL_ATLAS_H
+#include <vector>
+#include <cstddef>
+#include "core/size.h"
+
+namespace compiz {
+namespace opengl {
+
+/*
+ * Hands out equally sized cells of texture atlas pages. Released cells
+ * are reused before new ones are taken, new pages are added as needed.
+ */
+class AtlasAllocator
+{
+public:
+    struct Slot
+    {
+	unsigned int page;
+	int          x;
+	int          y;
+    };
+
+    AtlasAllocator (const CompSize &pageSize, const CompSize &cellSize);
+
+    const CompSize & pageSize () const;
+    const CompSize & cellSize () const;
+
+    /* Whether an image of size fits in a cell */
+    bool fits (const CompSize &size) const;
+
+    Slot allocate ();
+    void release (const Slot &slot);
+
+    /* Number of pages any cell was ever allocated from */
+    unsigned int pages () const;
+
+    /* Number of cells currently allocated */
+    unsigned int used () const;
+
+private:
+    CompSize          mPageSize;
+    CompSize          mCellSize;
+    unsigned int      mColumns;
+    unsigned int      mCellsPerPage;
+    unsigned int      mNext;
+    std::vector<Slot> mFree;
+};
+
+/* 64 bit FNV-1a hash of data, to find identical images */
+unsigned long long hashImage (const void *data, size_t bytes);
+
+}
+}
+#endif
@@ -0,0 +1,114 @@
+/*
+ * Compiz opengl plugin, AtlasAllocator class
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <set>
+#include <utility>
+#include "gtest/gtest.h"
+#include "atlas.h"
+
+using namespace compiz::opengl;
+
+TEST (OpenGLAtlasAllocator, Fits)
+{
+    AtlasAllocator allocator (CompSize (1024, 1024), CompSize (66, 66));
+
+    EXPECT_TRUE  (allocator.fits (CompSize (66, 66)));
+    EXPECT_TRUE  (allocator.fits (CompSize (16, 16)));
+    EXPECT_FALSE (allocator.fits (CompSize (67, 16)));
+    EXPECT_FALSE (allocator.fits (CompSize (16, 128)));
+}
+
+TEST (OpenGLAtlasAllocator, CellsDoNotOverlap)
+{
+    AtlasAllocator                     allocator (CompSize (100, 100),
+						  CompSize (30, 30));
+    std::set <std::pair <int, int> >   seen;
+
+    for (int i = 0; i < 9; i++)
+    {
+	AtlasAllocator::Slot slot = allocator.allocate ();
+
+	EXPECT_EQ (0u, slot.page);
+	EXPECT_LE (slot.x + 30, 100);
+	EXPECT_LE (slot.y + 30, 100);
+	EXPECT_TRUE (seen.insert (std::make_pair (slot.x, slot.y)).second);
+    }
+
+    EXPECT_EQ (1u, allocator.pages ());
+    EXPECT_EQ (9u, allocator.used ());
+}
+
+TEST (OpenGLAtlasAllocator, NewPageWhenFull)
+{
+    AtlasAllocator allocator (CompSize (64, 64), CompSize (32, 32));
+
+    for (int i = 0; i < 4; i++)
+	allocator.allocate ();
+
+    AtlasAllocator::Slot slot = allocator.allocate ();
+
+    EXPECT_EQ (1u, slot.page);
+    EXPECT_EQ (0, slot.x);
+    EXPECT_EQ (0, slot.y);
+    EXPECT_EQ (2u, allocator.pages ());
+}
+
+TEST (OpenGLAtlasAllocator, ReleasedCellsAreReused)
+{
+    AtlasAllocator allocator (CompSize (64, 64), CompSize (32, 32));
+
+    allocator.allocate ();
+    AtlasAllocator::Slot second = allocator.allocate ();
+    allocator.allocate ();
+
+    allocator.release (second);
+    EXPECT_EQ (2u, allocator.used ());
+
+    AtlasAllocator::Slot reused = allocator.allocate ();
+
+    EXPECT_EQ (second.page, reused.page);
+    EXPECT_EQ (second.x, reused.x);
+    EXPECT_EQ (second.y, reused.y);
+    EXPECT_EQ (1u, allocator.pages ());
+}
+
+TEST (OpenGLAtlasAllocator, PageSmallerThanCell)
+{
+    AtlasAllocator allocator (CompSize (16, 16), CompSize (32, 32));
+
+    EXPECT_EQ (0u, allocator.allocate ().page);
+    EXPECT_EQ (1u, allocator.allocate ().page);
+}
+
+TEST (OpenGLAtlasHash, IdenticalImagesHashEqual)
+{
+    unsigned int a[16], b[16];
+
+    for (int i = 0; i < 16; i++)
+	a[i] = b[i] = 0xff000000 | i;
+
+    EXPECT_EQ (hashImage (a, sizeof (a)), hashImage (b, sizeof (b)));
+
+    b[7] ^= 1;
+    EXPECT_NE (hashImage (a, sizeof (a)), hashImage (b, sizeof (b)));
+}
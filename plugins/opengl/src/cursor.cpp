@@ -0,0 +1,156 @@
+/*
+ * Compiz opengl plugin, cursor tracking
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <vector>
+
+#include <X11/extensions/Xfixes.h>
+
+#include "privates.h"
+
+namespace cgl = compiz::opengl;
+
+GLCursorTracker::GLCursorTracker () :
+    fixesSupported (false),
+    fixesEvent (0),
+    trackCount (0),
+    currentImage (),
+    images (CacheSize)
+{
+    int fixesError;
+
+    fixesSupported = XFixesQueryExtension (screen->dpy (), &fixesEvent,
+					   &fixesError);
+}
+
+GLCursorTracker::~GLCursorTracker ()
+{
+    if (trackCount && fixesSupported)
+	XFixesSelectCursorInput (screen->dpy (), screen->root (), 0);
+}
+
+void
+GLCursorTracker::track (bool track)
+{
+    if (track)
+    {
+	if (trackCount++)
+	    return;
+
+	if (fixesSupported)
+	    XFixesSelectCursorInput (screen->dpy (), screen->root (),
+				     XFixesDisplayCursorNotifyMask);
+
+	/* Nothing told us about cursor changes while untracked */
+	fetch ();
+    }
+    else if (trackCount && !--trackCount)
+    {
+	if (fixesSupported)
+	    XFixesSelectCursorInput (screen->dpy (), screen->root (), 0);
+
+	/* Cached images stay around for the next time */
+	currentImage = GLCursorImage ();
+    }
+}
+
+void
+GLCursorTracker::handleEvent (XEvent *event)
+{
+    if (!trackCount || !fixesSupported ||
+	event->type != fixesEvent + XFixesCursorNotify)
+	return;
+
+    XFixesCursorNotifyEvent *ce = (XFixesCursorNotifyEvent *) event;
+    GLCursorImage           *image = images.find (ce->cursor_serial);
+
+    if (image)
+	currentImage = *image;
+    else
+	fetch ();
+}
+
+const GLCursorImage &
+GLCursorTracker::current () const
+{
+    return currentImage;
+}
+
+void
+GLCursorTracker::fetch ()
+{
+    XFixesCursorImage *ci = NULL;
+
+    if (fixesSupported)
+	ci = XFixesGetCursorImage (screen->dpy ());
+
+    if (!ci || !ci->width || !ci->height)
+    {
+	if (ci)
+	    XFree (ci);
+
+	compLogMessage ("opengl", CompLogLevelWarn,
+			"unable to get the cursor image");
+
+	currentImage = GLCursorImage ();
+	return;
+    }
+
+    /* The cursor may have changed again since the last notify,
+     * what we got back is identified by its own serial */
+    GLCursorImage *cached = images.find (ci->cursor_serial);
+
+    if (cached)
+    {
+	currentImage = *cached;
+	XFree (ci);
+	return;
+    }
+
+    GLCursorImage              image;
+    std::vector <unsigned int> pixels (ci->width * ci->height);
+
+    cgl::packCursorPixels (ci->pixels, &pixels[0], pixels.size ());
+
+    image.size    = CompSize (ci->width, ci->height);
+    image.hotspot = CompPoint (ci->xhot, ci->yhot);
+    image.serial  = ci->cursor_serial;
+    image.textures =
+	GLTexture::imageBufferToTexture ((const char *) &pixels[0],
+					 image.size);
+
+    XFree (ci);
+
+    currentImage = images.insert (image.serial, image);
+}
+
+void
+GLScreen::trackCursor (bool track)
+{
+    priv->cursorTracker.track (track);
+}
+
+const GLCursorImage &
+GLScreen::cursor ()
+{
+    return priv->cursorTracker.current ();
+}
@@ -0,0 +1,114 @@
+/*
+ * Compiz opengl plugin, CursorCache class
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef __COMPIZ_OPENGL_CURSORCACHE_H
+#define __COMPIZ_OPENGL_CURSORCACHE_H
+#include <list>
+#include <map>
+#include <utility>
+#include <cstddef>
+
+namespace compiz {
+namespace opengl {
+
+/* Narrow XFixes cursor pixels, one ARGB value in each long, to packed
+ * 32 bit ARGB as uploaded with GL_BGRA. This is a plain loop so the
+ * compiler can vectorize it */
+void packCursorPixels (const unsigned long *src,
+		       unsigned int        *dst,
+		       size_t              count);
+
+/*
+ * Keeps the most recently used cursor images by XFixes cursor serial.
+ * The server gives every cursor shape its own serial, so an image can
+ * be reused whenever its serial comes up again.
+ */
+template <typename Image>
+class CursorCache
+{
+public:
+    CursorCache (unsigned int capacity) :
+	mCapacity (capacity)
+    {
+    }
+
+    /* Returns the image for serial, now the most recently used one,
+     * or NULL if it is not cached */
+    Image * find (unsigned long serial)
+    {
+	typename Index::iterator it = mIndex.find (serial);
+
+	if (it == mIndex.end ())
+	    return NULL;
+
+	mImages.splice (mImages.begin (), mImages, it->second);
+
+	return &it->second->second;
+    }
+
+    /* Adds or replaces the image for serial, dropping the least
+     * recently used image if the cache is full */
+    Image & insert (unsigned long serial, const Image &image)
+    {
+	typename Index::iterator it = mIndex.find (serial);
+
+	if (it != mIndex.end ())
+	{
+	    mImages.erase (it->second);
+	    mIndex.erase (it);
+	}
+	else if (mCapacity && mImages.size () >= mCapacity)
+	{
+	    mIndex.erase (mImages.back ().first);
+	    mImages.pop_back ();
+	}
+
+	mImages.push_front (std::make_pair (serial, image));
+	mIndex[serial] = mImages.begin ();
+
+	return mImages.front ().second;
+    }
+
+    unsigned int size () const
+    {
+	return mImages.size ();
+    }
+
+    void clear ()
+    {
+	mIndex.clear ();
+	mImages.clear ();
+    }
+
+private:
+    typedef std::list <std::pair <unsigned long, Image> >      List;
+    typedef std::map <unsigned long, typename List::iterator> Index;
+
+    unsigned int mCapacity;
+    List         mImages;
+    Index        mIndex;
+};
+
+}
+}
+#endif
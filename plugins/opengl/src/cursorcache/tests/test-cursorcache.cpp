@@ -0,0 +1,115 @@
+/*
+ * Compiz opengl plugin, CursorCache class
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <string>
+#include "gtest/gtest.h"
+#include "cursorcache.h"
+
+using namespace compiz::opengl;
+
+TEST (OpenGLCursorCache, PackKeepsTheLowThirtyTwoBits)
+{
+    unsigned long src[3] = { 0x80402010UL, 0xff000000UL, 0x00ffffffUL };
+    unsigned int  dst[3] = { 0, 0, 0 };
+
+    if (sizeof (unsigned long) > 4)
+	src[0] |= ~0UL << 32;
+
+    packCursorPixels (src, dst, 3);
+
+    EXPECT_EQ (0x80402010U, dst[0]);
+    EXPECT_EQ (0xff000000U, dst[1]);
+    EXPECT_EQ (0x00ffffffU, dst[2]);
+}
+
+TEST (OpenGLCursorCache, MissReturnsNull)
+{
+    CursorCache <std::string> cache (4);
+
+    EXPECT_EQ (NULL, cache.find (1));
+}
+
+TEST (OpenGLCursorCache, FindsInsertedImages)
+{
+    CursorCache <std::string> cache (4);
+
+    cache.insert (1, "arrow");
+    cache.insert (2, "text");
+
+    ASSERT_TRUE (cache.find (1));
+    EXPECT_EQ ("arrow", *cache.find (1));
+    ASSERT_TRUE (cache.find (2));
+    EXPECT_EQ ("text", *cache.find (2));
+    EXPECT_EQ (2u, cache.size ());
+}
+
+TEST (OpenGLCursorCache, InsertingAnExistingSerialReplacesIt)
+{
+    CursorCache <std::string> cache (4);
+
+    cache.insert (1, "arrow");
+    cache.insert (1, "hand");
+
+    ASSERT_TRUE (cache.find (1));
+    EXPECT_EQ ("hand", *cache.find (1));
+    EXPECT_EQ (1u, cache.size ());
+}
+
+TEST (OpenGLCursorCache, EvictsLeastRecentlyInserted)
+{
+    CursorCache <std::string> cache (2);
+
+    cache.insert (1, "arrow");
+    cache.insert (2, "text");
+    cache.insert (3, "hand");
+
+    EXPECT_EQ (NULL, cache.find (1));
+    EXPECT_TRUE (cache.find (2));
+    EXPECT_TRUE (cache.find (3));
+    EXPECT_EQ (2u, cache.size ());
+}
+
+TEST (OpenGLCursorCache, FindMakesAnImageRecentlyUsed)
+{
+    CursorCache <std::string> cache (2);
+
+    cache.insert (1, "arrow");
+    cache.insert (2, "text");
+    cache.find (1);
+    cache.insert (3, "hand");
+
+    EXPECT_TRUE (cache.find (1));
+    EXPECT_EQ (NULL, cache.find (2));
+    EXPECT_TRUE (cache.find (3));
+}
+
+TEST (OpenGLCursorCache, ClearDropsEverything)
+{
+    CursorCache <std::string> cache (2);
+
+    cache.insert (1, "arrow");
+    cache.clear ();
+
+    EXPECT_EQ (NULL, cache.find (1));
+    EXPECT_EQ (0u, cache.size ());
+}
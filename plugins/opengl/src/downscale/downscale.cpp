@@ -0,0 +1,100 @@
+/*
+ * Compiz opengl plugin, DownscalePolicy class
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <cmath>
+#include <algorithm>
+#include "downscale.h"
+
+using namespace compiz::opengl;
+
+DownscalePolicy::DownscalePolicy (long long refreshInterval) :
+    mRefreshInterval (refreshInterval),
+    mValid (false),
+    mStale (true),
+    mLastRefresh (0)
+{
+}
+
+CompSize
+DownscalePolicy::size (const CompSize &windowSize,
+		       const CompSize &maxSize)
+{
+    if (windowSize.width () <= 0 || windowSize.height () <= 0 ||
+	maxSize.width () <= 0 || maxSize.height () <= 0)
+	return CompSize ();
+
+    float scale = std::min ((float) maxSize.width () / windowSize.width (),
+			    (float) maxSize.height () / windowSize.height ());
+
+    if (scale > 0.5f)
+	return CompSize ();
+
+    /* Round down to a quarter octave, so the copy never exceeds maxSize */
+    scale = powf (2.0f, floorf (log2f (scale) * 4.0f) / 4.0f);
+
+    return CompSize (std::max (1, (int) (windowSize.width () * scale)),
+		     std::max (1, (int) (windowSize.height () * scale)));
+}
+
+void
+DownscalePolicy::damage ()
+{
+    mStale = true;
+}
+
+void
+DownscalePolicy::invalidate ()
+{
+    mValid = false;
+    mStale = true;
+}
+
+bool
+DownscalePolicy::refresh (long long now)
+{
+    if (mValid && delay (now))
+	return false;
+
+    if (!mStale)
+	return false;
+
+    mValid = true;
+    mStale = false;
+    mLastRefresh = now;
+
+    return true;
+}
+
+long long
+DownscalePolicy::delay (long long now) const
+{
+    if (!mStale || !mValid)
+	return 0;
+
+    long long elapsed = now - mLastRefresh;
+
+    if (elapsed < 0 || elapsed >= mRefreshInterval)
+	return 0;
+
+    return mRefreshInterval - elapsed;
+}
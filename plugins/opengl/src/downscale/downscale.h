@@ -0,0 +1,77 @@
+/*
+ * Compiz opengl plugin, DownscalePolicy class
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef __COMPIZ_OPENGL_DOWNSCALE_H
+#define __COMPIZ_OPENGL_DOWNSCALE_H
+#include "core/size.h"
+
+namespace compiz {
+namespace opengl {
+
+/*
+ * Decides how large a downscaled copy of a window should be and when
+ * that copy may be redrawn. Sizes are quantized to quarter octaves so
+ * that a window being animated does not need a new copy every frame,
+ * and redraws after damage are rate limited. Times are in milliseconds.
+ */
+class DownscalePolicy
+{
+public:
+    static const long long DefaultRefreshInterval = 100;
+
+    DownscalePolicy (long long refreshInterval = DefaultRefreshInterval);
+
+    /*
+     * Size of the copy of a window of windowSize which is drawn no larger
+     * than maxSize. Empty if the window is drawn at more than half its
+     * size, as sampling the window directly is good enough then.
+     */
+    static CompSize size (const CompSize &windowSize,
+			  const CompSize &maxSize);
+
+    /* The window contents changed, the copy is stale */
+    void damage ();
+
+    /* The copy is undefined and must be redrawn before being used */
+    void invalidate ();
+
+    /*
+     * Whether the copy should be redrawn at time now. Returns true at
+     * most once per damage and once per refresh interval, unless the
+     * copy has been invalidated.
+     */
+    bool refresh (long long now);
+
+    /* Time from now until a stale copy may be redrawn, 0 if not stale */
+    long long delay (long long now) const;
+
+private:
+    long long mRefreshInterval;
+    bool      mValid;
+    bool      mStale;
+    long long mLastRefresh;
+};
+
+}
+}
+#endif
@@ -0,0 +1,127 @@
+/*
+ * Compiz opengl plugin, DownscalePolicy class
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "gtest/gtest.h"
+#include "downscale.h"
+
+using namespace compiz::opengl;
+
+TEST (OpenGLDownscalePolicy, NoCopyWhenNearlyFullSize)
+{
+    EXPECT_EQ (CompSize (), DownscalePolicy::size (CompSize (800, 600),
+						   CompSize (800, 600)));
+    EXPECT_EQ (CompSize (), DownscalePolicy::size (CompSize (800, 600),
+						   CompSize (401, 301)));
+}
+
+TEST (OpenGLDownscalePolicy, NoCopyForEmptySizes)
+{
+    EXPECT_EQ (CompSize (), DownscalePolicy::size (CompSize (0, 600),
+						   CompSize (100, 100)));
+    EXPECT_EQ (CompSize (), DownscalePolicy::size (CompSize (800, 600),
+						   CompSize (0, 0)));
+}
+
+TEST (OpenGLDownscalePolicy, HalfSize)
+{
+    EXPECT_EQ (CompSize (400, 300), DownscalePolicy::size (CompSize (800, 600),
+							   CompSize (400, 300)));
+}
+
+TEST (OpenGLDownscalePolicy, NeverLargerThanRequested)
+{
+    CompSize window (3840, 2160);
+
+    for (int w = 16; w < 1920; w += 7)
+    {
+	CompSize max (w, w);
+	CompSize copy (DownscalePolicy::size (window, max));
+
+	EXPECT_LE (copy.width (), max.width ());
+	EXPECT_LE (copy.height (), max.height ());
+    }
+}
+
+TEST (OpenGLDownscalePolicy, KeepsAspectRatio)
+{
+    CompSize copy (DownscalePolicy::size (CompSize (3840, 2160),
+					  CompSize (300, 300)));
+
+    EXPECT_NEAR (3840.0f / 2160.0f,
+		 (float) copy.width () / copy.height (), 0.02f);
+}
+
+TEST (OpenGLDownscalePolicy, QuantizedToQuarterOctaves)
+{
+    CompSize window (1000, 1000);
+    CompSize a (DownscalePolicy::size (window, CompSize (300, 300)));
+    CompSize b (DownscalePolicy::size (window, CompSize (310, 310)));
+    CompSize c (DownscalePolicy::size (window, CompSize (200, 200)));
+
+    EXPECT_EQ (a, b);
+    EXPECT_NE (a, c);
+    EXPECT_GE (a.width (), 250);
+}
+
+TEST (OpenGLDownscalePolicy, InitialRefresh)
+{
+    DownscalePolicy policy (100);
+
+    EXPECT_TRUE (policy.refresh (0));
+    EXPECT_FALSE (policy.refresh (1000));
+}
+
+TEST (OpenGLDownscalePolicy, DamageIsRateLimited)
+{
+    DownscalePolicy policy (100);
+
+    EXPECT_TRUE (policy.refresh (1000));
+
+    policy.damage ();
+    EXPECT_EQ (60, policy.delay (1040));
+    EXPECT_FALSE (policy.refresh (1040));
+    EXPECT_TRUE (policy.refresh (1100));
+    EXPECT_EQ (0, policy.delay (1100));
+}
+
+TEST (OpenGLDownscalePolicy, DamageAfterIntervalRefreshesAtOnce)
+{
+    DownscalePolicy policy (100);
+
+    EXPECT_TRUE (policy.refresh (1000));
+
+    policy.damage ();
+    EXPECT_EQ (0, policy.delay (1500));
+    EXPECT_TRUE (policy.refresh (1500));
+}
+
+TEST (OpenGLDownscalePolicy, InvalidateIsNotRateLimited)
+{
+    DownscalePolicy policy (100);
+
+    EXPECT_TRUE (policy.refresh (1000));
+
+    policy.invalidate ();
+    EXPECT_EQ (0, policy.delay (1010));
+    EXPECT_TRUE (policy.refresh (1010));
+}
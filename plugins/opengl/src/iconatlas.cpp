@@ -0,0 +1,234 @@
+/*
+ * Compiz opengl plugin, icon atlas
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <vector>
+#include <algorithm>
+
+#include "privates.h"
+
+namespace cgl = compiz::opengl;
+
+/* Each cell holds an icon with a one pixel border around it, repeating
+ * the icon edges so filtering does not pick up neighbouring icons */
+static const int CellPadding = 1;
+
+GLIconTexture::GLIconTexture (GLIconAtlas                    *atlas,
+			      const Key                      &key,
+			      GLTexture                      *storage,
+			      const GLTexture::Matrix        &matrix,
+			      const cgl::AtlasAllocator::Slot *slot) :
+    atlas (atlas),
+    key (key),
+    storage (storage),
+    packed (slot != NULL)
+{
+    GLTexture::Matrix m (matrix);
+
+    if (slot)
+	this->slot = *slot;
+
+    GLTexture::incRef (storage);
+    PrivateTexture::borrow (this, storage);
+
+    setData (storage->target (), m, false);
+    setGeometry (0, 0, std::tr1::get <1> (key), std::tr1::get <2> (key));
+}
+
+GLIconTexture::~GLIconTexture ()
+{
+    if (atlas)
+	atlas->remove (this);
+
+    PrivateTexture::release (this);
+    GLTexture::decRef (storage);
+}
+
+void
+GLIconTexture::enable (GLTexture::Filter filter)
+{
+    storage->enable (filter);
+}
+
+void
+GLIconTexture::disable ()
+{
+    storage->disable ();
+}
+
+GLIconAtlas::GLIconAtlas () :
+    allocator (CompSize (PageSize, PageSize),
+	       CompSize (MaxPackedSize + 2 * CellPadding,
+			 MaxPackedSize + 2 * CellPadding)),
+    pages (),
+    textures ()
+{
+}
+
+GLIconAtlas::~GLIconAtlas ()
+{
+    /* Icons still held elsewhere keep their storage alive */
+    for (std::map <GLIconTexture::Key, GLIconTexture *>::iterator it =
+	 textures.begin (); it != textures.end (); ++it)
+	it->second->atlas = NULL;
+}
+
+GLTexture::List
+GLIconAtlas::get (CompIcon &icon)
+{
+    GLTexture::List         rv (1);
+    CompSize                size (icon.width (), icon.height ());
+    GLIconTexture::Key      key (cgl::hashImage (icon.data (),
+						 size.width () *
+						 size.height () * 4),
+				 size.width (), size.height ());
+
+    std::map <GLIconTexture::Key, GLIconTexture *>::iterator it =
+	textures.find (key);
+
+    if (it != textures.end ())
+    {
+	rv[0] = it->second;
+	GLTexture::incRef (rv[0]);
+
+	return rv;
+    }
+
+    GLIconTexture *texture = pack (key, icon);
+
+    if (!texture)
+    {
+	GLTexture::List storage =
+	    GLTexture::imageBufferToTexture ((char *) icon.data (), size);
+
+	if (storage.size () != 1)
+	    return GLTexture::List ();
+
+	texture = new GLIconTexture (this, key, storage[0],
+				     storage[0]->matrix (), NULL);
+    }
+
+    textures[key] = texture;
+    rv[0] = texture;
+
+    return rv;
+}
+
+GLIconTexture *
+GLIconAtlas::pack (const GLIconTexture::Key &key,
+		   CompIcon                 &icon)
+{
+    int width  = icon.width ();
+    int height = icon.height ();
+
+    if (width > MaxPackedSize || height > MaxPackedSize ||
+	GL::maxTextureSize < PageSize)
+	return NULL;
+
+#ifndef USE_GLES
+    /* Compressed pages can not be updated one cell at a time */
+    CompOption *opt = GLScreen::get (screen)->getOption ("texture_compression");
+
+    if (opt->value ().b () && GL::textureCompression)
+	return NULL;
+#endif
+
+    cgl::AtlasAllocator::Slot slot = allocator.allocate ();
+    GLTexture                 *storage = page (slot.page);
+
+    if (!storage)
+    {
+	allocator.release (slot);
+	return NULL;
+    }
+
+    int                       stride = width + 2 * CellPadding;
+    const unsigned int        *src = (const unsigned int *) icon.data ();
+    std::vector<unsigned int> padded (stride * (height + 2 * CellPadding));
+
+    for (int y = 0; y < height + 2 * CellPadding; y++)
+    {
+	int sy = std::max (0, std::min (height - 1, y - CellPadding));
+
+	for (int x = 0; x < stride; x++)
+	{
+	    int sx = std::max (0, std::min (width - 1, x - CellPadding));
+
+	    padded[y * stride + x] = src[sy * width + sx];
+	}
+    }
+
+    glBindTexture (storage->target (), storage->name ());
+
+#if IMAGE_BYTE_ORDER == MSBFirst
+    glTexSubImage2D (storage->target (), 0, slot.x, slot.y,
+		     stride, height + 2 * CellPadding,
+		     GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, &padded[0]);
+#else
+    glTexSubImage2D (storage->target (), 0, slot.x, slot.y,
+		     stride, height + 2 * CellPadding,
+		     GL_BGRA, GL_UNSIGNED_BYTE, &padded[0]);
+#endif
+
+    glBindTexture (storage->target (), 0);
+
+    GLTexture::Matrix matrix = storage->matrix ();
+
+    matrix.x0 += (slot.x + CellPadding) * matrix.xx;
+    matrix.y0 += (slot.y + CellPadding) * matrix.yy;
+
+    return new GLIconTexture (this, key, storage, matrix, &slot);
+}
+
+GLTexture *
+GLIconAtlas::page (unsigned int index)
+{
+    if (index < pages.size ())
+	return pages[index];
+
+    /* Pages are only ever added at the end */
+    if (index > pages.size ())
+	return NULL;
+
+    GLTexture::List page =
+	GLTexture::imageBufferToTexture (NULL, CompSize (PageSize, PageSize));
+
+    if (page.size () != 1)
+	return NULL;
+
+    /* Mipmaps would blend neighbouring icons together */
+    page[0]->setMipmap (false);
+
+    pages.push_back (page[0]);
+    GLTexture::incRef (page[0]);
+
+    return page[0];
+}
+
+void
+GLIconAtlas::remove (GLIconTexture *texture)
+{
+    textures.erase (texture->key);
+
+    if (texture->packed)
+	allocator.release (texture->slot);
+}
@@ -37,6 +37,7 @@
 #define foreach BOOST_FOREACH
 
 #include <opengl/opengl.h>
+#include <core/trace.h>
 
 #include "privates.h"
 #include "fsregion/fsregion.h"
@@ -622,8 +623,8 @@ GLScreen::glPaintOutput (const GLScreenPaintAttrib &sAttrib,
 			 CompOutput                *output,
 			 unsigned int              mask)
 {
-    WRAPABLE_HND_FUNCTN_RETURN (bool, glPaintOutput, sAttrib, transform,
-			      region, output, mask)
+    WRAPABLE_HND_FUNCTN_RETURN_TRACED (bool, glPaintOutput, sAttrib, transform,
+				       region, output, mask)
 
     GLMatrix sTransform = transform;
 
@@ -1311,12 +1312,16 @@ GLWindow::glDraw (const GLMatrix     &transform,
 		  const CompRegion   &region,
 		  unsigned int       mask)
 {
-    WRAPABLE_HND_FUNCTN_RETURN (bool, glDraw, transform,
-			      attrib, region, mask)
+    WRAPABLE_HND_FUNCTN_RETURN_TRACED (bool, glDraw, transform,
+				       attrib, region, mask)
 
     const CompRegion &reg = (mask & PAINT_WINDOW_TRANSFORMED_MASK) ?
                             infiniteRegion : region;
 
+    /* The hint only applies to this draw */
+    CompSize downscaleHint (priv->downscaleHint);
+    priv->downscaleHint = CompSize ();
+
     if (reg.isEmpty ())
 	return true;
 
@@ -1346,6 +1351,22 @@ GLWindow::glDraw (const GLMatrix     &transform,
     if (priv->updateState & PrivateGLWindow::UpdateRegion)
 	priv->updateWindowRegions ();
 
+    if ((mask & PAINT_WINDOW_TRANSFORMED_MASK) &&
+	downscaleHint.width () && downscaleHint.height ())
+    {
+	GLTexture *texture = downscaledTexture (downscaleHint, ml[0]);
+
+	if (texture)
+	{
+	    priv->vertexBuffer->begin ();
+	    glAddGeometry (ml, priv->window->region (), reg);
+	    if (priv->vertexBuffer->end ())
+		glDrawTexture (texture, transform, attrib, mask);
+
+	    return true;
+	}
+    }
+
     for (unsigned int i = 0; i < priv->textures.size (); i++)
     {
 	ml[0] = priv->matrices[i];
@@ -1364,7 +1385,7 @@ GLWindow::glPaint (const GLWindowPaintAttrib &attrib,
 		   const CompRegion          &region,
 		   unsigned int              mask)
 {
-    WRAPABLE_HND_FUNCTN_RETURN (bool, glPaint, attrib, transform, region, mask)
+    WRAPABLE_HND_FUNCTN_RETURN_TRACED (bool, glPaint, attrib, transform, region, mask)
 
     bool               status;
 
@@ -30,6 +30,7 @@
 
 #include <memory>
 #include <vector>
+#include <map>
 #include <tr1/tuple>
 #include <boost/shared_ptr.hpp>
 
@@ -37,6 +38,7 @@
 #include <opengl/opengl.h>
 #include <core/atoms.h>
 #include <core/configurerequestbuffer.h>
+#include <core/threadpool.h>
 
 #include <opengl/framebufferobject.h>
 #include <opengl/doublebuffer.h>
@@ -44,9 +46,16 @@
 #include "privatetexture.h"
 #include "privatevertexbuffer.h"
 #include "opengl_options.h"
+#include "downscale/downscale.h"
+#include "atlas/atlas.h"
+#include "cursorcache/cursorcache.h"
+#include "programbinary/programbinary.h"
 
 extern CompOutput *targetOutput;
 
+/* Set while the screen has somewhere to keep program binaries */
+extern compiz::opengl::ProgramBinaryStore *programBinaryStore;
+
 class GLDoubleBuffer :
     public compiz::opengl::DoubleBuffer
 {
@@ -111,6 +120,133 @@ class EGLDoubleBuffer :
 
 #endif
 
+class GLIconAtlas;
+
+/*
+ * An icon stored in a cell of an icon atlas page, or in a texture of
+ * its own if it does not fit. Drawing it binds that storage texture.
+ */
+class GLIconTexture :
+    public GLTexture
+{
+    public:
+
+	typedef std::tr1::tuple <unsigned long long, int, int> Key;
+
+	GLIconTexture (GLIconAtlas                          *atlas,
+		       const Key                            &key,
+		       GLTexture                            *storage,
+		       const GLTexture::Matrix              &matrix,
+		       const compiz::opengl::AtlasAllocator::Slot *slot);
+	~GLIconTexture ();
+
+	void enable (Filter filter);
+	void disable ();
+
+	GLIconAtlas                          *atlas;
+	Key                                  key;
+	GLTexture                            *storage;
+	bool                                 packed;
+	compiz::opengl::AtlasAllocator::Slot slot;
+};
+
+/*
+ * Screen wide icon textures, shared between all windows whose icons
+ * have the same contents. Small icons are packed into atlas pages so
+ * that they can be drawn from one texture. Icon textures are released
+ * as usual, when the last GLTexture::List holding them goes away.
+ */
+class GLIconAtlas
+{
+    public:
+
+	static const int PageSize = 1024;
+	static const int MaxPackedSize = 64;
+
+	GLIconAtlas ();
+	~GLIconAtlas ();
+
+	GLTexture::List get (CompIcon &icon);
+
+    private:
+
+	friend class GLIconTexture;
+
+	GLIconTexture * pack (const GLIconTexture::Key &key,
+			      CompIcon                 &icon);
+	GLTexture * page (unsigned int index);
+	void remove (GLIconTexture *texture);
+
+	compiz::opengl::AtlasAllocator                 allocator;
+	GLTexture::List                                pages;
+	std::map <GLIconTexture::Key, GLIconTexture *> textures;
+};
+
+/*
+ * Textures read from image files, shared by everything reading the same
+ * file. A few images that are not held any more are kept too, so that
+ * reloading them after an option change does not decode them again.
+ */
+class GLImageCache
+{
+    public:
+
+	static const unsigned int MaxIdle = 4;
+
+	GLTexture::List read (CompString &name,
+			      CompString &pluginName,
+			      CompSize   &size);
+
+    private:
+
+	struct Entry
+	{
+	    CompString      name;
+	    CompString      pluginName;
+	    time_t          mtime;
+	    off_t           fileSize;
+	    CompSize        size;
+	    GLTexture::List textures;
+	};
+
+	void trim ();
+
+	/* most recently used first */
+	std::list <Entry> entries;
+};
+
+/*
+ * Follows the cursor image for plugins which draw the cursor
+ * themselves. Images are uploaded once per cursor shape and kept by
+ * XFixes cursor serial, so going back to a recently used cursor needs
+ * neither a round trip nor an upload.
+ */
+class GLCursorTracker
+{
+    public:
+
+	static const unsigned int CacheSize = 16;
+
+	GLCursorTracker ();
+	~GLCursorTracker ();
+
+	void track (bool track);
+	void handleEvent (XEvent *event);
+
+	const GLCursorImage & current () const;
+
+    private:
+
+	void fetch ();
+
+	bool         fixesSupported;
+	int          fixesEvent;
+	unsigned int trackCount;
+
+	GLCursorImage                               currentImage;
+	compiz::opengl::CursorCache <GLCursorImage> images;
+};
+
 class GLIcon
 {
     public:
@@ -188,6 +324,8 @@ class PrivateGLScreen :
 
 	bool postprocessRequiredForCurrentFrame ();
 
+	void initProgramBinaries ();
+
     public:
 
 	GLScreen        *gScreen;
@@ -235,7 +373,10 @@ class PrivateGLScreen :
 	bool incorrectRefreshRate; // hack for NVIDIA specifying an incorrect
 				   // refresh rate, causing us to miss vblanks
 
-	GLIcon defaultIcon;
+	GLIconAtlas     iconAtlas;
+	GLImageCache    imageCache;
+	GLIcon          defaultIcon;
+	GLCursorTracker cursorTracker;
 
 	Window saveWindow; // hack for broken applications, see:
 			   // https://bugs.launchpad.net/ubuntu/+source/compiz/+bug/807487
@@ -244,6 +385,9 @@ class PrivateGLScreen :
 	GLShaderCache   shaderCache;
 	GLVertexBuffer::AutoProgram *autoProgram;
 
+	compiz::opengl::ProgramBinaryStore *binaryStore;
+	compiz::core::TaskHandle           binaryPreload;
+
 	Pixmap rootPixmapCopy;
 	CompSize rootPixmapSize;
 
@@ -273,11 +417,16 @@ class PrivateGLWindow :
 	void moveNotify (int dx, int dy, bool now);
 	void updateFrameRegion (CompRegion &region);
 
+	bool damageRect (bool initial, const CompRect &rect);
+
 	void setWindowMatrix ();
 	void updateWindowRegions ();
 
 	void clearTextures ();
 
+	bool drawDownscaled (const CompSize &size);
+	bool downscaleTimeout ();
+
 	CompWindow      *window;
 	GLWindow        *gWindow;
 	CompositeWindow *cWindow;
@@ -313,6 +462,11 @@ class PrivateGLWindow :
 	std::list<GLIcon> icons;
 
 	compiz::window::configure_buffers::Releasable::Ptr configureLock;
+
+	boost::shared_ptr <GLFramebufferObject> downscaleFbo;
+	compiz::opengl::DownscalePolicy         downscalePolicy;
+	CompTimer                               downscaleTimer;
+	CompSize                                downscaleHint;
 };
 
 #endif
@@ -58,6 +58,14 @@ class PrivateTexture {
 					      GLenum       format,
 					      GLenum       type);
 
+	static int references (const GLTexture *texture);
+
+	/* Makes texture draw from the GL texture of from, which must
+	 * outlive it. Call release () before texture is deleted, so that
+	 * the shared GL texture isn't deleted with it */
+	static void borrow (GLTexture *texture, const GLTexture *from);
+	static void release (GLTexture *texture);
+
     public:
 	GLTexture         *texture;
 	GLuint            name;
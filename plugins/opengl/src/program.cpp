@@ -27,6 +27,8 @@
 #include <fstream>
 #include <opengl/opengl.h>
 
+#include "privates.h"
+
 class PrivateProgram
 {
     public:
@@ -84,13 +86,68 @@ static bool compileShader (GLuint *shader, GLenum type, CompString &source)
     return (status == GL_TRUE);
 }
 
+static bool loadBinary (GLuint program, const std::string &key)
+{
+    compiz::opengl::ProgramBinary binary;
+    GLint                         status;
+
+    if (!programBinaryStore->find (key, binary))
+	return false;
+
+    (*GL::programBinary) (program, binary.format,
+			  &binary.data[0], binary.data.size ());
+
+    /* The driver may still refuse a binary, eg. after an update
+     * which didn't change its version string */
+    (*GL::getProgramiv) (program, GL::LINK_STATUS, &status);
+    return (status == GL_TRUE);
+}
+
+static void storeBinary (GLuint program, const std::string &key)
+{
+    compiz::opengl::ProgramBinary binary;
+    GLint                         length = 0;
+    GLsizei                       written = 0;
+    GLenum                        format = 0;
+
+    (*GL::getProgramiv) (program, GL::PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+	return;
+
+    binary.data.resize (length);
+    (*GL::getProgramBinary) (program, length, &written, &format,
+			     &binary.data[0]);
+    if (written <= 0)
+	return;
+
+    binary.data.resize (written);
+    binary.format = format;
+    programBinaryStore->store (key, binary);
+}
+
 GLProgram::GLProgram (CompString &vertexShader, CompString &fragmentShader) :
     priv (new PrivateProgram ())
 {
     GLuint vertex, fragment;
     GLint status;
+    std::string key;
 
     priv->valid = false;
+
+    if (programBinaryStore)
+    {
+	key = programBinaryStore->key (vertexShader, fragmentShader);
+
+	priv->program = (*GL::createProgram) ();
+	if (loadBinary (priv->program, key))
+	{
+	    priv->valid = true;
+	    return;
+	}
+
+	(*GL::deleteProgram) (priv->program);
+    }
+
     priv->program = (*GL::createProgram) ();
 
     if (!compileShader (&vertex, GL::VERTEX_SHADER, vertexShader))
@@ -110,6 +167,11 @@ GLProgram::GLProgram (CompString &vertexShader, CompString &fragmentShader) :
     (*GL::attachShader) (priv->program, vertex);
     (*GL::attachShader) (priv->program, fragment);
 
+    if (programBinaryStore && GL::programParameteri)
+	(*GL::programParameteri) (priv->program,
+				  GL::PROGRAM_BINARY_RETRIEVABLE_HINT,
+				  GL_TRUE);
+
     (*GL::linkProgram) (priv->program);
     (*GL::validateProgram) (priv->program);
 
@@ -123,6 +185,9 @@ GLProgram::GLProgram (CompString &vertexShader, CompString &fragmentShader) :
     (*GL::deleteShader) (vertex);
     (*GL::deleteShader) (fragment);
 
+    if (programBinaryStore)
+	storeBinary (priv->program, key);
+
     priv->valid = true;
 }
 
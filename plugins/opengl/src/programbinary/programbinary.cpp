@@ -0,0 +1,346 @@
+/*
+ * Compiz opengl plugin, ProgramBinaryStore class
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "programbinary.h"
+
+namespace cgl = compiz::opengl;
+
+namespace
+{
+    const char   Magic[4] = { 'C', 'P', 'B', '1' };
+    const size_t KeyLength = 32;
+
+    struct Header
+    {
+	char     magic[4];
+	uint32_t format;
+	uint64_t driver;
+	uint64_t length;
+	uint64_t checksum;
+    };
+
+    /* Two unrelated 64 bit hashes, together they name a file */
+    uint64_t
+    fnv1a (const std::string &s,
+	   uint64_t          h = 14695981039346656037ULL)
+    {
+	for (size_t i = 0; i < s.size (); ++i)
+	{
+	    h ^= (unsigned char) s[i];
+	    h *= 1099511628211ULL;
+	}
+
+	/* Separates consecutive strings */
+	h ^= 0xff;
+	h *= 1099511628211ULL;
+
+	return h;
+    }
+
+    uint64_t
+    mix (const char *data,
+	 size_t     length,
+	 uint64_t   h = 0x9e3779b97f4a7c15ULL)
+    {
+	for (size_t i = 0; i < length; ++i)
+	{
+	    h = (h ^ (unsigned char) data[i]) * 0xff51afd7ed558ccdULL;
+	    h ^= h >> 32;
+	}
+
+	h = (h ^ (length + 1)) * 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 29;
+
+	return h;
+    }
+
+    uint64_t
+    mix (const std::string &s,
+	 uint64_t          h)
+    {
+	return mix (s.data (), s.size (), h);
+    }
+
+    std::string
+    hex (uint64_t value)
+    {
+	char buffer[17];
+
+	snprintf (buffer, sizeof (buffer), "%016llx",
+		  (unsigned long long) value);
+
+	return buffer;
+    }
+
+    bool
+    isKey (const char *name)
+    {
+	if (strlen (name) != KeyLength)
+	    return false;
+
+	return strspn (name, "0123456789abcdef") == KeyLength;
+    }
+
+    enum ReadResult
+    {
+	ReadOk,
+	ReadMissing,
+	ReadStale,
+	ReadCorrupt
+    };
+
+    ReadResult
+    readBinary (const std::string  &path,
+		uint64_t           driver,
+		cgl::ProgramBinary &binary)
+    {
+	FILE *file = fopen (path.c_str (), "rb");
+
+	if (!file)
+	    return ReadMissing;
+
+	Header     header;
+	ReadResult result = ReadCorrupt;
+
+	if (fread (&header, sizeof (header), 1, file) == 1 &&
+	    !memcmp (header.magic, Magic, sizeof (Magic)))
+	{
+	    if (header.driver != driver)
+		result = ReadStale;
+	    else if (header.length > 0 && header.length < (64 << 20))
+	    {
+		binary.format = header.format;
+		binary.data.resize (header.length);
+
+		if (fread (&binary.data[0], 1, header.length, file) ==
+		    header.length &&
+		    mix (&binary.data[0], header.length) == header.checksum)
+		    result = ReadOk;
+	    }
+	}
+
+	fclose (file);
+
+	if (result != ReadOk)
+	    binary.data.clear ();
+
+	return result;
+    }
+
+    bool
+    makeDirectories (const std::string &path)
+    {
+	for (size_t pos = 1; pos != std::string::npos; )
+	{
+	    pos = path.find ('/', pos + 1);
+
+	    std::string parent = path.substr (0, pos);
+
+	    if (mkdir (parent.c_str (), 0700) && errno != EEXIST)
+		return false;
+	}
+
+	return true;
+    }
+}
+
+cgl::ProgramBinaryStore::ProgramBinaryStore (const std::string &directory,
+					     const std::string &driver) :
+    mDirectory (directory),
+    mDriver (driver),
+    mDriverDirectory (driverDirectory (directory, driver))
+{
+}
+
+std::string
+cgl::ProgramBinaryStore::defaultDirectory ()
+{
+    const char  *cacheHome = getenv ("XDG_CACHE_HOME");
+    std::string directory;
+
+    if (cacheHome && strlen (cacheHome))
+	directory = cacheHome;
+    else
+    {
+	const char *home = getenv ("HOME");
+
+	if (!home || !strlen (home))
+	    return "";
+
+	directory = std::string (home) + "/.cache";
+    }
+
+    return directory + "/compiz-1/glprograms";
+}
+
+std::string
+cgl::ProgramBinaryStore::driverDirectory (const std::string &directory,
+					  const std::string &driver)
+{
+    if (directory.empty ())
+	return "";
+
+    return directory + "/" + hex (fnv1a (driver));
+}
+
+std::string
+cgl::ProgramBinaryStore::key (const std::string &vertex,
+			      const std::string &fragment) const
+{
+    uint64_t first = fnv1a (mDriver, fnv1a (fragment, fnv1a (vertex)));
+    uint64_t second = mix (mDriver, mix (fragment, mix (vertex, 0)));
+
+    return hex (first) + hex (second);
+}
+
+bool
+cgl::ProgramBinaryStore::find (const std::string &key,
+			       ProgramBinary     &binary)
+{
+    ProgramBinaryMap::iterator it = mLoaded.find (key);
+
+    mHandled.insert (key);
+
+    /* Once found the program stays linked, so the copy
+     * in memory won't be needed again soon */
+    if (it != mLoaded.end ())
+    {
+	binary.format = it->second.format;
+	binary.data.swap (it->second.data);
+	mLoaded.erase (it);
+	return true;
+    }
+
+    if (mDriverDirectory.empty ())
+	return false;
+
+    std::string path = mDriverDirectory + "/" + key;
+    ReadResult  result = readBinary (path, fnv1a (mDriver), binary);
+
+    if (result == ReadStale || result == ReadCorrupt)
+	unlink (path.c_str ());
+
+    return result == ReadOk;
+}
+
+bool
+cgl::ProgramBinaryStore::store (const std::string   &key,
+				const ProgramBinary &binary)
+{
+    mHandled.insert (key);
+
+    if (mDriverDirectory.empty () || binary.data.empty () ||
+	!makeDirectories (mDriverDirectory))
+	return false;
+
+    Header header;
+
+    memcpy (header.magic, Magic, sizeof (Magic));
+    header.format = binary.format;
+    header.driver = fnv1a (mDriver);
+    header.length = binary.data.size ();
+    header.checksum = mix (&binary.data[0], binary.data.size ());
+
+    char pid[32];
+
+    snprintf (pid, sizeof (pid), ".%d", getpid ());
+
+    std::string path = mDriverDirectory + "/" + key;
+    std::string temporary = path + ".tmp" + pid;
+    FILE        *file = fopen (temporary.c_str (), "wb");
+
+    if (!file)
+	return false;
+
+    bool written =
+	fwrite (&header, sizeof (header), 1, file) == 1 &&
+	fwrite (&binary.data[0], 1, binary.data.size (), file) ==
+	    binary.data.size ();
+
+    if (fclose (file) || !written ||
+	rename (temporary.c_str (), path.c_str ()))
+    {
+	unlink (temporary.c_str ());
+	return false;
+    }
+
+    return true;
+}
+
+boost::shared_ptr<cgl::ProgramBinaryMap>
+cgl::ProgramBinaryStore::readAll (const std::string &directory,
+				  const std::string &driver)
+{
+    boost::shared_ptr<ProgramBinaryMap> binaries (new ProgramBinaryMap);
+    std::string                         path = driverDirectory (directory,
+								    driver);
+
+    if (path.empty ())
+	return binaries;
+
+    DIR *dir = opendir (path.c_str ());
+
+    if (!dir)
+	return binaries;
+
+    uint64_t      driverHash = fnv1a (driver);
+    struct dirent *entry;
+
+    while ((entry = readdir (dir)))
+    {
+	if (!isKey (entry->d_name))
+	    continue;
+
+	std::string   file = path + "/" + entry->d_name;
+	ProgramBinary binary;
+	ReadResult    result = readBinary (file, driverHash, binary);
+
+	if (result == ReadOk)
+	    (*binaries)[entry->d_name] = binary;
+	else if (result == ReadStale || result == ReadCorrupt)
+	    unlink (file.c_str ());
+    }
+
+    closedir (dir);
+
+    return binaries;
+}
+
+void
+cgl::ProgramBinaryStore::adopt (const ProgramBinaryMap &binaries)
+{
+    for (ProgramBinaryMap::const_iterator it = binaries.begin ();
+	 it != binaries.end (); ++it)
+	if (!mHandled.count (it->first))
+	    mLoaded.insert (*it);
+}
@@ -0,0 +1,107 @@
+/*
+ * Compiz opengl plugin, ProgramBinaryStore class
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef __COMPIZ_OPENGL_PROGRAMBINARY_H
+#define __COMPIZ_OPENGL_PROGRAMBINARY_H
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace compiz {
+namespace opengl {
+
+struct ProgramBinary
+{
+    unsigned int      format;
+    std::vector<char> data;
+};
+
+typedef std::map<std::string, ProgramBinary> ProgramBinaryMap;
+
+/*
+ * Linked program binaries kept on disk, one file per program named by
+ * a hash of its shader sources and of the driver which linked it. Each
+ * driver gets a subdirectory of its own, so sessions on different GPUs
+ * can share a cache directory without throwing out each other's
+ * binaries. A driver update changes the hash, so stale binaries are
+ * never used.
+ *
+ * Only readAll () may be called off the main thread.
+ */
+class ProgramBinaryStore :
+    boost::noncopyable
+{
+    public:
+
+	/* driver identifies the GL implementation, eg. vendor,
+	 * renderer and version strings joined together */
+	ProgramBinaryStore (const std::string &directory,
+			    const std::string &driver);
+
+	/* $XDG_CACHE_HOME/compiz-1/glprograms, or an empty string
+	 * if there is no home directory to put it in */
+	static std::string defaultDirectory ();
+
+	std::string key (const std::string &vertex,
+			 const std::string &fragment) const;
+
+	bool find (const std::string &key, ProgramBinary &binary);
+
+	/* Writes to a temporary file which is then renamed, so
+	 * readers never see a partially written binary */
+	bool store (const std::string &key, const ProgramBinary &binary);
+
+	/* Where the binaries linked by driver are kept */
+	static std::string driverDirectory (const std::string &directory,
+					    const std::string &driver);
+
+	/* Reads every binary which was linked by driver, deleting the
+	 * corrupt ones. Touches no state of the store */
+	static boost::shared_ptr<ProgramBinaryMap>
+	readAll (const std::string &directory,
+		 const std::string &driver);
+
+	/* Takes binaries read by readAll () so that find () doesn't
+	 * need to go to the disk for them. Skips the ones which find ()
+	 * or store () have seen already, those programs are linked */
+	void adopt (const ProgramBinaryMap &binaries);
+
+	const std::string & directory () const { return mDirectory; }
+	const std::string & driver () const { return mDriver; }
+
+    private:
+
+	std::string           mDirectory;
+	std::string           mDriver;
+	std::string           mDriverDirectory;
+	ProgramBinaryMap      mLoaded;
+	std::set<std::string> mHandled;
+};
+
+}
+}
+#endif
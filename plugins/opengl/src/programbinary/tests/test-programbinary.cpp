@@ -0,0 +1,303 @@
+/*
+ * Compiz opengl plugin, ProgramBinaryStore tests
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "programbinary.h"
+
+using compiz::opengl::ProgramBinary;
+using compiz::opengl::ProgramBinaryMap;
+using compiz::opengl::ProgramBinaryStore;
+
+namespace
+{
+    ProgramBinary
+    makeBinary (unsigned int format, const std::string &data)
+    {
+	ProgramBinary binary;
+
+	binary.format = format;
+	binary.data.assign (data.begin (), data.end ());
+
+	return binary;
+    }
+
+    std::string
+    contents (const ProgramBinary &binary)
+    {
+	return std::string (binary.data.begin (), binary.data.end ());
+    }
+
+    unsigned int
+    countFiles (const std::string &directory)
+    {
+	DIR           *dir = opendir (directory.c_str ());
+	struct dirent *entry;
+	unsigned int  count = 0;
+
+	if (!dir)
+	    return 0;
+
+	while ((entry = readdir (dir)))
+	    if (entry->d_name[0] != '.')
+		++count;
+
+	closedir (dir);
+
+	return count;
+    }
+}
+
+class ProgramBinaryStoreTest :
+    public ::testing::Test
+{
+    public:
+
+	virtual void SetUp ()
+	{
+	    char pattern[] = "/tmp/compiz-programbinary-XXXXXX";
+
+	    ASSERT_TRUE (mkdtemp (pattern));
+	    root = pattern;
+	    directory = root + "/cache/glprograms";
+	}
+
+	virtual void TearDown ()
+	{
+	    std::string command = "rm -rf '" + root + "'";
+
+	    ASSERT_EQ (0, system (command.c_str ()));
+	}
+
+	std::string root;
+	std::string directory;
+};
+
+TEST_F (ProgramBinaryStoreTest, KeyDependsOnSourcesAndDriver)
+{
+    ProgramBinaryStore store (directory, "Mesa llvmpipe 3.3");
+    ProgramBinaryStore other (directory, "Mesa softpipe 3.3");
+
+    std::string key = store.key ("vertex", "fragment");
+
+    EXPECT_EQ (32, key.size ());
+    EXPECT_EQ (key, store.key ("vertex", "fragment"));
+    EXPECT_NE (key, store.key ("vertex", "fragment2"));
+    EXPECT_NE (key, store.key ("vertexf", "ragment"));
+    EXPECT_NE (key, other.key ("vertex", "fragment"));
+}
+
+TEST_F (ProgramBinaryStoreTest, FindsNothingWhenEmpty)
+{
+    ProgramBinaryStore store (directory, "driver");
+    ProgramBinary      binary;
+
+    EXPECT_FALSE (store.find (store.key ("v", "f"), binary));
+}
+
+TEST_F (ProgramBinaryStoreTest, StoreCreatesDirectoryAndRoundTrips)
+{
+    ProgramBinaryStore store (directory, "driver");
+    std::string        key = store.key ("v", "f");
+    ProgramBinary      binary;
+
+    ASSERT_TRUE (store.store (key, makeBinary (0x8741, "linked program")));
+    EXPECT_EQ (1, countFiles (ProgramBinaryStore::driverDirectory (directory,
+								   "driver")));
+
+    ProgramBinaryStore reopened (directory, "driver");
+
+    ASSERT_TRUE (reopened.find (key, binary));
+    EXPECT_EQ (0x8741, binary.format);
+    EXPECT_EQ ("linked program", contents (binary));
+}
+
+TEST_F (ProgramBinaryStoreTest, OtherDriversBinariesAreIgnoredAndKept)
+{
+    ProgramBinaryStore old (directory, "old driver");
+    ProgramBinaryStore updated (directory, "new driver");
+    std::string        key = old.key ("v", "f");
+    ProgramBinary      binary;
+
+    ASSERT_TRUE (old.store (key, makeBinary (1, "old")));
+
+    EXPECT_FALSE (updated.find (key, binary));
+
+    /* Another session might still be running on the old driver */
+    ProgramBinaryStore reopened (directory, "old driver");
+
+    ASSERT_TRUE (reopened.find (key, binary));
+    EXPECT_EQ ("old", contents (binary));
+}
+
+TEST_F (ProgramBinaryStoreTest, CorruptBinariesAreIgnoredAndDeleted)
+{
+    ProgramBinaryStore store (directory, "driver");
+    std::string        key = store.key ("v", "f");
+    ProgramBinary      binary;
+
+    ASSERT_TRUE (store.store (key, makeBinary (1, "a linked program")));
+
+    /* Flip the last byte */
+    std::string driverDirectory =
+	ProgramBinaryStore::driverDirectory (directory, "driver");
+    std::string path = driverDirectory + "/" + key;
+    FILE        *file = fopen (path.c_str (), "r+b");
+
+    ASSERT_TRUE (file);
+    fseek (file, -1, SEEK_END);
+    fputc ('!', file);
+    fclose (file);
+
+    EXPECT_FALSE (store.find (key, binary));
+    EXPECT_EQ (0, countFiles (driverDirectory));
+}
+
+TEST_F (ProgramBinaryStoreTest, ReadAllSkipsOtherDriversAndForeignFiles)
+{
+    ProgramBinaryStore store (directory, "driver");
+    ProgramBinaryStore old (directory, "old driver");
+
+    ASSERT_TRUE (store.store (store.key ("a", "b"), makeBinary (1, "ab")));
+    ASSERT_TRUE (store.store (store.key ("c", "d"), makeBinary (2, "cd")));
+    ASSERT_TRUE (old.store (old.key ("e", "f"), makeBinary (3, "ef")));
+
+    std::string driverDirectory =
+	ProgramBinaryStore::driverDirectory (directory, "driver");
+    std::string foreign = driverDirectory + "/README";
+    FILE        *file = fopen (foreign.c_str (), "w");
+
+    ASSERT_TRUE (file);
+    fclose (file);
+
+    boost::shared_ptr<ProgramBinaryMap> binaries =
+	ProgramBinaryStore::readAll (directory, "driver");
+
+    ASSERT_EQ (2, binaries->size ());
+    EXPECT_EQ ("ab", contents ((*binaries)[store.key ("a", "b")]));
+    EXPECT_EQ ("cd", contents ((*binaries)[store.key ("c", "d")]));
+
+    /* Neither the other driver's binary nor the foreign file are touched */
+    EXPECT_EQ (3, countFiles (driverDirectory));
+    EXPECT_EQ (1, countFiles (ProgramBinaryStore::driverDirectory (directory,
+								   "old driver")));
+}
+
+TEST_F (ProgramBinaryStoreTest, AdoptedBinariesAreFoundWithoutDisk)
+{
+    ProgramBinaryStore writer (directory, "driver");
+    ProgramBinaryStore store (directory, "driver");
+    std::string        key = store.key ("a", "b");
+    ProgramBinary      binary;
+
+    ASSERT_TRUE (writer.store (key, makeBinary (1, "ab")));
+
+    boost::shared_ptr<ProgramBinaryMap> binaries =
+	ProgramBinaryStore::readAll (directory, "driver");
+
+    store.adopt (*binaries);
+
+    std::string command = "rm -rf '" + directory + "'";
+    ASSERT_EQ (0, system (command.c_str ()));
+
+    ASSERT_TRUE (store.find (key, binary));
+    EXPECT_EQ ("ab", contents (binary));
+
+    /* Handed out, the next lookup goes to the disk again */
+    EXPECT_FALSE (store.find (key, binary));
+}
+
+TEST_F (ProgramBinaryStoreTest, AdoptSkipsBinariesAlreadyFound)
+{
+    ProgramBinaryStore writer (directory, "driver");
+    ProgramBinaryStore store (directory, "driver");
+    std::string        key = store.key ("a", "b");
+    ProgramBinary      binary;
+
+    ASSERT_TRUE (writer.store (key, makeBinary (1, "ab")));
+
+    boost::shared_ptr<ProgramBinaryMap> binaries =
+	ProgramBinaryStore::readAll (directory, "driver");
+
+    /* Linked from the disk before the preload finished */
+    ASSERT_TRUE (store.find (key, binary));
+
+    store.adopt (*binaries);
+
+    std::string command = "rm -rf '" + directory + "'";
+    ASSERT_EQ (0, system (command.c_str ()));
+
+    EXPECT_FALSE (store.find (key, binary));
+}
+
+TEST_F (ProgramBinaryStoreTest, AdoptSkipsBinariesAlreadyStored)
+{
+    ProgramBinaryStore writer (directory, "driver");
+    ProgramBinaryStore store (directory, "driver");
+    std::string        key = store.key ("a", "b");
+    ProgramBinary      binary;
+
+    ASSERT_TRUE (writer.store (key, makeBinary (1, "refused")));
+
+    boost::shared_ptr<ProgramBinaryMap> binaries =
+	ProgramBinaryStore::readAll (directory, "driver");
+
+    /* The driver refused the binary, so the program was linked
+     * from source and its new binary stored */
+    ASSERT_TRUE (store.find (key, binary));
+    ASSERT_TRUE (store.store (key, makeBinary (1, "relinked")));
+
+    store.adopt (*binaries);
+
+    ASSERT_TRUE (store.find (key, binary));
+    EXPECT_EQ ("relinked", contents (binary));
+}
+
+TEST_F (ProgramBinaryStoreTest, NoDirectoryMeansNoStore)
+{
+    ProgramBinaryStore store ("", "driver");
+    ProgramBinary      binary;
+
+    EXPECT_FALSE (store.store (store.key ("a", "b"), makeBinary (1, "ab")));
+    EXPECT_FALSE (store.find (store.key ("a", "b"), binary));
+    EXPECT_TRUE (ProgramBinaryStore::readAll ("", "driver")->empty ());
+}
+
+TEST (ProgramBinaryStoreDirectory, FollowsXdgCacheHome)
+{
+    setenv ("XDG_CACHE_HOME", "/cache", 1);
+    EXPECT_EQ ("/cache/compiz-1/glprograms",
+	       ProgramBinaryStore::defaultDirectory ());
+
+    unsetenv ("XDG_CACHE_HOME");
+    setenv ("HOME", "/home/user", 1);
+    EXPECT_EQ ("/home/user/.cache/compiz-1/glprograms",
+	       ProgramBinaryStore::defaultDirectory ());
+}
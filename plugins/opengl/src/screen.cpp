@@ -31,6 +31,7 @@
 #define _GNU_SOURCE
 #endif
 #include <errno.h>
+#include <sstream>
 
 #include <boost/bind.hpp>
 #include <boost/make_shared.hpp>
@@ -170,6 +171,10 @@ namespace GL {
     GLBindRenderbufferProc bindRenderbuffer = NULL;
     GLRenderbufferStorageProc renderbufferStorage = NULL;
 
+    GLGetProgramBinaryProc  getProgramBinary = NULL;
+    GLProgramBinaryProc     programBinary = NULL;
+    GLProgramParameteriProc programParameteri = NULL;
+
     bool  textureFromPixmap = true;
     bool  textureRectangle = false;
     bool  textureNonPowerOfTwo = false;
@@ -187,6 +192,7 @@ namespace GL {
     bool  shaders = false;
     GLint maxTextureUnits = 1;
     bool  bufferAge = false;
+    bool  programBinarySupported = false;
 
     bool canDoSaturated = false;
     bool canDoSlightlySaturated = false;
@@ -280,6 +286,7 @@ namespace GL {
 }
 
 CompOutput *targetOutput = NULL;
+compiz::opengl::ProgramBinaryStore *programBinaryStore = NULL;
 
 /**
  * Callback object to create GLPrograms automatically when using GLVertexBuffer.
@@ -770,6 +777,21 @@ GLScreen::glInitContext (XVisualInfo *visinfo)
     GL::framebufferRenderbuffer = glFramebufferRenderbuffer;
     GL::renderbufferStorage = glRenderbufferStorage;
 
+    if (strstr (glExtensions, "GL_OES_get_program_binary"))
+    {
+	GLint formats = 0;
+
+	GL::getProgramBinary = (GL::GLGetProgramBinaryProc)
+	    eglGetProcAddress ("glGetProgramBinaryOES");
+	GL::programBinary = (GL::GLProgramBinaryProc)
+	    eglGetProcAddress ("glProgramBinaryOES");
+
+	glGetIntegerv (GL::NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+	if (GL::getProgramBinary && GL::programBinary && formats > 0)
+	    GL::programBinarySupported = true;
+    }
+
     glClearColor (0.0, 0.0, 0.0, 1.0);
     glBlendFunc (GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
     glEnable (GL_BLEND);
@@ -1051,6 +1073,23 @@ GLScreen::glInitContext (XVisualInfo *visinfo)
 	GL::shaders = true;
     }
 
+    if (GL::shaders && strstr (glExtensions, "GL_ARB_get_program_binary"))
+    {
+	GLint formats = 0;
+
+	GL::getProgramBinary = (GL::GLGetProgramBinaryProc)
+	    getProcAddress ("glGetProgramBinary");
+	GL::programBinary = (GL::GLProgramBinaryProc)
+	    getProcAddress ("glProgramBinary");
+	GL::programParameteri = (GL::GLProgramParameteriProc)
+	    getProcAddress ("glProgramParameteri");
+
+	glGetIntegerv (GL::NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+	if (GL::getProgramBinary && GL::programBinary && formats > 0)
+	    GL::programBinarySupported = true;
+    }
+
     if (strstr (glExtensions, "GL_ARB_texture_compression"))
 	GL::textureCompression = true;
 
@@ -1103,6 +1142,8 @@ GLScreen::glInitContext (XVisualInfo *visinfo)
     GLVertexBuffer::streamingBuffer ()->setAutoProgram (priv->autoProgram);
     priv->updateFrameProvider ();
 
+    priv->initProgramBinaries ();
+
     return true;
 }
 
@@ -1460,9 +1501,14 @@ PrivateGLScreen::PrivateGLScreen (GLScreen   *gs) :
     hasCompositing (false),
     commonFrontbuffer (true),
     incorrectRefreshRate (false),
+    iconAtlas (),
+    imageCache (),
+    cursorTracker (),
     programCache (new GLProgramCache (30)),
     shaderCache (),
     autoProgram (new GLScreenAutoProgram(gs)),
+    binaryStore (NULL),
+    binaryPreload (),
     rootPixmapCopy (None),
     rootPixmapSize (),
     frameProvider (),
@@ -1482,6 +1528,12 @@ PrivateGLScreen::~PrivateGLScreen ()
     delete projection;
     delete programCache;
     delete autoProgram;
+
+    /* The preload doesn't touch the store, only its continuation does */
+    binaryPreload.cancel ();
+    if (programBinaryStore == binaryStore)
+	programBinaryStore = NULL;
+    delete binaryStore;
     if (rootPixmapCopy)
 	XFreePixmap (screen->dpy (), rootPixmapCopy);
 
@@ -1510,6 +1562,8 @@ PrivateGLScreen::handleEvent (XEvent *event)
 
     screen->handleEvent (event);
 
+    cursorTracker.handleEvent (event);
+
     switch (event->type) {
 	case ConfigureNotify:
 	    if (event->xconfigure.window == screen->root ())
@@ -2471,6 +2525,65 @@ PrivateGLScreen::postprocessRequiredForCurrentFrame ()
     return postprocessingRequired;
 }
 
+namespace cgl = compiz::opengl;
+
+namespace
+{
+void
+readProgramBinaries (const std::string                          &directory,
+		     const std::string                          &driver,
+		     const boost::shared_ptr <cgl::ProgramBinaryMap> &binaries)
+{
+    cgl::ProgramBinaryStore::readAll (directory, driver)->swap (*binaries);
+}
+
+void
+adoptProgramBinaries (cgl::ProgramBinaryStore                         *store,
+		      const boost::shared_ptr <cgl::ProgramBinaryMap> &binaries)
+{
+    store->adopt (*binaries);
+}
+}
+
+void
+PrivateGLScreen::initProgramBinaries ()
+{
+    if (!GL::shaders || !GL::programBinarySupported)
+	return;
+
+    std::string directory (cgl::ProgramBinaryStore::defaultDirectory ());
+
+    if (directory.empty ())
+	return;
+
+    /* glVendor and friends are only filled in for GLX */
+    const char *vendor = (const char *) glGetString (GL_VENDOR);
+    const char *renderer = (const char *) glGetString (GL_RENDERER);
+    const char *version = (const char *) glGetString (GL_VERSION);
+    std::ostringstream driver;
+
+    driver << (vendor ? vendor : "") << '\n'
+	   << (renderer ? renderer : "") << '\n'
+	   << (version ? version : "") << '\n'
+	   << COMPIZ_OPENGL_ABI;
+
+    binaryStore = new cgl::ProgramBinaryStore (directory, driver.str ());
+    programBinaryStore = binaryStore;
+
+    /* Reading and checking the binaries is left to a worker so that
+     * startup doesn't wait on the disk. Programs linked before it is
+     * done just look their binary up directly */
+    boost::shared_ptr <cgl::ProgramBinaryMap> binaries =
+	boost::make_shared <cgl::ProgramBinaryMap> ();
+
+    binaryPreload =
+	screen->runTask (boost::bind (readProgramBinaries,
+				      directory, driver.str (), binaries),
+			 boost::bind (adoptProgramBinaries,
+				      binaryStore, binaries),
+			 NULL);
+}
+
 GLTexture::BindPixmapHandle
 GLScreen::registerBindPixmap (GLTexture::BindPixmapProc proc)
 {
@@ -2517,8 +2630,7 @@ GLScreen::defaultIcon ()
     if (priv->defaultIcon.icon == i)
 	return priv->defaultIcon.textures[0];
 
-    priv->defaultIcon.textures =
-	GLTexture::imageBufferToTexture ((char *) i->data (), *i);
+    priv->defaultIcon.textures = priv->iconAtlas.get (*i);
 
     if (priv->defaultIcon.textures.size () == 1)
 	priv->defaultIcon.icon = i;
@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
 #include <boost/scoped_ptr.hpp>
 
@@ -399,17 +400,111 @@ GLTexture::readImageToTexture (CompString &imageFileName,
 			       CompString &pluginName,
 			       CompSize   &size)
 {
+    return GLScreen::get (screen)->priv->imageCache.read (imageFileName,
+							   pluginName,
+							   size);
+}
+
+GLTexture::List
+GLImageCache::read (CompString &name,
+		    CompString &pluginName,
+		    CompSize   &size)
+{
+    struct stat st;
+    time_t      mtime = 0;
+    off_t       fileSize = -1;
+
+    /* Names that are not paths are looked up in the image directories
+     * by the image plugins, those files only change on upgrades */
+    if (stat (name.c_str (), &st) == 0)
+    {
+	mtime    = st.st_mtime;
+	fileSize = st.st_size;
+    }
+
+    for (std::list <Entry>::iterator it = entries.begin ();
+	 it != entries.end (); ++it)
+    {
+	if (it->name != name || it->pluginName != pluginName)
+	    continue;
+
+	if (it->mtime != mtime || it->fileSize != fileSize)
+	{
+	    entries.erase (it);
+	    break;
+	}
+
+	entries.splice (entries.begin (), entries, it);
+	size = it->size;
+
+	return it->textures;
+    }
+
     void *image = NULL;
 
-    if (!screen->readImageFromFile (imageFileName, pluginName, size, image) || !image)
+    if (!screen->readImageFromFile (name, pluginName, size, image) || !image)
 	return GLTexture::List ();
 
-    GLTexture::List rv =
-	GLTexture::imageBufferToTexture ((char *)image, size);
+    Entry entry;
+
+    entry.name       = name;
+    entry.pluginName = pluginName;
+    entry.mtime      = mtime;
+    entry.fileSize   = fileSize;
+    entry.size       = size;
+    entry.textures   = GLTexture::imageBufferToTexture ((char *) image, size);
 
     free (image);
 
-    return rv;
+    if (entry.textures.empty ())
+	return GLTexture::List ();
+
+    entries.push_front (entry);
+    trim ();
+
+    return entry.textures;
+}
+
+void
+GLImageCache::trim ()
+{
+    unsigned int idle = 0;
+
+    for (std::list <Entry>::iterator it = entries.begin ();
+	 it != entries.end ();)
+    {
+	bool held = false;
+
+	foreach (GLTexture *texture, it->textures)
+	    if (PrivateTexture::references (texture) > 1)
+		held = true;
+
+	if (!held && ++idle > MaxIdle)
+	    it = entries.erase (it);
+	else
+	    ++it;
+    }
+}
+
+int
+PrivateTexture::references (const GLTexture *texture)
+{
+    return texture->priv->refCount;
+}
+
+void
+PrivateTexture::borrow (GLTexture *texture, const GLTexture *from)
+{
+    if (texture->priv->name)
+	glDeleteTextures (1, &texture->priv->name);
+
+    texture->priv->name = from->priv->name;
+}
+
+void
+PrivateTexture::release (GLTexture *texture)
+{
+    texture->priv->name = 0;
 }
 
 void
@@ -25,6 +25,8 @@
  *          David Reveman <davidr@novell.com>
  */
 
+#include <time.h>
+
 #include "privates.h"
 
 template class WrapableInterface<GLWindow, GLWindowInterface>;
@@ -87,7 +89,11 @@ PrivateGLWindow::PrivateGLWindow (CompWindow *w,
     vertexBuffer (new GLVertexBuffer ()),
     autoProgram(new GLWindowAutoProgram (this)),
     icons (),
-    configureLock (w->obtainLockOnConfigureRequests ())
+    configureLock (w->obtainLockOnConfigureRequests ()),
+    downscaleFbo (),
+    downscalePolicy (),
+    downscaleTimer (),
+    downscaleHint ()
 {
     paint.xScale	= 1.0f;
     paint.yScale	= 1.0f;
@@ -100,6 +106,9 @@ PrivateGLWindow::PrivateGLWindow (CompWindow *w,
     vertexBuffer->setAutoProgram(autoProgram);
 
     cWindow->setNewPixmapReadyCallback (boost::bind (&PrivateGLWindow::clearTextures, this));
+
+    downscaleTimer.setCallback (boost::bind (&PrivateGLWindow::downscaleTimeout,
+					     this));
 }
 
 PrivateGLWindow::~PrivateGLWindow ()
@@ -131,6 +140,7 @@ void
 PrivateGLWindow::clearTextures ()
 {
     textures.clear ();
+    downscalePolicy.invalidate ();
 }
 
 bool
@@ -347,7 +357,7 @@ GLWindow::getIcon (int width, int height)
 	    return icon.textures[0];
 
     icon.icon = i;
-    icon.textures = GLTexture::imageBufferToTexture ((char *) i->data (), *i);
+    icon.textures = priv->gScreen->priv->iconAtlas.get (*i);
 
     if (icon.textures.size () > 1 || icon.textures.size () == 0)
 	return NULL;
@@ -357,6 +367,223 @@ GLWindow::getIcon (int width, int height)
     return icon.textures[0];
 }
 
+static long long
+downscaleTime ()
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (long long) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+GLTexture *
+GLWindow::downscaledTexture (const CompSize    &maxSize,
+			     GLTexture::Matrix &matrix)
+{
+    if (!GL::fboEnabled)
+	return NULL;
+
+    CompRect input (priv->window->inputRect ());
+    CompSize size (compiz::opengl::DownscalePolicy::size (
+		       CompSize (input.width (), input.height ()), maxSize));
+
+    if (!size.width () || !size.height ())
+	return NULL;
+
+    if (priv->textures.empty () && !bind ())
+	return NULL;
+
+    if (!priv->downscaleFbo)
+	priv->downscaleFbo.reset (new GLFramebufferObject ());
+
+    GLTexture *texture = priv->downscaleFbo->tex ();
+
+    if (!texture                             ||
+	texture->width ()  != size.width () ||
+	texture->height () != size.height ())
+    {
+	if (!priv->downscaleFbo->allocate (size, NULL, GL_BGRA))
+	{
+	    priv->downscaleFbo.reset ();
+	    return NULL;
+	}
+
+	priv->downscalePolicy.invalidate ();
+	texture = priv->downscaleFbo->tex ();
+    }
+
+    long long now = downscaleTime ();
+
+    if (priv->downscalePolicy.refresh (now))
+    {
+	if (!priv->drawDownscaled (size))
+	{
+	    priv->downscalePolicy.invalidate ();
+	    return NULL;
+	}
+    }
+    else if (!priv->downscaleTimer.active ())
+    {
+	/* Repaint once the stale copy may be redrawn */
+	long long delay = priv->downscalePolicy.delay (now);
+
+	if (delay)
+	    priv->downscaleTimer.start (delay, delay + delay / 4);
+    }
+
+    /* The copy is drawn with the input rectangle covering all of it */
+    matrix = texture->matrix ();
+    matrix.xx *= (float) size.width () / input.width ();
+    matrix.yy *= (float) size.height () / input.height ();
+    matrix.x0 -= input.x () * matrix.xx;
+    matrix.y0 -= input.y () * matrix.yy;
+
+    return texture;
+}
+
+void
+GLWindow::setDownscaleHint (const CompSize &maxSize)
+{
+    priv->downscaleHint = maxSize;
+}
+
+bool
+PrivateGLWindow::drawDownscaled (const CompSize &size)
+{
+    GLFramebufferObject *oldFbo = downscaleFbo->bind ();
+
+    if (!downscaleFbo->checkStatus ())
+    {
+	GLFramebufferObject::rebind (oldFbo);
+	return false;
+    }
+
+    if (updateState & UpdateMatrix)
+	setWindowMatrix ();
+
+    if (updateState & UpdateRegion)
+	updateWindowRegions ();
+
+    CompRect  input (window->inputRect ());
+    GLMatrix  projection, modelview;
+    GLint     viewport[4];
+    GLfloat   clearColor[4];
+    GLboolean scissor = glIsEnabled (GL_SCISSOR_TEST);
+    GLboolean blend = glIsEnabled (GL_BLEND);
+    GLenum    filter = gScreen->textureFilter ();
+
+    std::list<const GLShaderData *> pluginShaders;
+
+    /* Two triangles per rectangle */
+    static const int corners[] = { 0, 0,  1, 0,  0, 1,  0, 1,  1, 0,  1, 1 };
+
+    glGetIntegerv (GL_VIEWPORT, viewport);
+    glGetFloatv (GL_COLOR_CLEAR_VALUE, clearColor);
+
+    glViewport (0, 0, size.width (), size.height ());
+
+    if (scissor)
+	glDisable (GL_SCISSOR_TEST);
+
+    if (blend)
+	glDisable (GL_BLEND);
+
+    glClearColor (0.0f, 0.0f, 0.0f, 0.0f);
+    glClear (GL_COLOR_BUFFER_BIT);
+
+    /* Map the input rectangle onto the whole framebuffer */
+    modelview.translate (-1.0f, -1.0f, 0.0f);
+    modelview.scale (2.0f / input.width (), 2.0f / input.height (), 1.0f);
+    modelview.translate (-input.x (), -input.y (), 0.0f);
+
+    /* Sampling the mipmaps of the window texture averages all the
+     * pixels covered, where they are not available this is bilinear */
+    gScreen->setTextureFilter (GL_LINEAR_MIPMAP_LINEAR);
+    gScreen->setTexEnvMode (GL_REPLACE);
+
+    /* Shaders plugins added for the window itself do not apply here */
+    pluginShaders.swap (shaders);
+
+    for (unsigned int i = 0; i < textures.size (); i++)
+    {
+	const GLTexture::Matrix &m = matrices[i];
+	std::vector<GLfloat>     vertices;
+	std::vector<GLfloat>     texCoords;
+
+	foreach (const CompRect &r, regions[i].rects ())
+	{
+	    const GLfloat x[] = { (GLfloat) r.x1 (), (GLfloat) r.x2 () };
+	    const GLfloat y[] = { (GLfloat) r.y1 (), (GLfloat) r.y2 () };
+
+	    for (unsigned int c = 0; c < 12; c += 2)
+	    {
+		GLfloat vx = x[corners[c]], vy = y[corners[c + 1]];
+
+		vertices.push_back (vx);
+		vertices.push_back (vy);
+		vertices.push_back (0.0f);
+
+		texCoords.push_back (COMP_TEX_COORD_X (m, vx));
+		texCoords.push_back (COMP_TEX_COORD_Y (m, vy));
+	    }
+	}
+
+	if (vertices.empty ())
+	    continue;
+
+	vertexBuffer->begin ();
+	vertexBuffer->addVertices (vertices.size () / 3, &vertices[0]);
+	vertexBuffer->addTexCoords (0, texCoords.size () / 2, &texCoords[0]);
+
+	if (vertexBuffer->end ())
+	{
+	    glActiveTexture (GL_TEXTURE0);
+	    textures[i]->enable (GLTexture::Good);
+	    vertexBuffer->render (projection, modelview,
+				  GLWindow::defaultPaintAttrib);
+	    textures[i]->disable ();
+	}
+
+	shaders.clear ();
+    }
+
+    shaders.swap (pluginShaders);
+
+    gScreen->setTextureFilter (filter);
+
+    glClearColor (clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+
+    if (blend)
+	glEnable (GL_BLEND);
+
+    if (scissor)
+	glEnable (GL_SCISSOR_TEST);
+
+    glViewport (viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    GLFramebufferObject::rebind (oldFbo);
+
+    return true;
+}
+
+bool
+PrivateGLWindow::downscaleTimeout ()
+{
+    cWindow->addDamage ();
+
+    return false;
+}
+
+bool
+PrivateGLWindow::damageRect (bool            initial,
+			     const CompRect &rect)
+{
+    downscalePolicy.damage ();
+
+    return cWindow->damageRect (initial, rect);
+}
+
 void
 GLWindow::addShaders (std::string name,
                       std::string vertex_shader,
@@ -0,0 +1,76 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _COMPIZ_PLACE_SMART_OVERLAP_H
+#define _COMPIZ_PLACE_SMART_OVERLAP_H
+
+#include <vector>
+
+namespace compiz
+{
+    namespace place
+    {
+	/*
+	 * Answers "how much weighted area of a set of rectangles lies
+	 * within this rectangle" without visiting every rectangle.
+	 *
+	 * The rectangle edges are compressed into a grid and a summed
+	 * area table is built over it once. A query then only has to
+	 * find the grid cells its corners fall into, interpolating
+	 * inside those cells, which is exact since the weight is
+	 * constant across a cell.
+	 */
+	class OverlapAccumulator
+	{
+	    public:
+
+		OverlapAccumulator ();
+
+		/* Rectangles are half open, [x1, x2) x [y1, y2) */
+		void add (int x1, int y1, int x2, int y2, int weight);
+
+		/* Must be called after the last add () and before
+		 * the first overlap () */
+		void build ();
+
+		long long overlap (int x1, int y1, int x2, int y2) const;
+
+	    private:
+
+		struct Rect
+		{
+		    int x1, y1, x2, y2;
+		    int weight;
+		};
+
+		/* Weighted area of everything above and left of (x, y) */
+		long long integral (int x, int y) const;
+
+		long long sum (unsigned int i, unsigned int j) const
+		{
+		    return mSums[i * mYs.size () + j];
+		}
+
+		std::vector <Rect>      mRects;
+		std::vector <int>       mXs;
+		std::vector <int>       mYs;
+		std::vector <long long> mSums;
+	};
+    }
+}
+
+#endif
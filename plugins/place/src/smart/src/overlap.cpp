@@ -0,0 +1,178 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "overlap.h"
+#include <algorithm>
+#include <boost/foreach.hpp>
+
+#ifndef foreach
+#define foreach BOOST_FOREACH
+#endif
+
+namespace
+{
+    unsigned int indexOf (const std::vector <int> &coords, int c)
+    {
+	return std::lower_bound (coords.begin (), coords.end (), c) -
+	       coords.begin ();
+    }
+
+    void sortUnique (std::vector <int> &coords)
+    {
+	std::sort (coords.begin (), coords.end ());
+	coords.erase (std::unique (coords.begin (), coords.end ()),
+		      coords.end ());
+    }
+}
+
+namespace compiz
+{
+    namespace place
+    {
+	OverlapAccumulator::OverlapAccumulator ()
+	{
+	}
+
+	void
+	OverlapAccumulator::add (int x1, int y1, int x2, int y2, int weight)
+	{
+	    if (!weight || x2 <= x1 || y2 <= y1)
+		return;
+
+	    Rect r = { x1, y1, x2, y2, weight };
+	    mRects.push_back (r);
+	}
+
+	void
+	OverlapAccumulator::build ()
+	{
+	    mXs.clear ();
+	    mYs.clear ();
+	    mSums.clear ();
+
+	    if (mRects.empty ())
+		return;
+
+	    mXs.reserve (mRects.size () * 2);
+	    mYs.reserve (mRects.size () * 2);
+
+	    foreach (const Rect &r, mRects)
+	    {
+		mXs.push_back (r.x1);
+		mXs.push_back (r.x2);
+		mYs.push_back (r.y1);
+		mYs.push_back (r.y2);
+	    }
+
+	    sortUnique (mXs);
+	    sortUnique (mYs);
+
+	    const unsigned int nx = mXs.size ();
+	    const unsigned int ny = mYs.size ();
+
+	    /* Corner deltas, which sum up to the weight of each grid cell */
+	    std::vector <int> weights (nx * ny, 0);
+
+	    foreach (const Rect &r, mRects)
+	    {
+		unsigned int i1 = indexOf (mXs, r.x1), i2 = indexOf (mXs, r.x2);
+		unsigned int j1 = indexOf (mYs, r.y1), j2 = indexOf (mYs, r.y2);
+
+		weights[i1 * ny + j1] += r.weight;
+		weights[i2 * ny + j1] -= r.weight;
+		weights[i1 * ny + j2] -= r.weight;
+		weights[i2 * ny + j2] += r.weight;
+	    }
+
+	    for (unsigned int i = 0; i < nx; ++i)
+		for (unsigned int j = 0; j < ny; ++j)
+		{
+		    if (i)
+			weights[i * ny + j] += weights[(i - 1) * ny + j];
+		    if (j)
+			weights[i * ny + j] += weights[i * ny + j - 1];
+		    if (i && j)
+			weights[i * ny + j] -= weights[(i - 1) * ny + j - 1];
+		}
+
+	    /* mSums[i][j] is the weighted area left of mXs[i] and
+	     * above mYs[j] */
+	    mSums.assign (nx * ny, 0);
+
+	    for (unsigned int i = 0; i + 1 < nx; ++i)
+		for (unsigned int j = 0; j + 1 < ny; ++j)
+		{
+		    long long cell = (long long) weights[i * ny + j] *
+				     (mXs[i + 1] - mXs[i]) *
+				     (mYs[j + 1] - mYs[j]);
+
+		    mSums[(i + 1) * ny + j + 1] = cell +
+						  mSums[i * ny + j + 1] +
+						  mSums[(i + 1) * ny + j] -
+						  mSums[i * ny + j];
+		}
+	}
+
+	long long
+	OverlapAccumulator::integral (int x, int y) const
+	{
+	    if (mSums.empty () || x <= mXs.front () || y <= mYs.front ())
+		return 0;
+
+	    const unsigned int i = std::upper_bound (mXs.begin (), mXs.end (), x) -
+				   mXs.begin () - 1;
+	    const unsigned int j = std::upper_bound (mYs.begin (), mYs.end (), y) -
+				   mYs.begin () - 1;
+
+	    const long long dx = x - mXs[i];
+	    const long long dy = y - mYs[j];
+
+	    const bool insideX = dx && i + 1 < mXs.size ();
+	    const bool insideY = dy && j + 1 < mYs.size ();
+
+	    long long area = sum (i, j);
+
+	    /* The differences below are always exact multiples of the
+	     * cell sizes, since each cell has a constant weight */
+	    if (insideX)
+		area += dx * ((sum (i + 1, j) - sum (i, j)) /
+			      (mXs[i + 1] - mXs[i]));
+
+	    if (insideY)
+		area += dy * ((sum (i, j + 1) - sum (i, j)) /
+			      (mYs[j + 1] - mYs[j]));
+
+	    if (insideX && insideY)
+		area += dx * dy * ((sum (i + 1, j + 1) - sum (i + 1, j) -
+				    sum (i, j + 1) + sum (i, j)) /
+				   ((long long) (mXs[i + 1] - mXs[i]) *
+				    (mYs[j + 1] - mYs[j])));
+
+	    return area;
+	}
+
+	long long
+	OverlapAccumulator::overlap (int x1, int y1, int x2, int y2) const
+	{
+	    if (x2 <= x1 || y2 <= y1)
+		return 0;
+
+	    return integral (x2, y2) - integral (x1, y2) -
+		   integral (x2, y1) + integral (x1, y1);
+	}
+    }
+}
@@ -1,4 +1,6 @@
 #include "smart.h"
+#include "overlap.h"
+#include <algorithm>
 #include <boost/foreach.hpp>
 
 #ifndef foreach
@@ -25,6 +27,24 @@ namespace compiz
 	{
 	}
 
+	namespace
+	{
+	    struct Bounds
+	    {
+		int xl, yt, xr, yb;
+	    };
+
+	    int overlapWeight (const Placeable *p)
+	    {
+		if (p->state () & compiz::place::WindowAbove)
+		    return 16;
+		else if (p->state () & compiz::place::WindowBelow)
+		    return 0;
+
+		return 1;
+	    }
+	}
+
 	void smart (Placeable                      *placeable,
 		    CompPoint			   &pos,
 		    const compiz::place::Placeable::Vector &placeables)
@@ -38,7 +58,7 @@ namespace compiz
 	     * with ideas from xfce.
 	     * adapted for Compiz by Bellegarde Cedric (gnumdk(at)gmail.com)
 	     */
-	    int overlap = 0, minOverlap = 0;
+	    long long overlap = 0, minOverlap = 0;
 
 	    /* temp holder */
 	    int basket = 0;
@@ -56,6 +76,37 @@ namespace compiz
 	    int xOptimal = xTmp;
 	    int yOptimal = yTmp;
 
+	    /* The other windows don't move while we look for a spot, so
+	     * work out their frame bounds and the overlap table once */
+	    std::vector <Bounds> bounds;
+	    OverlapAccumulator   accumulator;
+
+	    bounds.reserve (placeables.size ());
+
+	    foreach (Placeable *p, placeables)
+	    {
+		const compiz::window::Geometry &otherGeometry = p->geometry ();
+		const compiz::window::extents::Extents &otherExtents = p->extents ();
+
+		Bounds b;
+
+		b.xl = otherGeometry.x () - otherExtents.left;
+		b.yt = otherGeometry.y () - otherExtents.top;
+		b.xr = otherGeometry.x2 () + otherExtents.right + otherGeometry.border () * 2;
+		b.yb = otherGeometry.y2 () + otherExtents.bottom + otherGeometry.border () * 2;
+
+		bounds.push_back (b);
+		accumulator.add (b.xl, b.yt, b.xr, b.yb, overlapWeight (p));
+	    }
+
+	    accumulator.build ();
+
+	    /* Sorted x positions at which the overlap can change for
+	     * the row of candidates at xStopsRow */
+	    std::vector <int> xStops;
+	    int               xStopsRow = yTmp;
+	    bool              xStopsValid = false;
+
 	    /* loop over possible positions */
 	    do
 	    {
@@ -66,39 +117,9 @@ namespace compiz
 		    overlap = W_WRONG;
 		else
 		{
-		    overlap = NONE; /* initialize */
-
-		    int cxl = xTmp;
-		    int cxr = xTmp + cw;
-		    int cyt = yTmp;
-		    int cyb = yTmp + ch;
-
-		    foreach (Placeable *p, placeables)
-		    {
-			const compiz::window::Geometry &otherGeometry = p->geometry ();
-			const compiz::window::extents::Extents &otherExtents = p->extents ();
-
-			int xl = otherGeometry.x () - otherExtents.left;
-			int yt = otherGeometry.y () - otherExtents.top;
-			int xr = otherGeometry.x2 () + otherExtents.right + otherGeometry.border () * 2;
-			int yb = otherGeometry.y2 () + otherExtents.bottom + otherGeometry.border () * 2;
-
-			/* if windows overlap, calc the overall overlapping */
-			if (cxl < xr && cxr > xl && cyt < yb && cyb > yt)
-			{
-			    xl = MAX (cxl, xl);
-			    xr = MIN (cxr, xr);
-			    yt = MAX (cyt, yt);
-			    yb = MIN (cyb, yb);
-
-			    if (p->state () & compiz::place::WindowAbove)
-				overlap += 16 * (xr - xl) * (yb - yt);
-			    else if (p->state () & compiz::place::WindowBelow)
-				overlap += 0;
-			    else
-				overlap += (xr - xl) * (yb - yt);
-			}
-		    }
+		    /* calc the overall overlapping */
+		    overlap = accumulator.overlap (xTmp, yTmp,
+						   xTmp + cw, yTmp + ch);
 		}
 
 		/* CT first time we get no overlap we stop */
@@ -130,30 +151,35 @@ namespace compiz
 		    if (possible - cw > xTmp)
 			possible -= cw;
 
-		    /* compare to the position of each client on the same desk */
-		    foreach (Placeable *p, placeables)
+		    /* compare to the position of each client on the same desk,
+		     * which only changes when we move on to the next row */
+		    if (!xStopsValid || xStopsRow != yTmp)
 		    {
-			const compiz::window::Geometry &otherGeometry = p->geometry ();
-			const compiz::window::extents::Extents &otherExtents = p->extents ();
-
-			int xl = otherGeometry.x () - otherExtents.left;
-			int yt = otherGeometry.y () - otherExtents.top;
-			int xr = otherGeometry.x2 () + otherExtents.right + otherGeometry.border () * 2;
-			int yb = otherGeometry.y2 () + otherExtents.bottom + otherGeometry.border () * 2;
+			xStopsValid = true;
+			xStopsRow = yTmp;
+			xStops.clear ();
 
-			/* if not enough room above or under the current
-			 * client determine the first non-overlapped x position
-			 */
-			if (yTmp < yb && yt < ch + yTmp)
+			foreach (const Bounds &b, bounds)
 			{
-			    if (xr > xTmp && possible > xr)
-				possible = xr;
-
-			    basket = xl - cw;
-			    if (basket > xTmp && possible > basket)
-				possible = basket;
+			    /* if not enough room above or under the current
+			     * client determine the first non-overlapped x position
+			     */
+			    if (yTmp < b.yb && b.yt < ch + yTmp)
+			    {
+				xStops.push_back (b.xr);
+				xStops.push_back (b.xl - cw);
+			    }
 			}
+
+			std::sort (xStops.begin (), xStops.end ());
 		    }
+
+		    std::vector <int>::const_iterator next =
+			std::upper_bound (xStops.begin (), xStops.end (), xTmp);
+
+		    if (next != xStops.end () && possible > *next)
+			possible = *next;
+
 		    xTmp = possible;
 		}
 		/* else ==> not enough x dimension (overlap was wrong on horizontal) */
@@ -166,21 +192,15 @@ namespace compiz
 			possible -= ch;
 
 		    /* test the position of each window on the desk */
-		    foreach (Placeable *p, placeables)
+		    foreach (const Bounds &b, bounds)
 		    {
-			const compiz::window::Geometry &otherGeometry = p->geometry ();
-			const compiz::window::extents::Extents &otherExtents = p->extents ();
-
-			int yt = otherGeometry.y () - otherExtents.top;
-			int yb = otherGeometry.y2 () + otherExtents.bottom + otherGeometry.border () * 2;
-
 			/* if not enough room to the left or right of the current
 			 * client determine the first non-overlapped y position
 			 */
-			if (yb > yTmp && possible > yb)
-			    possible = yb;
+			if (b.yb > yTmp && possible > b.yb)
+			    possible = b.yb;
 
-			basket = yt - ch;
+			basket = b.yt - ch;
 			if (basket > yTmp && possible > basket)
 			    possible = basket;
 		    }
@@ -0,0 +1,271 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <gtest/gtest.h>
+#include "smart.h"
+#include "overlap.h"
+#include <algorithm>
+#include <vector>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include <boost/foreach.hpp>
+
+#ifndef foreach
+#define foreach BOOST_FOREACH
+#endif
+
+namespace cp = compiz::place;
+
+namespace
+{
+    struct WeightedRect
+    {
+	int x1, y1, x2, y2, weight;
+    };
+
+    /* The per-window loop the accumulator replaces */
+    long long bruteForceOverlap (const std::vector <WeightedRect> &rects,
+				 int cxl, int cyt, int cxr, int cyb)
+    {
+	long long overlap = 0;
+
+	foreach (const WeightedRect &r, rects)
+	{
+	    if (cxl < r.x2 && cxr > r.x1 && cyt < r.y2 && cyb > r.y1)
+		overlap += (long long) r.weight *
+			   (std::min (cxr, r.x2) - std::max (cxl, r.x1)) *
+			   (std::min (cyb, r.y2) - std::max (cyt, r.y1));
+	}
+
+	return overlap;
+    }
+
+    std::vector <WeightedRect> randomRects (unsigned int n,
+					    int width, int height)
+    {
+	static const int weights[] = { 0, 1, 1, 1, 16 };
+	std::vector <WeightedRect> rects;
+
+	for (unsigned int i = 0; i < n; ++i)
+	{
+	    WeightedRect r;
+
+	    r.x1 = rand () % width - 50;
+	    r.y1 = rand () % height - 50;
+	    r.x2 = r.x1 + 1 + rand () % (width / 2);
+	    r.y2 = r.y1 + 1 + rand () % (height / 2);
+	    r.weight = weights[rand () % 5];
+
+	    rects.push_back (r);
+	}
+
+	return rects;
+    }
+
+    unsigned long long usecs ()
+    {
+	struct timeval tv;
+
+	gettimeofday (&tv, NULL);
+	return (unsigned long long) tv.tv_sec * 1000000 + tv.tv_usec;
+    }
+
+    class MockPlaceable :
+	public cp::Placeable
+    {
+	public:
+
+	    MockPlaceable (const compiz::window::Geometry &geometry,
+			   const CompRect                 &workArea,
+			   unsigned int                   state) :
+		mGeometry (geometry),
+		mWorkArea (workArea),
+		mState (state)
+	    {
+		mExtents.left = 1;
+		mExtents.right = 1;
+		mExtents.top = 20;
+		mExtents.bottom = 1;
+	    }
+
+	    const compiz::window::Geometry & getGeometry () const { return mGeometry; }
+	    const CompRect & getWorkarea () const { return mWorkArea; }
+	    const compiz::window::extents::Extents & getExtents () const { return mExtents; }
+	    unsigned int getState () const { return mState; }
+
+	private:
+
+	    compiz::window::Geometry         mGeometry;
+	    CompRect                         mWorkArea;
+	    compiz::window::extents::Extents mExtents;
+	    unsigned int                     mState;
+    };
+}
+
+class CompPlaceSmartOverlapTest :
+    public ::testing::Test
+{
+    protected:
+
+	void SetUp ()
+	{
+	    srand (1);
+	}
+
+	void fill (const std::vector <WeightedRect> &rects)
+	{
+	    foreach (const WeightedRect &r, rects)
+		accumulator.add (r.x1, r.y1, r.x2, r.y2, r.weight);
+
+	    accumulator.build ();
+	}
+
+	cp::OverlapAccumulator accumulator;
+};
+
+TEST_F (CompPlaceSmartOverlapTest, EmptyHasNoOverlap)
+{
+    accumulator.build ();
+
+    EXPECT_EQ (0, accumulator.overlap (0, 0, 100, 100));
+}
+
+TEST_F (CompPlaceSmartOverlapTest, SingleRectangle)
+{
+    accumulator.add (10, 10, 110, 60, 1);
+    accumulator.build ();
+
+    EXPECT_EQ (100 * 50, accumulator.overlap (0, 0, 200, 200));
+    EXPECT_EQ (100 * 50, accumulator.overlap (10, 10, 110, 60));
+    EXPECT_EQ (10 * 10, accumulator.overlap (100, 50, 120, 70));
+    EXPECT_EQ (5 * 7, accumulator.overlap (20, 20, 25, 27));
+}
+
+TEST_F (CompPlaceSmartOverlapTest, TouchingEdgesDoNotOverlap)
+{
+    accumulator.add (10, 10, 110, 60, 1);
+    accumulator.build ();
+
+    EXPECT_EQ (0, accumulator.overlap (110, 10, 200, 60));
+    EXPECT_EQ (0, accumulator.overlap (10, 60, 110, 100));
+    EXPECT_EQ (0, accumulator.overlap (0, 0, 10, 10));
+}
+
+TEST_F (CompPlaceSmartOverlapTest, WeightsAreApplied)
+{
+    accumulator.add (0, 0, 10, 10, 16);
+    accumulator.add (5, 5, 15, 15, 1);
+    accumulator.add (0, 0, 100, 100, 0);
+    accumulator.build ();
+
+    EXPECT_EQ (16 * 100 + 100, accumulator.overlap (0, 0, 100, 100));
+    EXPECT_EQ (16 * 25 + 25, accumulator.overlap (5, 5, 10, 10));
+}
+
+TEST_F (CompPlaceSmartOverlapTest, MatchesBruteForce)
+{
+    std::vector <WeightedRect> rects = randomRects (200, 1920, 1080);
+
+    fill (rects);
+
+    for (unsigned int i = 0; i < 5000; ++i)
+    {
+	int x = rand () % 2000 - 40;
+	int y = rand () % 1200 - 60;
+	int w = rand () % 800;
+	int h = rand () % 600;
+
+	ASSERT_EQ (bruteForceOverlap (rects, x, y, x + w, y + h),
+		   accumulator.overlap (x, y, x + w, y + h));
+    }
+}
+
+/* Evaluates every candidate position a placement of a 640x480
+ * window could visit on a workspace with 500 windows, both with the
+ * per-window loop and with the accumulator */
+TEST_F (CompPlaceSmartOverlapTest, Benchmark500Placeables)
+{
+    const int width = 2560, height = 1440;
+    const int cw = 639, ch = 479;
+
+    std::vector <WeightedRect> rects = randomRects (500, width, height);
+    std::vector <long long> expected, actual;
+
+    unsigned long long start = usecs ();
+
+    for (int y = 0; y + ch < height; y += 16)
+	for (int x = 0; x + cw < width; x += 16)
+	    expected.push_back (bruteForceOverlap (rects, x, y, x + cw, y + ch));
+
+    unsigned long long bruteForce = usecs () - start;
+
+    start = usecs ();
+
+    fill (rects);
+
+    unsigned long long built = usecs () - start;
+
+    start = usecs ();
+
+    for (int y = 0; y + ch < height; y += 16)
+	for (int x = 0; x + cw < width; x += 16)
+	    actual.push_back (accumulator.overlap (x, y, x + cw, y + ch));
+
+    unsigned long long queried = usecs () - start;
+
+    EXPECT_EQ (expected, actual);
+
+    RecordProperty ("candidates", expected.size ());
+    RecordProperty ("brute_force_usec", bruteForce);
+    RecordProperty ("accumulator_build_usec", built);
+    RecordProperty ("accumulator_query_usec", queried);
+}
+
+TEST_F (CompPlaceSmartOverlapTest, Place500Placeables)
+{
+    CompRect workArea (0, 24, 2560, 1416);
+    std::vector <MockPlaceable *> windows;
+    cp::Placeable::Vector placeables;
+
+    for (unsigned int i = 0; i < 500; ++i)
+    {
+	compiz::window::Geometry g (rand () % 2200, 24 + rand () % 1100,
+				    100 + rand () % 600, 100 + rand () % 400, 0);
+
+	windows.push_back (new MockPlaceable (g, workArea,
+					      i % 10 ? 0 : cp::WindowAbove));
+	placeables.push_back (windows.back ());
+    }
+
+    MockPlaceable placeable (compiz::window::Geometry (0, 0, 640, 480, 0),
+			     workArea, 0);
+    CompPoint     pos;
+
+    unsigned long long start = usecs ();
+
+    cp::smart (&placeable, pos, placeables);
+
+    RecordProperty ("placement_usec", usecs () - start);
+
+    EXPECT_GE (pos.x (), workArea.x ());
+    EXPECT_GE (pos.y (), workArea.y ());
+    EXPECT_LE (pos.x () + 640, workArea.right ());
+
+    foreach (MockPlaceable *w, windows)
+	delete w;
+}
@@ -273,6 +273,9 @@ RingWindow::glPaint (const GLWindowPaintAttrib &attrib,
 				  mTy / mScale - window->y (),
 				  0.0f);
 
+	    gWindow->setDownscaleHint (
+		CompSize (window->inputRect ().width ()  * mScale,
+			  window->inputRect ().height () * mScale));
 	    gWindow->glDraw (wTransform, wAttrib, region,
 			     mask | PAINT_WINDOW_TRANSFORMED_MASK);
 	}
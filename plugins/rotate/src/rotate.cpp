@@ -118,6 +118,13 @@ RotateScreen::releaseMoveWindow ()
     mMoveWindow = None;
 }
 
+void
+RotateScreen::toggleFunctions (bool enabled)
+{
+    cScreen->preparePaintSetEnabled (this, enabled);
+    cScreen->donePaintSetEnabled (this, enabled);
+}
+
 void 
 RotateScreen::preparePaint (int msSinceLastPaint)
 {
@@ -325,6 +332,10 @@ RotateScreen::donePaint ()
 	 mXVelocity || mYVelocity || mProgressVelocity))
 	cScreen->damageScreen ();
 
+    /* the cube is back at rest, stop stepping it */
+    if (!mGrabIndex && !mMoving && !mGrabbed && mProgress == 0.0f)
+	toggleFunctions (false);
+
     cScreen->donePaint ();
 }
 
@@ -383,6 +394,8 @@ RotateScreen::initiate (CompAction         *action,
     mMoving = false;
     mSlow   = false;
 
+    toggleFunctions (true);
+
     /* Set the rotation state for cube - if action is non-NULL,
      * we set it to manual (as we were called from the 'Initiate
      * Rotation' binding. Otherwise, we set it to Change.
@@ -487,6 +500,8 @@ RotateScreen::rotate (CompAction         *action,
     mMoveTo += 360.0f / screen->vpSize ().width () * direction;
     mGrabbed = false;
 
+    toggleFunctions (true);
+
     cScreen->damageScreen ();
 
     return false;
@@ -546,6 +561,8 @@ RotateScreen::rotateWithWindow (CompAction         *action,
 	mMoveTo += 360.0f / screen->vpSize ().width () * direction;
 	mGrabbed = false;
 
+	toggleFunctions (true);
+
 	cScreen->damageScreen ();
     }
 
@@ -670,6 +687,8 @@ RotateScreen::rotateEdgeFlip (CompAction         *action,
 	mMoveTo += 360.0f / screen->vpSize ().width () * direction;
 	mSlow    = true;
 
+	toggleFunctions (true);
+
 	if (state & CompAction::StateInitEdge)
 	    action->setState (action->state () | CompAction::StateTermEdge);
 
@@ -1001,6 +1020,8 @@ RotateScreen::RotateScreen (CompScreen *s) :
     CompositeScreenInterface::setHandler (cScreen);
     GLScreenInterface::setHandler (gScreen);
     CubeScreenInterface::setHandler (cubeScreen);
+
+    toggleFunctions (false);
 }
 
 RotateWindow::RotateWindow (CompWindow *w) :
@@ -74,6 +74,8 @@ class RotateScreen :
 			     int invert);
 
 	void releaseMoveWindow ();
+
+	void toggleFunctions (bool enabled);
 	
 	bool initiate (CompAction         *action,
 		       CompAction::State  state,
@@ -473,6 +473,9 @@ PrivateScaleWindow::glPaint (const GLWindowPaintAttrib& attrib,
 	    wTransform.translate (tx / scale - window->x (),
 				  ty / scale - window->y (), 0.0f);
 
+	    gWindow->setDownscaleHint (
+		CompSize (window->inputRect ().width ()  * scale,
+			  window->inputRect ().height () * scale));
 	    gWindow->glDraw (wTransform, lastAttrib, region,
 			     mask | PAINT_WINDOW_TRANSFORMED_MASK);
 
@@ -312,6 +312,9 @@ ShiftWindow::glPaint (const GLWindowPaintAttrib &attrib,
 	    wTransform.translate (-window->x () - (window->width () / 2),
 				  -window->y () - (window->height () / 2), 0.0f);
 
+	    gWindow->setDownscaleHint (
+		CompSize (window->inputRect ().width ()  * sscale,
+			  window->inputRect ().height () * sscale));
 	    gWindow->glDraw (wTransform, wAttrib, region,
 			     mask | PAINT_WINDOW_TRANSFORMED_MASK);
 	}
@@ -908,6 +908,9 @@ ThumbScreen::thumbPaintThumb (Thumbnail      *t,
 	   very ugly but necessary until the vertex stage has been made
 	   fully pluggable. */
 	gWindow->glAddGeometrySetCurrentIndex (MAXSHORT);
+	gWindow->setDownscaleHint (
+	    CompSize (w->inputRect ().width ()  * sAttrib.xScale,
+		      w->inputRect ().height () * sAttrib.yScale));
 	gWindow->glDraw (wTransform, sAttrib, infiniteRegion, mask);
 
 	gScreen->setTextureFilter (filter);
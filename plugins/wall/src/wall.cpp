@@ -459,6 +459,7 @@ WallScreen::moveViewport (int    x,
 
     moving          = true;
     focusDefault    = true;
+    toggleFunctions (true);
     boxOutputDevice = screen->outputDeviceForPoint (pointerX, pointerY);
 
     if (optionGetShowSwitcher ())
@@ -744,6 +745,9 @@ WallScreen::initiate (CompAction         *action,
 
     showPreview = optionGetShowSwitcher ();
 
+    if (showPreview)
+	toggleFunctions (true);
+
     return true;
 }
 
@@ -1461,6 +1465,10 @@ WallScreen::donePaint ()
 	grabIndex = 0;
     }
 
+    /* nothing left to animate until the next viewport switch */
+    if (!moving && !showPreview && !boxTimeout)
+	toggleFunctions (false);
+
     cScreen->donePaint ();
 }
 
@@ -1528,6 +1536,13 @@ WallScreen::toggleEdges (bool enabled)
     }
 }
 
+void
+WallScreen::toggleFunctions (bool enabled)
+{
+    cScreen->preparePaintSetEnabled (this, enabled);
+    cScreen->donePaintSetEnabled (this, enabled);
+}
+
 void
 WallScreen::optionChanged (CompOption           *opt,
 			   WallOptions::Options num)
@@ -1642,6 +1657,8 @@ WallScreen::WallScreen (CompScreen *screen) :
     CompositeScreenInterface::setHandler (cScreen);
     GLScreenInterface::setHandler (glScreen);
 
+    toggleFunctions (false);
+
     // HACK: we have to keep libcairo loaded even if wall gets unloaded
     // to prevent crashes in XCloseDisplay
     dlopen ("libcairo.so.2", RTLD_LAZY);
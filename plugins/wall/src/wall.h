@@ -122,6 +122,7 @@ class WallScreen :
 
 	void optionChanged (CompOption *opt, WallOptions::Options num);
 	void toggleEdges (bool);
+	void toggleFunctions (bool);
 
 	void positionUpdate (const CompPoint &pos);
 
@@ -27,6 +27,7 @@
 #include <string.h>
 
 #include <boost/foreach.hpp>
+#include <boost/bind.hpp>
 #define foreach BOOST_FOREACH
 
 #include <core/screen.h>
@@ -39,6 +40,11 @@
 
 const CompMatch CompMatch::emptyMatch;
 
+namespace cm = compiz::match;
+
+static cm::AtomTable         atomTable;
+static CompMatch::Statistics matchStatistics;
+
 class CoreExp : public CompMatch::Expression {
     public:
 	virtual ~CoreExp () {};
@@ -156,6 +162,9 @@ CompScreen::matchExpHandlerChanged ()
 void
 CompScreenImpl::_matchExpHandlerChanged ()
 {
+    /* The same string may yield a different expression now */
+    atomTable.expire ();
+
     foreach (CompPlugin *p, CompPlugin::getPlugins ())
     {
 	CompOption::Vector &options = p->vTable->getOptions ();
@@ -166,6 +175,11 @@ CompScreenImpl::_matchExpHandlerChanged ()
 void
 CompScreen::matchPropertyChanged (CompWindow *w)
 {
+    /* Plugins evaluate matches before passing this on,
+     * so drop the stale results before every handler */
+    if (w)
+	PrivateWindow::matchResultCache (w).invalidate ();
+
     WRAPABLE_HND_FUNCTN (matchPropertyChanged, w);
     _matchPropertyChanged (w);
 }
@@ -188,7 +202,10 @@ matchResetOps (MatchOp::List &list)
 	    case MatchOp::TypeExp:
 		exp = dynamic_cast <MatchExpOp *> (op);
 		if (exp && exp->e)
+		{
 		    exp->e.reset ();
+		    exp->atom = 0;
+		}
 		break;
 	    default:
 		break;
@@ -454,7 +471,10 @@ matchUpdateOps (MatchOp::List &list)
 	    case MatchOp::TypeExp:
 		exp = dynamic_cast <MatchExpOp *> (op);
 		if (exp && screen)
-		    exp->e.reset (screen->matchInitExp (exp->value));
+		    exp->e = atomTable.get (exp->value,
+					    boost::bind (&CompScreen::matchInitExp,
+							 screen, _1),
+					    exp->atom);
 		break;
 	    default:
 		break;
@@ -462,17 +482,88 @@ matchUpdateOps (MatchOp::List &list)
     }
 }
 
-static bool
-matchEvalOps (MatchOp::List &list,
-	      const CompWindow *w)
+static void
+matchCompileOps (MatchOp::List                 &list,
+		 std::vector<MatchInstruction> &program)
 {
-    bool       value, result = false;
     MatchExpOp *exp;
 
     foreach (MatchOp *op, list)
     {
+	MatchInstruction instruction;
+	unsigned int     index = program.size ();
+
+	instruction.flags = op->flags;
+	instruction.group = false;
+	instruction.e     = NULL;
+	instruction.atom  = 0;
+
+	switch (op->type ()) {
+	    case MatchOp::TypeGroup:
+		instruction.group = true;
+		program.push_back (instruction);
+		matchCompileOps (dynamic_cast <MatchGroupOp *> (op)->op,
+				 program);
+		break;
+	    case MatchOp::TypeExp:
+		exp = dynamic_cast <MatchExpOp *> (op);
+		instruction.e    = exp->e.get ();
+		instruction.atom = exp->atom;
+		program.push_back (instruction);
+		break;
+	    default:
+		/* Evaluates to true, just like an expression
+		 * without handler */
+		program.push_back (instruction);
+		break;
+	}
+
+	program[index].end = program.size ();
+    }
+}
+
+static bool
+matchEvalExpression (const MatchInstruction &instruction,
+		     const CompWindow       *w)
+{
+    bool value;
+
+    if (!instruction.e)
+	return true;
+
+    if (!w)
+	return instruction.e->evaluate (w);
+
+    cm::ResultCache &cache = PrivateWindow::matchResultCache (w);
+
+    if (cache.lookup (instruction.atom, value))
+    {
+	++matchStatistics.cacheHits;
+	return value;
+    }
+
+    ++matchStatistics.expressionEvaluations;
+
+    value = instruction.e->evaluate (w);
+    cache.store (instruction.atom, value);
+
+    return value;
+}
+
+static bool
+matchEvalProgram (const std::vector<MatchInstruction> &program,
+		  unsigned int                        begin,
+		  unsigned int                        end,
+		  const CompWindow                    *w)
+{
+    bool value, result = false;
+
+    for (unsigned int i = begin; i < end; i = program[i].end)
+    {
+	const MatchInstruction &instruction = program[i];
+
 	/* fast evaluation */
-	if (op->flags & MATCH_OP_AND_MASK)
+	if (instruction.flags & MATCH_OP_AND_MASK)
 	{
 	    /* result will never be true */
 	    if (!result)
@@ -485,27 +576,15 @@ matchEvalOps (MatchOp::List &list,
 		return true;
 	}
 
-	switch (op->type ()) {
-	    case MatchOp::TypeGroup:
-		value =
-		    matchEvalOps (dynamic_cast <MatchGroupOp *> (op)->op, w);
-		break;
-	    case MatchOp::TypeExp:
-		exp = dynamic_cast <MatchExpOp *> (op);
-		if (exp->e.get ())
-		    value = exp->e->evaluate (w);
-		else
-		    value = true;
-		break;
-	    default:
-		value = true;
-		break;
-	}
+	if (instruction.group)
+	    value = matchEvalProgram (program, i + 1, instruction.end, w);
+	else
+	    value = matchEvalExpression (instruction, w);
 
-	if (op->flags & MATCH_OP_NOT_MASK)
+	if (instruction.flags & MATCH_OP_NOT_MASK)
 	    value = !value;
 
-	if (op->flags & MATCH_OP_AND_MASK)
+	if (instruction.flags & MATCH_OP_AND_MASK)
 	    result = (result && value);
 	else
 	    result = (result || value);
@@ -514,6 +593,12 @@ matchEvalOps (MatchOp::List &list,
     return result;
 }
 
+void
+cm::countEvent ()
+{
+    ++matchStatistics.events;
+}
+
 MatchOp::MatchOp () :
     flags (0)
 {
@@ -525,13 +610,15 @@ MatchOp::~MatchOp ()
 
 MatchExpOp::MatchExpOp () :
     value (""),
-    e ()
+    e (),
+    atom (0)
 {
 }
 
 MatchExpOp::MatchExpOp (const MatchExpOp &ex) :
     value (ex.value),
-    e (ex.e)
+    e (ex.e),
+    atom (ex.atom)
 {
     flags = ex.flags;
 }
@@ -590,6 +677,13 @@ PrivateMatch::PrivateMatch () :
 {
 }
 
+void
+PrivateMatch::compile ()
+{
+    program.clear ();
+    matchCompileOps (op.op, program);
+}
+
 
 CompMatch::CompMatch () :
     priv (new PrivateMatch ())
@@ -620,12 +714,16 @@ CompMatch::update ()
 {
     matchResetOps (priv->op.op);
     matchUpdateOps (priv->op.op);
+    priv->compile ();
 }
 
 bool
 CompMatch::evaluate (const CompWindow *window) const
 {
-    return matchEvalOps (priv->op.op, window);
+    ++matchStatistics.evaluations;
+
+    return matchEvalProgram (priv->program, 0, priv->program.size (),
+			     window);
 }
 
 CompString
@@ -757,3 +855,15 @@ CompMatch::operator!= (const CompMatch &match) const
 {
     return !(*this == match);
 }
+
+const CompMatch::Statistics &
+CompMatch::statistics ()
+{
+    return matchStatistics;
+}
+
+void
+CompMatch::resetStatistics ()
+{
+    matchStatistics = Statistics ();
+}
@@ -0,0 +1,103 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "matchcache.h"
+
+namespace cm = compiz::match;
+
+bool
+cm::ResultCache::lookup (AtomId atom, bool &result) const
+{
+    if (atom >= mResults.size () || mResults[atom] == Unknown)
+	return false;
+
+    result = (mResults[atom] == True);
+    return true;
+}
+
+void
+cm::ResultCache::store (AtomId atom, bool result)
+{
+    if (!atom)
+	return;
+
+    if (atom >= mResults.size ())
+	mResults.resize (atom + 1, Unknown);
+
+    mResults[atom] = result ? True : False;
+}
+
+void
+cm::ResultCache::invalidate ()
+{
+    mResults.clear ();
+}
+
+cm::AtomTable::AtomTable () :
+    mNextId (1)
+{
+}
+
+cm::AtomTable::Expression
+cm::AtomTable::get (const CompString &value,
+		    const Factory    &factory,
+		    AtomId           &id)
+{
+    std::map <CompString, Atom>::iterator it = mAtoms.find (value);
+
+    if (it != mAtoms.end ())
+    {
+	Expression expression (it->second.expression.lock ());
+
+	if (expression)
+	{
+	    id = it->second.id;
+	    return expression;
+	}
+    }
+
+    Expression expression (factory (value));
+
+    if (!expression)
+    {
+	id = 0;
+	return expression;
+    }
+
+    Atom &atom = mAtoms[value];
+
+    atom.id = id = mNextId++;
+    atom.expression = expression;
+
+    return expression;
+}
+
+void
+cm::AtomTable::expire ()
+{
+    mAtoms.clear ();
+}
+
+unsigned int
+cm::AtomTable::size () const
+{
+    return mAtoms.size ();
+}
@@ -0,0 +1,109 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _COMPIZ_MATCHCACHE_H
+#define _COMPIZ_MATCHCACHE_H
+
+#include <map>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <core/match.h>
+
+namespace compiz
+{
+namespace match
+{
+
+/* Identifies one expression instance. Ids are never reused, so
+ * a cached result can never be mistaken for the result of a
+ * different expression. Zero means "no expression" */
+typedef unsigned int AtomId;
+
+/*
+ * Memoized expression results for a single window. They stay
+ * valid until the window's match properties change.
+ */
+class ResultCache
+{
+    public:
+
+	bool lookup (AtomId atom, bool &result) const;
+	void store (AtomId atom, bool result);
+	void invalidate ();
+
+    private:
+
+	enum
+	{
+	    Unknown = 0,
+	    False,
+	    True
+	};
+
+	std::vector <unsigned char> mResults;
+};
+
+/*
+ * Interns match expressions by their string, so that every
+ * CompMatch containing the same expression shares one instance,
+ * and with it one result slot in each window's ResultCache.
+ */
+class AtomTable
+{
+    public:
+
+	typedef boost::function <CompMatch::Expression * (const CompString &)> Factory;
+	typedef boost::shared_ptr <CompMatch::Expression> Expression;
+
+	AtomTable ();
+
+	/* Returns the live instance for value, or a new one made
+	 * by factory */
+	Expression get (const CompString &value,
+			const Factory    &factory,
+			AtomId           &id);
+
+	/* Stop handing out the current instances, used when the
+	 * expression handlers change */
+	void expire ();
+
+	unsigned int size () const;
+
+    private:
+
+	struct Atom
+	{
+	    AtomId                                  id;
+	    boost::weak_ptr <CompMatch::Expression> expression;
+	};
+
+	std::map <CompString, Atom> mAtoms;
+	AtomId                      mNextId;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "postqueue.h"
+
+namespace cc = compiz::core;
+
+struct cc::PostQueue::Node
+{
+    Node    *next;
+    Closure closure;
+};
+
+/* The queue always holds one node whose closure has already been
+ * taken, mTail. Popping takes the closure of the node after it,
+ * which then becomes the new mTail */
+cc::PostQueue::PostQueue () :
+    mHead (new Node),
+    mTail (mHead),
+    mPending (0),
+    mFd (eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC))
+{
+    mHead->next = NULL;
+}
+
+cc::PostQueue::~PostQueue ()
+{
+    while (mTail)
+    {
+	Node *next = mTail->next;
+	delete mTail;
+	mTail = next;
+    }
+
+    if (mFd != -1)
+	close (mFd);
+}
+
+int
+cc::PostQueue::fd () const
+{
+    return mFd;
+}
+
+void
+cc::PostQueue::post (const Closure &closure)
+{
+    Node *node = new Node;
+
+    node->next = NULL;
+    node->closure = closure;
+
+    /* Between these two steps the node is not reachable from mTail
+     * yet, pop () just sees the queue end early until it is */
+    Node *prev = __atomic_exchange_n (&mHead, node, __ATOMIC_ACQ_REL);
+    __atomic_store_n (&prev->next, node, __ATOMIC_RELEASE);
+
+    /* Only the first post since the last run needs to wake the owner */
+    if (__atomic_exchange_n (&mPending, 1, __ATOMIC_ACQ_REL) || mFd == -1)
+	return;
+
+    uint64_t one = 1;
+
+    while (write (mFd, &one, sizeof (one)) == -1 && errno == EINTR);
+}
+
+cc::PostQueue::Node *
+cc::PostQueue::pop (Closure &closure)
+{
+    Node *tail = mTail;
+    Node *next = __atomic_load_n (&tail->next, __ATOMIC_ACQUIRE);
+
+    if (!next)
+	return NULL;
+
+    closure.swap (next->closure);
+    mTail = next;
+    delete tail;
+
+    return next;
+}
+
+unsigned int
+cc::PostQueue::run ()
+{
+    /* Drain the eventfd before clearing mPending: a post which
+     * sees mPending still set is then picked up below, one which
+     * sees it cleared signals the eventfd again */
+    if (mFd != -1)
+    {
+	uint64_t count;
+
+	while (read (mFd, &count, sizeof (count)) == -1 && errno == EINTR);
+    }
+
+    __atomic_exchange_n (&mPending, 0, __ATOMIC_ACQ_REL);
+
+    Node         *last = __atomic_load_n (&mHead, __ATOMIC_ACQUIRE);
+    unsigned int n = 0;
+    Closure      closure;
+
+    while (Node *node = pop (closure))
+    {
+	++n;
+	closure ();
+	closure.clear ();
+
+	if (node == last)
+	    break;
+    }
+
+    return n;
+}
@@ -0,0 +1,79 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _COMPIZ_POSTQUEUE_H
+#define _COMPIZ_POSTQUEUE_H
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace compiz
+{
+namespace core
+{
+
+/* A queue of closures which any thread may post to and which
+ * the thread owning it runs, usually the main loop.
+ *
+ * Posting never takes a lock: a closure is linked in with a single
+ * atomic exchange. The first post after the queue was last run also
+ * makes fd () readable, so the owner only needs to watch that for
+ * POLLIN and call run () when it is. */
+class PostQueue :
+    boost::noncopyable
+{
+    public:
+
+	typedef boost::function <void ()> Closure;
+
+	PostQueue ();
+	~PostQueue ();
+
+	/* An eventfd which is readable while closures are waiting,
+	 * or -1 if it could not be created */
+	int fd () const;
+
+	/* Safe to call from any thread */
+	void post (const Closure &closure);
+
+	/* Runs the closures posted so far in the order they were posted
+	 * and returns how many were run. Closures they post in turn wait
+	 * for the next call. Only the owning thread may call this */
+	unsigned int run ();
+
+    private:
+
+	struct Node;
+
+	Node * pop (Closure &closure);
+
+	/* Producers exchange themselves into mHead, the
+	 * consumer follows the links from mTail */
+	Node *mHead;
+	Node *mTail;
+	int  mPending;
+	int  mFd;
+};
+
+}
+}
+
+#endif
@@ -56,12 +56,17 @@ class CompWatchFd :
 
     private:
 
+	bool		 drop ();
+
 	int		  mFd;
+	Glib::IOCondition mEvents;
 	FdWatchCallBack   mCallBack;
 	CompWatchFdHandle mHandle;
 	bool		  mForceFail;
 	bool		  mExecuting;
 
+	::compiz::private_screen::EventManager *mEventManager;
+
     friend class ::compiz::private_screen::EventManager;
 };
 
@@ -30,6 +30,9 @@
 
 #include <core/match.h>
 #include <boost/shared_ptr.hpp>
+#include <vector>
+
+#include "matchcache.h"
 
 #define MATCH_OP_AND_MASK (1 << 0)
 #define MATCH_OP_NOT_MASK (1 << 1)
@@ -62,6 +65,7 @@ class MatchExpOp : public MatchOp {
 	CompString	      value;
 
 	boost::shared_ptr<CompMatch::Expression> e;
+	compiz::match::AtomId                    atom;
 };
 
 class MatchGroupOp : public MatchOp {
@@ -77,12 +81,34 @@ class MatchGroupOp : public MatchOp {
 	MatchOp::List op;
 };
 
+/* One op of a match flattened into an array. Groups are followed
+ * by their children, end is the index after the last of them */
+struct MatchInstruction {
+    unsigned int          flags;
+    bool                  group;
+    unsigned int          end;
+    CompMatch::Expression *e;
+    compiz::match::AtomId atom;
+};
+
 class PrivateMatch {
     public:
 	PrivateMatch ();
 
+	void compile ();
+
     public:
 	MatchGroupOp op;
+
+	std::vector<MatchInstruction> program;
 };
 
+namespace compiz
+{
+namespace match
+{
+void countEvent ();
+}
+}
+
 #endif
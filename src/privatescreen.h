@@ -34,8 +34,10 @@
 #include <core/timer.h>
 #include <core/plugin.h>
 #include <core/servergrab.h>
+#include <core/threadpool.h>
 #include <time.h>
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
 
 #include <glibmm/main.h>
 
@@ -44,6 +46,8 @@
 #include "privateeventsource.h"
 #include "privatesignalsource.h"
 #include "outputdevices.h"
+#include "stackingorder.h"
+#include "postqueue.h"
 
 #include "core_options.h"
 
@@ -129,14 +133,19 @@ class WindowManager : boost::noncopyable
 
 	void updateClientList (PrivateScreen& ps);
 
+	/* Defer writing the client list properties until the
+	 * matching release, nests like RestackBatch */
+	void freezeClientList () { clientListFreezeCount++; }
+	void releaseClientList (PrivateScreen& ps);
+
 	void addToDestroyedWindows(CompWindow * cw)
 	    { destroyedWindows.push_back (cw); }
 
 	void incrementPendingDestroys() { pendingDestroys++; }
 	const CompWindowVector& getClientList () const
-	    { return clientList; }
+	    { validateClientList (); return clientList; }
 	const CompWindowVector& getClientListStacking () const
-	    { return clientListStacking; }
+	    { validateClientList (); return clientListStacking; }
 
 	CompWindow * findWindow (Window id) const;
 	CompWindow * getTopWindow() const;
@@ -163,6 +172,8 @@ class WindowManager : boost::noncopyable
 	void unhookWindow (CompWindow *w);
 	CompWindowList& getWindows()	{ return windows; }
 
+	int compareStacking (const CompWindow *a, const CompWindow *b) const;
+
 	CompWindowList& getDestroyedWindows()	{ return destroyedWindows; }
 
 	void insertServerWindow(CompWindow* w, Window aboveId);
@@ -194,7 +205,11 @@ class WindowManager : boost::noncopyable
 	}
 
     private:
+	void validateClientList () const;
+	void flushClientList (PrivateScreen& ps);
+
 	CompWindowList windows;
+	compiz::window::StackingOrder stackingOrder; /* labels for windows */
 	CompWindowList serverWindows;
 	CompWindowList destroyedWindows;
 	bool           stackIsFresh;
@@ -202,11 +217,16 @@ class WindowManager : boost::noncopyable
 	CompWindow::Map windowsMap;
 	std::list<CompGroup *> groups;
 
-	CompWindowVector clientList;            /* clients in mapping order */
-	CompWindowVector clientListStacking;    /* clients in stacking order */
+	/* rebuilt on demand from the window stack */
+	mutable CompWindowVector clientList;            /* clients in mapping order */
+	mutable CompWindowVector clientListStacking;    /* clients in stacking order */
+	mutable bool             clientListDirty;
 
+	/* contents of the root window properties */
 	std::vector<Window> clientIdList;        /* client ids in mapping order */
 	std::vector<Window> clientIdListStacking;/* client ids in stacking order */
+	bool                clientListPropertiesDirty;
+	unsigned int        clientListFreezeCount;
 
 	unsigned int pendingDestroys;
 
@@ -288,6 +308,18 @@ class EventManager :
 
 	void removeWatchFd (CompWatchFdHandle handle);
 
+	/* Drops the handle of a source glib is already destroying */
+	void forgetWatchFd (CompWatchFdHandle handle);
+
+	bool hasWatchFd (CompWatchFdHandle handle) const
+	{
+	    return watchFds.find (handle) != watchFds.end ();
+	}
+
+	void postToMainLoop (const MainLoopCallBack &callBack);
+
+	compiz::core::ThreadPool & getThreadPool () { return threadPool; }
+
 	CompFileWatch* addFileWatch (
 	    const char        *path,
 	    int               mask,
@@ -319,16 +351,25 @@ class EventManager :
 	CompSignalSource *sighupSource;
 	CompSignalSource *sigtermSource;
 	CompSignalSource *sigintSource;
+	CompSignalSource *sigusr1Source;
 	Glib::RefPtr <Glib::MainContext> ctx;
 
 	CompFileWatchList   fileWatch;
 	CompFileWatchHandle lastFileWatchHandle;
 
-	// TODO - almost certainly the wrong data structure
-	// Why not a std::map<CompWatchFdHandle, CompWatchFd>?
-	std::list<Glib::RefPtr<CompWatchFd> > watchFds;
+	typedef boost::unordered_map <CompWatchFdHandle,
+				      Glib::RefPtr <CompWatchFd> > WatchFdMap;
+
+	WatchFdMap               watchFds;
 	CompWatchFdHandle        lastWatchFdHandle;
 
+	/* Closures posted from other threads, run from a watch on its fd */
+	compiz::core::PostQueue  postQueue;
+	CompWatchFdHandle        postQueueWatch;
+
+	/* Posts continuations to postQueue, so it is declared after it */
+	compiz::core::ThreadPool threadPool;
+
         bool	grabbed;   /* true once we receive a GrabNotify
 			      on FocusOut and false on
 			      UngrabNotify from FocusIn */
@@ -861,6 +902,13 @@ class CompScreenImpl : public CompScreen,
 
 	void removeWatchFd (CompWatchFdHandle handle);
 
+	void postToMainLoop (const MainLoopCallBack &callBack);
+
+	compiz::core::TaskHandle runTask (const MainLoopCallBack &work,
+					  const MainLoopCallBack &continuation,
+					  CompWindow             *owner);
+	compiz::core::ThreadPool & threadPool ();
+
 	void storeValue (CompString key, CompPrivate value);
 	bool hasValue (CompString key);
 	CompPrivate getValue (CompString key);
@@ -1060,6 +1108,7 @@ class CompScreenImpl : public CompScreen,
 	virtual bool displayInitialised() const;
 	virtual void applyStartupProperties (CompWindow *window);
 	virtual void updateClientList();
+	virtual int compareStacking (const CompWindow *a, const CompWindow *b) const;
 	virtual CompWindow * getTopWindow() const;
 	virtual CompWindow * getTopServerWindow() const;
 	virtual CoreOptions& getCoreOptions();
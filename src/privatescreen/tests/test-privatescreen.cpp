@@ -10,6 +10,8 @@
 #include <gmock/gmock.h>
 
 #include <stdlib.h>
+#include <poll.h>
+#include <unistd.h>
 
 using ::testing::Return;
 using ::testing::ReturnRef;
@@ -122,6 +124,11 @@ public:
 				      short int       events,
 				      FdWatchCallBack callBack));
     MOCK_METHOD1(removeWatchFd, void (CompWatchFdHandle handle));
+    MOCK_METHOD1(postToMainLoop, void (const MainLoopCallBack &callBack));
+    MOCK_METHOD3(runTask, compiz::core::TaskHandle (const MainLoopCallBack &work,
+						    const MainLoopCallBack &continuation,
+						    CompWindow             *owner));
+    MOCK_METHOD0(threadPool, compiz::core::ThreadPool & ());
     MOCK_METHOD0(eventLoop, void ());
     MOCK_METHOD3(addFileWatch, CompFileWatchHandle (const char        *path,
 					  int               mask,
@@ -188,6 +195,7 @@ public:
     MOCK_CONST_METHOD0(displayInitialised, bool ());
     MOCK_METHOD1(applyStartupProperties, void (CompWindow *window));
     MOCK_METHOD0(updateClientList, void ());
+    MOCK_CONST_METHOD2(compareStacking, int (const CompWindow *, const CompWindow *));
     MOCK_CONST_METHOD0(getTopWindow, CompWindow * ());
     MOCK_CONST_METHOD0(getTopServerWindow, CompWindow * ());
     MOCK_METHOD0(getCoreOptions, CoreOptions& ());
@@ -763,6 +771,92 @@ TEST(privatescreen_EventManagerTest, init)
     em.init();
 }
 
+namespace
+{
+void
+recordWatchFdEvents (short int    revents,
+		     short int    *received,
+		     unsigned int *calls)
+{
+    *received = revents;
+    ++(*calls);
+}
+}
+
+class privatescreen_EventManagerWatchFdTest :
+    public ::testing::Test
+{
+    public:
+
+	virtual void SetUp ()
+	{
+	    using namespace testing;
+
+	    initialPlugins = std::list <CompString>();
+
+	    EXPECT_CALL(comp_screen, addAction(_)).WillRepeatedly(Return(false));
+	    EXPECT_CALL(comp_screen, removeAction(_)).WillRepeatedly(Return());
+	    EXPECT_CALL(comp_screen, _matchInitExp(StrEq("any"))).WillRepeatedly(Return((CompMatch::Expression*)0));
+	    EXPECT_CALL(comp_screen, dpy()).WillRepeatedly(Return((Display*)(0)));
+
+	    em.init ();
+
+	    ASSERT_EQ (0, pipe (fds));
+	}
+
+	/* Closing the read end makes glib poll an invalid descriptor */
+	void CloseAndDispatch (CompWatchFdHandle handle)
+	{
+	    close (fds[0]);
+	    close (fds[1]);
+
+	    for (unsigned int i = 0; i < 10 && em.hasWatchFd (handle); ++i)
+		g_main_context_iteration (NULL, FALSE);
+	}
+
+	MockCompScreen    comp_screen;
+	cps::EventManager em;
+	int               fds[2];
+};
+
+TEST_F(privatescreen_EventManagerWatchFdTest, DroppedAfterReportingInvalidFd)
+{
+    short int    received = 0;
+    unsigned int calls = 0;
+
+    CompWatchFdHandle handle =
+	em.addWatchFd (fds[0], POLLIN | POLLNVAL,
+		       boost::bind (recordWatchFdEvents, _1, &received, &calls));
+
+    ASSERT_TRUE (em.hasWatchFd (handle));
+
+    CloseAndDispatch (handle);
+
+    EXPECT_EQ (1u, calls);
+    EXPECT_TRUE (received & POLLNVAL);
+    EXPECT_FALSE (em.hasWatchFd (handle));
+
+    /* Removing it again afterwards is harmless */
+    em.removeWatchFd (handle);
+}
+
+TEST_F(privatescreen_EventManagerWatchFdTest, DroppedSilentlyOnInvalidFdUnlessAsked)
+{
+    short int    received = 0;
+    unsigned int calls = 0;
+
+    CompWatchFdHandle handle =
+	em.addWatchFd (fds[0], POLLIN,
+		       boost::bind (recordWatchFdEvents, _1, &received, &calls));
+
+    ASSERT_TRUE (em.hasWatchFd (handle));
+
+    CloseAndDispatch (handle);
+
+    EXPECT_EQ (0u, calls);
+    EXPECT_FALSE (em.hasWatchFd (handle));
+}
+
 TEST(privatescreen_ViewportGeometryTest, PickCurrent)
 {
     CompPoint vp;
@@ -32,6 +32,9 @@
 #include <core/window.h>
 #include <core/point.h>
 #include <core/timer.h>
+#include <core/threadpool.h>
+
+#include <stdint.h>
 
 #include <boost/shared_ptr.hpp>
 
@@ -39,6 +42,8 @@
 
 #include "syncserverwindow.h"
 #include "asyncserverwindow.h"
+#include "matchcache.h"
+#include "stackingorder.h"
 
 #define XWINDOWCHANGES_INIT {0, 0, 0, 0, 0, None, 0}
 
@@ -150,6 +155,8 @@ class PrivateWindow :
 					unsigned int valueMask);
 	int  requestConfigureOnFrame (const XWindowChanges &xwc,
 				      unsigned int valueMask);
+	void sendConfigureOnFrame (const XWindowChanges &xwc,
+				   unsigned int valueMask);
 	void sendSyntheticConfigureNotify ();
 	bool hasCustomShape () const;
 
@@ -157,6 +164,8 @@ class PrivateWindow :
 
 	bool updateFrameWindow ();
 
+	bool restackPending ();
+
 	void setWindowMatrix ();
 
 	bool restack (Window aboveId);
@@ -331,10 +340,21 @@ class PrivateWindow :
 	void setOverrideRedirect (bool overrideRedirect);
 
 	void readIconHint ();
+	void readIconSizes ();
+	CompIcon * readIcon (unsigned int index);
 
 	bool checkClear ();
 
+	void addTask (const compiz::core::TaskHandle &task);
+	void cancelTasks ();
+
 	static CompWindow* createCompWindow (Window aboveId, Window aboveServerId, XWindowAttributes &wa, Window id);
+
+	static compiz::match::ResultCache & matchResultCache (const CompWindow *w)
+	{
+	    return w->priv->matchResults;
+	}
+
     public:
 
 	PrivateWindow *priv;
@@ -432,11 +452,21 @@ class PrivateWindow :
 
 	CompStruts *struts;
 
+	/* Sizes of the icons a window has and where their pixels start in
+	 * iconPixels, as read from _NET_WM_ICON. The pixels are only
+	 * converted once an icon is used, icons holds NULL until then. */
+	std::vector<CompSize>   iconSizes;
+	std::vector<long>       iconOffsets;
+	std::vector<uint32_t>   iconPixels;
 	std::vector<CompIcon *> icons;
 	bool noIcons;
 
 	CompRect   iconGeometry;
 
+	/* Tasks from CompScreen::runTask owned by this window,
+	 * finished ones are dropped as new ones are added */
+	std::list<compiz::core::TaskHandle> tasks;
+
 	XWindowChanges saveWc;
 	int		   saveMask;
 
@@ -455,6 +485,12 @@ class PrivateWindow :
 
 	X11SyncServerWindow                            syncServerWindow;
 	compiz::window::configure_buffers::Buffer::Ptr configureBuffer;
+
+	compiz::match::ResultCache matchResults;
+
+	/* Position in the screen's stacking order index, NULL
+	 * while the window is not in the stack */
+	compiz::window::StackingOrder::Handle stackingHandle;
 };
 
 #endif
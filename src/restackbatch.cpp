@@ -0,0 +1,156 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "restackbatch.h"
+
+namespace crb = compiz::window::configure_buffers;
+
+namespace
+{
+    const unsigned int StackMask = CWStackMode | CWSibling;
+}
+
+crb::RestackBatch::RestackBatch () :
+    mFreezeCount (0)
+{
+}
+
+crb::RestackBatch &
+crb::RestackBatch::Default ()
+{
+    static RestackBatch batch;
+
+    return batch;
+}
+
+void
+crb::RestackBatch::freeze ()
+{
+    ++mFreezeCount;
+}
+
+void
+crb::RestackBatch::release ()
+{
+    if (!mFreezeCount)
+	return;
+
+    if (!--mFreezeCount)
+	flush ();
+}
+
+bool
+crb::RestackBatch::frozen () const
+{
+    return mFreezeCount != 0;
+}
+
+crb::RestackBatch::EntryList::iterator
+crb::RestackBatch::find (Window window)
+{
+    for (EntryList::iterator it = mEntries.begin (); it != mEntries.end (); ++it)
+	if (it->window == window)
+	    return it;
+
+    return mEntries.end ();
+}
+
+bool
+crb::RestackBatch::referencedAfter (EntryList::iterator it)
+{
+    Window window = it->window;
+
+    for (++it; it != mEntries.end (); ++it)
+	if (it->valueMask & CWSibling && it->xwc.sibling == window)
+	    return true;
+
+    return false;
+}
+
+bool
+crb::RestackBatch::add (Window               window,
+			const XWindowChanges &xwc,
+			unsigned int         valueMask,
+			const Request        &request)
+{
+    if (!mFreezeCount || !(valueMask & StackMask))
+	return false;
+
+    EntryList::iterator it = find (window);
+    Entry               entry;
+
+    entry.window    = window;
+    entry.xwc       = xwc;
+    entry.valueMask = valueMask;
+    entry.request   = request;
+
+    /* Restacking the window again makes its queued request useless,
+     * unless someone was stacked relative to it since then. The
+     * others are not affected by where this window sits, so the
+     * newer request can go to the end of the queue instead */
+    if (it != mEntries.end () && !referencedAfter (it))
+	mEntries.erase (it);
+
+    mEntries.push_back (entry);
+
+    return true;
+}
+
+bool
+crb::RestackBatch::pending (Window window) const
+{
+    for (EntryList::const_iterator it = mEntries.begin ();
+	 it != mEntries.end (); ++it)
+	if (it->window == window)
+	    return true;
+
+    return false;
+}
+
+void
+crb::RestackBatch::remove (Window window)
+{
+    EntryList::iterator it = mEntries.begin ();
+
+    while (it != mEntries.end ())
+    {
+	if (it->window == window)
+	    it = mEntries.erase (it);
+	else
+	    ++it;
+    }
+}
+
+void
+crb::RestackBatch::flush ()
+{
+    /* Requests sent from here must not end up in the queue again */
+    EntryList entries;
+    unsigned int freezeCount = mFreezeCount;
+
+    entries.swap (mEntries);
+    mFreezeCount = 0;
+
+    for (EntryList::iterator it = entries.begin (); it != entries.end (); ++it)
+	it->request (it->xwc, it->valueMask);
+
+    mFreezeCount = freezeCount;
+}
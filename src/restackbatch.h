@@ -0,0 +1,94 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _COMPIZ_RESTACKBATCH_H
+#define _COMPIZ_RESTACKBATCH_H
+
+#include <list>
+
+#include <boost/function.hpp>
+#include <X11/Xlib.h>
+
+namespace compiz
+{
+namespace window
+{
+namespace configure_buffers
+{
+
+/* Collects the configure requests which restack windows while
+ * frozen and sends them when the last freeze is released.
+ *
+ * A window restacked again while its previous request is still
+ * queued only gets the newer request, unless another queued
+ * request was stacked relative to it in the meantime. */
+class RestackBatch
+{
+    public:
+
+	typedef boost::function <void (const XWindowChanges &,
+				       unsigned int)> Request;
+
+	RestackBatch ();
+
+	static RestackBatch & Default ();
+
+	void freeze ();
+	void release ();
+	bool frozen () const;
+
+	/* Returns false if the request was not queued and should
+	 * be sent by the caller right away. Requests without any
+	 * stacking changes are never queued */
+	bool add (Window               window,
+		  const XWindowChanges &xwc,
+		  unsigned int         valueMask,
+		  const Request        &request);
+
+	bool pending (Window window) const;
+	void remove (Window window);
+
+	void flush ();
+
+    private:
+
+	struct Entry
+	{
+	    Window         window;
+	    XWindowChanges xwc;
+	    unsigned int   valueMask;
+	    Request        request;
+	};
+
+	typedef std::list <Entry> EntryList;
+
+	EntryList::iterator find (Window window);
+	bool referencedAfter (EntryList::iterator it);
+
+	EntryList    mEntries;
+	unsigned int mFreezeCount;
+};
+
+}
+}
+}
+
+#endif
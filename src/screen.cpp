@@ -61,7 +61,11 @@
 #include "privatescreen.h"
 #include "privatewindow.h"
 #include "privateaction.h"
+#include "privatematch.h"
 #include "privatestackdebugger.h"
+#include "restackbatch.h"
+
+#include <core/trace.h>
 
 template class WrapableInterface<CompScreen, ScreenInterface>;
 
@@ -93,6 +97,7 @@ typedef struct {
 
 namespace cps = compiz::private_screen;
 namespace ca = compiz::actions;
+namespace crb = compiz::window::configure_buffers;
 
 
 
@@ -150,6 +155,17 @@ cps::EventManager::handleSignal (int signum)
 	    restartSignal = true;
 	    mainloop->quit ();
 	    break;
+	case SIGUSR1:
+	{
+	    CompString path = compiz::trace::dump ();
+
+	    if (path.empty ())
+		compLogMessage ("core", CompLogLevelWarn, "failed to write trace");
+	    else
+		compLogMessage ("core", CompLogLevelInfo, "trace written to %s", path.c_str ());
+
+	    return;
+	}
 	default:
 	    break;
     }
@@ -166,11 +182,21 @@ CompScreenImpl::eventLoop ()
 void
 cps::EventManager::startEventLoop(Display* dpy)
 {
+    /* Both sources have the same priority, so glib dispatches them in
+     * the order they were attached. Attach the X event source first, so
+     * that when input and a repaint become ready at the same time the
+     * input is handled first and the frame already reflects it, rather
+     * than waiting behind a whole frame of painting.
+     *
+     * This only changes the order of the sources. Painting stays on
+     * this thread: the GL context is current here, and every paint stage
+     * is a wrapable hook that reads live plugin state, so a frame can't
+     * be handed to another thread */
     source = CompEventSource::create ();
-    timeout = CompTimeoutSource::create (ctx);
-
     source->attach (ctx);
 
+    timeout = CompTimeoutSource::create (ctx);
+
     XFlush (dpy);
 
     mainloop->run();
@@ -258,11 +284,15 @@ cps::EventManager::getFileWatches () const
 CompWatchFd::CompWatchFd (int		    fd,
 			  Glib::IOCondition events,
 			  FdWatchCallBack   callback) :
-    Glib::IOSource (fd, events),
+    /* Always poll for an invalid fd, a source only dispatches on events
+     * it asked for and would otherwise keep polling a dead descriptor */
+    Glib::IOSource (fd, events | Glib::IO_NVAL),
     mFd (fd),
+    mEvents (events),
     mCallBack (callback),
     mForceFail (false),
-    mExecuting (false)
+    mExecuting (false),
+    mEventManager (NULL)
 {
     connect (sigc::mem_fun <Glib::IOCondition, bool>
 	     (this, &CompWatchFd::internalCallback));
@@ -307,19 +337,28 @@ cps::EventManager::addWatchFd (int             fd,
 	gEvents |= Glib::IO_ERR;
     if (events & POLLHUP)
 	gEvents |= Glib::IO_HUP;
+    if (events & POLLNVAL)
+	gEvents |= Glib::IO_NVAL;
 
     Glib::RefPtr<CompWatchFd> watchFd = CompWatchFd::create (fd, gEvents, callBack);
 
-    watchFd->attach (ctx);
-
     if (!watchFd)
 	return 0;
-    watchFd->mHandle   = lastWatchFdHandle++;
+
+    watchFd->attach (ctx);
+
+    /* Handles wrap around, skip any still in use */
+    while (watchFds.find (lastWatchFdHandle) != watchFds.end ())
+	if (++lastWatchFdHandle == MAXSHORT)
+	    lastWatchFdHandle = 1;
+
+    watchFd->mHandle       = lastWatchFdHandle++;
+    watchFd->mEventManager = this;
 
     if (lastWatchFdHandle == MAXSHORT)
 	lastWatchFdHandle = 1;
 
-    watchFds.push_front (watchFd);
+    watchFds[watchFd->mHandle] = watchFd;
 
     return watchFd->mHandle;
 }
@@ -333,28 +372,59 @@ CompScreenImpl::removeWatchFd (CompWatchFdHandle handle)
 void
 cps::EventManager::removeWatchFd (CompWatchFdHandle handle)
 {
-    std::list<Glib::RefPtr<CompWatchFd> >::iterator it;
-    Glib::RefPtr<CompWatchFd> w;
-
-    for (it = watchFds.begin();
-	 it != watchFds.end (); ++it)
-    {
-	if ((*it)->mHandle == handle)
-	    break;
-    }
+    WatchFdMap::iterator it = watchFds.find (handle);
 
     if (it == watchFds.end ())
 	return;
 
-    w = (*it);
+    Glib::RefPtr<CompWatchFd> w = it->second;
 
+    watchFds.erase (it);
+
+    /* The main context keeps the source alive while it is being
+     * dispatched, returning false from the callback destroys it */
     if (w->mExecuting)
-    {
 	w->mForceFail = true;
-	return;
-    }
+    else
+	g_source_destroy (w->gobj ());
+}
 
-    watchFds.erase (it);
+void
+cps::EventManager::forgetWatchFd (CompWatchFdHandle handle)
+{
+    watchFds.erase (handle);
+}
+
+void
+CompScreenImpl::postToMainLoop (const MainLoopCallBack &callBack)
+{
+    privateScreen.eventManager.postToMainLoop (callBack);
+}
+
+void
+cps::EventManager::postToMainLoop (const MainLoopCallBack &callBack)
+{
+    postQueue.post (callBack);
+}
+
+compiz::core::TaskHandle
+CompScreenImpl::runTask (const MainLoopCallBack &work,
+			 const MainLoopCallBack &continuation,
+			 CompWindow             *owner)
+{
+    compiz::core::TaskHandle task =
+	privateScreen.eventManager.getThreadPool ().submit (work, continuation);
+
+    if (owner)
+	owner->priv->addTask (task);
+
+    return task;
+}
+
+compiz::core::ThreadPool &
+CompScreenImpl::threadPool ()
+{
+    return privateScreen.eventManager.getThreadPool ();
 }
 
 void
@@ -390,24 +460,42 @@ CompWatchFd::internalCallback (Glib::IOCondition events)
 	revents |= POLLERR;
     if (events & Glib::IO_HUP)
 	revents |= POLLHUP;
+
+    /* The source goes away with an invalid fd, only watches
+     * which asked for POLLNVAL get to hear about it */
     if (events & Glib::IO_NVAL)
-	return false;
+    {
+	if (!(mEvents & Glib::IO_NVAL))
+	    return drop ();
+
+	revents |= POLLNVAL;
+    }
 
     mExecuting = true;
     mCallBack (revents);
     mExecuting = false;
 
+    /* Removed by the callback, core has already dropped it */
     if (mForceFail)
-    {
-	/* FIXME: Need to find a way to properly remove the watchFd
-	 * from the internal list in core */
-	//screen->priv->watchFds.remove (this);
 	return false;
-    }
+
+    if (revents & POLLNVAL)
+	return drop ();
     
     return true;
 }    
 
+/* Glib destroys the source once the callback returns false, so core
+ * has to forget its handle too, or it would hand out a dead watch */
+bool
+CompWatchFd::drop ()
+{
+    if (mEventManager)
+	mEventManager->forgetWatchFd (mHandle);
+
+    return false;
+}
+
 void
 CompScreenImpl::eraseValue (CompString key)
 {
@@ -793,6 +881,29 @@ PrivateScreen::getNextEvent (XEvent &ev)
 	return getNextXEvent (ev);
 }
 
+#ifdef COMPIZ_TRACING
+static const char *
+eventName (int type)
+{
+    static const char *names[LASTEvent] = {
+	NULL, NULL, "KeyPress", "KeyRelease", "ButtonPress", "ButtonRelease",
+	"MotionNotify", "EnterNotify", "LeaveNotify", "FocusIn", "FocusOut",
+	"KeymapNotify", "Expose", "GraphicsExpose", "NoExpose",
+	"VisibilityNotify", "CreateNotify", "DestroyNotify", "UnmapNotify",
+	"MapNotify", "MapRequest", "ReparentNotify", "ConfigureNotify",
+	"ConfigureRequest", "GravityNotify", "ResizeRequest",
+	"CirculateNotify", "CirculateRequest", "PropertyNotify",
+	"SelectionClear", "SelectionRequest", "SelectionNotify",
+	"ColormapNotify", "ClientMessage", "MappingNotify", "GenericEvent"
+    };
+
+    if (type >= 0 && type < LASTEvent && names[type])
+	return names[type];
+
+    return "ExtensionEvent";
+}
+#endif
+
 void
 PrivateScreen::processEvents ()
 {
@@ -817,8 +928,15 @@ PrivateScreen::processEvents ()
 
     XEvent event;
 
+    /* Restacks are sent all at once after the events are handled,
+     * most of them are superseded by later ones anyways */
+    crb::RestackBatch::Default ().freeze ();
+    windowManager.freezeClientList ();
+
     while (getNextEvent (event))
     {
+	COMPIZ_TRACE_SCOPE ("event", eventName (event.type));
+
 	switch (event.type) {
 	case ButtonPress:
 	case ButtonRelease:
@@ -874,6 +992,8 @@ PrivateScreen::processEvents ()
 
 	sn_display_process_event (snDisplay, &event);
 
+	compiz::match::countEvent ();
+
 	inHandleEvent = true;
 	screen->alwaysHandleEvent (&event);
 	inHandleEvent = false;
@@ -885,6 +1005,10 @@ PrivateScreen::processEvents ()
 	lastPointerMods = pointerMods;
     }
 
+    windowManager.releaseClientList (*this);
+    crb::RestackBatch::Default ().release ();
+    XFlush (dpy);
+
     /* remove destroyed windows */
     windowManager.removeDestroyed ();
 
@@ -2825,6 +2949,7 @@ cps::WindowManager::insertWindow (CompWindow* w, Window aboveId)
 	    w->next = windows.front ();
 	}
 	windows.push_front (w);
+	w->priv->stackingHandle = stackingOrder.insertAbove (NULL);
 
 	addWindowToMap(w);
 
@@ -2862,6 +2987,8 @@ cps::WindowManager::insertWindow (CompWindow* w, Window aboveId)
 	w->next->prev = w;
     }
 
+    w->priv->stackingHandle = stackingOrder.insertAbove ((*it)->priv->stackingHandle);
+
     windows.insert (++it, w);
     addWindowToMap(w);
 }
@@ -2929,6 +3056,16 @@ cps::WindowManager::insertServerWindow(CompWindow* w, Window aboveId)
     serverWindows.insert (++it, w);
 }
 
+int
+cps::WindowManager::compareStacking (const CompWindow *a, const CompWindow *b) const
+{
+    if (!a->priv->stackingHandle || !b->priv->stackingHandle)
+	return 0;
+
+    return compiz::window::StackingOrder::compare (a->priv->stackingHandle,
+						   b->priv->stackingHandle);
+}
+
 void
 cps::WindowManager::eraseWindowFromMap (Window id)
 {
@@ -2962,6 +3099,12 @@ cps::WindowManager::unhookWindow(CompWindow* w)
     windows.erase (it);
     eraseWindowFromMap (w->id ());
 
+    if (w->priv->stackingHandle)
+    {
+	stackingOrder.remove (w->priv->stackingHandle);
+	w->priv->stackingHandle = NULL;
+    }
+
     if (w->next)
 	w->next->prev = w->prev;
 
@@ -3589,16 +3732,6 @@ isClientListWindow (CompWindow *w)
     return true;
 }
 
-static void
-countClientListWindow (CompWindow *w,
-		       int        *n)
-{
-    if (isClientListWindow (w))
-    {
-	*n = *n + 1;
-    }
-}
-
 static bool
 compareMappingOrder (const CompWindow *w1,
 		     const CompWindow *w2)
@@ -3608,19 +3741,66 @@ compareMappingOrder (const CompWindow *w1,
 
 void
 cps::WindowManager::updateClientList (PrivateScreen& ps)
+{
+    clientListDirty = true;
+    clientListPropertiesDirty = true;
+
+    /* Maps, unmaps and restacks all come through here, so while
+     * events are being handled only write the root properties
+     * once the whole batch has been processed */
+    if (!clientListFreezeCount)
+	flushClientList (ps);
+}
+
+void
+cps::WindowManager::releaseClientList (PrivateScreen& ps)
+{
+    if (clientListFreezeCount && --clientListFreezeCount == 0)
+	flushClientList (ps);
+}
+
+void
+cps::WindowManager::validateClientList () const
+{
+    if (!clientListDirty)
+	return;
+
+    clientListDirty = false;
+    clientListStacking.clear ();
+
+    for (iterator i = begin(); i != end(); ++i)
+    {
+	CompWindow* const w(*i);
+	if (isClientListWindow (w))
+	    clientListStacking.push_back (w);
+    }
+
+    /* clear clientList and copy clientListStacking into clientList */
+    clientList = clientListStacking;
+
+    /* sort clientList in mapping order */
+    sort (clientList.begin (), clientList.end (),
+	  compareMappingOrder);
+}
+
+void
+cps::WindowManager::flushClientList (PrivateScreen& ps)
 {
     bool   updateClientList = false;
     bool   updateClientListStacking = false;
-    int	   n = 0;
 
-    screen->forEachWindow (boost::bind (countClientListWindow, _1, &n));
+    if (!clientListPropertiesDirty)
+	return;
+
+    clientListPropertiesDirty = false;
+    validateClientList ();
+
+    unsigned int n = clientList.size ();
 
     if (n == 0)
     {
-	if ((unsigned int) n != clientList.size ())
+	if (n != clientIdList.size ())
 	{
-	    clientList.clear ();
-	    clientListStacking.clear ();
 	    clientIdList.clear ();
 	    clientIdListStacking.clear ();
 
@@ -3637,7 +3817,7 @@ cps::WindowManager::updateClientList (PrivateScreen& ps)
 	return;
     }
 
-    if ((unsigned int) n != clientList.size ())
+    if (n != clientIdList.size ())
     {
 	clientIdList.resize (n);
 	clientIdListStacking.resize (n);
@@ -3645,24 +3825,8 @@ cps::WindowManager::updateClientList (PrivateScreen& ps)
 	updateClientList = updateClientListStacking = true;
     }
 
-    clientListStacking.clear ();
-
-    for (iterator i = begin(); i != end(); ++i)
-    {
-	CompWindow* const w(*i);
-	if (isClientListWindow (w))
-	    clientListStacking.push_back (w);
-    }
-
-    /* clear clientList and copy clientListStacking into clientList */
-    clientList = clientListStacking;
-
-    /* sort clientList in mapping order */
-    sort (clientList.begin (), clientList.end (),
-	  compareMappingOrder);
-
     /* make sure client id lists are up-to-date */
-    for (int i = 0; i < n; i++)
+    for (unsigned int i = 0; i < n; i++)
     {
 	if (!updateClientList &&
 	    clientIdList[i] != clientList[i]->id ())
@@ -3672,7 +3836,7 @@ cps::WindowManager::updateClientList (PrivateScreen& ps)
 
 	clientIdList[i] = clientList[i]->id ();
     }
-    for (int i = 0; i < n; i++)
+    for (unsigned int i = 0; i < n; i++)
     {
 	if (!updateClientListStacking &&
 	    clientIdListStacking[i] != clientListStacking[i]->id ())
@@ -4560,6 +4724,18 @@ cps::EventManager::init ()
     sighupSource = CompSignalSource::create (SIGHUP, boost::bind (&EventManager::handleSignal, this, _1));
     sigintSource = CompSignalSource::create (SIGINT, boost::bind (&EventManager::handleSignal, this, _1));
     sigtermSource = CompSignalSource::create (SIGTERM, boost::bind (&EventManager::handleSignal, this, _1));
+#ifdef COMPIZ_TRACING
+    sigusr1Source = CompSignalSource::create (SIGUSR1, boost::bind (&EventManager::handleSignal, this, _1));
+#endif
+
+    if (postQueue.fd () != -1)
+	postQueueWatch = addWatchFd (postQueue.fd (), POLLIN,
+				     boost::bind (&compiz::core::PostQueue::run,
+						  &postQueue));
+    else
+	compLogMessage ("core", CompLogLevelWarn,
+			"eventfd failed, closures posted from other "
+			"threads will not run");
 }
 
 bool
@@ -4586,6 +4762,12 @@ CompScreenImpl::updateClientList()
     privateScreen.updateClientList ();
 }
 
+int
+CompScreenImpl::compareStacking (const CompWindow *a, const CompWindow *b) const
+{
+    return windowManager.compareStacking (a, b);
+}
+
 CompWindow *
 CompScreenImpl::getTopWindow() const
 {
@@ -5241,6 +5423,9 @@ cps::WindowManager::WindowManager() :
     destroyedWindows (),
     stackIsFresh (false),
     groups (0),
+    clientListDirty (false),
+    clientListPropertiesDirty (false),
+    clientListFreezeCount (0),
     pendingDestroys (0),
     lastFoundWindow(0)
 {
@@ -5259,10 +5444,14 @@ cps::EventManager::EventManager () :
     sighupSource(0),
     sigtermSource(0),
     sigintSource(0),
+    sigusr1Source(0),
     fileWatch (0),
     lastFileWatchHandle (1),
-    watchFds (0),
+    watchFds (),
     lastWatchFdHandle (1),
+    postQueueWatch (0),
+    threadPool (0, boost::bind (&compiz::core::PostQueue::post,
+				&postQueue, _1)),
     grabWindow (None)
 {
     TimeoutHandler *dTimeoutHandler = new TimeoutHandler ();
@@ -5288,6 +5477,7 @@ cps::EventManager::~EventManager ()
 	g_source_destroy (timeout->gobj ());
     }
 
+    delete sigusr1Source;
     delete sigintSource;
     delete sigtermSource;
     delete sighupSource;
@@ -5299,8 +5489,8 @@ cps::EventManager::~EventManager ()
     }
 
     /* This will implicitly call ~CompWatchFd */
-    foreach (Glib::RefPtr<CompWatchFd> fd, watchFds)
-	g_source_destroy (fd->gobj ());
+    for (WatchFdMap::iterator it = watchFds.begin (); it != watchFds.end (); ++it)
+	g_source_destroy (it->second->gobj ());
 
     watchFds.clear ();
 }
@@ -0,0 +1,198 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "stackingorder.h"
+
+namespace cw = compiz::window;
+
+namespace
+{
+    /* Labels live in [1, LabelSpace), 0 and LabelSpace are the
+     * implicit neighbours of the bottom and top entries */
+    const unsigned int LabelBits  = 62;
+    const uint64_t     LabelSpace = static_cast <uint64_t> (1) << LabelBits;
+
+    /* A range of 2^i labels may hold at most (2 / T)^i entries
+     * before it has to be spread out over a larger one */
+    const double       Density = 2.0 / 1.5;
+}
+
+struct cw::StackingOrder::Node
+{
+    uint64_t label;
+    Node     *prev;
+    Node     *next;
+};
+
+cw::StackingOrder::StackingOrder () :
+    mBottom (NULL),
+    mTop (NULL),
+    mSize (0)
+{
+}
+
+cw::StackingOrder::~StackingOrder ()
+{
+    while (mBottom)
+    {
+	Node *next = mBottom->next;
+	delete mBottom;
+	mBottom = next;
+    }
+}
+
+cw::StackingOrder::Handle
+cw::StackingOrder::insertAbove (Handle below)
+{
+    Node *node = new Node;
+
+    node->prev = below;
+    node->next = below ? below->next : mBottom;
+
+    if (node->prev)
+	node->prev->next = node;
+    else
+	mBottom = node;
+
+    if (node->next)
+	node->next->prev = node;
+    else
+	mTop = node;
+
+    ++mSize;
+
+    uint64_t lower = node->prev ? node->prev->label : 0;
+    uint64_t upper = node->next ? node->next->label : LabelSpace;
+
+    if (upper - lower > 1)
+	node->label = lower + (upper - lower) / 2;
+    else
+    {
+	node->label = lower;
+	relabel (node);
+    }
+
+    return node;
+}
+
+void
+cw::StackingOrder::relabel (Handle handle)
+{
+    double maxEntries = 1.0;
+
+    for (unsigned int bits = 1; bits <= LabelBits; ++bits)
+    {
+	uint64_t    rangeSize = static_cast <uint64_t> (1) << bits;
+	uint64_t    base = handle->label & ~(rangeSize - 1);
+	Node        *first = handle;
+	Node        *last = handle;
+	std::size_t count = 1;
+
+	maxEntries *= Density;
+
+	while (first->prev && first->prev->label >= base)
+	{
+	    first = first->prev;
+	    ++count;
+	}
+
+	while (last->next && last->next->label < base + rangeSize)
+	{
+	    last = last->next;
+	    ++count;
+	}
+
+	if (count > maxEntries && bits < LabelBits)
+	    continue;
+
+	/* Spread the entries evenly over the range, leaving
+	 * the first label free so that 0 is never used */
+	uint64_t gap = rangeSize / (count + 1);
+	uint64_t label = base + gap;
+
+	for (Node *n = first; n != last->next; n = n->next)
+	{
+	    n->label = label;
+	    label += gap;
+	}
+
+	return;
+    }
+}
+
+void
+cw::StackingOrder::remove (Handle handle)
+{
+    if (handle->prev)
+	handle->prev->next = handle->next;
+    else
+	mBottom = handle->next;
+
+    if (handle->next)
+	handle->next->prev = handle->prev;
+    else
+	mTop = handle->prev;
+
+    --mSize;
+
+    delete handle;
+}
+
+int
+cw::StackingOrder::compare (Handle a, Handle b)
+{
+    if (a->label < b->label)
+	return -1;
+    else if (a->label > b->label)
+	return 1;
+
+    return 0;
+}
+
+cw::StackingOrder::Handle
+cw::StackingOrder::bottom () const
+{
+    return mBottom;
+}
+
+cw::StackingOrder::Handle
+cw::StackingOrder::top () const
+{
+    return mTop;
+}
+
+cw::StackingOrder::Handle
+cw::StackingOrder::above (Handle handle)
+{
+    return handle->next;
+}
+
+cw::StackingOrder::Handle
+cw::StackingOrder::below (Handle handle)
+{
+    return handle->prev;
+}
+
+std::size_t
+cw::StackingOrder::size () const
+{
+    return mSize;
+}
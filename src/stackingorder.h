@@ -0,0 +1,86 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _COMPIZ_STACKINGORDER_H
+#define _COMPIZ_STACKINGORDER_H
+
+#include <cstddef>
+#include <stdint.h>
+
+#include <boost/noncopyable.hpp>
+
+namespace compiz
+{
+namespace window
+{
+
+/* Keeps an integer label for every entry of a stack, increasing
+ * from bottom to top, so that the relative order of any two
+ * entries can be found by comparing their labels instead of
+ * walking the stack.
+ *
+ * New entries take the midpoint of the labels of their neighbours.
+ * When there is no room left, the smallest enclosing range of labels
+ * which is sparse enough is spread out evenly again, which keeps
+ * insertion cheap on average. */
+class StackingOrder :
+    boost::noncopyable
+{
+    private:
+
+	struct Node;
+
+    public:
+
+	typedef Node * Handle;
+
+	StackingOrder ();
+	~StackingOrder ();
+
+	/* Inserts a new entry directly above below, or at the bottom
+	 * of the stack if below is NULL */
+	Handle insertAbove (Handle below);
+	void   remove (Handle handle);
+
+	/* Negative if a is below b, positive if it is above
+	 * and zero if they are the same entry */
+	static int compare (Handle a, Handle b);
+
+	Handle bottom () const;
+	Handle top () const;
+	static Handle above (Handle handle);
+	static Handle below (Handle handle);
+
+	std::size_t size () const;
+
+    private:
+
+	void relabel (Handle handle);
+
+	Handle      mBottom;
+	Handle      mTop;
+	std::size_t mSize;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,223 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <boost/bind.hpp>
+#include <gtest/gtest.h>
+
+#include "matchcache.h"
+
+namespace cm = compiz::match;
+
+namespace
+{
+    class CountingExpression :
+	public CompMatch::Expression
+    {
+	public:
+
+	    CountingExpression (bool value, unsigned int &evaluations) :
+		mValue (value),
+		mEvaluations (evaluations)
+	    {
+	    }
+
+	    bool evaluate (const CompWindow *) const
+	    {
+		++mEvaluations;
+		return mValue;
+	    }
+
+	private:
+
+	    bool         mValue;
+	    unsigned int &mEvaluations;
+    };
+}
+
+class MatchCacheTest :
+    public ::testing::Test
+{
+    public:
+
+	MatchCacheTest () :
+	    created (0),
+	    evaluations (0)
+	{
+	}
+
+	CompMatch::Expression * create (const CompString &value)
+	{
+	    if (value == "none")
+		return NULL;
+
+	    ++created;
+	    return new CountingExpression (value == "true", evaluations);
+	}
+
+	cm::AtomTable::Factory factory ()
+	{
+	    return boost::bind (&MatchCacheTest::create, this, _1);
+	}
+
+	/* What CompMatch::evaluate does for a single expression */
+	bool evaluate (const cm::AtomTable::Expression &e,
+		       cm::AtomId                      atom,
+		       cm::ResultCache                 &cache)
+	{
+	    bool value;
+
+	    if (cache.lookup (atom, value))
+		return value;
+
+	    value = e->evaluate (NULL);
+	    cache.store (atom, value);
+
+	    return value;
+	}
+
+	cm::AtomTable   table;
+	cm::ResultCache cache;
+	unsigned int    created;
+	unsigned int    evaluations;
+};
+
+TEST_F (MatchCacheTest, EmptyCacheHasNoResults)
+{
+    bool value;
+
+    EXPECT_FALSE (cache.lookup (1, value));
+    EXPECT_FALSE (cache.lookup (0, value));
+}
+
+TEST_F (MatchCacheTest, StoredResultsAreReturned)
+{
+    bool value = false;
+
+    cache.store (3, true);
+    cache.store (1, false);
+
+    ASSERT_TRUE (cache.lookup (3, value));
+    EXPECT_TRUE (value);
+    ASSERT_TRUE (cache.lookup (1, value));
+    EXPECT_FALSE (value);
+    EXPECT_FALSE (cache.lookup (2, value));
+}
+
+TEST_F (MatchCacheTest, NoExpressionIsNeverCached)
+{
+    bool value;
+
+    cache.store (0, true);
+
+    EXPECT_FALSE (cache.lookup (0, value));
+}
+
+TEST_F (MatchCacheTest, InvalidateDropsResults)
+{
+    bool value;
+
+    cache.store (1, true);
+    cache.invalidate ();
+
+    EXPECT_FALSE (cache.lookup (1, value));
+}
+
+TEST_F (MatchCacheTest, SameStringSharesExpression)
+{
+    cm::AtomId a, b;
+
+    cm::AtomTable::Expression e1 = table.get ("true", factory (), a);
+    cm::AtomTable::Expression e2 = table.get ("true", factory (), b);
+
+    EXPECT_EQ (e1, e2);
+    EXPECT_EQ (a, b);
+    EXPECT_EQ (1, created);
+}
+
+TEST_F (MatchCacheTest, DifferentStringsGetDifferentIds)
+{
+    cm::AtomId a, b;
+
+    cm::AtomTable::Expression e1 = table.get ("true", factory (), a);
+    cm::AtomTable::Expression e2 = table.get ("false", factory (), b);
+
+    EXPECT_NE (e1, e2);
+    EXPECT_NE (a, b);
+    EXPECT_NE (0, a);
+    EXPECT_NE (0, b);
+}
+
+TEST_F (MatchCacheTest, ExpireCreatesNewInstanceAndId)
+{
+    cm::AtomId a, b;
+
+    cm::AtomTable::Expression e1 = table.get ("true", factory (), a);
+
+    table.expire ();
+
+    cm::AtomTable::Expression e2 = table.get ("true", factory (), b);
+
+    EXPECT_NE (e1, e2);
+    EXPECT_NE (a, b);
+    EXPECT_EQ (2, created);
+}
+
+TEST_F (MatchCacheTest, ReleasedExpressionIsNotReused)
+{
+    cm::AtomId a, b;
+
+    table.get ("true", factory (), a);
+    table.get ("true", factory (), b);
+
+    EXPECT_NE (a, b);
+    EXPECT_EQ (2, created);
+}
+
+TEST_F (MatchCacheTest, UnhandledExpressionHasNoId)
+{
+    cm::AtomId a = 42;
+
+    cm::AtomTable::Expression e = table.get ("none", factory (), a);
+
+    EXPECT_FALSE (e);
+    EXPECT_EQ (0, a);
+    EXPECT_EQ (0, table.size ());
+}
+
+TEST_F (MatchCacheTest, SharedAtomIsEvaluatedOncePerWindow)
+{
+    cm::AtomId a, b;
+
+    cm::AtomTable::Expression e1 = table.get ("true", factory (), a);
+    cm::AtomTable::Expression e2 = table.get ("true", factory (), b);
+
+    for (unsigned int i = 0; i < 10; ++i)
+    {
+	EXPECT_TRUE (evaluate (e1, a, cache));
+	EXPECT_TRUE (evaluate (e2, b, cache));
+    }
+
+    EXPECT_EQ (1, evaluations);
+
+    cache.invalidate ();
+
+    EXPECT_TRUE (evaluate (e2, b, cache));
+    EXPECT_EQ (2, evaluations);
+}
@@ -0,0 +1,218 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <poll.h>
+#include <pthread.h>
+
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <gtest/gtest.h>
+
+#include "postqueue.h"
+
+namespace cc = compiz::core;
+
+namespace
+{
+    bool
+    readable (int fd)
+    {
+	struct pollfd pfd = { fd, POLLIN, 0 };
+
+	return poll (&pfd, 1, 0) == 1 && (pfd.revents & POLLIN);
+    }
+
+    void
+    append (std::vector <int> *values, int value)
+    {
+	values->push_back (value);
+    }
+
+    void
+    postAgain (cc::PostQueue *queue, std::vector <int> *values)
+    {
+	values->push_back (0);
+	queue->post (boost::bind (append, values, 1));
+    }
+
+    void
+    keep (boost::shared_ptr <int>)
+    {
+    }
+
+    const unsigned int Producers = 4;
+    const unsigned int PostsPerProducer = 20000;
+
+    struct Producer
+    {
+	cc::PostQueue *queue;
+	unsigned int  id;
+	/* Only touched by the closures, so only by the consumer */
+	unsigned int  *next;
+	bool          *inOrder;
+    };
+
+    void
+    receive (Producer *producer, unsigned int i)
+    {
+	if (producer->next[producer->id] != i)
+	    *producer->inOrder = false;
+
+	producer->next[producer->id] = i + 1;
+    }
+
+    void *
+    produce (void *data)
+    {
+	Producer *producer = static_cast <Producer *> (data);
+
+	for (unsigned int i = 0; i < PostsPerProducer; ++i)
+	    producer->queue->post (boost::bind (receive, producer, i));
+
+	return NULL;
+    }
+}
+
+TEST (PostQueue, EmptyQueueIsNotReadable)
+{
+    cc::PostQueue queue;
+
+    ASSERT_NE (-1, queue.fd ());
+    EXPECT_FALSE (readable (queue.fd ()));
+    EXPECT_EQ (0, queue.run ());
+}
+
+TEST (PostQueue, PostMakesFdReadableUntilRun)
+{
+    cc::PostQueue     queue;
+    std::vector <int> values;
+
+    queue.post (boost::bind (append, &values, 1));
+    EXPECT_TRUE (readable (queue.fd ()));
+    EXPECT_TRUE (values.empty ());
+
+    EXPECT_EQ (1, queue.run ());
+    EXPECT_FALSE (readable (queue.fd ()));
+    ASSERT_EQ (1, values.size ());
+}
+
+TEST (PostQueue, RunsInPostOrder)
+{
+    cc::PostQueue     queue;
+    std::vector <int> values;
+
+    for (int i = 0; i < 100; ++i)
+	queue.post (boost::bind (append, &values, i));
+
+    EXPECT_EQ (100, queue.run ());
+    ASSERT_EQ (100, values.size ());
+
+    for (int i = 0; i < 100; ++i)
+	EXPECT_EQ (i, values[i]);
+}
+
+TEST (PostQueue, ClosuresPostedWhileRunningWaitForNextRun)
+{
+    cc::PostQueue     queue;
+    std::vector <int> values;
+
+    queue.post (boost::bind (postAgain, &queue, &values));
+
+    EXPECT_EQ (1, queue.run ());
+    ASSERT_EQ (1, values.size ());
+    EXPECT_TRUE (readable (queue.fd ()));
+
+    EXPECT_EQ (1, queue.run ());
+    ASSERT_EQ (2, values.size ());
+    EXPECT_EQ (1, values[1]);
+    EXPECT_FALSE (readable (queue.fd ()));
+}
+
+TEST (PostQueue, ReleasesClosuresAfterRunning)
+{
+    cc::PostQueue           queue;
+    boost::shared_ptr <int> value (new int (0));
+
+    queue.post (boost::bind (keep, value));
+    EXPECT_EQ (2, value.use_count ());
+
+    queue.run ();
+    EXPECT_TRUE (value.unique ());
+}
+
+TEST (PostQueue, ReleasesPendingClosuresOnDestruction)
+{
+    boost::shared_ptr <int> value (new int (0));
+
+    {
+	cc::PostQueue queue;
+
+	queue.post (boost::bind (keep, value));
+	queue.post (boost::bind (keep, value));
+	EXPECT_EQ (3, value.use_count ());
+    }
+
+    EXPECT_TRUE (value.unique ());
+}
+
+TEST (PostQueue, ManyProducers)
+{
+    cc::PostQueue queue;
+    unsigned int  next[Producers] = { 0 };
+    bool          inOrder = true;
+    Producer      producers[Producers];
+    pthread_t     threads[Producers];
+
+    for (unsigned int i = 0; i < Producers; ++i)
+    {
+	Producer p = { &queue, i, next, &inOrder };
+
+	producers[i] = p;
+	ASSERT_EQ (0, pthread_create (&threads[i], NULL,
+				      produce, &producers[i]));
+    }
+
+    /* Consume like the main loop does, only running when woken */
+    unsigned int total = 0;
+
+    while (total < Producers * PostsPerProducer)
+    {
+	struct pollfd pfd = { queue.fd (), POLLIN, 0 };
+
+	ASSERT_EQ (1, poll (&pfd, 1, 5000));
+	total += queue.run ();
+    }
+
+    for (unsigned int i = 0; i < Producers; ++i)
+	pthread_join (threads[i], NULL);
+
+    EXPECT_EQ (Producers * PostsPerProducer, total);
+    EXPECT_TRUE (inOrder);
+
+    for (unsigned int i = 0; i < Producers; ++i)
+	EXPECT_EQ (PostsPerProducer, next[i]);
+
+    EXPECT_EQ (0, queue.run ());
+    EXPECT_FALSE (readable (queue.fd ()));
+}
@@ -0,0 +1,210 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <gtest/gtest.h>
+
+#include "restackbatch.h"
+
+namespace crb = compiz::window::configure_buffers;
+
+namespace
+{
+    struct SentRequest
+    {
+	Window         window;
+	XWindowChanges xwc;
+	unsigned int   valueMask;
+    };
+}
+
+class RestackBatchTest :
+    public ::testing::Test
+{
+    public:
+
+	/* Stands in for XConfigureWindow, so we can count the
+	 * requests which would have gone out to the server */
+	void send (Window window, const XWindowChanges &xwc, unsigned int valueMask)
+	{
+	    SentRequest request;
+
+	    request.window    = window;
+	    request.xwc       = xwc;
+	    request.valueMask = valueMask;
+
+	    sent.push_back (request);
+	}
+
+	bool restack (Window window, Window sibling)
+	{
+	    XWindowChanges xwc;
+
+	    xwc.stack_mode = Above;
+	    xwc.sibling    = sibling;
+
+	    return batch.add (window, xwc, CWStackMode | CWSibling,
+			      boost::bind (&RestackBatchTest::send, this, window, _1, _2));
+	}
+
+	bool move (Window window)
+	{
+	    XWindowChanges xwc;
+
+	    return batch.add (window, xwc, CWX | CWY,
+			      boost::bind (&RestackBatchTest::send, this, window, _1, _2));
+	}
+
+	crb::RestackBatch        batch;
+	std::vector <SentRequest> sent;
+};
+
+TEST_F (RestackBatchTest, NotQueuedUnlessFrozen)
+{
+    EXPECT_FALSE (restack (1, 2));
+    EXPECT_FALSE (batch.pending (1));
+}
+
+TEST_F (RestackBatchTest, SentOnRelease)
+{
+    batch.freeze ();
+
+    EXPECT_TRUE (restack (1, 2));
+    EXPECT_TRUE (batch.pending (1));
+    EXPECT_TRUE (sent.empty ());
+
+    batch.release ();
+
+    ASSERT_EQ (1, sent.size ());
+    EXPECT_EQ (1, sent[0].window);
+    EXPECT_EQ (2, sent[0].xwc.sibling);
+    EXPECT_FALSE (batch.pending (1));
+}
+
+TEST_F (RestackBatchTest, NestedFreezeSendsOnLastRelease)
+{
+    batch.freeze ();
+    batch.freeze ();
+
+    restack (1, 2);
+    batch.release ();
+
+    EXPECT_TRUE (sent.empty ());
+
+    batch.release ();
+
+    EXPECT_EQ (1, sent.size ());
+}
+
+TEST_F (RestackBatchTest, RepeatedRestackSendsLatestOnly)
+{
+    batch.freeze ();
+
+    for (Window sibling = 2; sibling < 10; ++sibling)
+	restack (1, sibling);
+
+    batch.release ();
+
+    ASSERT_EQ (1, sent.size ());
+    EXPECT_EQ (9, sent[0].xwc.sibling);
+}
+
+TEST_F (RestackBatchTest, SupersedingRestackMovesToTheEnd)
+{
+    batch.freeze ();
+
+    restack (1, 5);
+    restack (2, 6);
+    restack (1, 7);
+
+    batch.release ();
+
+    ASSERT_EQ (2, sent.size ());
+    EXPECT_EQ (2, sent[0].window);
+    EXPECT_EQ (1, sent[1].window);
+    EXPECT_EQ (7, sent[1].xwc.sibling);
+}
+
+TEST_F (RestackBatchTest, RestackKeptWhenUsedAsSibling)
+{
+    batch.freeze ();
+
+    restack (1, 5);
+    restack (2, 1);
+    restack (1, 6);
+
+    batch.release ();
+
+    ASSERT_EQ (3, sent.size ());
+    EXPECT_EQ (1, sent[0].window);
+    EXPECT_EQ (5, sent[0].xwc.sibling);
+    EXPECT_EQ (2, sent[1].window);
+    EXPECT_EQ (1, sent[2].window);
+    EXPECT_EQ (6, sent[2].xwc.sibling);
+}
+
+TEST_F (RestackBatchTest, GeometryNotQueued)
+{
+    batch.freeze ();
+
+    EXPECT_FALSE (move (1));
+
+    restack (1, 5);
+
+    EXPECT_FALSE (move (1));
+
+    batch.release ();
+
+    ASSERT_EQ (1, sent.size ());
+    EXPECT_EQ (CWStackMode | CWSibling, sent[0].valueMask);
+}
+
+TEST_F (RestackBatchTest, RemovedWindowNotSent)
+{
+    batch.freeze ();
+
+    restack (1, 5);
+    restack (2, 6);
+    batch.remove (1);
+
+    EXPECT_FALSE (batch.pending (1));
+
+    batch.release ();
+
+    ASSERT_EQ (1, sent.size ());
+    EXPECT_EQ (2, sent[0].window);
+}
+
+TEST_F (RestackBatchTest, ManyWindowsOneRequestEach)
+{
+    const Window nWindows = 100;
+
+    batch.freeze ();
+
+    for (unsigned int pass = 0; pass < 3; ++pass)
+	for (Window w = 1; w <= nWindows; ++w)
+	    restack (w, nWindows + pass + 1);
+
+    batch.release ();
+
+    EXPECT_EQ (nWindows, sent.size ());
+}
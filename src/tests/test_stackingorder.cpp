@@ -0,0 +1,233 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <list>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "stackingorder.h"
+
+namespace cw = compiz::window;
+
+namespace
+{
+    typedef cw::StackingOrder::Handle Handle;
+    typedef std::list <Handle> HandleList;
+
+    /* Checks the order against a plain list kept in the same
+     * order, bottom first, like CompScreen::windows () */
+    void
+    expectSameOrder (const cw::StackingOrder &order,
+		     const HandleList        &reference)
+    {
+	ASSERT_EQ (reference.size (), order.size ());
+
+	Handle handle = order.bottom ();
+
+	for (HandleList::const_iterator it = reference.begin ();
+	     it != reference.end ();
+	     ++it)
+	{
+	    ASSERT_EQ (*it, handle);
+
+	    HandleList::const_iterator next = it;
+
+	    if (++next != reference.end ())
+	    {
+		EXPECT_LT (cw::StackingOrder::compare (*it, *next), 0);
+		EXPECT_GT (cw::StackingOrder::compare (*next, *it), 0);
+	    }
+
+	    handle = cw::StackingOrder::above (handle);
+	}
+
+	EXPECT_EQ (NULL, handle);
+    }
+}
+
+TEST (StackingOrderTest, EmptyStack)
+{
+    cw::StackingOrder order;
+
+    EXPECT_EQ (0, order.size ());
+    EXPECT_EQ (NULL, order.bottom ());
+    EXPECT_EQ (NULL, order.top ());
+}
+
+TEST (StackingOrderTest, InsertAtBottom)
+{
+    cw::StackingOrder order;
+
+    Handle first = order.insertAbove (NULL);
+    Handle second = order.insertAbove (NULL);
+
+    EXPECT_EQ (second, order.bottom ());
+    EXPECT_EQ (first, order.top ());
+    EXPECT_LT (cw::StackingOrder::compare (second, first), 0);
+}
+
+TEST (StackingOrderTest, InsertAbove)
+{
+    cw::StackingOrder order;
+
+    Handle bottom = order.insertAbove (NULL);
+    Handle top = order.insertAbove (bottom);
+    Handle middle = order.insertAbove (bottom);
+
+    EXPECT_EQ (middle, cw::StackingOrder::above (bottom));
+    EXPECT_EQ (middle, cw::StackingOrder::below (top));
+    EXPECT_LT (cw::StackingOrder::compare (bottom, middle), 0);
+    EXPECT_LT (cw::StackingOrder::compare (middle, top), 0);
+    EXPECT_EQ (0, cw::StackingOrder::compare (middle, middle));
+}
+
+TEST (StackingOrderTest, Remove)
+{
+    cw::StackingOrder order;
+
+    Handle bottom = order.insertAbove (NULL);
+    Handle middle = order.insertAbove (bottom);
+    Handle top = order.insertAbove (middle);
+
+    order.remove (middle);
+
+    EXPECT_EQ (2, order.size ());
+    EXPECT_EQ (top, cw::StackingOrder::above (bottom));
+    EXPECT_EQ (bottom, cw::StackingOrder::below (top));
+
+    order.remove (bottom);
+    order.remove (top);
+
+    EXPECT_EQ (NULL, order.bottom ());
+    EXPECT_EQ (NULL, order.top ());
+}
+
+TEST (StackingOrderTest, RepeatedInsertionAtOnePlaceRelabels)
+{
+    cw::StackingOrder order;
+    HandleList        reference;
+
+    Handle bottom = order.insertAbove (NULL);
+    reference.push_back (bottom);
+
+    /* Always splitting the same gap runs out of labels after
+     * a few dozen insertions */
+    for (unsigned int i = 0; i < 1000; ++i)
+    {
+	HandleList::iterator it = reference.begin ();
+	reference.insert (++it, order.insertAbove (bottom));
+    }
+
+    expectSameOrder (order, reference);
+}
+
+TEST (StackingOrderTest, RepeatedInsertionAtTopRelabels)
+{
+    cw::StackingOrder order;
+    HandleList        reference;
+
+    for (unsigned int i = 0; i < 1000; ++i)
+	reference.push_back (order.insertAbove (order.top ()));
+
+    expectSameOrder (order, reference);
+}
+
+TEST (StackingOrderTest, RandomOperationsMatchList)
+{
+    cw::StackingOrder order;
+    HandleList        reference;
+
+    srand (1234);
+
+    for (unsigned int i = 0; i < 20000; ++i)
+    {
+	unsigned int operation = rand () % 4;
+
+	if (reference.empty () || operation < 2)
+	{
+	    /* Insert above a random entry, or at the bottom */
+	    unsigned int position = rand () % (reference.size () + 1);
+	    HandleList::iterator it = reference.begin ();
+
+	    if (position == 0)
+		reference.push_front (order.insertAbove (NULL));
+	    else
+	    {
+		std::advance (it, position - 1);
+		Handle handle = order.insertAbove (*it);
+		reference.insert (++it, handle);
+	    }
+	}
+	else if (operation == 2)
+	{
+	    /* Remove a random entry */
+	    HandleList::iterator it = reference.begin ();
+	    std::advance (it, rand () % reference.size ());
+
+	    order.remove (*it);
+	    reference.erase (it);
+	}
+	else
+	{
+	    /* Restack a random entry above another one, the same
+	     * way windows are unhooked and inserted again */
+	    HandleList::iterator it = reference.begin ();
+	    std::advance (it, rand () % reference.size ());
+
+	    order.remove (*it);
+	    reference.erase (it);
+
+	    if (reference.empty ())
+		reference.push_front (order.insertAbove (NULL));
+	    else
+	    {
+		HandleList::iterator sibling = reference.begin ();
+		std::advance (sibling, rand () % reference.size ());
+		Handle handle = order.insertAbove (*sibling);
+		reference.insert (++sibling, handle);
+	    }
+	}
+
+	if (i % 1000 == 0)
+	    expectSameOrder (order, reference);
+    }
+
+    expectSameOrder (order, reference);
+
+    /* Compare random pairs against their list positions */
+    std::vector <Handle> positions (reference.begin (), reference.end ());
+
+    for (unsigned int i = 0; i < 10000; ++i)
+    {
+	unsigned int a = rand () % positions.size ();
+	unsigned int b = rand () % positions.size ();
+	int          result = cw::StackingOrder::compare (positions[a], positions[b]);
+
+	if (a < b)
+	    EXPECT_LT (result, 0);
+	else if (a > b)
+	    EXPECT_GT (result, 0);
+	else
+	    EXPECT_EQ (0, result);
+    }
+}
@@ -0,0 +1,142 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _COMPIZ_THREADPOOL_H
+#define _COMPIZ_THREADPOOL_H
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace compiz
+{
+namespace core
+{
+
+typedef boost::function <void ()> Work;
+
+class PrivateThreadPool;
+
+/* Refers to a task submitted to a ThreadPool. Copies refer to the
+ * same task, a default constructed handle to none */
+class TaskHandle
+{
+    public:
+
+	TaskHandle ();
+
+	bool valid () const;
+
+	/* Keeps the work from starting and the continuation from
+	 * running. Returns false if the work had already started,
+	 * which it is then left to finish. Long running work may
+	 * poll cancelled () to stop early */
+	bool cancel ();
+	bool cancelled () const;
+
+	/* True once the work has run or will never run */
+	bool finished () const;
+
+	/* True while the continuation has been posted to the
+	 * main loop but has not run yet */
+	bool continuationPending () const;
+
+	/* Blocks until finished (). If no worker has started the work
+	 * yet, the calling thread runs it itself instead of waiting */
+	void wait ();
+
+	struct State;
+
+    private:
+
+	explicit TaskHandle (const boost::shared_ptr <State> &);
+
+	boost::shared_ptr <State> mState;
+
+    friend class ThreadPool;
+    friend class PrivateThreadPool;
+};
+
+/* A fixed set of worker threads, each with its own queue of tasks.
+ * Workers take their newest task first and, when they run out, take
+ * the oldest task of another worker. Tasks submitted from a worker
+ * go to its own queue, others are spread over all of them.
+ *
+ * The threads are only started by the first submit (). */
+class ThreadPool :
+    boost::noncopyable
+{
+    public:
+
+	/* Has to arrange for the closure to run on the main thread */
+	typedef boost::function <void (const Work &)> Poster;
+
+	typedef boost::function <void (unsigned int begin,
+				       unsigned int end)> Range;
+
+	struct Stats
+	{
+	    unsigned int       threads;
+	    /* Tasks waiting in the queues right now, and the most
+	     * there have ever been */
+	    unsigned int       queued;
+	    unsigned int       peakQueued;
+	    unsigned int       running;
+	    unsigned long long submitted;
+	    unsigned long long completed;
+	    unsigned long long cancelled;
+	    /* Tasks a worker took from the queue of another */
+	    unsigned long long stolen;
+	};
+
+	/* With threads set to 0 there is one thread per online CPU */
+	ThreadPool (unsigned int threads, const Poster &post);
+
+	/* Cancels the tasks which have not started and waits for
+	 * the running ones */
+	~ThreadPool ();
+
+	/* Runs work on one of the workers, then hands continuation
+	 * to the poster unless the task was cancelled. work must not
+	 * touch anything the main thread might be using meanwhile */
+	TaskHandle submit (const Work &work,
+			   const Work &continuation = Work ());
+
+	/* Calls range for consecutive chunks of [0, n), at least grain
+	 * long, on the workers and the calling thread, and returns once
+	 * all of them are done */
+	void forEachChunk (unsigned int n,
+			   unsigned int grain,
+			   const Range  &range);
+
+	unsigned int threads () const;
+
+	Stats stats () const;
+
+    private:
+
+	PrivateThreadPool *priv;
+};
+
+}
+}
+
+#endif
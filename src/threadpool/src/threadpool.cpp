@@ -0,0 +1,544 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include <boost/bind.hpp>
+
+#include <core/trace.h>
+#include <core/threadpool.h>
+
+namespace cc = compiz::core;
+
+namespace
+{
+    enum
+    {
+	Pending,
+	Running,
+	Done,
+	Cancelled
+    };
+
+    template <typename T>
+    void
+    raiseTo (T *value, T candidate)
+    {
+	T current = __atomic_load_n (value, __ATOMIC_RELAXED);
+
+	while (current < candidate &&
+	       !__atomic_compare_exchange_n (value, &current, candidate, true,
+					     __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    }
+}
+
+struct cc::TaskHandle::State :
+    boost::noncopyable
+{
+    State (PrivateThreadPool *pool,
+	   const Work        &work,
+	   const Work        &continuation) :
+	pool (pool),
+	work (work),
+	continuation (continuation),
+	status (Pending),
+	cancelRequested (0),
+	continuationPosted (0)
+    {
+	pthread_mutex_init (&lock, NULL);
+	pthread_cond_init (&finished, NULL);
+    }
+
+    ~State ()
+    {
+	pthread_cond_destroy (&finished);
+	pthread_mutex_destroy (&lock);
+    }
+
+    PrivateThreadPool *pool;
+    Work              work;
+    Work              continuation;
+    int               status;
+    int               cancelRequested;
+    int               continuationPosted;
+    pthread_mutex_t   lock;
+    pthread_cond_t    finished;
+};
+
+typedef boost::shared_ptr <cc::TaskHandle::State> TaskPtr;
+
+class cc::PrivateThreadPool
+{
+    public:
+
+	struct Worker
+	{
+	    PrivateThreadPool    *pool;
+	    unsigned int         index;
+	    pthread_t            thread;
+	    pthread_mutex_t      lock;
+	    std::deque <TaskPtr> tasks;
+	};
+
+	PrivateThreadPool (unsigned int threads, const ThreadPool::Poster &post);
+	~PrivateThreadPool ();
+
+	void start ();
+	void push (const TaskPtr &task);
+	TaskPtr take (Worker *self);
+
+	/* Runs the task if nobody has claimed it yet */
+	void run (const TaskPtr &task);
+	void finish (const TaskPtr &task, int status);
+
+	static void runContinuation (const TaskPtr &task);
+	static void * loop (void *data);
+
+	ThreadPool::Poster    post;
+	std::vector <Worker>  workers;
+	unsigned int          nextWorker;
+	bool                  started;
+	bool                  stopping;
+
+	/* Held while starting the threads and for sleeping */
+	pthread_mutex_t       lock;
+	pthread_cond_t        wake;
+
+	ThreadPool::Stats     stats;
+};
+
+namespace
+{
+    /* The worker the calling thread is, if any */
+    __thread cc::PrivateThreadPool::Worker *currentWorker = NULL;
+}
+
+cc::TaskHandle::TaskHandle ()
+{
+}
+
+cc::TaskHandle::TaskHandle (const boost::shared_ptr <State> &state) :
+    mState (state)
+{
+}
+
+bool
+cc::TaskHandle::valid () const
+{
+    return mState.get () != NULL;
+}
+
+bool
+cc::TaskHandle::cancel ()
+{
+    if (!mState)
+	return false;
+
+    __atomic_store_n (&mState->cancelRequested, 1, __ATOMIC_RELEASE);
+
+    int pending = Pending;
+
+    if (!__atomic_compare_exchange_n (&mState->status, &pending, Cancelled,
+				      false, __ATOMIC_ACQ_REL,
+				      __ATOMIC_ACQUIRE))
+	return false;
+
+    mState->pool->finish (mState, Cancelled);
+
+    return true;
+}
+
+bool
+cc::TaskHandle::cancelled () const
+{
+    return mState &&
+	   __atomic_load_n (&mState->cancelRequested, __ATOMIC_ACQUIRE);
+}
+
+bool
+cc::TaskHandle::finished () const
+{
+    if (!mState)
+	return true;
+
+    int status = __atomic_load_n (&mState->status, __ATOMIC_ACQUIRE);
+
+    return status == Done || status == Cancelled;
+}
+
+bool
+cc::TaskHandle::continuationPending () const
+{
+    return mState &&
+	   __atomic_load_n (&mState->continuationPosted, __ATOMIC_ACQUIRE);
+}
+
+void
+cc::TaskHandle::wait ()
+{
+    if (!mState)
+	return;
+
+    if (__atomic_load_n (&mState->status, __ATOMIC_ACQUIRE) == Pending)
+	mState->pool->run (mState);
+
+    pthread_mutex_lock (&mState->lock);
+
+    while (!finished ())
+	pthread_cond_wait (&mState->finished, &mState->lock);
+
+    pthread_mutex_unlock (&mState->lock);
+}
+
+cc::PrivateThreadPool::PrivateThreadPool (unsigned int              threads,
+					  const ThreadPool::Poster &post) :
+    post (post),
+    workers (threads),
+    nextWorker (0),
+    started (false),
+    stopping (false)
+{
+    pthread_mutex_init (&lock, NULL);
+    pthread_cond_init (&wake, NULL);
+
+    for (unsigned int i = 0; i < workers.size (); ++i)
+    {
+	workers[i].pool = this;
+	workers[i].index = i;
+	pthread_mutex_init (&workers[i].lock, NULL);
+    }
+
+    stats.threads = threads;
+    stats.queued = 0;
+    stats.peakQueued = 0;
+    stats.running = 0;
+    stats.submitted = 0;
+    stats.completed = 0;
+    stats.cancelled = 0;
+    stats.stolen = 0;
+}
+
+cc::PrivateThreadPool::~PrivateThreadPool ()
+{
+    pthread_mutex_lock (&lock);
+    __atomic_store_n (&stopping, true, __ATOMIC_RELEASE);
+    pthread_cond_broadcast (&wake);
+    pthread_mutex_unlock (&lock);
+
+    /* Workers take no more tasks once stopping is set, cancel the
+     * ones left and release anybody waiting on them */
+    for (unsigned int i = 0; i < workers.size (); ++i)
+    {
+	std::deque <TaskPtr> tasks;
+
+	pthread_mutex_lock (&workers[i].lock);
+	tasks.swap (workers[i].tasks);
+	pthread_mutex_unlock (&workers[i].lock);
+
+	__atomic_sub_fetch (&stats.queued, tasks.size (), __ATOMIC_SEQ_CST);
+
+	for (unsigned int j = 0; j < tasks.size (); ++j)
+	    TaskHandle (tasks[j]).cancel ();
+    }
+
+    if (started)
+	for (unsigned int i = 0; i < workers.size (); ++i)
+	    pthread_join (workers[i].thread, NULL);
+
+    for (unsigned int i = 0; i < workers.size (); ++i)
+	pthread_mutex_destroy (&workers[i].lock);
+
+    pthread_cond_destroy (&wake);
+    pthread_mutex_destroy (&lock);
+}
+
+void
+cc::PrivateThreadPool::start ()
+{
+    if (__atomic_load_n (&started, __ATOMIC_ACQUIRE))
+	return;
+
+    pthread_mutex_lock (&lock);
+
+    if (!started)
+    {
+	for (unsigned int i = 0; i < workers.size (); ++i)
+	    pthread_create (&workers[i].thread, NULL, loop, &workers[i]);
+
+	__atomic_store_n (&started, true, __ATOMIC_RELEASE);
+    }
+
+    pthread_mutex_unlock (&lock);
+}
+
+void
+cc::PrivateThreadPool::push (const TaskPtr &task)
+{
+    Worker *worker = currentWorker;
+
+    if (!worker || worker->pool != this)
+	worker = &workers[__atomic_fetch_add (&nextWorker, 1, __ATOMIC_RELAXED) %
+			  workers.size ()];
+
+    /* Count the task before anybody can take it, or taking it
+     * could wrap stats.queued around */
+    pthread_mutex_lock (&worker->lock);
+    worker->tasks.push_back (task);
+    unsigned int queued = __atomic_add_fetch (&stats.queued, 1,
+					      __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock (&worker->lock);
+
+    __atomic_add_fetch (&stats.submitted, 1, __ATOMIC_RELAXED);
+    raiseTo (&stats.peakQueued, queued);
+
+    /* Sleeping workers check stats.queued with the lock held,
+     * so they can't miss this */
+    pthread_mutex_lock (&lock);
+    pthread_cond_signal (&wake);
+    pthread_mutex_unlock (&lock);
+}
+
+TaskPtr
+cc::PrivateThreadPool::take (Worker *self)
+{
+    TaskPtr task;
+
+    pthread_mutex_lock (&self->lock);
+
+    if (!self->tasks.empty ())
+    {
+	task = self->tasks.back ();
+	self->tasks.pop_back ();
+    }
+
+    pthread_mutex_unlock (&self->lock);
+
+    for (unsigned int i = 1; !task && i < workers.size (); ++i)
+    {
+	Worker *victim = &workers[(self->index + i) % workers.size ()];
+
+	pthread_mutex_lock (&victim->lock);
+
+	if (!victim->tasks.empty ())
+	{
+	    task = victim->tasks.front ();
+	    victim->tasks.pop_front ();
+	    __atomic_add_fetch (&stats.stolen, 1, __ATOMIC_RELAXED);
+	}
+
+	pthread_mutex_unlock (&victim->lock);
+    }
+
+    if (task)
+	__atomic_sub_fetch (&stats.queued, 1, __ATOMIC_SEQ_CST);
+
+    return task;
+}
+
+void
+cc::PrivateThreadPool::run (const TaskPtr &task)
+{
+    int pending = Pending;
+
+    if (!__atomic_compare_exchange_n (&task->status, &pending, Running,
+				      false, __ATOMIC_ACQ_REL,
+				      __ATOMIC_ACQUIRE))
+	return;
+
+    __atomic_add_fetch (&stats.running, 1, __ATOMIC_RELAXED);
+
+    {
+	COMPIZ_TRACE_SCOPE ("task", "run");
+	task->work ();
+    }
+
+    task->work.clear ();
+
+    /* Mark the continuation as pending before the task as done,
+     * so that nobody sees a finished task with nothing pending
+     * whose continuation is about to be posted */
+    bool continues = task->continuation &&
+		     !__atomic_load_n (&task->cancelRequested,
+				       __ATOMIC_ACQUIRE);
+
+    if (continues)
+	__atomic_store_n (&task->continuationPosted, 1, __ATOMIC_RELEASE);
+
+    __atomic_sub_fetch (&stats.running, 1, __ATOMIC_RELAXED);
+    __atomic_store_n (&task->status, Done, __ATOMIC_RELEASE);
+
+    finish (task, Done);
+
+    if (continues)
+	post (boost::bind (runContinuation, task));
+}
+
+void
+cc::PrivateThreadPool::finish (const TaskPtr &task, int status)
+{
+    if (status == Done)
+	__atomic_add_fetch (&stats.completed, 1, __ATOMIC_RELAXED);
+    else
+	__atomic_add_fetch (&stats.cancelled, 1, __ATOMIC_RELAXED);
+
+    pthread_mutex_lock (&task->lock);
+    pthread_cond_broadcast (&task->finished);
+    pthread_mutex_unlock (&task->lock);
+}
+
+void
+cc::PrivateThreadPool::runContinuation (const TaskPtr &task)
+{
+    Work continuation;
+
+    continuation.swap (task->continuation);
+    __atomic_store_n (&task->continuationPosted, 0, __ATOMIC_RELEASE);
+
+    /* The task might have been cancelled since it was posted */
+    if (!__atomic_load_n (&task->cancelRequested, __ATOMIC_ACQUIRE))
+	continuation ();
+}
+
+void *
+cc::PrivateThreadPool::loop (void *data)
+{
+    Worker            *self = static_cast <Worker *> (data);
+    PrivateThreadPool *pool = self->pool;
+
+    currentWorker = self;
+
+    /* Tasks still queued when the pool goes away are cancelled by
+     * its destructor, they may refer to state which is gone already */
+    while (!__atomic_load_n (&pool->stopping, __ATOMIC_ACQUIRE))
+    {
+	TaskPtr task = pool->take (self);
+
+	if (task)
+	{
+	    pool->run (task);
+	    continue;
+	}
+
+	pthread_mutex_lock (&pool->lock);
+
+	while (!pool->stopping &&
+	       !__atomic_load_n (&pool->stats.queued, __ATOMIC_SEQ_CST))
+	    pthread_cond_wait (&pool->wake, &pool->lock);
+
+	pthread_mutex_unlock (&pool->lock);
+    }
+
+    currentWorker = NULL;
+
+    return NULL;
+}
+
+cc::ThreadPool::ThreadPool (unsigned int  threads,
+			    const Poster &post)
+{
+    if (!threads)
+    {
+	long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+
+	threads = cpus > 0 ? (unsigned int) cpus : 1;
+    }
+
+    priv = new PrivateThreadPool (threads, post);
+}
+
+cc::ThreadPool::~ThreadPool ()
+{
+    delete priv;
+}
+
+cc::TaskHandle
+cc::ThreadPool::submit (const Work &work,
+			const Work &continuation)
+{
+    TaskPtr task (new TaskHandle::State (priv, work, continuation));
+
+    priv->start ();
+    priv->push (task);
+
+    return TaskHandle (task);
+}
+
+void
+cc::ThreadPool::forEachChunk (unsigned int n,
+			      unsigned int grain,
+			      const Range  &range)
+{
+    if (!grain)
+	grain = 1;
+
+    unsigned int chunks = std::min (n / grain, threads () + 1);
+
+    if (chunks < 2)
+    {
+	if (n)
+	    range (0, n);
+
+	return;
+    }
+
+    std::vector <TaskHandle> tasks;
+    unsigned int             size = n / chunks;
+
+    tasks.reserve (chunks - 1);
+
+    /* The calling thread takes the last chunk, which
+     * also picks up the remainder */
+    for (unsigned int i = 0; i < chunks - 1; ++i)
+	tasks.push_back (submit (boost::bind (range, i * size, (i + 1) * size)));
+
+    range ((chunks - 1) * size, n);
+
+    for (unsigned int i = 0; i < tasks.size (); ++i)
+	tasks[i].wait ();
+}
+
+unsigned int
+cc::ThreadPool::threads () const
+{
+    return priv->workers.size ();
+}
+
+cc::ThreadPool::Stats
+cc::ThreadPool::stats () const
+{
+    Stats s;
+
+    s.threads = priv->workers.size ();
+    s.queued = __atomic_load_n (&priv->stats.queued, __ATOMIC_RELAXED);
+    s.peakQueued = __atomic_load_n (&priv->stats.peakQueued, __ATOMIC_RELAXED);
+    s.running = __atomic_load_n (&priv->stats.running, __ATOMIC_RELAXED);
+    s.submitted = __atomic_load_n (&priv->stats.submitted, __ATOMIC_RELAXED);
+    s.completed = __atomic_load_n (&priv->stats.completed, __ATOMIC_RELAXED);
+    s.cancelled = __atomic_load_n (&priv->stats.cancelled, __ATOMIC_RELAXED);
+    s.stolen = __atomic_load_n (&priv->stats.stolen, __ATOMIC_RELAXED);
+
+    return s;
+}
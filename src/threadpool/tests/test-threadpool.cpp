@@ -0,0 +1,453 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <boost/bind.hpp>
+
+#include <gtest/gtest.h>
+
+#include <core/threadpool.h>
+
+namespace cc = compiz::core;
+
+namespace
+{
+    /* Stands in for the main loop: collects posted
+     * continuations until the test runs them */
+    class FakeMainLoop
+    {
+	public:
+
+	    FakeMainLoop ()
+	    {
+		pthread_mutex_init (&lock, NULL);
+	    }
+
+	    ~FakeMainLoop ()
+	    {
+		pthread_mutex_destroy (&lock);
+	    }
+
+	    void post (const cc::Work &work)
+	    {
+		pthread_mutex_lock (&lock);
+		posted.push_back (work);
+		pthread_mutex_unlock (&lock);
+	    }
+
+	    unsigned int run ()
+	    {
+		std::vector <cc::Work> work;
+
+		pthread_mutex_lock (&lock);
+		work.swap (posted);
+		pthread_mutex_unlock (&lock);
+
+		for (unsigned int i = 0; i < work.size (); ++i)
+		    work[i] ();
+
+		return work.size ();
+	    }
+
+	    cc::ThreadPool::Poster poster ()
+	    {
+		return boost::bind (&FakeMainLoop::post, this, _1);
+	    }
+
+	private:
+
+	    pthread_mutex_t        lock;
+	    std::vector <cc::Work> posted;
+    };
+
+    void
+    increment (int *value)
+    {
+	__atomic_add_fetch (value, 1, __ATOMIC_SEQ_CST);
+    }
+
+    void
+    recordThread (pthread_t *thread)
+    {
+	*thread = pthread_self ();
+    }
+
+    /* Blocks a worker until released, so tests can
+     * hold tasks in the queue behind it */
+    class Gate
+    {
+	public:
+
+	    Gate () :
+		entered (0),
+		open (0)
+	    {
+	    }
+
+	    void pass ()
+	    {
+		__atomic_store_n (&entered, 1, __ATOMIC_SEQ_CST);
+
+		while (!__atomic_load_n (&open, __ATOMIC_SEQ_CST))
+		    usleep (100);
+	    }
+
+	    void waitForEntry ()
+	    {
+		while (!__atomic_load_n (&entered, __ATOMIC_SEQ_CST))
+		    usleep (100);
+	    }
+
+	    void release ()
+	    {
+		__atomic_store_n (&open, 1, __ATOMIC_SEQ_CST);
+	    }
+
+	private:
+
+	    int entered;
+	    int open;
+    };
+
+    void
+    submitChild (cc::ThreadPool *pool, int *value)
+    {
+	pool->submit (boost::bind (increment, value)).wait ();
+	increment (value);
+    }
+
+    void
+    sumRange (std::vector <int> *values,
+	      unsigned int      begin,
+	      unsigned int      end)
+    {
+	for (unsigned int i = begin; i < end; ++i)
+	    (*values)[i] += 1;
+    }
+}
+
+TEST (ThreadPool, ZeroThreadsMeansOnePerCPU)
+{
+    FakeMainLoop   loop;
+    cc::ThreadPool pool (0, loop.poster ());
+
+    EXPECT_EQ (sysconf (_SC_NPROCESSORS_ONLN), pool.threads ());
+}
+
+TEST (ThreadPool, RunsWorkOffTheCallingThread)
+{
+    FakeMainLoop   loop;
+    cc::ThreadPool pool (2, loop.poster ());
+    pthread_t      thread = pthread_self ();
+
+    cc::TaskHandle task = pool.submit (boost::bind (recordThread, &thread));
+
+    /* Not wait (), which would run the work here if it was early */
+    while (!task.finished ())
+	usleep (100);
+
+    EXPECT_FALSE (pthread_equal (thread, pthread_self ()));
+}
+
+TEST (ThreadPool, ContinuationIsPostedAfterWork)
+{
+    FakeMainLoop   loop;
+    cc::ThreadPool pool (2, loop.poster ());
+    int            work = 0;
+    int            continuation = 0;
+
+    pool.submit (boost::bind (increment, &work),
+		 boost::bind (increment, &continuation)).wait ();
+
+    EXPECT_EQ (1, work);
+    EXPECT_EQ (0, continuation);
+}
+
+TEST (ThreadPool, ContinuationPendingUntilRun)
+{
+    FakeMainLoop   loop;
+    cc::ThreadPool pool (2, loop.poster ());
+    int            work = 0;
+    int            continuation = 0;
+
+    cc::TaskHandle task = pool.submit (boost::bind (increment, &work),
+				       boost::bind (increment, &continuation));
+
+    task.wait ();
+    EXPECT_TRUE (task.continuationPending ());
+
+    EXPECT_EQ (1, loop.run ());
+    EXPECT_EQ (1, continuation);
+    EXPECT_FALSE (task.continuationPending ());
+}
+
+TEST (ThreadPool, CancelBeforeStartSkipsWorkAndContinuation)
+{
+    FakeMainLoop   loop;
+    cc::ThreadPool pool (1, loop.poster ());
+    Gate           gate;
+    int            work = 0;
+    int            continuation = 0;
+
+    cc::TaskHandle blocker = pool.submit (boost::bind (&Gate::pass, &gate));
+    gate.waitForEntry ();
+
+    cc::TaskHandle task = pool.submit (boost::bind (increment, &work),
+				       boost::bind (increment, &continuation));
+
+    EXPECT_TRUE (task.cancel ());
+    EXPECT_TRUE (task.cancelled ());
+    EXPECT_TRUE (task.finished ());
+
+    gate.release ();
+    blocker.wait ();
+    task.wait ();
+    loop.run ();
+
+    EXPECT_EQ (0, work);
+    EXPECT_EQ (0, continuation);
+    EXPECT_EQ (1, pool.stats ().cancelled);
+}
+
+TEST (ThreadPool, CancelAfterWorkDropsPostedContinuation)
+{
+    FakeMainLoop   loop;
+    cc::ThreadPool pool (1, loop.poster ());
+    int            work = 0;
+    int            continuation = 0;
+
+    cc::TaskHandle task = pool.submit (boost::bind (increment, &work),
+				       boost::bind (increment, &continuation));
+
+    task.wait ();
+    EXPECT_FALSE (task.cancel ());
+    EXPECT_TRUE (task.cancelled ());
+
+    loop.run ();
+
+    EXPECT_EQ (1, work);
+    EXPECT_EQ (0, continuation);
+}
+
+TEST (ThreadPool, WaitRunsQueuedWorkOnCallingThread)
+{
+    FakeMainLoop   loop;
+    cc::ThreadPool pool (1, loop.poster ());
+    Gate           gate;
+    pthread_t      thread;
+
+    cc::TaskHandle blocker = pool.submit (boost::bind (&Gate::pass, &gate));
+    gate.waitForEntry ();
+
+    cc::TaskHandle task = pool.submit (boost::bind (recordThread, &thread));
+
+    task.wait ();
+    EXPECT_TRUE (pthread_equal (thread, pthread_self ()));
+
+    gate.release ();
+    blocker.wait ();
+}
+
+TEST (ThreadPool, WorkMaySubmitAndWaitForMoreWork)
+{
+    FakeMainLoop   loop;
+    cc::ThreadPool pool (2, loop.poster ());
+    int            value = 0;
+    std::vector <cc::TaskHandle> tasks;
+
+    for (unsigned int i = 0; i < 100; ++i)
+	tasks.push_back (pool.submit (boost::bind (submitChild, &pool, &value)));
+
+    for (unsigned int i = 0; i < tasks.size (); ++i)
+	tasks[i].wait ();
+
+    EXPECT_EQ (200, value);
+}
+
+TEST (ThreadPool, IdleWorkersStealQueuedTasks)
+{
+    FakeMainLoop   loop;
+    cc::ThreadPool pool (2, loop.poster ());
+    Gate           gate;
+    int            value = 0;
+
+    /* Submissions alternate between the two queues. With the first
+     * worker held up, the second has to take its share */
+    cc::TaskHandle blocker = pool.submit (boost::bind (&Gate::pass, &gate));
+    gate.waitForEntry ();
+
+    std::vector <cc::TaskHandle> tasks;
+
+    for (unsigned int i = 0; i < 10; ++i)
+	tasks.push_back (pool.submit (boost::bind (increment, &value)));
+
+    while (__atomic_load_n (&value, __ATOMIC_SEQ_CST) < 10)
+	usleep (100);
+
+    EXPECT_LT (0, pool.stats ().stolen);
+
+    gate.release ();
+    blocker.wait ();
+}
+
+TEST (ThreadPool, StatsCountTasks)
+{
+    FakeMainLoop   loop;
+    cc::ThreadPool pool (1, loop.poster ());
+    Gate           gate;
+    int            value = 0;
+
+    cc::TaskHandle blocker = pool.submit (boost::bind (&Gate::pass, &gate));
+    gate.waitForEntry ();
+
+    std::vector <cc::TaskHandle> tasks;
+
+    for (unsigned int i = 0; i < 5; ++i)
+	tasks.push_back (pool.submit (boost::bind (increment, &value)));
+
+    cc::ThreadPool::Stats stats = pool.stats ();
+
+    EXPECT_EQ (1, stats.threads);
+    EXPECT_EQ (5, stats.queued);
+    EXPECT_EQ (5, stats.peakQueued);
+    EXPECT_EQ (1, stats.running);
+
+    gate.release ();
+
+    for (unsigned int i = 0; i < tasks.size (); ++i)
+	tasks[i].wait ();
+    blocker.wait ();
+
+    stats = pool.stats ();
+
+    EXPECT_EQ (6, stats.submitted);
+    EXPECT_EQ (6, stats.completed);
+    EXPECT_EQ (5, stats.peakQueued);
+}
+
+TEST (ThreadPool, QueuedCountStaysInRange)
+{
+    FakeMainLoop   loop;
+    cc::ThreadPool pool (4, loop.poster ());
+    int            value = 0;
+
+    std::vector <cc::TaskHandle> tasks;
+
+    /* Workers take tasks as soon as they are pushed, which
+     * must never count them off before they were counted */
+    for (unsigned int i = 0; i < 2000; ++i)
+    {
+	tasks.push_back (pool.submit (boost::bind (increment, &value)));
+	EXPECT_GE (i + 1, pool.stats ().queued);
+    }
+
+    for (unsigned int i = 0; i < tasks.size (); ++i)
+	tasks[i].wait ();
+
+    while (pool.stats ().queued)
+	usleep (100);
+
+    EXPECT_GE (2000, pool.stats ().peakQueued);
+}
+
+TEST (ThreadPool, ForEachChunkCoversRangeOnce)
+{
+    FakeMainLoop      loop;
+    cc::ThreadPool    pool (3, loop.poster ());
+    std::vector <int> values (1001, 0);
+
+    pool.forEachChunk (values.size (), 16,
+		       boost::bind (sumRange, &values, _1, _2));
+
+    for (unsigned int i = 0; i < values.size (); ++i)
+	ASSERT_EQ (1, values[i]) << "at " << i;
+}
+
+TEST (ThreadPool, ForEachChunkRunsSmallRangesInline)
+{
+    FakeMainLoop      loop;
+    cc::ThreadPool    pool (3, loop.poster ());
+    std::vector <int> values (10, 0);
+
+    pool.forEachChunk (values.size (), 16,
+		       boost::bind (sumRange, &values, _1, _2));
+
+    for (unsigned int i = 0; i < values.size (); ++i)
+	EXPECT_EQ (1, values[i]);
+
+    EXPECT_EQ (0, pool.stats ().submitted);
+}
+
+namespace
+{
+    /* Opens the gate once the task has been cancelled */
+    struct ReleaseOnCancel
+    {
+	Gate           *gate;
+	cc::TaskHandle task;
+    };
+
+    void *
+    releaseOnCancel (void *data)
+    {
+	ReleaseOnCancel *release = static_cast <ReleaseOnCancel *> (data);
+
+	while (!release->task.cancelled ())
+	    usleep (100);
+
+	release->gate->release ();
+
+	return NULL;
+    }
+}
+
+TEST (ThreadPool, DestructionCancelsQueuedTasks)
+{
+    FakeMainLoop    loop;
+    Gate            gate;
+    int             value = 0;
+    ReleaseOnCancel release;
+    pthread_t       releaser;
+
+    {
+	cc::ThreadPool pool (1, loop.poster ());
+
+	pool.submit (boost::bind (&Gate::pass, &gate));
+	gate.waitForEntry ();
+
+	release.gate = &gate;
+	release.task = pool.submit (boost::bind (increment, &value));
+
+	/* The worker is held until the pool is being destroyed */
+	pthread_create (&releaser, NULL, releaseOnCancel, &release);
+    }
+
+    pthread_join (releaser, NULL);
+
+    EXPECT_TRUE (release.task.finished ());
+    EXPECT_TRUE (release.task.cancelled ());
+    EXPECT_EQ (0, value);
+    EXPECT_EQ (0, loop.run ());
+}
@@ -27,6 +27,8 @@
 #include <boost/foreach.hpp>
 #include <cmath>
 
+#include <core/trace.h>
+
 #include "privatetimeoutsource.h"
 #include "privatetimer.h"
 
@@ -224,6 +226,8 @@ CompTimer::setActive (bool active)
 bool
 CompTimer::triggerCallback ()
 {
+    COMPIZ_TRACE_SCOPE ("timer", "CompTimer");
+
     return priv->mCallBack ();
 }
 
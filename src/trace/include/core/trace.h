@@ -0,0 +1,167 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _COMPIZ_TRACE_H
+#define _COMPIZ_TRACE_H
+
+#include <ostream>
+#include <string>
+#include <typeinfo>
+
+namespace compiz
+{
+namespace trace
+{
+
+struct Event
+{
+    const char         *category;
+    const char         *name;
+    /* Mangled name of the type which handled the event, if any */
+    const char         *object;
+    unsigned long long start;
+    unsigned long long end;
+};
+
+/* Nanoseconds on the monotonic clock */
+unsigned long long now ();
+
+/* Appends an event to the ring buffer of the calling thread,
+ * overwriting the oldest event once the buffer is full. Writing
+ * never takes a lock, each thread only ever touches its own buffer.
+ * Events being overwritten while a trace is written are left out */
+void record (const char         *category,
+	     const char         *name,
+	     const char         *object,
+	     unsigned long long start,
+	     unsigned long long end);
+
+/* Number of events each thread keeps */
+unsigned int capacity ();
+
+/* Writes the events of all threads in the Chrome trace event format,
+ * which chrome://tracing and Perfetto can open */
+void writeChromeTrace (std::ostream &);
+
+/* Writes the trace to $COMPIZ_TRACE_FILE, or to compiz-trace-<pid>.json
+ * in $XDG_RUNTIME_DIR or /tmp if that is unset. New files are only readable
+ * by the user. Returns the path written, or an empty string */
+std::string dump ();
+
+/* Drops all recorded events */
+void clear ();
+
+class Scope
+{
+    public:
+
+	Scope (const char *category,
+	       const char *name,
+	       const char *object = NULL) :
+	    mCategory (category),
+	    mName (name),
+	    mObject (object),
+	    mStart (now ())
+	{
+	}
+
+	~Scope ()
+	{
+	    record (mCategory, mName, mObject, mStart, now ());
+	}
+
+    private:
+
+	Scope (const Scope &);
+	Scope & operator= (const Scope &);
+
+	const char         *mCategory;
+	const char         *mName;
+	const char         *mObject;
+	unsigned long long mStart;
+};
+
+}
+}
+
+/* Tracing is compiled in with -DCOMPIZ_TRACING=ON, otherwise these
+ * expand to nothing. The dump is triggered by sending SIGUSR1 */
+#ifdef COMPIZ_TRACING
+#define COMPIZ_TRACE_CONCAT_(a, b) a ## b
+#define COMPIZ_TRACE_CONCAT(a, b) COMPIZ_TRACE_CONCAT_ (a, b)
+
+#define COMPIZ_TRACE_SCOPE(category, name)				\
+    compiz::trace::Scope COMPIZ_TRACE_CONCAT (compizTraceScope, __LINE__)	\
+	(category, name)
+
+#define COMPIZ_TRACE_OBJECT_SCOPE(category, event, object)		\
+    compiz::trace::Scope COMPIZ_TRACE_CONCAT (compizTraceScope, __LINE__)	\
+	(category, event, typeid (object).name ())
+
+/* The same as WRAPABLE_HND_FUNCTN and WRAPABLE_HND_FUNCTN_RETURN, but
+ * records the time spent in each of the plugins wrapping the function */
+#define WRAPABLE_HND_FUNCTN_TRACED(func, ...)				\
+{									\
+    enum { num = func ## Index };                                       \
+    unsigned int curr = mCurrFunction[num];				\
+    while (mCurrFunction[num] < mInterface.size () &&			\
+           !mInterface[mCurrFunction[num]].enabled[num])		\
+	++mCurrFunction[num];						\
+    if (mCurrFunction[num] < mInterface.size ())			\
+    {									\
+	COMPIZ_TRACE_OBJECT_SCOPE ("wrap", #func,			\
+				   *mInterface[mCurrFunction[num]].obj);	\
+	mInterface[mCurrFunction[num]++].obj-> func (__VA_ARGS__);	\
+	mCurrFunction[num] = curr;					\
+	return;								\
+    }									\
+    mCurrFunction[num] = curr;						\
+}
+
+#define WRAPABLE_HND_FUNCTN_RETURN_TRACED(rtype, func, ...)		\
+{									\
+    enum { num = func ## Index };                                       \
+    unsigned int curr = mCurrFunction[num];				\
+    while (mCurrFunction[num] < mInterface.size () &&			\
+           !mInterface[mCurrFunction[num]].enabled[num])		\
+	++mCurrFunction[num];						\
+    if (mCurrFunction[num] < mInterface.size ())			\
+    {									\
+	COMPIZ_TRACE_OBJECT_SCOPE ("wrap", #func,			\
+				   *mInterface[mCurrFunction[num]].obj);	\
+	rtype rv = mInterface[mCurrFunction[num]++].obj-> func (__VA_ARGS__); \
+	mCurrFunction[num] = curr;					\
+	return rv;							\
+    }									\
+    mCurrFunction[num] = curr;						\
+}
+#else
+#define COMPIZ_TRACE_SCOPE(category, name)
+#define COMPIZ_TRACE_OBJECT_SCOPE(category, event, object)
+
+#define WRAPABLE_HND_FUNCTN_TRACED(func, ...)				\
+    WRAPABLE_HND_FUNCTN (func, __VA_ARGS__)
+
+#define WRAPABLE_HND_FUNCTN_RETURN_TRACED(rtype, func, ...)		\
+    WRAPABLE_HND_FUNCTN_RETURN (rtype, func, __VA_ARGS__)
+#endif
+
+#endif
@@ -0,0 +1,333 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <cxxabi.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include <core/trace.h>
+
+namespace ct = compiz::trace;
+
+namespace
+{
+    const unsigned int Capacity = 1 << 15;
+
+    /* An event and the number of the write which filled it in, plus
+     * one. That is zero while the owner is rewriting the slot, so a
+     * reader can tell when the slot changed under it */
+    struct Slot
+    {
+	ct::Event          event;
+	unsigned long long sequence;
+    };
+
+    struct Buffer
+    {
+	Buffer () :
+	    written (0),
+	    cleared (0),
+	    thread (syscall (SYS_gettid))
+	{
+	}
+
+	Slot               slots[Capacity];
+	/* Total number of events ever written, only
+	 * stored to by the thread owning the buffer */
+	unsigned long long written;
+	/* Events before this one were dropped by clear (),
+	 * which leaves written to the owner */
+	unsigned long long cleared;
+	long               thread;
+    };
+
+    /* Only held to register new threads and to read the buffers */
+    pthread_mutex_t       buffersMutex = PTHREAD_MUTEX_INITIALIZER;
+    std::vector <Buffer *> buffers;
+
+    __thread Buffer *threadBuffer = NULL;
+
+    Buffer *
+    currentBuffer ()
+    {
+	if (!threadBuffer)
+	{
+	    threadBuffer = new Buffer;
+
+	    pthread_mutex_lock (&buffersMutex);
+	    buffers.push_back (threadBuffer);
+	    pthread_mutex_unlock (&buffersMutex);
+	}
+
+	return threadBuffer;
+    }
+
+    std::string
+    demangle (const char *mangled)
+    {
+	int        status;
+	char       *name = abi::__cxa_demangle (mangled, NULL, NULL, &status);
+	std::string result (status == 0 && name ? name : mangled);
+
+	free (name);
+
+	return result;
+    }
+
+    void
+    writeString (std::ostream &os, const std::string &str)
+    {
+	os << '"';
+
+	for (std::string::const_iterator it = str.begin (); it != str.end (); ++it)
+	{
+	    if (*it == '"' || *it == '\\')
+		os << '\\' << *it;
+	    else if ((unsigned char) *it < 0x20)
+		os << ' ';
+	    else
+		os << *it;
+	}
+
+	os << '"';
+    }
+
+    /* Copies out event number index of buffer. Fails if the owner
+     * has overwritten it, or is doing so right now */
+    bool
+    readEvent (Buffer             *buffer,
+	       unsigned long long index,
+	       ct::Event          &event)
+    {
+	Slot               &slot = buffer->slots[index % Capacity];
+	unsigned long long sequence = __atomic_load_n (&slot.sequence,
+							__ATOMIC_ACQUIRE);
+
+	if (sequence != index + 1)
+	    return false;
+
+	event.category = __atomic_load_n (&slot.event.category, __ATOMIC_RELAXED);
+	event.name     = __atomic_load_n (&slot.event.name, __ATOMIC_RELAXED);
+	event.object   = __atomic_load_n (&slot.event.object, __ATOMIC_RELAXED);
+	event.start    = __atomic_load_n (&slot.event.start, __ATOMIC_RELAXED);
+	event.end      = __atomic_load_n (&slot.event.end, __ATOMIC_RELAXED);
+
+	__atomic_thread_fence (__ATOMIC_ACQUIRE);
+
+	return __atomic_load_n (&slot.sequence, __ATOMIC_RELAXED) == sequence;
+    }
+
+    void
+    writeMicroseconds (std::ostream &os, unsigned long long ns)
+    {
+	char buf[32];
+
+	snprintf (buf, sizeof (buf), "%llu.%03llu", ns / 1000, ns % 1000);
+	os << buf;
+    }
+}
+
+unsigned long long
+ct::now ()
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void
+ct::record (const char         *category,
+	    const char         *name,
+	    const char         *object,
+	    unsigned long long start,
+	    unsigned long long end)
+{
+    Buffer             *buffer  = currentBuffer ();
+    unsigned long long written = buffer->written;
+    Slot               &slot   = buffer->slots[written % Capacity];
+
+    __atomic_store_n (&slot.sequence, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence (__ATOMIC_RELEASE);
+
+    __atomic_store_n (&slot.event.category, category, __ATOMIC_RELAXED);
+    __atomic_store_n (&slot.event.name, name, __ATOMIC_RELAXED);
+    __atomic_store_n (&slot.event.object, object, __ATOMIC_RELAXED);
+    __atomic_store_n (&slot.event.start, start, __ATOMIC_RELAXED);
+    __atomic_store_n (&slot.event.end, end, __ATOMIC_RELAXED);
+
+    /* Publish the event only once it is complete */
+    __atomic_store_n (&slot.sequence, written + 1, __ATOMIC_RELEASE);
+    __atomic_store_n (&buffer->written, written + 1, __ATOMIC_RELEASE);
+}
+
+unsigned int
+ct::capacity ()
+{
+    return Capacity;
+}
+
+void
+ct::writeChromeTrace (std::ostream &os)
+{
+    std::map <const char *, std::string> objects;
+    bool                                 first = true;
+    pid_t                                pid = getpid ();
+
+    os << "{\"traceEvents\":[";
+
+    pthread_mutex_lock (&buffersMutex);
+
+    for (std::vector <Buffer *>::iterator it = buffers.begin ();
+	 it != buffers.end (); ++it)
+    {
+	Buffer             *buffer  = *it;
+	unsigned long long written = __atomic_load_n (&buffer->written,
+						      __ATOMIC_ACQUIRE);
+	unsigned long long cleared = __atomic_load_n (&buffer->cleared,
+						      __ATOMIC_ACQUIRE);
+	unsigned long long i       = written > Capacity ? written - Capacity : 0;
+
+	for (i = std::max (i, cleared); i < written; ++i)
+	{
+	    Event event;
+
+	    /* The owner may be overwriting the oldest events */
+	    if (!readEvent (buffer, i, event))
+		continue;
+
+	    std::string name (event.name);
+
+	    if (event.object)
+	    {
+		std::map <const char *, std::string>::iterator o =
+		    objects.find (event.object);
+
+		if (o == objects.end ())
+		    o = objects.insert (std::make_pair (event.object,
+							demangle (event.object))).first;
+
+		name = o->second + "::" + name;
+	    }
+
+	    if (!first)
+		os << ',';
+
+	    first = false;
+
+	    os << "{\"name\":";
+	    writeString (os, name);
+	    os << ",\"cat\":";
+	    writeString (os, event.category);
+	    os << ",\"ph\":\"X\",\"ts\":";
+	    writeMicroseconds (os, event.start);
+	    os << ",\"dur\":";
+	    writeMicroseconds (os, event.end - event.start);
+	    os << ",\"pid\":" << pid << ",\"tid\":" << buffer->thread << '}';
+	}
+    }
+
+    pthread_mutex_unlock (&buffersMutex);
+
+    os << "]}" << std::endl;
+}
+
+std::string
+ct::dump ()
+{
+    const char *env = getenv ("COMPIZ_TRACE_FILE");
+    std::string path;
+    int         flags = O_WRONLY | O_CREAT | O_NOFOLLOW | O_CLOEXEC;
+
+    if (env && *env)
+	path = env;
+    else
+    {
+	const char         *dir = getenv ("XDG_RUNTIME_DIR");
+	std::ostringstream ss;
+
+	ss << (dir && *dir ? dir : "/tmp")
+	   << "/compiz-trace-" << getpid () << ".json";
+	path = ss.str ();
+
+	/* The name is easy to guess, so never write through a file
+	 * somebody else put there. A dump of our own is replaced */
+	unlink (path.c_str ());
+	flags |= O_EXCL;
+    }
+
+    int fd = open (path.c_str (), flags | O_TRUNC, 0600);
+
+    if (fd < 0)
+	return std::string ();
+
+    std::ostringstream trace;
+
+    writeChromeTrace (trace);
+
+    std::string data (trace.str ());
+    size_t      done = 0;
+
+    while (done < data.size ())
+    {
+	ssize_t n = write (fd, data.data () + done, data.size () - done);
+
+	if (n < 0 && errno == EINTR)
+	    continue;
+
+	if (n <= 0)
+	    break;
+
+	done += n;
+    }
+
+    if (close (fd) < 0 || done < data.size ())
+	return std::string ();
+
+    return path;
+}
+
+void
+ct::clear ()
+{
+    pthread_mutex_lock (&buffersMutex);
+
+    /* Only the owner stores to written */
+    for (std::vector <Buffer *>::iterator it = buffers.begin ();
+	 it != buffers.end (); ++it)
+	__atomic_store_n (&(*it)->cleared,
+			  __atomic_load_n (&(*it)->written, __ATOMIC_ACQUIRE),
+			  __ATOMIC_RELEASE);
+
+    pthread_mutex_unlock (&buffersMutex);
+}
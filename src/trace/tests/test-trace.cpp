@@ -0,0 +1,252 @@
+/*
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of the
+ * authors not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * The authors make no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * THE AUTHORS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <core/trace.h>
+
+namespace ct = compiz::trace;
+
+namespace
+{
+    class PaintingThing
+    {
+    };
+
+    unsigned int
+    occurrences (const std::string &haystack, const std::string &needle)
+    {
+	unsigned int           count = 0;
+	std::string::size_type pos = haystack.find (needle);
+
+	while (pos != std::string::npos)
+	{
+	    ++count;
+	    pos = haystack.find (needle, pos + needle.size ());
+	}
+
+	return count;
+    }
+
+    void *
+    recordFromThread (void *)
+    {
+	ct::Scope scope ("test", "threaded");
+	return NULL;
+    }
+
+    /* Every event lasts exactly 1ns, so a torn
+     * one shows up with another duration */
+    void *
+    recordUntilStopped (void *data)
+    {
+	int                *stop = static_cast <int *> (data);
+	unsigned long long i = 0;
+
+	while (!__atomic_load_n (stop, __ATOMIC_ACQUIRE))
+	{
+	    ct::record ("test", "busy", NULL, i * 1000, i * 1000 + 1);
+	    ++i;
+	}
+
+	return NULL;
+    }
+}
+
+class TraceTest :
+    public ::testing::Test
+{
+    public:
+
+	void SetUp ()
+	{
+	    ct::clear ();
+	}
+
+	std::string trace ()
+	{
+	    std::ostringstream ss;
+
+	    ct::writeChromeTrace (ss);
+	    return ss.str ();
+	}
+};
+
+TEST_F (TraceTest, EmptyTrace)
+{
+    EXPECT_EQ ("{\"traceEvents\":[]}\n", trace ());
+}
+
+TEST_F (TraceTest, ScopeRecordsCompleteEvent)
+{
+    {
+	ct::Scope scope ("paint", "handlePaintTimeout");
+    }
+
+    std::string result (trace ());
+
+    EXPECT_EQ (1, occurrences (result, "\"name\":\"handlePaintTimeout\""));
+    EXPECT_EQ (1, occurrences (result, "\"cat\":\"paint\""));
+    EXPECT_EQ (1, occurrences (result, "\"ph\":\"X\""));
+}
+
+TEST_F (TraceTest, NestedScopes)
+{
+    {
+	ct::Scope outer ("paint", "outer");
+	ct::Scope inner ("paint", "inner");
+    }
+
+    std::string result (trace ());
+
+    EXPECT_EQ (2, occurrences (result, "\"ph\":\"X\""));
+    /* The inner scope ends first */
+    EXPECT_LT (result.find ("\"inner\""), result.find ("\"outer\""));
+}
+
+TEST_F (TraceTest, ObjectNameIsDemangled)
+{
+    PaintingThing thing;
+
+    {
+	ct::Scope scope ("wrap", "glPaint", typeid (thing).name ());
+    }
+
+    EXPECT_EQ (1, occurrences (trace (), "\"name\":\"(anonymous namespace)::PaintingThing::glPaint\""));
+}
+
+TEST_F (TraceTest, RingKeepsNewestEvents)
+{
+    for (unsigned int i = 0; i < ct::capacity (); ++i)
+	ct::record ("test", "old", NULL, 0, 1);
+
+    for (unsigned int i = 0; i < 10; ++i)
+	ct::record ("test", "new", NULL, 2, 3);
+
+    std::string result (trace ());
+
+    EXPECT_EQ (10, occurrences (result, "\"name\":\"new\""));
+    EXPECT_EQ (ct::capacity () - 10, occurrences (result, "\"name\":\"old\""));
+}
+
+TEST_F (TraceTest, EventsFromOtherThreads)
+{
+    pthread_t thread;
+
+    {
+	ct::Scope scope ("test", "main");
+    }
+
+    ASSERT_EQ (0, pthread_create (&thread, NULL, recordFromThread, NULL));
+    pthread_join (thread, NULL);
+
+    std::string result (trace ());
+
+    EXPECT_EQ (1, occurrences (result, "\"name\":\"main\""));
+    EXPECT_EQ (1, occurrences (result, "\"name\":\"threaded\""));
+}
+
+TEST_F (TraceTest, ClearedEventsStayDropped)
+{
+    for (unsigned int i = 0; i < ct::capacity () + 10; ++i)
+	ct::record ("test", "old", NULL, 0, 1);
+
+    ct::clear ();
+
+    for (unsigned int i = 0; i < 10; ++i)
+	ct::record ("test", "new", NULL, 2, 3);
+
+    std::string result (trace ());
+
+    EXPECT_EQ (10, occurrences (result, "\"name\":\"new\""));
+    EXPECT_EQ (0, occurrences (result, "\"name\":\"old\""));
+}
+
+TEST_F (TraceTest, TraceWhileAnotherThreadRecords)
+{
+    pthread_t thread;
+    int       stop = 0;
+
+    ASSERT_EQ (0, pthread_create (&thread, NULL, recordUntilStopped, &stop));
+
+    for (unsigned int i = 0; i < 20; ++i)
+    {
+	std::string result (trace ());
+
+	EXPECT_EQ (occurrences (result, "\"name\":\"busy\""),
+		   occurrences (result, "\"dur\":0.001,"));
+
+	ct::clear ();
+    }
+
+    __atomic_store_n (&stop, 1, __ATOMIC_RELEASE);
+    pthread_join (thread, NULL);
+}
+
+TEST_F (TraceTest, DumpDoesNotFollowSymlinks)
+{
+    char dir[] = "/tmp/compiz-trace-test-XXXXXX";
+
+    ASSERT_TRUE (mkdtemp (dir));
+
+    std::ostringstream path;
+    std::string        victim (std::string (dir) + "/victim");
+
+    path << dir << "/compiz-trace-" << getpid () << ".json";
+
+    std::ofstream (victim.c_str ()) << "untouched";
+    ASSERT_EQ (0, symlink (victim.c_str (), path.str ().c_str ()));
+
+    unsetenv ("COMPIZ_TRACE_FILE");
+    setenv ("XDG_RUNTIME_DIR", dir, 1);
+
+    {
+	ct::Scope scope ("test", "dumped");
+    }
+
+    EXPECT_EQ (path.str (), ct::dump ());
+
+    std::string   contents;
+    std::ifstream (victim.c_str ()) >> contents;
+    EXPECT_EQ ("untouched", contents);
+
+    struct stat st;
+
+    ASSERT_EQ (0, lstat (path.str ().c_str (), &st));
+    EXPECT_TRUE (S_ISREG (st.st_mode));
+    EXPECT_EQ (0600, st.st_mode & 0777);
+
+    /* Dumping again replaces our own file */
+    EXPECT_EQ (path.str (), ct::dump ());
+
+    unlink (path.str ().c_str ());
+    unlink (victim.c_str ());
+    rmdir (dir);
+}
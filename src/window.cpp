@@ -33,6 +33,7 @@
 #include <strings.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <limits.h>
 #include <assert.h>
 #include <math.h>
 
@@ -48,6 +49,7 @@
 #include "privatestackdebugger.h"
 
 #include "configurerequestbuffer-impl.h"
+#include "restackbatch.h"
 
 #include <boost/scoped_array.hpp>
 
@@ -926,9 +928,8 @@ PrivateWindow::updateRegion ()
     {
 	int order;
 
-	/* We should update the server here */
-	XSync (screen->dpy (), false);
-
+	/* No need to XSync here, the replies to these requests
+	 * already reflect everything we have sent before them */
 	boundingShapeRects = XShapeGetRectangles (screen->dpy (),
 						  priv->id,
 						  ShapeBounding,
@@ -1175,6 +1176,8 @@ CompWindow::destroy ()
     {
 	StackDebugger *dbg = StackDebugger::Default ();
 
+	priv->cancelTasks ();
+
 	windowNotify (CompWindowNotifyBeforeDestroy);
 
 	/* Don't allow frame windows to block input */
@@ -1353,6 +1356,11 @@ CompWindow::map ()
 	}
     }
 
+    /* MapNotify changes the map state, shading and management of the
+     * window without a matchPropertyChanged, handlers of the map
+     * notification must not see results from before the map */
+    priv->matchResults.invalidate ();
+
     windowNotify (CompWindowNotifyMap);
     /* Send a resizeNotify to plugins to indicate
      * that the map is complete */
@@ -2916,6 +2924,15 @@ static bool isPendingRestack (const compiz::X11::PendingEvent::Ptr &p)
     return pc->matchVM (CWStackMode | CWSibling);
 }
 
+bool
+PrivateWindow::restackPending ()
+{
+    if (pendingConfigures.forEachIf (boost::bind (isPendingRestack, _1)))
+	return true;
+
+    return serverFrame && crb::RestackBatch::Default ().pending (serverFrame);
+}
+
 static bool isExistingRequest (const compiz::X11::PendingEvent::Ptr &p,
 			       XWindowChanges                       &xwc,
 			       unsigned int                         valueMask)
@@ -2929,12 +2946,14 @@ static bool isExistingRequest (const compiz::X11::PendingEvent::Ptr &p,
 bool
 PrivateWindow::queryAttributes (XWindowAttributes &attrib)
 {
+    crb::RestackBatch::Default ().flush ();
     return configureBuffer->queryAttributes (attrib);
 }
 
 bool
 PrivateWindow::queryFrameAttributes (XWindowAttributes &attrib)
 {
+    crb::RestackBatch::Default ().flush ();
     return configureBuffer->queryFrameAttributes (attrib);
 }
 
@@ -2950,6 +2969,10 @@ int
 PrivateWindow::requestConfigureOnClient (const XWindowChanges &xwc,
 					 unsigned int         valueMask)
 {
+    /* Keep restacks of the client in order with the queued ones */
+    if (valueMask & (CWStackMode | CWSibling))
+	crb::RestackBatch::Default ().flush ();
+
     return XConfigureWindow (screen->dpy (),
 			     id,
 			     valueMask,
@@ -2960,6 +2983,9 @@ int
 PrivateWindow::requestConfigureOnWrapper (const XWindowChanges &xwc,
 					  unsigned int         valueMask)
 {
+    if (valueMask & (CWStackMode | CWSibling))
+	crb::RestackBatch::Default ().flush ();
+
     return XConfigureWindow (screen->dpy (),
 			     wrapper,
 			     valueMask,
@@ -2969,6 +2995,28 @@ PrivateWindow::requestConfigureOnWrapper (const XWindowChanges &xwc,
 int
 PrivateWindow::requestConfigureOnFrame (const XWindowChanges &xwc,
 					unsigned int         frameValueMask)
+{
+    unsigned int stackMask = frameValueMask & (CWStackMode | CWSibling);
+
+    /* Restacks requested while handling events are collected and
+     * go out together once all of the pending events are handled.
+     * The geometry goes out right away so that the frame stays in
+     * step with the wrapper and client */
+    if (stackMask &&
+	crb::RestackBatch::Default ().add (serverFrame, xwc, stackMask,
+					   boost::bind (&PrivateWindow::sendConfigureOnFrame,
+							this, _1, _2)))
+	frameValueMask &= ~stackMask;
+
+    if (frameValueMask)
+	sendConfigureOnFrame (xwc, frameValueMask);
+
+    return 1;
+}
+
+void
+PrivateWindow::sendConfigureOnFrame (const XWindowChanges &xwc,
+				     unsigned int         frameValueMask)
 {
     XWindowChanges wc = xwc;
 
@@ -2985,7 +3033,7 @@ PrivateWindow::requestConfigureOnFrame (const XWindowChanges &xwc,
 
     pendingConfigures.add (pc);
 
-    return XConfigureWindow (screen->dpy (), serverFrame, frameValueMask, &wc);
+    XConfigureWindow (screen->dpy (), serverFrame, frameValueMask, &wc);
 }
 
 void
@@ -3062,7 +3110,7 @@ PrivateWindow::reconfigureXWindow (unsigned int   valueMask,
 	ROOTPARENT (window->serverPrev) == xwc->sibling)
     {
 	bool matchingRequest = priv->pendingConfigures.forEachIf (boost::bind (isExistingRequest, _1, *xwc, valueMask));
-	bool restackPending  = window->serverPrev->priv->pendingConfigures.forEachIf (boost::bind (isPendingRestack, _1));
+	bool restackPending  = window->serverPrev->priv->restackPending ();
 	bool remove          = matchingRequest;
 
 	if (!remove)
@@ -4085,6 +4133,7 @@ PrivateWindow::addWindowStackChanges (XWindowChanges   *xwc,
 
 		/* Below with no sibling puts the window at the bottom
 		 * of the stack */
+		crb::RestackBatch::Default ().flush ();
 		XConfigureWindow (screen->dpy (), ROOTPARENT (window), valueMask, &lxwc);
 
 		/* Update the list of windows last sent to the server */
@@ -4094,7 +4143,7 @@ PrivateWindow::addWindowStackChanges (XWindowChanges   *xwc,
 	    else if (sibling)
 	    {
 		bool matchingRequest = priv->pendingConfigures.forEachIf (boost::bind (isExistingRequest, _1, *xwc, (CWStackMode | CWSibling)));
-		bool restackPending  = window->serverPrev->priv->pendingConfigures.forEachIf (boost::bind (isPendingRestack, _1));
+		bool restackPending  = window->serverPrev->priv->restackPending ();
 		bool processAnyways  = restackPending;
 
 		if (matchingRequest)
@@ -4989,92 +5038,140 @@ PrivateWindow::readIconHint ()
     if (maskImage)
 	XDestroyImage (maskImage);
 
+    iconSizes.push_back (CompSize (width, height));
+    iconOffsets.push_back (-1);
     icons.push_back (icon);
 }
 
-/* returns icon with dimensions as close as possible to width and height
-   but never greater. */
-CompIcon *
-CompWindow::getIcon (int width,
-		     int height)
+void
+PrivateWindow::readIconSizes ()
 {
-    CompIcon     *icon;
-    int          wh, diff, oldDiff;
-    unsigned int i;
+    Atom          actual;
+    int           format;
+    unsigned long n, left;
+    unsigned char *data;
 
-    /* need to fetch icon property */
-    if (priv->icons.size () == 0 && !priv->noIcons)
+    /* A single round trip for every icon, the pixels are only
+       converted once an icon of that size is actually used */
+    int result = XGetWindowProperty (screen->dpy (), id, Atoms::wmIcon,
+				     0L, LONG_MAX, false, XA_CARDINAL,
+				     &actual, &format, &n, &left, &data);
+
+    if (result != Success || !data)
+	return;
+
+    unsigned long *idata = (unsigned long *) data;
+    unsigned long offset = 0;
+
+    while (format == 32 && n - offset > 2)
     {
-	Atom          actual;
-	int           format;
-	unsigned long n, left;
-	unsigned char *data;
+	unsigned long iw = idata[offset];
+	unsigned long ih = idata[offset + 1];
 
-	int result = XGetWindowProperty (screen->dpy (), priv->id, Atoms::wmIcon,
-					 0L, 65536L, false, XA_CARDINAL,
-					 &actual, &format, &n, &left, &data);
+	/* iw * ih may be larger than the value range of unsigned
+	 * long, so better do some checking for extremely weird
+	 * icon sizes first */
+	if (iw > 2048 || ih > 2048 || iw * ih > n - offset - 2)
+	    break;
 
-	if (result == Success && data)
+	if (iw && ih)
 	{
-	    CARD32        *p;
-	    CARD32        alpha, red, green, blue;
-	    unsigned long iw, ih;
-	    unsigned long *idata;
+	    iconSizes.push_back (CompSize (iw, ih));
+	    iconOffsets.push_back (iconPixels.size ());
+	    icons.push_back (NULL);
 
-	    for (i = 0; i + 2 < n; i += iw * ih + 2)
-	    {
-		idata = (unsigned long *) data;
+	    iconPixels.insert (iconPixels.end (),
+			       idata + offset + 2,
+			       idata + offset + 2 + iw * ih);
+	}
 
-		iw = idata[i];
-		ih = idata[i + 1];
+	offset += 2 + iw * ih;
+    }
 
-		/* iw * ih may be larger than the value range of unsigned
-		* long, so better do some checking for extremely weird
-		* icon sizes first */
-		if (iw > 2048 || ih > 2048 || iw * ih + 2 > n - i)
-		    break;
+    XFree (data);
+}
 
-		if (iw && ih)
-		{
-		    icon = new CompIcon (iw, ih);
+CompIcon *
+PrivateWindow::readIcon (unsigned int index)
+{
+    long           length = iconSizes[index].width () *
+			    iconSizes[index].height ();
+    CompIcon       *icon = new CompIcon (iconSizes[index].width (),
+					 iconSizes[index].height ());
+    CARD32         *p = (CARD32 *) (icon->data ());
+    const uint32_t *idata = &iconPixels[iconOffsets[index]];
+    CARD32         alpha, red, green, blue;
 
-		    if (!icon)
-			continue;
+    /* EWMH doesn't say if icon data is premultiplied or
+       not but most applications seem to assume data should
+       be unpremultiplied. */
+    for (long j = 0; j < length; ++j)
+    {
+	alpha = (idata[j] >> 24) & 0xff;
+	red   = (idata[j] >> 16) & 0xff;
+	green = (idata[j] >>  8) & 0xff;
+	blue  = (idata[j] >>  0) & 0xff;
 
-		    priv->icons.push_back (icon);
+	red   = (red   * alpha) >> 8;
+	green = (green * alpha) >> 8;
+	blue  = (blue  * alpha) >> 8;
 
-		    p = (CARD32 *) (icon->data ());
+	p[j] =
+	    (alpha << 24) |
+	    (red   << 16) |
+	    (green <<  8) |
+	    (blue  <<  0);
+    }
 
-		    /* EWMH doesn't say if icon data is premultiplied or
-		       not but most applications seem to assume data should
-		       be unpremultiplied. */
-		    for (unsigned long j = 0; j < iw * ih; ++j)
-		    {
-			alpha = (idata[i + j + 2] >> 24) & 0xff;
-			red   = (idata[i + j + 2] >> 16) & 0xff;
-			green = (idata[i + j + 2] >>  8) & 0xff;
-			blue  = (idata[i + j + 2] >>  0) & 0xff;
-
-			red   = (red   * alpha) >> 8;
-			green = (green * alpha) >> 8;
-			blue  = (blue  * alpha) >> 8;
-
-			p[j] =
-			    (alpha << 24) |
-			    (red   << 16) |
-			    (green <<  8) |
-			    (blue  <<  0);
-		    }
-		}
-	    }
+    return icon;
+}
 
-	    XFree (data);
-	}
-	else if (priv->hints && (priv->hints->flags & IconPixmapHint))
+void
+PrivateWindow::addTask (const compiz::core::TaskHandle &task)
+{
+    std::list<compiz::core::TaskHandle>::iterator it = tasks.begin ();
+
+    while (it != tasks.end ())
+    {
+	if (it->finished () && !it->continuationPending ())
+	    it = tasks.erase (it);
+	else
+	    ++it;
+    }
+
+    tasks.push_back (task);
+}
+
+void
+PrivateWindow::cancelTasks ()
+{
+    foreach (compiz::core::TaskHandle &task, tasks)
+	task.cancel ();
+
+    tasks.clear ();
+}
+
+/* returns icon with dimensions as close as possible to width and height
+   but never greater. */
+CompIcon *
+CompWindow::getIcon (int width,
+		     int height)
+{
+    int          wh, diff, oldDiff;
+    int          best = -1;
+    unsigned int i;
+
+    /* need to fetch icon property */
+    if (priv->iconSizes.size () == 0 && !priv->noIcons)
+    {
+	priv->readIconSizes ();
+
+	if (priv->iconSizes.size () == 0 &&
+	    priv->hints && (priv->hints->flags & IconPixmapHint))
 	    priv->readIconHint ();
 
 	/* don't fetch property again */
-	if (priv->icons.size () == 0)
+	if (priv->iconSizes.size () == 0)
 	    priv->noIcons = true;
     }
 
@@ -5082,30 +5179,38 @@ CompWindow::getIcon (int width,
     if (priv->noIcons)
 	return NULL;
 
-    icon = NULL;
-    wh   = width + height;
+    wh = width + height;
 
-    for (i = 0; i < priv->icons.size (); ++i)
+    for (i = 0; i < priv->iconSizes.size (); ++i)
     {
-	const CompSize iconSize = *priv->icons[i];
+	const CompSize &iconSize = priv->iconSizes[i];
 
 	if ((int) iconSize.width ()  > width ||
 	    (int) iconSize.height () > height)
 	    continue;
 
-	if (icon)
+	if (best >= 0)
 	{
+	    const CompSize &bestSize = priv->iconSizes[best];
+
 	    diff    = wh - (iconSize.width () + iconSize.height ());
-	    oldDiff = wh - (icon->width ()    + icon->height ());
+	    oldDiff = wh - (bestSize.width () + bestSize.height ());
 
 	    if (diff < oldDiff)
-		icon = priv->icons[i];
+		best = i;
 	}
 	else
-	    icon = priv->icons[i];
+	    best = i;
     }
 
-    return icon;
+    if (best < 0)
+	return NULL;
+
+    /* only fetch the pixels of the icon that is actually used */
+    if (!priv->icons[best])
+	priv->icons[best] = priv->readIcon (best);
+
+    return priv->icons[best];
 }
 
 const CompRect&
@@ -5120,6 +5225,9 @@ PrivateWindow::freeIcons ()
     for (unsigned int i = 0; i < priv->icons.size (); ++i)
 	delete priv->icons[i];
 
+    priv->iconSizes.resize (0);
+    priv->iconOffsets.resize (0);
+    priv->iconPixels.clear ();
     priv->icons.resize (0);
     priv->noIcons = false;
 }
@@ -6208,6 +6316,8 @@ CompWindow::CompWindow (Window            aboveId,
 
 CompWindow::~CompWindow ()
 {
+    priv->cancelTasks ();
+
     if (priv->serverFrame)
 	priv->unreparent ();
 
@@ -6414,6 +6524,9 @@ PrivateWindow::PrivateWindow () :
 
     struts (0),
 
+    iconSizes (),
+    iconOffsets (),
+    iconPixels (),
     icons (0),
     noIcons (false),
 
@@ -6433,7 +6546,8 @@ PrivateWindow::PrivateWindow () :
 	crb::ConfigureRequestBuffer::Create (
 	    this,
 	    &syncServerWindow,
-	    boost::bind (createConfigureBufferLock, _1)))
+	    boost::bind (createConfigureBufferLock, _1))),
+    stackingHandle (NULL)
 {
     input.left   = 0;
     input.right  = 0;
@@ -6459,7 +6573,10 @@ PrivateWindow::~PrivateWindow ()
     syncWaitTimer.stop ();
 
     if (serverFrame)
+    {
+	crb::RestackBatch::Default ().remove (serverFrame);
 	XDestroyWindow (screen->dpy (), serverFrame);
+    }
     else if (frame)
 	XDestroyWindow (screen->dpy (), frame);
 
@@ -6469,7 +6586,7 @@ PrivateWindow::~PrivateWindow ()
     if (hints)
 	XFree (hints);
 
-    if (icons.size ())
+    if (iconSizes.size ())
 	freeIcons ();
 
     if (startupId)
@@ -6789,6 +6906,8 @@ PrivateWindow::reparent ()
     foreach (CompWindow *w, screen->windows ())
 	w->priv->configureBuffer->forceRelease ();
 
+    crb::RestackBatch::Default ().flush ();
+
     if (!window->priv->queryAttributes (wa))
     {
 	XUngrabServer (dpy);
@@ -7037,6 +7156,7 @@ PrivateWindow::unreparent ()
     XWindowAttributes wa;
     StackDebugger     *dbg      = StackDebugger::Default ();
 
+    crb::RestackBatch::Default ().flush ();
     XSync (dpy, false);
 
     if (XCheckTypedWindowEvent (dpy, id, DestroyNotify, &e))
@@ -0,0 +1,366 @@
+/*
+ * Compiz XOrg GTest, headless frame time benchmark
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <gtest/gtest.h>
+#include <xorg/gtest/xorg-gtest.h>
+#include <compiz-xorg-gtest.h>
+
+#include <gtest_shared_tmpenv.h>
+
+#include <X11/Xlib.h>
+
+namespace ct = compiz::testing;
+
+/*
+ * Runs compiz with the composite, opengl and bench plugins against the
+ * headless server, drives a scripted workload of damage, moves and
+ * resizes on a number of windows and leaves the JSON frame timings
+ * recorded by the bench plugin in COMPIZ_BENCH_OUTPUT.
+ *
+ * The workload is tuned with these environment variables:
+ *
+ * COMPIZ_BENCH_OUTPUT  - where to write the results
+ *                        (default: compiz-bench.json)
+ * COMPIZ_BENCH_WINDOWS - number of windows (default: 16)
+ * COMPIZ_BENCH_FRAMES  - number of frames to record (default: 300)
+ * COMPIZ_BENCH_PLUGINS - comma separated list of additional plugins
+ *                        to load, eg. effect plugins
+ *
+ * The OptionLoadingStartup benchmark instead starts compiz a number of
+ * times with and without the ccp plugin and reports how much of the time
+ * until startup is spent loading the options of every other plugin from
+ * the compizconfig context. It uses the backend and profile the
+ * environment selects, and is tuned with:
+ *
+ * COMPIZ_BENCH_STARTUP_PLUGINS - comma separated list of plugins whose
+ *                                options are loaded
+ *                                (default: move,resize,place,grid,scale,
+ *                                          wall,expo)
+ * COMPIZ_BENCH_STARTUP_RUNS    - number of startups of each kind
+ *                                (default: 5)
+ */
+
+namespace
+{
+const char *DEFAULT_OUTPUT = "compiz-bench.json";
+const unsigned int DEFAULT_WINDOWS = 16;
+const unsigned int DEFAULT_FRAMES = 300;
+
+const char *DEFAULT_STARTUP_PLUGINS = "move,resize,place,grid,scale,wall,expo";
+const unsigned int DEFAULT_STARTUP_RUNS = 5;
+
+const unsigned int BENCH_WINDOW_WIDTH = 200;
+const unsigned int BENCH_WINDOW_HEIGHT = 150;
+
+/* Give up if the recording isn't finished after this many seconds */
+const int MAXIMUM_RUN_TIME = 120;
+
+/* Roughly one step of the workload per frame at 60Hz */
+const unsigned int STEP_INTERVAL_US = 16000;
+
+std::string
+EnvOr (const char *name, const std::string &fallback)
+{
+    const char *value = getenv (name);
+    return value ? value : fallback;
+}
+
+unsigned int
+EnvOr (const char *name, unsigned int fallback)
+{
+    const char *value = getenv (name);
+    return value ? atoi (value) : fallback;
+}
+
+std::string
+ToString (unsigned int value)
+{
+    std::stringstream ss;
+    ss << value;
+    return ss.str ();
+}
+
+bool
+FileExists (const std::string &path)
+{
+    struct stat st;
+    return stat (path.c_str (), &st) == 0;
+}
+
+bool Advance (Display *d, bool r)
+{
+    return ct::AdvanceToNextEventOnSuccess (d, r);
+}
+
+void
+AppendPlugins (ct::CompizProcess::PluginList &list,
+	       const std::string             &names)
+{
+    std::stringstream ss (names);
+    std::string       name;
+
+    while (std::getline (ss, name, ','))
+	if (!name.empty ())
+	    list.push_back (ct::CompizProcess::Plugin (name.c_str (),
+						       ct::CompizProcess::Real));
+}
+
+double
+MonotonicMs ()
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+double
+Median (std::vector <double> samples)
+{
+    std::sort (samples.begin (), samples.end ());
+
+    return samples[samples.size () / 2];
+}
+}
+
+class CompizXorgSystemBenchmark :
+    public ct::CompizXorgSystemTest
+{
+    public:
+
+	CompizXorgSystemBenchmark () :
+	    output (EnvOr ("COMPIZ_BENCH_OUTPUT", DEFAULT_OUTPUT)),
+	    nWindows (EnvOr ("COMPIZ_BENCH_WINDOWS", DEFAULT_WINDOWS)),
+	    nFrames (EnvOr ("COMPIZ_BENCH_FRAMES", DEFAULT_FRAMES)),
+	    /* Render with llvmpipe, so results don't depend on a GPU */
+	    softwareGL ("LIBGL_ALWAYS_SOFTWARE", "1"),
+	    galliumDriver ("GALLIUM_DRIVER", "llvmpipe"),
+	    recordFile ("COMPIZ_BENCH_RECORD_FILE", output.c_str ()),
+	    recordFrames ("COMPIZ_BENCH_RECORD_FRAMES",
+			  ToString (nFrames).c_str ())
+	{
+	}
+
+	virtual void SetUp ()
+	{
+	    unlink (output.c_str ());
+
+	    ct::CompizXorgSystemTest::SetUp ();
+
+	    XSelectInput (Display (), DefaultRootWindow (Display ()),
+			  StructureNotifyMask);
+	}
+
+	ct::CompizProcess::PluginList
+	Plugins ()
+	{
+	    ct::CompizProcess::PluginList list;
+
+	    list.push_back (ct::CompizProcess::Plugin ("composite",
+						       ct::CompizProcess::Real));
+	    list.push_back (ct::CompizProcess::Plugin ("opengl",
+						       ct::CompizProcess::Real));
+
+	    AppendPlugins (list, EnvOr ("COMPIZ_BENCH_PLUGINS", ""));
+
+	    /* Loaded last, so that it measures everything else */
+	    list.push_back (ct::CompizProcess::Plugin ("bench",
+						       ct::CompizProcess::Real));
+
+	    return list;
+	}
+
+	/* Milliseconds from starting compiz until it is up, with ccp
+	 * loaded first to set the options of all the plugins after it */
+	double
+	TimeStartup (bool withCcp)
+	{
+	    ct::CompizProcess::PluginList list;
+
+	    if (withCcp)
+		list.push_back (ct::CompizProcess::Plugin ("ccp",
+							   ct::CompizProcess::Real));
+
+	    list.push_back (ct::CompizProcess::Plugin ("composite",
+						       ct::CompizProcess::Real));
+	    list.push_back (ct::CompizProcess::Plugin ("opengl",
+						       ct::CompizProcess::Real));
+
+	    AppendPlugins (list, EnvOr ("COMPIZ_BENCH_STARTUP_PLUGINS",
+					DEFAULT_STARTUP_PLUGINS));
+
+	    double start = MonotonicMs ();
+
+	    /* Killed again when it goes out of scope */
+	    ct::CompizProcess process (Display (),
+				       static_cast <ct::CompizProcess::StartupFlags> (
+					   ct::CompizProcess::ReplaceCurrentWM |
+					   ct::CompizProcess::WaitForStartupMessage),
+				       list);
+
+	    return MonotonicMs () - start;
+	}
+
+	std::string  output;
+	unsigned int nWindows;
+	unsigned int nFrames;
+
+    private:
+
+	TmpEnv softwareGL;
+	TmpEnv galliumDriver;
+	TmpEnv recordFile;
+	TmpEnv recordFrames;
+};
+
+TEST_F (CompizXorgSystemBenchmark, ScriptedWorkload)
+{
+    ::Display *dpy = Display ();
+
+    StartCompiz (static_cast <ct::CompizProcess::StartupFlags> (
+		     ct::CompizProcess::ReplaceCurrentWM |
+		     ct::CompizProcess::WaitForStartupMessage),
+		 Plugins ());
+
+    std::vector <Window> windows;
+
+    for (unsigned int i = 0; i < nWindows; ++i)
+    {
+	Window w = ct::CreateNormalWindow (dpy);
+
+	XResizeWindow (dpy, w, BENCH_WINDOW_WIDTH, BENCH_WINDOW_HEIGHT);
+	XMapRaised (dpy, w);
+
+	ASSERT_TRUE (Advance (dpy,
+			      ct::WaitForEventOfTypeOnWindow (dpy,
+							      w,
+							      MapNotify,
+							      -1,
+							      -1)));
+
+	windows.push_back (w);
+    }
+
+    GC gc = XCreateGC (dpy, DefaultRootWindow (dpy), 0, NULL);
+
+    int screenWidth = DisplayWidth (dpy, DefaultScreen (dpy));
+    int screenHeight = DisplayHeight (dpy, DefaultScreen (dpy));
+
+    time_t deadline = time (NULL) + MAXIMUM_RUN_TIME;
+
+    for (unsigned int step = 0;
+	 !FileExists (output) && time (NULL) < deadline;
+	 ++step)
+    {
+	for (unsigned int i = 0; i < windows.size (); ++i)
+	{
+	    Window w = windows[i];
+
+	    switch ((step + i) % 3)
+	    {
+		/* Damage part of the window */
+		case 0:
+		    XSetForeground (dpy, gc, (step * 2654435761u) ^ i);
+		    XFillRectangle (dpy, w, gc,
+				    (step * 7) % BENCH_WINDOW_WIDTH,
+				    (step * 5) % BENCH_WINDOW_HEIGHT,
+				    BENCH_WINDOW_WIDTH / 4,
+				    BENCH_WINDOW_HEIGHT / 4);
+		    break;
+		/* Move it around the screen */
+		case 1:
+		    XMoveWindow (dpy, w,
+				 (step * 3 + i * 37) %
+				 (screenWidth - BENCH_WINDOW_WIDTH),
+				 (step * 2 + i * 53) %
+				 (screenHeight - BENCH_WINDOW_HEIGHT));
+		    break;
+		/* And animate its size */
+		case 2:
+		    XResizeWindow (dpy, w,
+				   BENCH_WINDOW_WIDTH + (step % 32),
+				   BENCH_WINDOW_HEIGHT + (step % 32));
+		    break;
+	    }
+	}
+
+	XSync (dpy, False);
+
+	/* We don't care about the events generated by the workload */
+	while (XPending (dpy))
+	{
+	    XEvent event;
+	    XNextEvent (dpy, &event);
+	}
+
+	usleep (STEP_INTERVAL_US);
+    }
+
+    XFreeGC (dpy, gc);
+
+    ASSERT_TRUE (FileExists (output));
+
+    std::ifstream in (output.c_str ());
+    std::string   json ((std::istreambuf_iterator <char> (in)),
+			std::istreambuf_iterator <char> ());
+
+    EXPECT_NE (std::string::npos,
+	       json.find ("\"frames\": " + ToString (nFrames) + ","));
+
+    std::cout << "[BENCH] frame timings written to " << output << std::endl;
+}
+
+TEST_F (CompizXorgSystemBenchmark, OptionLoadingStartup)
+{
+    unsigned int runs = EnvOr ("COMPIZ_BENCH_STARTUP_RUNS",
+			       DEFAULT_STARTUP_RUNS);
+
+    ASSERT_GT (runs, 0u);
+
+    std::vector <double> withoutCcp, withCcp;
+
+    /* Interleave the two, so that a slow spell on the machine affects
+     * both of them alike */
+    for (unsigned int i = 0; i < runs; ++i)
+    {
+	withoutCcp.push_back (TimeStartup (false));
+	ASSERT_FALSE (HasFailure ());
+
+	withCcp.push_back (TimeStartup (true));
+	ASSERT_FALSE (HasFailure ());
+    }
+
+    double base = Median (withoutCcp);
+    double ccp = Median (withCcp);
+
+    std::cout << "[BENCH] startup without ccp: " << base << " ms, "
+	      << "with ccp: " << ccp << " ms, "
+	      << "loading options: " << ccp - base << " ms "
+	      << "(median of " << runs << " runs)" << std::endl;
+}